@@ -0,0 +1,48 @@
+#include <microbenchmark.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <rendering/camera.hpp>
+#include <benchmarking/camera_path.h>
+
+constexpr size_t CameraCount = 1024;
+
+
+void dengine::runCameraBenchmarks(MicrobenchmarkRunner& runner)
+{
+	const CameraPath cameraPath = makeOrbitCameraPath(glm::vec3(0.0f), 10.0f, 2.0f, 60.0f);
+	std::pmr::vector<Camera> cameras;
+	for (size_t i = 0; i < CameraCount; i++)
+		cameras.push_back(cameraPath.Sample(60.0f * static_cast<float>(i) / static_cast<float>(CameraCount)));
+
+	runner.Run("camera look at", CameraCount, CameraCount, [&](unsigned long long iterations)
+	{
+		for (unsigned long long i = 0; i < iterations; i++)
+			for (auto& camera : cameras)
+			{
+				auto viewMatrix = CameraControl::GetLookAtMatrix(camera);
+				doNotOptimize(viewMatrix);
+			}
+	});
+
+	//what scene renderer computes every frame before culling
+	runner.Run("camera view projection", CameraCount, CameraCount, [&](unsigned long long iterations)
+	{
+		for (unsigned long long i = 0; i < iterations; i++)
+			for (auto& camera : cameras)
+			{
+				const auto projectionMatrix = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+				auto viewProjection = projectionMatrix * CameraControl::GetLookAtMatrix(camera);
+				doNotOptimize(viewProjection);
+			}
+	});
+
+	runner.Run("camera path sample", CameraCount, CameraCount, [&](unsigned long long iterations)
+	{
+		for (unsigned long long i = 0; i < iterations; i++)
+			for (size_t key = 0; key < CameraCount; key++)
+			{
+				auto camera = cameraPath.Sample(60.0f * static_cast<float>(key) / static_cast<float>(CameraCount));
+				doNotOptimize(camera);
+			}
+	});
+}
@@ -0,0 +1,44 @@
+#!/bin/sh
+#renders one scene through gl on mesa llvmpipe and through software rasterizer with same camera, size and frames,
+#then reports frame times of both and image difference between them
+#  benchmarks/compare_software_renderer.sh <graphics-engine binary> <scene> [headless arguments]
+#  e.g. benchmarks/compare_software_renderer.sh build/graphics-engine scenes/sponza.dscene --frames 120 --warmup 10
+#results go to $OUTPUT_DIR, software-comparison by default; both renderers use every core, llvmpipe through
+#LP_NUM_THREADS, software rasterizer through its thread pool
+set -e
+
+if [ $# -lt 2 ]; then
+	echo "usage: $0 <graphics-engine binary> <scene> [headless arguments]" >&2
+	exit 1
+fi
+engine=$1
+scene=$2
+shift 2
+output=${OUTPUT_DIR:-software-comparison}
+mkdir -p "$output/llvmpipe" "$output/software"
+
+#forced software rendering makes surfaceless egl pick llvmpipe even on machines with a gpu
+LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe "$engine" --headless "$scene" --renderer opengl \
+	--output-dir "$output/llvmpipe" --benchmark-json "$output/llvmpipe.json" --benchmark-csv "$output/llvmpipe.csv" "$@"
+if ! grep -q '"renderer": ".*llvmpipe' "$output/llvmpipe.json"; then
+	echo "warning: gl run did not use llvmpipe, see renderer in $output/llvmpipe.json" >&2
+fi
+#software frames are compared with llvmpipe ones written above
+"$engine" --headless "$scene" --renderer software --output-dir "$output/software" --compare-dir "$output/llvmpipe" \
+	--benchmark-json "$output/software.json" --benchmark-csv "$output/software.csv" "$@"
+
+#value of statistic inside summary object of benchmark json, e.g. summary_value file wall_ms p95
+summary_value() {
+	sed -n "s/.*\"$2\": {[^}]*\"$3\": \([0-9.]*\).*/\1/p" "$1"
+}
+
+#wall time covers whole frame for both, gl cpu time is submission only
+echo
+printf "%-10s %12s %12s %12s\n" renderer "wall mean" "wall p50" "wall p95"
+for renderer in llvmpipe software; do
+	printf "%-10s %12s %12s %12s\n" "$renderer" "$(summary_value "$output/$renderer.json" wall_ms mean)" \
+		"$(summary_value "$output/$renderer.json" wall_ms p50)" "$(summary_value "$output/$renderer.json" wall_ms p95)"
+done
+awk -v gl="$(summary_value "$output/llvmpipe.json" wall_ms mean)" \
+	-v software="$(summary_value "$output/software.json" wall_ms mean)" \
+	'BEGIN { if (software > 0) printf "software rasterizer is %.2fx llvmpipe mean frame rate\n", gl / software }'
@@ -0,0 +1,287 @@
+#include <microbenchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+
+#include <assimp/scene.h>
+#include <stb_image_write.h>
+#include <importers/assimp_model_importer.h>
+#include <importers/mesh_processing.h>
+
+
+//flat grid with every attribute ProcessMesh reads, two triangles per quad; mirrored uvs fold u around middle
+//column like symmetric models sharing one half of texture, so tangent generation has to split seam vertices
+std::unique_ptr<aiMesh> makeGridMesh(unsigned int quadsPerSide, bool mirroredUVs = false)
+{
+	const unsigned int verticesPerSide = quadsPerSide + 1;
+	auto mesh = std::make_unique<aiMesh>();
+	mesh->mNumVertices = verticesPerSide * verticesPerSide;
+	mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+	mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+	mesh->mTangents = new aiVector3D[mesh->mNumVertices];
+	mesh->mBitangents = new aiVector3D[mesh->mNumVertices];
+	mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+	mesh->mNumUVComponents[0] = 2;
+	for (unsigned int y = 0; y < verticesPerSide; y++)
+	{
+		for (unsigned int x = 0; x < verticesPerSide; x++)
+		{
+			const unsigned int index = y * verticesPerSide + x;
+			const float u = static_cast<float>(x) / static_cast<float>(quadsPerSide);
+			const float v = static_cast<float>(y) / static_cast<float>(quadsPerSide);
+			mesh->mVertices[index] = aiVector3D(u, 0.0f, v);
+			mesh->mNormals[index] = aiVector3D(0.0f, 1.0f, 0.0f);
+			mesh->mTangents[index] = aiVector3D(1.0f, 0.0f, 0.0f);
+			mesh->mBitangents[index] = aiVector3D(0.0f, 0.0f, 1.0f);
+			mesh->mTextureCoords[0][index] = aiVector3D(mirroredUVs ? 1.0f - std::abs(2.0f * u - 1.0f) : u, v, 0.0f);
+		}
+	}
+
+	mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+	mesh->mNumFaces = quadsPerSide * quadsPerSide * 2;
+	mesh->mFaces = new aiFace[mesh->mNumFaces];
+	unsigned int faceIndex = 0;
+	for (unsigned int y = 0; y < quadsPerSide; y++)
+	{
+		for (unsigned int x = 0; x < quadsPerSide; x++)
+		{
+			const unsigned int corner = y * verticesPerSide + x;
+			const unsigned int triangles[2][3] = {
+				{ corner, corner + verticesPerSide, corner + 1 },
+				{ corner + 1, corner + verticesPerSide, corner + verticesPerSide + 1 },
+			};
+			for (auto& triangle : triangles)
+			{
+				auto& face = mesh->mFaces[faceIndex++];
+				face.mNumIndices = 3;
+				face.mIndices = new unsigned int[3]{ triangle[0], triangle[1], triangle[2] };
+			}
+		}
+	}
+	return mesh;
+}
+
+
+//grids of separate objects, each becomes own mesh on import, so mesh processing has work for every worker
+std::pmr::string makeGridObj(unsigned int meshCount, unsigned int quadsPerSide)
+{
+	const unsigned int verticesPerSide = quadsPerSide + 1;
+	std::pmr::string obj;
+	char line[128];
+	unsigned int firstVertex = 1;
+	for (unsigned int meshIndex = 0; meshIndex < meshCount; meshIndex++)
+	{
+		std::snprintf(line, sizeof(line), "o grid%u\n", meshIndex);
+		obj += line;
+		//wavy surface, so normals and tangents differ between vertices
+		for (unsigned int y = 0; y < verticesPerSide; y++)
+			for (unsigned int x = 0; x < verticesPerSide; x++)
+			{
+				const float u = static_cast<float>(x) / static_cast<float>(quadsPerSide);
+				const float v = static_cast<float>(y) / static_cast<float>(quadsPerSide);
+				const float height = 0.05f * std::sin(u * 12.0f) * std::cos(v * 9.0f);
+				const float slopeU = 0.6f * std::cos(u * 12.0f) * std::cos(v * 9.0f);
+				const float slopeV = -0.45f * std::sin(u * 12.0f) * std::sin(v * 9.0f);
+				const float normalScale = 1.0f / std::sqrt(1.0f + slopeU * slopeU + slopeV * slopeV);
+				std::snprintf(line, sizeof(line), "v %.5f %.5f %.5f\nvt %.5f %.5f\nvn %.5f %.5f %.5f\n",
+					u + meshIndex * 1.5f, height, v, u, v, -slopeU * normalScale, normalScale, -slopeV * normalScale);
+				obj += line;
+			}
+		for (unsigned int y = 0; y < quadsPerSide; y++)
+			for (unsigned int x = 0; x < quadsPerSide; x++)
+			{
+				const unsigned int corner = firstVertex + y * verticesPerSide + x;
+				const unsigned int triangles[2][3] = {
+					{ corner, corner + verticesPerSide, corner + 1 },
+					{ corner + 1, corner + verticesPerSide, corner + verticesPerSide + 1 },
+				};
+				for (auto& triangle : triangles)
+				{
+					std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", triangle[0], triangle[0], triangle[0],
+						triangle[1], triangle[1], triangle[1], triangle[2], triangle[2], triangle[2]);
+					obj += line;
+				}
+			}
+		firstVertex += verticesPerSide * verticesPerSide;
+	}
+	return obj;
+}
+
+
+//smooth gradient with noise, compresses roughly like albedo maps instead of flat color
+std::pmr::vector<unsigned char> makeTestImage(int size)
+{
+	std::mt19937 random(size);
+	std::uniform_int_distribution<int> noise(-12, 12);
+	std::pmr::vector<unsigned char> pixels(static_cast<size_t>(size) * size * 4);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			unsigned char* pixel = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+			pixel[0] = static_cast<unsigned char>(std::clamp(x * 255 / size + noise(random), 0, 255));
+			pixel[1] = static_cast<unsigned char>(std::clamp(y * 255 / size + noise(random), 0, 255));
+			pixel[2] = static_cast<unsigned char>(std::clamp((x + y) * 127 / size + noise(random), 0, 255));
+			pixel[3] = 255;
+		}
+	}
+	return pixels;
+}
+
+
+void appendEncodedBytes(void* context, void* data, int size)
+{
+	auto& encoded = *static_cast<std::pmr::vector<unsigned char>*>(context);
+	const auto bytes = static_cast<unsigned char*>(data);
+	encoded.insert(encoded.end(), bytes, bytes + size);
+}
+
+
+void dengine::runImporterBenchmarks(MicrobenchmarkRunner& runner)
+{
+	if (runner.IsEnabled("importer process mesh"))
+	{
+		for (unsigned int quadsPerSide : { 32u, 128u, 512u })
+		{
+			const auto mesh = makeGridMesh(quadsPerSide);
+			runner.Run("importer process mesh", mesh->mNumVertices, mesh->mNumVertices, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					auto processedMesh = AssimpModelImporter::ProcessMesh(mesh.get(), nullptr);
+					doNotOptimize(processedMesh);
+				}
+			});
+		}
+	}
+
+	if (runner.IsEnabled("mesh bounds") || runner.IsEnabled("mesh tangents mirrored"))
+	{
+		for (unsigned int quadsPerSide : { 32u, 128u, 512u })
+		{
+			auto mesh = AssimpModelImporter::ProcessMesh(makeGridMesh(quadsPerSide).get(), nullptr);
+			const auto vertexCount = mesh.Positions.size();
+			runner.Run("mesh bounds", vertexCount, vertexCount, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					computeMeshBounds(mesh);
+					doNotOptimize(mesh.BoundingSphere);
+				}
+			});
+			runner.Run("mesh tangents", vertexCount, vertexCount, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					computeMeshTangents(mesh);
+					doNotOptimize(mesh.Tangents.front());
+				}
+			});
+			//seam vertices are split on first pass, later passes only find them again
+			auto mirroredMesh = AssimpModelImporter::ProcessMesh(makeGridMesh(quadsPerSide, true).get(), nullptr);
+			runner.Run("mesh tangents mirrored", vertexCount, vertexCount, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					computeMeshTangents(mirroredMesh);
+					doNotOptimize(mirroredMesh.Tangents.front());
+				}
+			});
+		}
+	}
+
+	//whole import of same file with either tangent generation, items are meshes
+	if (runner.IsEnabled("import tangents assimp asset") || runner.IsEnabled("import tangents batched asset"))
+	{
+		BS::thread_pool threadPool;
+		AssimpModelImporter importer(&threadPool);
+		for (unsigned int meshCount : { 1u, 16u, 128u })
+		{
+			const auto obj = makeGridObj(meshCount, 64);
+			auto runImport = [&](const char* name, TangentGeneration tangentGeneration)
+			{
+				importer.SetTangentGeneration(tangentGeneration);
+				runner.Run(name, meshCount, meshCount, [&](unsigned long long iterations)
+				{
+					for (unsigned long long i = 0; i < iterations; i++)
+					{
+						auto model = importer.ImportFromMemory(obj.data(), obj.size(), "obj", "grid.obj");
+						doNotOptimize(model);
+					}
+				});
+			};
+			runImport("import tangents assimp", TangentGeneration::Assimp);
+			runImport("import tangents batched", TangentGeneration::Batched);
+		}
+
+		//real assets from --asset, parameter is their position on command line and items are triangles, whole
+		//import including textures is timed, so difference between both is what tangent generation saves
+		const auto& assets = runner.GetSettings().Assets;
+		for (size_t asset = 0; asset < assets.size(); asset++)
+		{
+			importer.SetTangentGeneration(TangentGeneration::Batched);
+			const auto firstModel = importer.Import(assets[asset]);
+			unsigned long long triangles = 0;
+			for (const auto& mesh : firstModel.Meshes)
+				triangles += mesh.Indecies.size() / 3;
+			if (triangles == 0)
+			{
+				std::fprintf(stderr, "failed to import %s\n", assets[asset].c_str());
+				continue;
+			}
+			std::printf("asset %zu: %s, %zu meshes, %llu triangles\n", asset, assets[asset].c_str(),
+				firstModel.Meshes.size(), triangles);
+			auto runImport = [&](const char* name, TangentGeneration tangentGeneration)
+			{
+				importer.SetTangentGeneration(tangentGeneration);
+				runner.Run(name, static_cast<long long>(asset), triangles, [&](unsigned long long iterations)
+				{
+					for (unsigned long long i = 0; i < iterations; i++)
+					{
+						auto model = importer.Import(assets[asset]);
+						doNotOptimize(model);
+					}
+				});
+			};
+			runImport("import tangents assimp asset", TangentGeneration::Assimp);
+			runImport("import tangents batched asset", TangentGeneration::Batched);
+		}
+	}
+
+	const bool decodePng = runner.IsEnabled("texture decode png");
+	const bool decodeJpeg = runner.IsEnabled("texture decode jpeg");
+	if (!decodePng && !decodeJpeg)
+		return;
+	for (int size : { 256, 1024, 2048 })
+	{
+		const auto pixels = makeTestImage(size);
+		const long long texels = static_cast<long long>(size) * size;
+		auto decode = [&](const char* name, std::pmr::vector<unsigned char>& encoded)
+		{
+			runner.Run(name, size, texels, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					auto texture = AssimpModelImporter::LoadTextureFromMemory(encoded.data(),
+						static_cast<unsigned int>(encoded.size()));
+					doNotOptimize(texture);
+				}
+			});
+		};
+		if (decodePng)
+		{
+			std::pmr::vector<unsigned char> encoded;
+			stbi_write_png_to_func(appendEncodedBytes, &encoded, size, size, 4, pixels.data(), size * 4);
+			decode("texture decode png", encoded);
+		}
+		if (decodeJpeg)
+		{
+			std::pmr::vector<unsigned char> encoded;
+			stbi_write_jpg_to_func(appendEncodedBytes, &encoded, size, size, 4, pixels.data(), 90);
+			decode("texture decode jpeg", encoded);
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#!/bin/sh
+#generates scenes with many instances of one model and renders them headless through gl with one or more
+#graphics-engine builds, then reports frame and gpu times of every build at every instance count
+#  benchmarks/instance_heavy_benchmark.sh <model> <graphics-engine binary>... [-- headless arguments]
+#  e.g. benchmarks/instance_heavy_benchmark.sh models/cube.obj before/graphics-engine after/graphics-engine -- --frames 300
+#instance counts come from $INSTANCES, "10000 100000 1000000" by default; scenes and reports go to $OUTPUT_DIR,
+#instance-benchmark by default; ratio column compares every build with first one
+set -e
+
+if [ $# -lt 2 ]; then
+	echo "usage: $0 <model> <graphics-engine binary>... [-- headless arguments]" >&2
+	exit 1
+fi
+model=$1
+shift
+engines=
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+	engines="$engines $1"
+	shift
+done
+[ "$1" = "--" ] && shift
+output=${OUTPUT_DIR:-instance-benchmark}
+instances=${INSTANCES:-10000 100000 1000000}
+mkdir -p "$output"
+
+#scenes are generated by first build so every build renders same placement
+for generator in $engines; do break; done
+for count in $instances; do
+	"$generator" --generate-scene --output "$output/instances_$count.dscene" --model "$model" --instances "$count" \
+		--lights 4 --seed 1
+done
+
+#value of statistic inside summary object of benchmark json, e.g. summary_value file wall_ms p95
+summary_value() {
+	sed -n "s/.*\"$2\": {[^}]*\"$3\": \(-\{0,1\}[0-9.]*\).*/\1/p" "$1"
+}
+
+build=0
+for engine in $engines; do
+	build=$((build + 1))
+	for count in $instances; do
+		"$engine" --headless "$output/instances_$count.dscene" --renderer opengl --warmup 10 --frames 200 \
+			--benchmark-json "$output/build${build}_$count.json" --benchmark-csv "$output/build${build}_$count.csv" "$@"
+	done
+done
+
+#gpu time is what instance packing and per instance shading cost, wall time includes submission
+echo
+printf "%-6s %10s %12s %12s %12s %12s %8s\n" build instances "wall mean" "wall p50" "gpu mean" "gpu p50" ratio
+for count in $instances; do
+	build=0
+	baseline=
+	for engine in $engines; do
+		build=$((build + 1))
+		report="$output/build${build}_$count.json"
+		gpu=$(summary_value "$report" gpu_ms p50)
+		[ -z "$baseline" ] && baseline=$gpu
+		ratio=$(awk -v base="$baseline" -v gpu="$gpu" 'BEGIN { if (base > 0) printf "%.2fx", gpu / base; else print "-" }')
+		printf "%-6s %10s %12s %12s %12s %12s %8s\n" "$build" "$count" "$(summary_value "$report" wall_ms mean)" \
+			"$(summary_value "$report" wall_ms p50)" "$(summary_value "$report" gpu_ms mean)" "$gpu" "$ratio"
+	done
+done
+echo "builds:"
+build=0
+for engine in $engines; do
+	build=$((build + 1))
+	echo "  $build $engine"
+done
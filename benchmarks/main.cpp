@@ -0,0 +1,65 @@
+#include <microbenchmark.h>
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+
+template<typename TValue>
+bool parseValue(const char* text, TValue& value)
+{
+	const char* textEnd = text + std::strlen(text);
+	auto [ptr, error] = std::from_chars(text, textEnd, value);
+	return error == std::errc() && ptr == textEnd;
+}
+
+
+void printUsage()
+{
+	std::printf("usage: dengine-microbenchmarks [--json <path>] [--filter <substring>] [--repetitions <count>]"
+		" [--min-time <ms>] [--asset <model path>]...\n");
+}
+
+
+int main(int argc, char* argv[])
+{
+	dengine::MicrobenchmarkSettings settings;
+	std::pmr::string jsonPath;
+	for (int i = 1; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+		bool valid = true;
+		if (std::strcmp(argv[i], "--json") == 0 && hasValue)
+			jsonPath = argv[++i];
+		else if (std::strcmp(argv[i], "--filter") == 0 && hasValue)
+			settings.Filter = argv[++i];
+		else if (std::strcmp(argv[i], "--repetitions") == 0 && hasValue)
+			valid = parseValue(argv[++i], settings.Repetitions) && settings.Repetitions > 0;
+		else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue)
+			valid = parseValue(argv[++i], settings.MinRepetitionMilliseconds) && settings.MinRepetitionMilliseconds > 0.0;
+		else if (std::strcmp(argv[i], "--asset") == 0 && hasValue)
+			settings.Assets.push_back(argv[++i]);
+		else
+			valid = false;
+		if (!valid)
+		{
+			printUsage();
+			return -1;
+		}
+	}
+
+	dengine::MicrobenchmarkRunner runner(settings);
+	dengine::runImporterBenchmarks(runner);
+	dengine::runSubmissionBenchmarks(runner);
+	dengine::runUploadBenchmarks(runner);
+	dengine::runCameraBenchmarks(runner);
+	dengine::runRasterizerBenchmarks(runner);
+	dengine::runPathTracerBenchmarks(runner);
+
+	if (!jsonPath.empty() && !dengine::writeMicrobenchmarkJson(jsonPath, runner.GetResults()))
+	{
+		std::fprintf(stderr, "failed to write %s\n", jsonPath.c_str());
+		return -1;
+	}
+	return 0;
+}
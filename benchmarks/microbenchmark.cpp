@@ -0,0 +1,104 @@
+#include <microbenchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+//calibration stops growing iteration count here even if body is still too fast to time
+constexpr unsigned long long MaxIterations = 1ull << 30;
+
+
+double measureNanoseconds(const dengine::MicrobenchmarkBody& body, unsigned long long iterations)
+{
+	const auto start = std::chrono::steady_clock::now();
+	body(iterations);
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+dengine::MicrobenchmarkRunner::MicrobenchmarkRunner(MicrobenchmarkSettings settings) : settings(std::move(settings))
+{
+}
+
+
+bool dengine::MicrobenchmarkRunner::IsEnabled(const char* name) const
+{
+	return settings.Filter.empty() || std::strstr(name, settings.Filter.c_str()) != nullptr;
+}
+
+
+void dengine::MicrobenchmarkRunner::Run(const char* name, long long parameter, unsigned long long itemsPerIteration,
+	const MicrobenchmarkBody& body)
+{
+	if (!IsEnabled(name))
+		return;
+
+	//grow iteration count until one repetition is long enough to time reliably, first call also warms caches
+	const double minNanoseconds = settings.MinRepetitionMilliseconds * 1'000'000.0;
+	unsigned long long iterations = 1;
+	double elapsed = measureNanoseconds(body, iterations);
+	while (elapsed < minNanoseconds && iterations < MaxIterations)
+	{
+		const double scale = elapsed > 0.0 ? minNanoseconds * 1.2 / elapsed : 10.0;
+		iterations = std::min(MaxIterations, static_cast<unsigned long long>(static_cast<double>(iterations) *
+			std::min(std::max(scale, 2.0), 10.0)));
+		elapsed = measureNanoseconds(body, iterations);
+	}
+
+	std::pmr::vector<double> iterationTimes;
+	for (int i = 0; i < settings.Repetitions; i++)
+		iterationTimes.push_back(measureNanoseconds(body, iterations) / static_cast<double>(iterations));
+
+	MicrobenchmarkResult result;
+	result.Name = name;
+	result.Parameter = parameter;
+	result.Iterations = iterations;
+	result.Repetitions = settings.Repetitions;
+	result.Nanoseconds = summarizeValues(std::move(iterationTimes));
+	if (result.Nanoseconds.P50 > 0.0)
+		result.ItemsPerSecond = static_cast<double>(itemsPerIteration) * 1'000'000'000.0 / result.Nanoseconds.P50;
+	std::printf("%-32s %10lld %14.1f ns %14.1f ns p95 %14.4g items/s\n", name, parameter, result.Nanoseconds.P50,
+		result.Nanoseconds.P95, result.ItemsPerSecond);
+	std::fflush(stdout);
+	results.push_back(std::move(result));
+}
+
+
+const std::pmr::vector<dengine::MicrobenchmarkResult>& dengine::MicrobenchmarkRunner::GetResults() const
+{
+	return results;
+}
+
+
+const dengine::MicrobenchmarkSettings& dengine::MicrobenchmarkRunner::GetSettings() const
+{
+	return settings;
+}
+
+
+bool dengine::writeMicrobenchmarkJson(const std::pmr::string& path, const std::pmr::vector<MicrobenchmarkResult>& results)
+{
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr)
+		return false;
+
+#ifdef NDEBUG
+	const char* buildType = "release";
+#else
+	const char* buildType = "debug";
+#endif
+	std::fprintf(file, "{\n  \"build\": \"%s\",\n  \"benchmarks\": [\n", buildType);
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		auto& result = results[i];
+		auto& summary = result.Nanoseconds;
+		std::fprintf(file, "    {\"name\": \"%s\", \"parameter\": %lld, \"iterations\": %llu, \"repetitions\": %d, "
+			"\"items_per_second\": %.2f, \"ns\": {\"min\": %.2f, \"mean\": %.2f, \"p50\": %.2f, \"p95\": %.2f, "
+			"\"p99\": %.2f, \"max\": %.2f}}%s\n", result.Name.c_str(), result.Parameter, result.Iterations,
+			result.Repetitions, result.ItemsPerSecond, summary.Min, summary.Mean, summary.P50, summary.P95, summary.P99,
+			summary.Max, i + 1 == results.size() ? "" : ",");
+	}
+	std::fprintf(file, "  ]\n}\n");
+	return std::fclose(file) == 0;
+}
@@ -0,0 +1,69 @@
+#ifndef MICROBENCHMARK_INCLUDED
+#define MICROBENCHMARK_INCLUDED
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <benchmarking/frame_statistics.h>
+
+namespace dengine
+{
+	struct MicrobenchmarkSettings {
+		//only benchmarks whose name contains filter are run
+		std::pmr::string Filter;
+		double MinRepetitionMilliseconds{ 25.0 };
+		int Repetitions{ 10 };
+		//model files imported whole by importer benchmarks, next to generated ones
+		std::pmr::vector<std::pmr::string> Assets;
+	};
+
+	struct MicrobenchmarkResult {
+		std::pmr::string Name;
+		long long Parameter{ 0 };
+		unsigned long long Iterations{ 0 };
+		int Repetitions{ 0 };
+		//time of one iteration over all repetitions
+		StatisticsSummary Nanoseconds;
+		double ItemsPerSecond{ 0.0 };
+	};
+
+	//body gets iteration count and has to run measured code that many times
+	using MicrobenchmarkBody = std::function<void(unsigned long long iterations)>;
+
+	class MicrobenchmarkRunner {
+	public:
+		explicit MicrobenchmarkRunner(MicrobenchmarkSettings settings);
+
+		bool IsEnabled(const char* name) const;
+		void Run(const char* name, long long parameter, unsigned long long itemsPerIteration, const MicrobenchmarkBody& body);
+		const std::pmr::vector<MicrobenchmarkResult>& GetResults() const;
+		const MicrobenchmarkSettings& GetSettings() const;
+	private:
+		MicrobenchmarkSettings settings;
+		std::pmr::vector<MicrobenchmarkResult> results;
+	};
+
+	bool writeMicrobenchmarkJson(const std::pmr::string& path, const std::pmr::vector<MicrobenchmarkResult>& results);
+
+	//keeps compiler from dropping computation whose result is otherwise unused
+	template<typename T>
+	inline void doNotOptimize(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "g"(&value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+	void runImporterBenchmarks(MicrobenchmarkRunner& runner);
+	void runSubmissionBenchmarks(MicrobenchmarkRunner& runner);
+	void runUploadBenchmarks(MicrobenchmarkRunner& runner);
+	void runCameraBenchmarks(MicrobenchmarkRunner& runner);
+	void runRasterizerBenchmarks(MicrobenchmarkRunner& runner);
+	void runPathTracerBenchmarks(MicrobenchmarkRunner& runner);
+}
+
+#endif
@@ -0,0 +1,194 @@
+#include <microbenchmark.h>
+
+#include <cmath>
+#include <atomic>
+#include <rendering/software/software_rasterizer.h>
+#include <rendering/software/path_tracer.h>
+#include <importers/mesh_processing.h>
+
+constexpr int SyntheticSphereRings = 32;
+constexpr int SyntheticSphereSegments = 64;
+constexpr int SyntheticTextureSize = 512;
+constexpr float SyntheticInstanceSpacing = 3.0f;
+constexpr int RasterizerWidth = 1280;
+constexpr int RasterizerHeight = 720;
+//rays per second are measured on smaller image, path tracing a frame takes far longer than rasterizing it
+constexpr int TracerWidth = 320;
+constexpr int TracerHeight = 180;
+
+
+//uv sphere with checker albedo, every import returns it so scenes need no files on disk
+class SyntheticSphereImporter : public dengine::IModelImporter {
+public:
+	dengine::Model Import(std::pmr::string path) override
+	{
+		dengine::Model model;
+		model.Name = path;
+		auto& mesh = model.Meshes.emplace_back();
+		mesh.MaterialIndex = 0;
+		for (int ring = 0; ring <= SyntheticSphereRings; ring++)
+		{
+			const float theta = 3.14159265f * ring / SyntheticSphereRings;
+			for (int segment = 0; segment <= SyntheticSphereSegments; segment++)
+			{
+				const float phi = 2.0f * 3.14159265f * segment / SyntheticSphereSegments;
+				const glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				mesh.Positions.push_back(normal);
+				mesh.Normals.push_back(normal);
+				mesh.Tangents.push_back(glm::vec4(-std::sin(phi), 0.0f, std::cos(phi), 1.0f));
+				mesh.UVs.push_back(glm::vec2(static_cast<float>(segment) / SyntheticSphereSegments,
+					static_cast<float>(ring) / SyntheticSphereRings));
+			}
+		}
+		for (int ring = 0; ring < SyntheticSphereRings; ring++)
+			for (int segment = 0; segment < SyntheticSphereSegments; segment++)
+			{
+				const unsigned int first = ring * (SyntheticSphereSegments + 1) + segment;
+				const unsigned int second = first + SyntheticSphereSegments + 1;
+				mesh.Indecies.insert(mesh.Indecies.end(), { first, second, first + 1, second, second + 1, first + 1 });
+			}
+		dengine::computeMeshBounds(mesh);
+
+		auto& texture = model.Textures.emplace_back();
+		texture.Width = SyntheticTextureSize;
+		texture.Height = SyntheticTextureSize;
+		texture.Data.resize(static_cast<size_t>(SyntheticTextureSize) * SyntheticTextureSize * 4);
+		for (int y = 0; y < SyntheticTextureSize; y++)
+			for (int x = 0; x < SyntheticTextureSize; x++)
+			{
+				const unsigned char value = ((x / 32 + y / 32) % 2) != 0 ? 230 : 40;
+				auto* texel = texture.Data.data() + (static_cast<size_t>(y) * SyntheticTextureSize + x) * 4;
+				texel[0] = value;
+				texel[1] = value;
+				texel[2] = value;
+				texel[3] = 255;
+			}
+		model.Materials.push_back(dengine::Material{ 0, -1, -1 });
+		model.Nodes.push_back(dengine::Node{ glm::mat4(1.0f), -1, { 0 } });
+		return model;
+	}
+};
+
+
+dengine::SceneDescription makeSphereGridScene(int instanceCount)
+{
+	dengine::SceneDescription sceneDescription;
+	sceneDescription.Models.push_back(dengine::SceneModel{ "synthetic sphere" });
+	const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(instanceCount))));
+	for (int i = 0; i < instanceCount; i++)
+	{
+		dengine::SceneInstance instance;
+		instance.Position = glm::vec3((i % columns - columns / 2) * SyntheticInstanceSpacing, 0.0f,
+			(i / columns) * SyntheticInstanceSpacing);
+		sceneDescription.Instances.push_back(instance);
+	}
+	sceneDescription.Lights.push_back(dengine::SceneLight{ glm::vec4(0, 10, -5, 0), glm::vec4(1.0f, 1.0f, 1.0f, 50.0f) });
+	return sceneDescription;
+}
+
+
+void dengine::runRasterizerBenchmarks(MicrobenchmarkRunner& runner)
+{
+	const struct {
+		const char* Name;
+		SoftwareShading Shading;
+	} variants[] = {
+		{ "software render cook-torrance", SoftwareShading::CookTorrance },
+		{ "software render blinn-phong", SoftwareShading::BlinnPhong },
+	};
+	//scene building and thread pool are skipped when filter excludes every variant
+	if (!runner.IsEnabled(variants[0].Name) && !runner.IsEnabled(variants[1].Name))
+		return;
+	SyntheticSphereImporter importer;
+	BS::thread_pool threadPool;
+	SoftwareRasterizer rasterizer(threadPool);
+	rasterizer.Resize(RasterizerWidth, RasterizerHeight);
+	const Camera camera{ glm::vec3(0.0f, 6.0f, -8.0f), glm::normalize(glm::vec3(0.0f, -0.5f, 1.0f)), glm::vec3(0, 1, 0) };
+	const auto pixelCount = static_cast<unsigned long long>(RasterizerWidth) * RasterizerHeight;
+
+	for (int instanceCount : { 1, 64, 1024 })
+	{
+		SoftwareScene scene(importer);
+		scene.Build(makeSphereGridScene(instanceCount));
+		for (const auto& variant : variants)
+		{
+			rasterizer.GetSettings().Shading = variant.Shading;
+			runner.Run(variant.Name, instanceCount, pixelCount, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					rasterizer.Render(scene, camera);
+					doNotOptimize(rasterizer.GetColor().front());
+				}
+			});
+		}
+	}
+}
+
+
+void dengine::runPathTracerBenchmarks(MicrobenchmarkRunner& runner)
+{
+	if (!runner.IsEnabled("bvh build") && !runner.IsEnabled("bvh closest hit") && !runner.IsEnabled("path trace"))
+		return;
+	SyntheticSphereImporter importer;
+	BS::thread_pool threadPool;
+	const Camera camera{ glm::vec3(0.0f, 6.0f, -8.0f), glm::normalize(glm::vec3(0.0f, -0.5f, 1.0f)), glm::vec3(0, 1, 0) };
+
+	for (int instanceCount : { 1, 64, 1024 })
+	{
+		SoftwareScene scene(importer);
+		scene.Build(makeSphereGridScene(instanceCount));
+		runner.Run("bvh build", instanceCount, scene.GetTriangleCount(), [&](unsigned long long iterations)
+		{
+			for (unsigned long long i = 0; i < iterations; i++)
+			{
+				TriangleBvh bvh(threadPool);
+				bvh.Build(scene);
+				doNotOptimize(bvh.GetNodeCount());
+			}
+		});
+
+		PathTracer pathTracer(threadPool);
+		pathTracer.Resize(TracerWidth, TracerHeight);
+		pathTracer.SetScene(scene);
+		//one closest hit query per pixel of camera, items per second of this benchmark are rays per second
+		const auto& bvh = pathTracer.GetBvh();
+		const glm::vec3 forward = glm::normalize(camera.Diraction);
+		const glm::vec3 right = glm::normalize(glm::cross(forward, camera.Up));
+		const glm::vec3 up = glm::cross(right, forward);
+		runner.Run("bvh closest hit", instanceCount, static_cast<unsigned long long>(TracerWidth) * TracerHeight,
+			[&](unsigned long long iterations)
+		{
+			for (unsigned long long i = 0; i < iterations; i++)
+			{
+				std::atomic<unsigned int> hits{ 0 };
+				threadPool.parallelize_loop(0, TracerHeight, [&](int firstRow, int lastRow)
+				{
+					unsigned int rowHits = 0;
+					for (int y = firstRow; y < lastRow; y++)
+						for (int x = 0; x < TracerWidth; x++)
+						{
+							const float ndcX = (x + 0.5f) / TracerWidth * 2.0f - 1.0f;
+							const float ndcY = 1.0f - (y + 0.5f) / TracerHeight * 2.0f;
+							BvhHit hit;
+							const BvhRay ray{ camera.Position, glm::normalize(forward + right * ndcX + up * ndcY * 0.5625f), 1e30f };
+							rowHits += bvh.Intersect(ray, hit) ? 1 : 0;
+						}
+					hits += rowHits;
+				}).wait();
+				doNotOptimize(hits.load());
+			}
+		});
+
+		//rays of one accumulation vary little with sample index, first pass sets item count of benchmark
+		pathTracer.Accumulate(camera, 1);
+		runner.Run("path trace", instanceCount, pathTracer.GetStatistics().Rays, [&](unsigned long long iterations)
+		{
+			for (unsigned long long i = 0; i < iterations; i++)
+			{
+				pathTracer.Accumulate(camera, 1);
+				doNotOptimize(pathTracer.GetColor().front());
+			}
+		});
+	}
+}
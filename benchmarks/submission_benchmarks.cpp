@@ -0,0 +1,143 @@
+#include <microbenchmark.h>
+
+#include <algorithm>
+#include <glad/glad.h>
+#include <rendering/schemas/pbr_rendering_scheme.h>
+
+namespace
+{
+	//synthetic scene reuses this many meshes and materials, so batches stay realistic at every entity count
+	constexpr unsigned int SyntheticMeshCount = 64;
+	constexpr unsigned int SyntheticMaterialCount = 16;
+
+
+	//submitter creates its buffers on construction, benchmarks run without context so those calls do nothing;
+	//loader pointers are process wide, previous ones are restored on destruction
+	class NullBufferFunctions {
+	public:
+		NullBufferFunctions() : createBuffers(glad_glCreateBuffers), deleteBuffers(glad_glDeleteBuffers),
+			namedBufferData(glad_glNamedBufferData)
+		{
+			glad_glCreateBuffers = [](GLsizei count, GLuint* buffers)
+			{
+				for (GLsizei i = 0; i < count; i++)
+					buffers[i] = static_cast<GLuint>(i + 1);
+			};
+			glad_glDeleteBuffers = [](GLsizei, const GLuint*) {};
+			glad_glNamedBufferData = [](GLuint, GLsizeiptr, const void*, GLenum) {};
+		}
+
+		~NullBufferFunctions()
+		{
+			glad_glCreateBuffers = createBuffers;
+			glad_glDeleteBuffers = deleteBuffers;
+			glad_glNamedBufferData = namedBufferData;
+		}
+
+		NullBufferFunctions(const NullBufferFunctions&) = delete;
+		NullBufferFunctions& operator=(const NullBufferFunctions&) = delete;
+	private:
+		PFNGLCREATEBUFFERSPROC createBuffers;
+		PFNGLDELETEBUFFERSPROC deleteBuffers;
+		PFNGLNAMEDBUFFERDATAPROC namedBufferData;
+	};
+
+
+	struct SyntheticEntity {
+		dengine::PbrRenderingUnit RenderingUnit;
+		dengine::Material Material;
+		glm::mat4 ModelMatrix;
+	};
+
+
+	std::pmr::vector<SyntheticEntity> makeSyntheticEntities(size_t count)
+	{
+		std::pmr::vector<SyntheticEntity> entities(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const auto meshIndex = static_cast<unsigned int>(i % SyntheticMeshCount);
+			const auto materialIndex = static_cast<int>((i / SyntheticMeshCount) % SyntheticMaterialCount);
+			auto& entity = entities[i];
+			entity.RenderingUnit = dengine::PbrRenderingUnit{ meshIndex + 1, meshIndex + 1, 36, glm::vec4(0, 0, 0, 1) };
+			entity.Material = dengine::Material{ materialIndex * 3, materialIndex * 3 + 1, materialIndex * 3 + 2 };
+			entity.ModelMatrix = glm::mat4(1.0f);
+			entity.ModelMatrix[3] = glm::vec4(static_cast<float>(i % 1024), 0.0f, static_cast<float>(i / 1024), 1.0f);
+		}
+		return entities;
+	}
+}
+
+
+void dengine::runSubmissionBenchmarks(MicrobenchmarkRunner& runner)
+{
+	const NullBufferFunctions nullBufferFunctions;
+	for (size_t entityCount : { 1'000, 10'000, 100'000, 1'000'000 })
+	{
+		const auto entities = makeSyntheticEntities(entityCount);
+		const auto parameter = static_cast<long long>(entityCount);
+
+		runner.Run("pbr cache id", parameter, entityCount, [&](unsigned long long iterations)
+		{
+			for (unsigned long long i = 0; i < iterations; i++)
+			{
+				size_t hash = 0;
+				for (auto& entity : entities)
+					hash ^= PbrBatchKeyHash{}(getPbrCacheId(entity.RenderingUnit.Vao, entity.Material));
+				doNotOptimize(hash);
+			}
+		});
+
+		//conversion every submitted entity pays, 48 bytes written per instance
+		if (runner.IsEnabled("pbr pack instances"))
+		{
+			std::pmr::vector<PbrInstancesData> instances(entities.size());
+			runner.Run("pbr pack instances", parameter, entityCount, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					for (size_t entity = 0; entity < entities.size(); entity++)
+						instances[entity] = PbrInstancesData{ entities[entity].ModelMatrix };
+					doNotOptimize(instances.data());
+				}
+			});
+		}
+
+		if (runner.IsEnabled("pbr submit"))
+		{
+			PbrRenderingSubmitter submitter(OpenglSettings{ 256 });
+			runner.Run("pbr submit", parameter, entityCount, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					for (auto& entity : entities)
+						submitter.Submit(entity.RenderingUnit, entity.Material, entity.ModelMatrix);
+					submitter.Clear();
+				}
+			});
+		}
+
+		//same work as above, fed from presorted draw list the way worker buckets deliver it
+		if (runner.IsEnabled("pbr merge sorted"))
+		{
+			std::pmr::vector<PbrDrawListItem> items;
+			items.reserve(entities.size());
+			for (auto& entity : entities)
+				items.push_back(PbrDrawListItem{ getPbrCacheId(entity.RenderingUnit.Vao, entity.Material),
+					entity.RenderingUnit, PbrInstancesData{ entity.ModelMatrix } });
+			std::sort(items.begin(), items.end(), [](const auto& left, const auto& right)
+			{
+				return left.Key < right.Key;
+			});
+
+			PbrRenderingSubmitter submitter(OpenglSettings{ 256 });
+			runner.Run("pbr merge sorted", parameter, entityCount, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					submitter.Merge(items);
+					submitter.Clear();
+				}
+			});
+		}
+	}
+}
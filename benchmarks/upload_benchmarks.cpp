@@ -0,0 +1,84 @@
+#include <microbenchmark.h>
+
+#include <rendering/rendering_tmp.h>
+#include <rendering/texture_streamer.h>
+
+constexpr size_t BufferSizeMeshCount = 4096;
+
+
+dengine::Mesh makeSyntheticMesh(size_t vertexCount)
+{
+	dengine::Mesh mesh;
+	mesh.Positions.resize(vertexCount, glm::vec3(1.0f, 2.0f, 3.0f));
+	mesh.Normals.resize(vertexCount, glm::vec3(0.0f, 1.0f, 0.0f));
+	mesh.Tangents.resize(vertexCount, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+	mesh.UVs.resize(vertexCount, glm::vec2(0.5f));
+	mesh.Indecies.resize(vertexCount);
+	mesh.MaterialIndex = 0;
+	return mesh;
+}
+
+
+void dengine::runUploadBenchmarks(MicrobenchmarkRunner& runner)
+{
+	if (runner.IsEnabled("calculate buffer size"))
+	{
+		std::pmr::vector<Mesh> meshes;
+		for (size_t i = 0; i < BufferSizeMeshCount; i++)
+			meshes.push_back(makeSyntheticMesh(i % 64 + 1));
+		runner.Run("calculate buffer size", BufferSizeMeshCount, BufferSizeMeshCount, [&](unsigned long long iterations)
+		{
+			for (unsigned long long i = 0; i < iterations; i++)
+			{
+				unsigned long long totalSize = 0;
+				for (auto& mesh : meshes)
+					totalSize += calculateBufferSize(mesh);
+				doNotOptimize(totalSize);
+			}
+		});
+	}
+
+	if (runner.IsEnabled("pack vertex data"))
+	{
+		for (size_t vertexCount : { 1'000, 65'536, 1'000'000 })
+		{
+			const auto mesh = makeSyntheticMesh(vertexCount);
+			std::pmr::vector<unsigned char> stagingBuffer(calculateBufferSize(mesh));
+			runner.Run("pack vertex data", static_cast<long long>(vertexCount), vertexCount, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					auto vertexLayouts = packVertexData(mesh, stagingBuffer.data());
+					doNotOptimize(vertexLayouts);
+					doNotOptimize(stagingBuffer.front());
+				}
+			});
+		}
+	}
+
+	//cpu side of registering streamed texture, every level is box filtered from previous one
+	if (runner.IsEnabled("texture mip chain"))
+	{
+		for (int size : { 512, 2048, 4096 })
+		{
+			const size_t texelCount = static_cast<size_t>(size) * size;
+			std::pmr::vector<unsigned char> texels(texelCount * 4 * 4 / 3 + 4);
+			for (size_t i = 0; i < texelCount * 4; i++)
+				texels[i] = static_cast<unsigned char>(i * 31);
+			runner.Run("texture mip chain", size, texelCount, [&](unsigned long long iterations)
+			{
+				for (unsigned long long i = 0; i < iterations; i++)
+				{
+					size_t offset = 0;
+					for (int levelSize = size; levelSize > 1; levelSize /= 2)
+					{
+						const size_t nextOffset = offset + static_cast<size_t>(levelSize) * levelSize * 4;
+						downsampleTextureLevel(texels.data() + offset, levelSize, levelSize, texels.data() + nextOffset);
+						offset = nextOffset;
+					}
+					doNotOptimize(texels.back());
+				}
+			});
+		}
+	}
+}
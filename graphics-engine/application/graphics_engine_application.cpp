@@ -16,20 +16,36 @@
 #include <rendering/rendering_tmp.h>
 #include <rendering/camera.hpp>
 #include <rendering/global_environment.h>
-#include <rendering/schemas/blin_fong_rendering_scheme.h>
-#include <rendering/schemas/pbr_rendering_scheme.h>
+#include <rendering/gpu_timer.h>
+#include <rendering/scene_renderer.h>
+//benchmarking
+#include <benchmarking/camera_path.h>
+//profiling
+#include <profiling/gpu_profiler.h>
+#include <profiling/profiler_panel.h>
+#include <profiling/memory_panel.h>
+//scene
+#include <scene/scene_components.h>
+//utils
+#include <utils/directory_watcher.h>
 
-const char* OpenGlLoggerName = "opengl_logger";
-const char* AppLoggerName = "app_logger";
+const char* dengine::OpenGlLoggerName = "opengl_logger";
+const char* dengine::AppLoggerName = "app_logger";
 
 
 
 bool dengine::GraphicsEngineApplication::Terminate()
 {
-	//Terminate ImGui
-	ImGui_ImplOpenGL3_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
-	ImGui::DestroyContext();
+	//queries belong to context, release them while it is alive
+	GpuProfiler::Get().Shutdown();
+
+	//Terminate ImGui, initialization may have failed before it was created
+	if (ImGui::GetCurrentContext() != nullptr)
+	{
+		ImGui_ImplOpenGL3_Shutdown();
+		ImGui_ImplGlfw_Shutdown();
+		ImGui::DestroyContext();
+	}
 
 	//Terminate GLFW
 	if (window != nullptr)
@@ -39,17 +55,7 @@ bool dengine::GraphicsEngineApplication::Terminate()
 }
 
 
-struct TransformComponent{
-	glm::mat4 ModelMatrix;
-};
-
-struct LightComponent{
-	glm::vec4 Position;
-	glm::vec4 Color;
-};
-
-
-void GLAPIENTRY MessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+void GLAPIENTRY dengine::openglMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
                                 const GLchar* message, const void* userParam)
 {
 	auto openglLogger = spdlog::get(OpenGlLoggerName);
@@ -60,6 +66,15 @@ void GLAPIENTRY MessageCallback(GLenum source, GLenum type, GLuint id, GLenum se
 
 float cameraSpeed = 7.5f;
 float cameraRotationSpeed = 0.0005f;
+//smoothing factor of displayed frame time, higher reacts faster
+constexpr float FrameTimeSmoothing = 0.05f;
+//recorded camera paths are replayed by headless benchmark mode
+constexpr float CameraPathKeyInterval = 0.1f;
+const char* RecordedCameraPathFile = "camera-path.campath";
+const char* CapturedDrawStreamFile = "frame.dstream";
+const char* ShaderDirectory = "shaders";
+//on-demand rendering still wakes this often, so shader watcher and ui animations keep going
+constexpr double IdleWaitTimeout = 0.25;
 
 
 void UpdateCamera(dengine::Camera& cam, float dTime)
@@ -92,121 +107,76 @@ void UpdateRotateCamera(dengine::Camera& cam, float xPitch, float yYaw)
 
 int dengine::GraphicsEngineApplication::RunInternal(GraphicsEngineRunArguments& runArguments)
 {
-	//load models
-	auto model = modelImporter.Import(runArguments.pathToModel);
-	auto openglModel = loadModelToGpu(model);
-	model.Materials.clear();
-	model.Meshes.clear();
-	model.Textures.clear();
-
 	int uniformBufferAlignment;
 	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferAlignment);
 	OpenglSettings openglSettings{ uniformBufferAlignment };
 
-	//make vaos
-	for (int i = 0; i < openglModel.Meshes.size(); i++)
-	{
-		auto simpleRenderinUnit = PbrRenderingScheme::CreateRenderingUnit(openglModel.Meshes[i], openglSettings);
-		auto entity = registry.create();
-		registry.emplace<PbrRenderingUnit>(entity, simpleRenderinUnit);
-		registry.emplace<TransformComponent>(entity, glm::mat4{1.0f});
-		Material material{
-			openglModel.Materils[openglModel.Meshes[i].MaterialIndex].DiffuseTextureId,
-			openglModel.Materils[openglModel.Meshes[i].MaterialIndex].NormalTextureId,
-			openglModel.Materils[openglModel.Meshes[i].MaterialIndex].MetalnessTextureId,
-		};
-		registry.emplace<Material>(entity, material);
-	}
-
-	//load shader program and compile it
-	PbrRenderingScheme renderingScheme;
-	auto program = renderingScheme.LoadShaderProgram();
-
-
-	glEnable(GL_DEPTH_TEST);
-
-	//CreateRenderBuffer
-	unsigned int fbo, depthTexture, colorAttachmentTexture;
-	glCreateFramebuffers(1, &fbo);
-	glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture);
-	glCreateTextures(GL_TEXTURE_2D, 1, &colorAttachmentTexture);
-	glTextureStorage2D(depthTexture, 1, GL_DEPTH24_STENCIL8, 1920, 1080);
-	glTextureStorage2D(colorAttachmentTexture, 1, GL_RGBA8, 1920, 1080);
-	glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, depthTexture, 0);
-	glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, colorAttachmentTexture, 0);
-
-	GLenum drawBuffs[1] = {GL_COLOR_ATTACHMENT0};
-	glNamedFramebufferDrawBuffers(fbo, 1, drawBuffs);
+	modelImporter.SetTangentGeneration(runArguments.tangentGeneration);
+	SceneRenderer sceneRenderer(registry, threadPool, modelImporter, openglSettings);
+	if (!sceneRenderer.LoadScene(runArguments.pathToModel))
+		return -1;
+	if (!runArguments.environmentPath.empty() && !sceneRenderer.LoadEnvironment(runArguments.environmentPath))
+		return -1;
+	auto& rendererSettings = sceneRenderer.GetSettings();
 
 	Camera camera{glm::vec3(-2.967f, 2.192f, 1.149f), glm::vec3(0.580f, -0.210f, 0.785f), glm::vec3(0, 1, 0)};
 
-	float color[3] = {33.0f/255.0f, 33.0f / 255.0f, 33.0f / 255.0f};
 	float time = glfwGetTime();
-	ImVec2 currentViewportSize(1920, 1080);
+	float averageFrameTime = 0.0f;
 	ImVec2 tempViewPortSize(1920, 1080);
 
-	//set up global environment
-	GlobalEnvironment globalEnvironment;
-	PbrRenderingSubmitter renderingSubmitter(openglSettings);
-
-	auto lightEntity = registry.create();
-	auto startLightComponent = LightComponent{ glm::vec4(5,3,1,0), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)};
-	registry.emplace<LightComponent>(lightEntity, startLightComponent);
+	//control panel edits first scene light and sun
+	auto lightEntity = registry.view<LightComponent>().front();
+	auto sunEntity = registry.view<DirectionalLightComponent>().front();
+	bool recordingCameraPath = false;
+	float recordingTime = 0.0f;
+	CameraPath recordedCameraPath;
+	//saving any shader recompiles all programs in background
+	DirectoryWatcher shaderWatcher(ShaderDirectory);
+	//scene gpu time drives dynamic resolution
+	GpuFrameTimer gpuTimer;
+	std::pmr::vector<GpuTiming> gpuTimings;
+	size_t frameIndex = 0;
+	bool onDemandRendering = runArguments.onDemandRendering;
+	size_t scenesRendered = 0;
+	size_t frameCount = 0;
 
 
 	while (!glfwWindowShouldClose(window))
 	{
+		DENGINE_PROFILE_FRAME();
+		DENGINE_PROFILE_SCOPE("frame");
 		float newTime = glfwGetTime();
 		float dTime = newTime - time;
 		time = newTime;
+		averageFrameTime += (dTime - averageFrameTime) * FrameTimeSmoothing;
 
 		ImGui_ImplOpenGL3_NewFrame();
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
 
-		if (tempViewPortSize.x != currentViewportSize.x || currentViewportSize.y != tempViewPortSize.y)
-		{
-			glDeleteTextures(1, &colorAttachmentTexture);
-			glDeleteTextures(1, &depthTexture);
-			glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture);
-			glCreateTextures(GL_TEXTURE_2D, 1, &colorAttachmentTexture);
-			glTextureStorage2D(depthTexture, 1, GL_DEPTH24_STENCIL8, tempViewPortSize.x, tempViewPortSize.y);
-			glTextureStorage2D(colorAttachmentTexture, 1, GL_RGBA8, tempViewPortSize.x, tempViewPortSize.y);
-			glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, depthTexture, 0);
-			glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, colorAttachmentTexture, 0);
-			currentViewportSize = tempViewPortSize;
-		}
-
-
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glClearColor(color[0], color[1], color[2], 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		if (shaderWatcher.Poll())
+			sceneRenderer.ReloadShaders();
+		sceneRenderer.Resize(static_cast<int>(tempViewPortSize.x), static_cast<int>(tempViewPortSize.y));
 		auto delta = ImGui::GetIO().MouseDelta;
-
-		int width, height;
-		glfwGetWindowSize(window, &width, &height);
-		auto aspect = currentViewportSize.x / currentViewportSize.y;
-		globalEnvironment.CameraPostion = glm::vec4(camera.Position, 1.0f);
-		globalEnvironment.ProjectionMatrix = glm::perspective(glm::radians(55.0f), aspect, 0.01f, 100.0f);
-		globalEnvironment.ViewMatrix = CameraControl::GetLookAtMatrix(camera);
-
-		auto drawView = registry.view<PbrRenderingUnit, TransformComponent, Material>();
-		for (auto entity : drawView)
+		//clean scene keeps showing color target of its last render
+		if (!onDemandRendering || sceneRenderer.NeedsRender(camera))
 		{
-			auto renderingUnit = drawView.get<PbrRenderingUnit>(entity);
-			auto material = drawView.get<Material>(entity);
-			renderingSubmitter.Submit(renderingUnit, material, glm::mat4(1.0f));
+			gpuTimer.Begin(frameIndex++);
+			sceneRenderer.Render(camera);
+			gpuTimer.End();
+			scenesRendered++;
 		}
-
-		auto view = registry.view<LightComponent>();
-		globalEnvironment.Lights.clear();
-		for (auto entity : view)
+		gpuTimings.clear();
+		gpuTimer.Collect(false, gpuTimings);
+		for (auto& gpuTiming : gpuTimings)
+			sceneRenderer.GetDynamicResolution().Adjust(gpuTiming.Milliseconds);
+		if (recordingCameraPath)
 		{
-			auto lightComponent = view.get<LightComponent>(entity);
-			globalEnvironment.Lights.push_back(LightInfo{ lightComponent.Position, lightComponent.Color });
+			if (recordedCameraPath.Keys.empty() || recordingTime - recordedCameraPath.Keys.back().Time >= CameraPathKeyInterval)
+				recordedCameraPath.Keys.push_back(CameraKey{ recordingTime, camera.Position, camera.Diraction });
+			recordingTime += dTime;
 		}
-		renderingSubmitter.DispatchDrawCall(program, globalEnvironment);
-		renderingSubmitter.Clear();
 
 		//swap to default framebuffer
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -228,7 +198,79 @@ int dengine::GraphicsEngineApplication::RunInternal(GraphicsEngineRunArguments&
 
 		ImGui::Begin("control panel");
 		//Start New ImGui frame
-		ImGui::ColorPicker3("background color", color);
+		ImGui::ColorPicker3("background color", glm::value_ptr(rendererSettings.ClearColor));
+		ImGui::Text("frame time: %.3f ms (%.1f fps)", averageFrameTime * 1000.0f, 1.0f / averageFrameTime);
+		if (ImGui::Checkbox("on-demand rendering", &onDemandRendering))
+			sceneRenderer.Invalidate();
+		if (onDemandRendering)
+			ImGui::Text("scenes rendered: %zu of %zu frames", scenesRendered, frameCount);
+		ImGui::Checkbox("retained draw lists", &rendererSettings.RetainedDrawing);
+		if (rendererSettings.RetainedDrawing)
+			ImGui::Text("draw items: %zu retained", sceneRenderer.GetRetainedDrawList().GetInstanceCount());
+		else
+			ImGui::Text("draw items: %zu visible of %zu", sceneRenderer.GetDrawListBuilder().GetVisibleCount(),
+				sceneRenderer.GetDrawListBuilder().GetTotalCount());
+		ImGui::Checkbox("depth pre-pass", &rendererSettings.DepthPrepass);
+		ImGui::Checkbox("front-to-back sorting", &rendererSettings.FrontToBackSorting);
+		bool lambertLighting = rendererSettings.LightModel == PbrLightModel::Lambert;
+		if (ImGui::Checkbox("lambert lighting", &lambertLighting))
+			rendererSettings.LightModel = lambertLighting ? PbrLightModel::Lambert : PbrLightModel::CookTorrance;
+		bool deferredShading = rendererSettings.ShadingPath == PbrShadingPath::Deferred;
+		if (ImGui::Checkbox("deferred shading", &deferredShading))
+			rendererSettings.ShadingPath = deferredShading ? PbrShadingPath::Deferred : PbrShadingPath::Forward;
+		ImGui::DragFloat("environment intensity", &rendererSettings.EnvironmentIntensity, 0.01f, 0.0f, 10.0f);
+		auto& dynamicResolutionSettings = sceneRenderer.GetDynamicResolution().GetSettings();
+		ImGui::Checkbox("dynamic resolution", &dynamicResolutionSettings.Enabled);
+		if (dynamicResolutionSettings.Enabled)
+		{
+			ImGui::DragFloat("target gpu ms", &dynamicResolutionSettings.TargetMilliseconds, 0.1f, 1.0f, 100.0f);
+			ImGui::DragFloatRange2("render scale", &dynamicResolutionSettings.MinScale, &dynamicResolutionSettings.MaxScale,
+				0.01f, 0.25f, 1.0f);
+			ImGui::SliderFloat("sharpness", &dynamicResolutionSettings.Sharpness, 0.0f, 1.0f);
+			ImGui::Text("render size: %dx%d (scale %.2f)", sceneRenderer.GetRenderSize().x,
+				sceneRenderer.GetRenderSize().y, sceneRenderer.GetDynamicResolution().GetScale());
+		}
+		ImGui::Checkbox("shadows", &rendererSettings.Shadows);
+		if (rendererSettings.Shadows)
+		{
+			auto& shadowSettings = sceneRenderer.GetShadowSettings();
+			const auto& shadowStatistics = sceneRenderer.GetShadowStatistics();
+			ImGui::SliderInt("shadow cascades", &shadowSettings.CascadeCount, 1, MaxShadowCascades);
+			ImGui::DragFloat("shadow distance", &shadowSettings.MaxDistance, 0.5f, 1.0f, 500.0f);
+			ImGui::DragInt("shadow static delay", &shadowSettings.StaticDelay, 1.0f, 1, 600);
+			ImGui::Text("shadow cascades drawn: %u (%u static), %u draws, %zu dynamic entities",
+				shadowStatistics.CascadesRendered, shadowStatistics.StaticCascadesRendered,
+				shadowStatistics.DrawCommands, shadowStatistics.DynamicEntities);
+		}
+		auto& textureStreamingSettings = sceneRenderer.GetTextureStreamingSettings();
+		ImGui::Checkbox("texture streaming", &textureStreamingSettings.Enabled);
+		if (textureStreamingSettings.Enabled)
+		{
+			const auto& textureStreamingStatistics = sceneRenderer.GetTextureStreamingStatistics();
+			int uploadBudgetMegabytes = static_cast<int>(textureStreamingSettings.UploadBudget >> 20);
+			if (ImGui::SliderInt("upload budget mb", &uploadBudgetMegabytes, 1, 256))
+				textureStreamingSettings.UploadBudget = static_cast<long long>(uploadBudgetMegabytes) << 20;
+			ImGui::SliderInt("feedback interval", &textureStreamingSettings.FeedbackInterval, 1, 30);
+			ImGui::Text("textures resident: %.1f of %.1f mb, %zu levels pending, %u uploaded, %u evicted",
+				static_cast<double>(textureStreamingStatistics.ResidentBytes) / (1 << 20),
+				static_cast<double>(textureStreamingStatistics.FullBytes) / (1 << 20), textureStreamingStatistics.PendingLevels,
+				textureStreamingStatistics.UploadedLevels, textureStreamingStatistics.EvictedLevels);
+		}
+		ImGui::Text("shader variants: %zu%s", sceneRenderer.GetProgramVariants().GetCount(),
+			sceneRenderer.IsCompilingShaders() ? ", compiling" : "");
+		if (ImGui::Button("reload shaders"))
+			sceneRenderer.ReloadShaders();
+		if (ImGui::Checkbox("record camera path", &recordingCameraPath))
+		{
+			recordingTime = 0.0f;
+			if (recordingCameraPath)
+				recordedCameraPath.Keys.clear();
+			else if (!writeCameraPath(RecordedCameraPathFile, recordedCameraPath))
+				spdlog::get(AppLoggerName)->error("failed to write camera path {}", RecordedCameraPathFile);
+		}
+		//replay with --headless frame.dstream
+		if (ImGui::Button("capture draw stream"))
+			sceneRenderer.CaptureDrawStream(CapturedDrawStreamFile);
 		ImGui::DragFloat("camera move speed", &cameraSpeed, 1.0f, 0, 50);
 		ImGui::DragFloat("camera rotation speed", &cameraRotationSpeed, 0.0001f, 0, 1);
 		ImGui::DragFloat3("camera position", reinterpret_cast<float*>(&camera.Position), 0.0001f, 0, 1);
@@ -237,6 +279,13 @@ int dengine::GraphicsEngineApplication::RunInternal(GraphicsEngineRunArguments&
 		ImGui::DragFloat4("light position", glm::value_ptr(lightComponent.Position));
 		ImGui::ColorPicker3("light color", glm::value_ptr(lightComponent.Color));
 		ImGui::DragFloat("light intensity", &lightComponent.Color.w);
+		if (sunEntity != entt::null)
+		{
+			auto& sunComponent = registry.get<DirectionalLightComponent>(sunEntity);
+			ImGui::DragFloat3("sun direction", glm::value_ptr(sunComponent.Direction), 0.01f, -1, 1);
+			ImGui::ColorPicker3("sun color", glm::value_ptr(sunComponent.Color));
+			ImGui::DragFloat("sun intensity", &sunComponent.Color.w, 0.01f, 0, 100);
+		}
 
 		ImGui::End();
 
@@ -253,17 +302,39 @@ int dengine::GraphicsEngineApplication::RunInternal(GraphicsEngineRunArguments&
 		{
 			glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 		}
-		ImGui::Image((void*)static_cast<intptr_t>(colorAttachmentTexture),
-		             ImVec2(currentViewportSize.x, currentViewportSize.y), ImVec2(0, 1), ImVec2(1, 0));
+		//targets lag behind viewport size while it is being resized, only their lower left part is shown
+		const auto colorRegion = sceneRenderer.GetColorTextureRegion();
+		ImGui::Image((void*)static_cast<intptr_t>(sceneRenderer.GetColorTexture()),
+		             ImVec2(sceneRenderer.GetWidth(), sceneRenderer.GetHeight()), ImVec2(0, colorRegion.y),
+		             ImVec2(colorRegion.x, 0));
 		ImGui::End();
+
+		drawProfilerPanel();
+		drawMemoryPanel();
 		//Render ImGui frame
 		ImGui::Render();
 
 		//Submit command to GPU(need bound opengl context)
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		{
+			DENGINE_PROFILE_GPU_SCOPE("imgui");
+			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		}
 
+		//settings and light are edited in place, any active widget or splitter may have changed them
+		if (ImGui::IsAnyItemActive())
+			sceneRenderer.Invalidate();
 		glfwSwapBuffers(window);
-		glfwPollEvents();
+		frameCount++;
+		if (onDemandRendering && !recordingCameraPath && !sceneRenderer.NeedsRender(camera))
+		{
+			glfwWaitEventsTimeout(IdleWaitTimeout);
+			//time spent waiting must not move camera on first input after idle
+			time = glfwGetTime();
+		}
+		else
+		{
+			glfwPollEvents();
+		}
 	}
 	return 0;
 }
@@ -271,7 +342,7 @@ int dengine::GraphicsEngineApplication::RunInternal(GraphicsEngineRunArguments&
 
 void glfwErrorCallback(int code, const char* errorMessgae)
 {
-	auto logger = spdlog::get(AppLoggerName);
+	auto logger = spdlog::get(dengine::AppLoggerName);
 	logger->critical(errorMessgae);
 }
 
@@ -306,7 +377,7 @@ bool dengine::GraphicsEngineApplication::Initialize()
 	}
 	// During init, enable debug output
 	glEnable(GL_DEBUG_OUTPUT);
-	glDebugMessageCallback(MessageCallback, nullptr);
+	glDebugMessageCallback(openglMessageCallback, nullptr);
 
 	//Init ImGui
 	IMGUI_CHECKVERSION();
@@ -3,35 +3,38 @@
 
 #include <glad/glad.h>
 #include <importers/assimp_model_importer.h>
+#include <application/run_arguments.h>
 #include <entt/entt.hpp>
 #include <GLFW/glfw3.h>
+#include <BS_thread_pool.hpp>
 
 namespace dengine
 {
+	extern const char* OpenGlLoggerName;
+	extern const char* AppLoggerName;
+	void GLAPIENTRY openglMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+		const GLchar* message, const void* userParam);
 
 	template<typename TRunArguments>
 	class IApplication
 	{
 	public:
 		virtual ~IApplication() = default;
+		//teardown is owned here, RunInternal may return from anywhere once its own objects are released
 		int Run(TRunArguments& runArguments)
 		{
+			int result = -1;
 			try
 			{
-				if (!Initialize())
-				{
-					Terminate();
-					return -1;
-				}
-				return this->RunInternal(runArguments);
+				if (Initialize())
+					result = this->RunInternal(runArguments);
 			}
-			catch (std::exception exception)
+			catch (const std::exception&)
 			{
-				Terminate();
+				result = -1;
 			}
 			Terminate();
-			return -1;
-			
+			return result;
 		}
 	protected:
 		virtual bool Initialize() = 0;
@@ -39,12 +42,6 @@ namespace dengine
 		virtual int RunInternal(TRunArguments& runArguments) = 0;
 	};
 
-	struct GraphicsEngineRunArguments
-	{
-		std::pmr::string pathToModel;
-	};
-
-
 	class GraphicsEngineApplication : public IApplication<GraphicsEngineRunArguments>
 	{
 	public:
@@ -54,8 +51,10 @@ namespace dengine
 		int RunInternal(GraphicsEngineRunArguments& arguments) override;
 		bool Initialize() override;
 	private:
-		GLFWwindow* window;
-		AssimpModelImporter modelImporter;
+		GLFWwindow* window{ nullptr };
+		//declared before importer, which processes meshes on it
+		BS::thread_pool threadPool;
+		AssimpModelImporter modelImporter{ &threadPool };
 		entt::registry registry;
 	};
 }
@@ -0,0 +1,211 @@
+#include <application/headless_application.h>
+
+//stl
+#include <string>
+
+//logging
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/basic_file_sink.h>
+
+//rendering
+#include <rendering/scene_renderer.h>
+#include <rendering/frame_readback.h>
+#include <rendering/draw_stream.h>
+#include <rendering/gpu_timer.h>
+#include <application/headless_run.h>
+//profiling
+#include <profiling/gpu_profiler.h>
+#include <profiling/memory_tracker.h>
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+bool dengine::HeadlessApplication::Initialize()
+{
+	//Enable logger
+	auto logger = spdlog::basic_logger_mt(OpenGlLoggerName, "opengl-logs.txt", true);
+	auto applicationLogger = spdlog::basic_logger_mt(AppLoggerName, "app-logs.txt", true);
+#if defined(__linux__)
+	//surfaceless platform needs no display server, falls back to default display otherwise
+	EGLDisplay display = EGL_NO_DISPLAY;
+	auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+		eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (getPlatformDisplay != nullptr)
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		applicationLogger->critical("Failed to initialize EGL display, error {:#x}", eglGetError());
+		return false;
+	}
+	eglDisplay = display;
+
+	const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config = EGL_NO_CONFIG_KHR;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+		config = EGL_NO_CONFIG_KHR;
+
+	//4.5 core is what mesa llvmpipe reliably exposes
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE,
+	};
+	eglBindAPI(EGL_OPENGL_API);
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT)
+	{
+		applicationLogger->critical("Failed to create OpenGL 4.5 context, error {:#x}", eglGetError());
+		return false;
+	}
+	eglContext = context;
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		applicationLogger->critical("Failed to make surfaceless context current, error {:#x}", eglGetError());
+		return false;
+	}
+	if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)))
+	{
+		applicationLogger->critical("Failed to initialize OpenGL context");
+		return false;
+	}
+	glEnable(GL_DEBUG_OUTPUT);
+	glDebugMessageCallback(openglMessageCallback, nullptr);
+	return true;
+#else
+	applicationLogger->critical("Headless mode requires EGL and is only supported on linux");
+	return false;
+#endif
+}
+
+
+bool dengine::HeadlessApplication::Terminate()
+{
+	GpuProfiler::Get().Shutdown();
+#if defined(__linux__)
+	if (eglDisplay != nullptr)
+	{
+		eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (eglContext != nullptr)
+			eglDestroyContext(eglDisplay, eglContext);
+		eglTerminate(eglDisplay);
+	}
+#endif
+	eglContext = nullptr;
+	eglDisplay = nullptr;
+	return true;
+}
+
+
+int dengine::HeadlessApplication::RunInternal(GraphicsEngineRunArguments& runArguments)
+{
+	auto logger = spdlog::get(AppLoggerName);
+	const auto& headlessArguments = runArguments.headless;
+	modelImporter.SetTangentGeneration(runArguments.tangentGeneration);
+	HeadlessRun headlessRun(headlessArguments);
+	if (!headlessRun.Prepare())
+		return -1;
+
+	int uniformBufferAlignment;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferAlignment);
+	OpenglSettings openglSettings{ uniformBufferAlignment };
+
+	auto& samples = headlessRun.GetSamples();
+	size_t failedWrites = 0;
+	unsigned int lightCount = 0;
+	{
+		//draw stream replays captured dispatch in a loop, camera and scene systems are bypassed
+		const bool replayingDrawStream = isDrawStreamFile(runArguments.pathToModel);
+		SceneRenderer sceneRenderer(registry, threadPool, modelImporter, openglSettings);
+		//variants of chosen path are compiled while scene loads
+		sceneRenderer.GetSettings().ShadingPath = headlessArguments.deferredShading
+			? PbrShadingPath::Deferred : PbrShadingPath::Forward;
+		sceneRenderer.GetSettings().Shadows = headlessArguments.shadows;
+		sceneRenderer.GetSettings().DepthPrepass = headlessArguments.depthPrepass;
+		sceneRenderer.GetSettings().FrontToBackSorting = headlessArguments.frontToBackSorting;
+		auto& textureStreamingSettings = sceneRenderer.GetTextureStreamingSettings();
+		textureStreamingSettings.Enabled = headlessArguments.textureStreaming;
+		textureStreamingSettings.Synchronous = true;
+		if (replayingDrawStream ? !sceneRenderer.LoadDrawStream(runArguments.pathToModel)
+			: !sceneRenderer.LoadScene(runArguments.pathToModel))
+			return -1;
+		if (!runArguments.environmentPath.empty() && !sceneRenderer.LoadEnvironment(runArguments.environmentPath))
+			return -1;
+		sceneRenderer.Resize(headlessArguments.width, headlessArguments.height);
+		//programs link in background, first frames would otherwise miss draws depending on driver speed
+		sceneRenderer.FinishShaderCompilation();
+
+		FrameReadback frameReadback(threadPool);
+		GpuFrameTimer gpuTimer;
+		std::pmr::vector<GpuTiming> gpuTimings;
+		HeadlessFrameCallbacks callbacks;
+		callbacks.Render = [&](int frame, const Camera& camera)
+		{
+			if (frame == headlessArguments.captureFrame && !headlessArguments.captureDrawStreamPath.empty())
+				sceneRenderer.CaptureDrawStream(headlessArguments.captureDrawStreamPath);
+			const bool recorded = frame >= 0;
+			if (recorded)
+				gpuTimer.Begin(frame);
+			if (replayingDrawStream)
+				sceneRenderer.RenderDrawStream();
+			else
+				sceneRenderer.Render(camera);
+			if (recorded)
+				gpuTimer.End();
+		};
+		//submission returns long before gpu is done, wall time of frame waits for it
+		callbacks.Finish = []()
+		{
+			glFinish();
+		};
+		callbacks.Record = [&](int frame, FrameSample& sample)
+		{
+			sample.DrawCalls = sceneRenderer.GetDispatchStatistics().DrawCalls;
+			sample.Instances = sceneRenderer.GetDispatchStatistics().Instances;
+			sample.Triangles = sceneRenderer.GetDispatchStatistics().Triangles;
+			if (headlessRun.IsWritingFrames())
+			{
+				frameReadback.Queue(sceneRenderer.GetFramebuffer(), headlessArguments.width, headlessArguments.height,
+					std::pmr::string(HeadlessRun::GetFramePath(headlessRun.GetOutputDirectory(), frame).string()));
+				frameReadback.Poll(false);
+			}
+			gpuTimer.Collect(false, gpuTimings);
+		};
+		headlessRun.RunFrames(callbacks);
+		frameReadback.Poll(true);
+		gpuTimer.Collect(true, gpuTimings);
+		for (auto& gpuTiming : gpuTimings)
+			samples[gpuTiming.FrameIndex].GpuMilliseconds = gpuTiming.Milliseconds;
+		failedWrites = frameReadback.GetFailedWrites();
+		lightCount = sceneRenderer.GetDispatchStatistics().Lights;
+		if (!headlessArguments.memoryReportPath.empty() &&
+			!writeMemoryReportJson(headlessArguments.memoryReportPath, MemoryTracker::Get().GetReport()))
+			logger->error("failed to write memory report {}", headlessArguments.memoryReportPath.c_str());
+	}
+
+	if (headlessRun.IsBenchmarking())
+	{
+		BenchmarkInfo benchmarkInfo;
+		benchmarkInfo.Scene = runArguments.pathToModel;
+		benchmarkInfo.Renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+		benchmarkInfo.Shading = headlessArguments.deferredShading ? "deferred" : "forward";
+		benchmarkInfo.CpuScope = "submission";
+		benchmarkInfo.Lights = lightCount;
+		benchmarkInfo.DepthPrepass = headlessArguments.depthPrepass;
+		benchmarkInfo.FrontToBackSorting = headlessArguments.frontToBackSorting;
+		benchmarkInfo.Width = headlessArguments.width;
+		benchmarkInfo.Height = headlessArguments.height;
+		benchmarkInfo.Timestep = headlessArguments.timestep;
+		//pre-pass mostly moves gpu time, runs compared with --depth-prepass and --sorting print both
+		headlessRun.Report(benchmarkInfo, std::string(", pre-pass ") + (benchmarkInfo.DepthPrepass ? "on" : "off") +
+			", sorting " + (benchmarkInfo.FrontToBackSorting ? "on" : "off"));
+	}
+	return headlessRun.Finish("headless", failedWrites);
+}
@@ -0,0 +1,27 @@
+#ifndef HEADLESS_APPLICATION_INCLUDED
+#define HEADLESS_APPLICATION_INCLUDED
+
+#include <application/graphics_engine_application.h>
+
+namespace dengine
+{
+	//renders scene into image files through surfaceless EGL context, no window or ui is created
+	class HeadlessApplication : public IApplication<GraphicsEngineRunArguments>
+	{
+	public:
+		HeadlessApplication() = default;
+	protected:
+		bool Terminate() override;
+		int RunInternal(GraphicsEngineRunArguments& arguments) override;
+		bool Initialize() override;
+	private:
+		void* eglDisplay{ nullptr };
+		void* eglContext{ nullptr };
+		//declared before importer, which processes meshes on it
+		BS::thread_pool threadPool;
+		AssimpModelImporter modelImporter{ &threadPool };
+		entt::registry registry;
+	};
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include <application/headless_run.h>
+
+//stl
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+//logging
+#include <spdlog/spdlog.h>
+
+#include <application/graphics_engine_application.h>
+//profiling
+#include <profiling/gpu_profiler.h>
+
+
+dengine::HeadlessRun::HeadlessRun(const HeadlessArguments& arguments) : arguments(arguments),
+	staticCamera{ arguments.cameraPosition, glm::normalize(arguments.cameraDirection), glm::vec3(0, 1, 0) },
+	outputDirectory(arguments.outputDirectory.empty() ? "." : arguments.outputDirectory.c_str()),
+	samples(arguments.frames)
+{
+}
+
+
+bool dengine::HeadlessRun::Prepare()
+{
+	if (IsWritingFrames())
+	{
+		std::error_code error;
+		std::filesystem::create_directories(outputDirectory, error);
+	}
+
+	//scripted or recorded path replaces static camera, sampled at fixed timestep so runs are reproducible
+	if (!arguments.cameraPathFile.empty())
+		return loadCameraPath(arguments.cameraPathFile, cameraPath);
+	if (arguments.orbit)
+		cameraPath = makeOrbitCameraPath(glm::vec3(0.0f), arguments.orbitRadius, arguments.orbitHeight,
+			arguments.timestep * static_cast<float>(arguments.frames));
+	return true;
+}
+
+
+bool dengine::HeadlessRun::IsBenchmarking() const
+{
+	return !arguments.benchmark.jsonPath.empty() || !arguments.benchmark.csvPath.empty();
+}
+
+
+bool dengine::HeadlessRun::IsWritingFrames() const
+{
+	return !arguments.outputDirectory.empty() || !IsBenchmarking();
+}
+
+
+const std::filesystem::path& dengine::HeadlessRun::GetOutputDirectory() const
+{
+	return outputDirectory;
+}
+
+
+std::filesystem::path dengine::HeadlessRun::GetFramePath(const std::filesystem::path& directory, int frame)
+{
+	char fileName[32];
+	std::snprintf(fileName, sizeof(fileName), "frame_%04d.png", frame);
+	return directory / fileName;
+}
+
+
+void dengine::HeadlessRun::RunFrames(const HeadlessFrameCallbacks& callbacks)
+{
+	const int warmupFrames = IsBenchmarking() ? arguments.benchmark.warmupFrames : 0;
+	for (int frame = -warmupFrames; frame < arguments.frames; frame++)
+	{
+		DENGINE_PROFILE_FRAME();
+		DENGINE_PROFILE_SCOPE("frame");
+		//warmup frames render first key and are not recorded
+		const float time = arguments.timestep * static_cast<float>(std::max(frame, 0));
+		const Camera camera = cameraPath.Keys.empty() ? staticCamera : cameraPath.Sample(time);
+
+		const auto frameStart = std::chrono::steady_clock::now();
+		callbacks.Render(frame, camera);
+		const auto renderEnd = std::chrono::steady_clock::now();
+		if (callbacks.Finish)
+			callbacks.Finish();
+		if (frame < 0)
+			continue;
+
+		auto& sample = samples[frame];
+		sample.CpuMilliseconds = std::chrono::duration<double, std::milli>(renderEnd - frameStart).count();
+		sample.WallMilliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - frameStart).count();
+		callbacks.Record(frame, sample);
+	}
+}
+
+
+std::pmr::vector<dengine::FrameSample>& dengine::HeadlessRun::GetSamples()
+{
+	return samples;
+}
+
+
+void dengine::HeadlessRun::Report(const BenchmarkInfo& info, const std::string& details) const
+{
+	auto logger = spdlog::get(AppLoggerName);
+	const auto& benchmarkArguments = arguments.benchmark;
+	if (!benchmarkArguments.jsonPath.empty() && !writeBenchmarkJson(benchmarkArguments.jsonPath, info, samples))
+		logger->error("failed to write benchmark report {}", benchmarkArguments.jsonPath.c_str());
+	if (!benchmarkArguments.csvPath.empty() && !writeBenchmarkCsv(benchmarkArguments.csvPath, samples))
+		logger->error("failed to write benchmark frames {}", benchmarkArguments.csvPath.c_str());
+
+	//gpu line only for renderers with timer queries, their unread frames stay negative
+	std::pmr::vector<double> cpuTimes;
+	std::pmr::vector<double> wallTimes;
+	std::pmr::vector<double> gpuTimes;
+	for (auto& sample : samples)
+	{
+		cpuTimes.push_back(sample.CpuMilliseconds);
+		wallTimes.push_back(sample.WallMilliseconds);
+		if (sample.GpuMilliseconds >= 0.0)
+			gpuTimes.push_back(sample.GpuMilliseconds);
+	}
+	const auto cpuSummary = summarizeValues(std::move(cpuTimes));
+	const auto wallSummary = summarizeValues(std::move(wallTimes));
+	std::printf("%s: %d frames, %s shading, %u lights%s\n  cpu ms (%s): mean %.3f p50 %.3f p95 %.3f p99 %.3f\n"
+		"  wall ms: mean %.3f p50 %.3f p95 %.3f p99 %.3f\n", info.Renderer.c_str(), arguments.frames, info.Shading.c_str(),
+		info.Lights, details.c_str(), info.CpuScope.c_str(), cpuSummary.Mean, cpuSummary.P50, cpuSummary.P95,
+		cpuSummary.P99, wallSummary.Mean, wallSummary.P50, wallSummary.P95, wallSummary.P99);
+	if (!gpuTimes.empty())
+	{
+		const auto gpuSummary = summarizeValues(std::move(gpuTimes));
+		std::printf("  gpu ms: mean %.3f p50 %.3f p95 %.3f p99 %.3f\n", gpuSummary.Mean, gpuSummary.P50, gpuSummary.P95,
+			gpuSummary.P99);
+	}
+}
+
+
+int dengine::HeadlessRun::Finish(const char* renderer, size_t failedWrites) const
+{
+	if (IsWritingFrames())
+		spdlog::get(AppLoggerName)->info("{} run finished, {} frames written to {}", renderer,
+			static_cast<size_t>(arguments.frames) - failedWrites, outputDirectory.string());
+	return failedWrites == 0 ? 0 : -1;
+}
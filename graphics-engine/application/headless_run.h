@@ -0,0 +1,56 @@
+#ifndef HEADLESS_RUN_INCLUDED
+#define HEADLESS_RUN_INCLUDED
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <rendering/camera.hpp>
+#include <application/run_arguments.h>
+#include <benchmarking/camera_path.h>
+#include <benchmarking/frame_statistics.h>
+
+namespace dengine
+{
+	//renderer specific part of headless frame loop
+	struct HeadlessFrameCallbacks {
+		//draws frame, negative frames are warmup and are not recorded
+		std::function<void(int frame, const Camera& camera)> Render;
+		//waits until image of rendered frame is complete, wall time is taken after it; unset when Render already
+		//finishes frame
+		std::function<void()> Finish;
+		//fills counters of recorded frame and hands its image over, runs after cpu time of frame is taken
+		std::function<void(int frame, FrameSample& sample)> Record;
+	};
+
+
+	//camera path, output directory, frame loop and reports shared by opengl and software headless runs,
+	//so every renderer sees same cameras at same frames and writes same files
+	class HeadlessRun {
+	public:
+		explicit HeadlessRun(const HeadlessArguments& arguments);
+
+		//loads camera path and creates output directory, false when camera path can not be read
+		bool Prepare();
+		bool IsBenchmarking() const;
+		bool IsWritingFrames() const;
+		const std::filesystem::path& GetOutputDirectory() const;
+		//frame_NNNN.png of frame in given directory
+		static std::filesystem::path GetFramePath(const std::filesystem::path& directory, int frame);
+		void RunFrames(const HeadlessFrameCallbacks& callbacks);
+		std::pmr::vector<FrameSample>& GetSamples();
+		//writes json and csv reports and prints summary, details follow light count on its first line
+		void Report(const BenchmarkInfo& info, const std::string& details) const;
+		//logs where frames went, returns exit code of run
+		int Finish(const char* renderer, size_t failedWrites) const;
+	private:
+		const HeadlessArguments& arguments;
+		CameraPath cameraPath;
+		Camera staticCamera;
+		std::filesystem::path outputDirectory;
+		std::pmr::vector<FrameSample> samples;
+	};
+}
+
+#endif
@@ -0,0 +1,290 @@
+#include <application/run_arguments.h>
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+
+template<typename TValue>
+bool parseValue(const char* text, TValue& value)
+{
+	const char* textEnd = text + std::strlen(text);
+	auto [ptr, error] = std::from_chars(text, textEnd, value);
+	return error == std::errc() && ptr == textEnd;
+}
+
+
+bool parseGeneratorArguments(int argc, char* argv[], dengine::SceneGeneratorArguments& arguments)
+{
+	arguments.enabled = true;
+	for (int i = 2; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--output") == 0 && hasValue)
+			arguments.outputPath = argv[++i];
+		else if (std::strcmp(argv[i], "--model") == 0 && hasValue)
+			arguments.modelPaths.push_back(argv[++i]);
+		else if (std::strcmp(argv[i], "--instances") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.gridSettings.InstanceCount))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--spacing") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.gridSettings.Spacing))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--scale-jitter") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.gridSettings.ScaleJitter))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--lights") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.lightsSettings.LightCount))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--seed") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.gridSettings.Seed))
+				return false;
+			arguments.lightsSettings.Seed = arguments.gridSettings.Seed;
+		}
+		else
+			return false;
+	}
+	return !arguments.outputPath.empty() && !arguments.modelPaths.empty();
+}
+
+
+bool parseVec3(int argc, char* argv[], int& i, glm::vec3& value)
+{
+	if (i + 3 >= argc)
+		return false;
+	return parseValue(argv[++i], value.x) && parseValue(argv[++i], value.y) && parseValue(argv[++i], value.z);
+}
+
+
+bool parseTangentGeneration(const char* value, dengine::TangentGeneration& tangentGeneration)
+{
+	if (std::strcmp(value, "assimp") == 0)
+		tangentGeneration = dengine::TangentGeneration::Assimp;
+	else if (std::strcmp(value, "batched") == 0)
+		tangentGeneration = dengine::TangentGeneration::Batched;
+	else
+		return false;
+	return true;
+}
+
+
+bool parseHeadlessArguments(int argc, char* argv[], dengine::GraphicsEngineRunArguments& runArguments)
+{
+	auto& arguments = runArguments.headless;
+	arguments.enabled = true;
+	if (argc < 3)
+		return false;
+	runArguments.pathToModel = argv[2];
+	for (int i = 3; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--output-dir") == 0 && hasValue)
+			arguments.outputDirectory = argv[++i];
+		else if (std::strcmp(argv[i], "--width") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.width))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--height") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.height))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.frames))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--camera-position") == 0)
+		{
+			if (!parseVec3(argc, argv, i, arguments.cameraPosition))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--camera-direction") == 0)
+		{
+			if (!parseVec3(argc, argv, i, arguments.cameraDirection))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--camera-path") == 0 && hasValue)
+			arguments.cameraPathFile = argv[++i];
+		else if (std::strcmp(argv[i], "--orbit") == 0 && i + 2 < argc)
+		{
+			arguments.orbit = true;
+			if (!parseValue(argv[++i], arguments.orbitRadius) || !parseValue(argv[++i], arguments.orbitHeight))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--timestep") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.timestep))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.benchmark.warmupFrames))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--benchmark-json") == 0 && hasValue)
+			arguments.benchmark.jsonPath = argv[++i];
+		else if (std::strcmp(argv[i], "--benchmark-csv") == 0 && hasValue)
+			arguments.benchmark.csvPath = argv[++i];
+		else if (std::strcmp(argv[i], "--memory-report") == 0 && hasValue)
+			arguments.memoryReportPath = argv[++i];
+		else if (std::strcmp(argv[i], "--capture-draw-stream") == 0 && hasValue)
+			arguments.captureDrawStreamPath = argv[++i];
+		else if (std::strcmp(argv[i], "--capture-frame") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.captureFrame))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--environment") == 0 && hasValue)
+			runArguments.environmentPath = argv[++i];
+		else if (std::strcmp(argv[i], "--tangents") == 0 && hasValue)
+		{
+			if (!parseTangentGeneration(argv[++i], runArguments.tangentGeneration))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--shading") == 0 && hasValue)
+		{
+			const char* shadingPath = argv[++i];
+			if (std::strcmp(shadingPath, "deferred") != 0 && std::strcmp(shadingPath, "forward") != 0)
+				return false;
+			arguments.deferredShading = std::strcmp(shadingPath, "deferred") == 0;
+		}
+		else if (std::strcmp(argv[i], "--shadows") == 0 && hasValue)
+		{
+			const char* shadows = argv[++i];
+			if (std::strcmp(shadows, "on") != 0 && std::strcmp(shadows, "off") != 0)
+				return false;
+			arguments.shadows = std::strcmp(shadows, "on") == 0;
+		}
+		else if (std::strcmp(argv[i], "--depth-prepass") == 0 && hasValue)
+		{
+			const char* depthPrepass = argv[++i];
+			if (std::strcmp(depthPrepass, "on") != 0 && std::strcmp(depthPrepass, "off") != 0)
+				return false;
+			arguments.depthPrepass = std::strcmp(depthPrepass, "on") == 0;
+		}
+		else if (std::strcmp(argv[i], "--sorting") == 0 && hasValue)
+		{
+			const char* sorting = argv[++i];
+			if (std::strcmp(sorting, "on") != 0 && std::strcmp(sorting, "off") != 0)
+				return false;
+			arguments.frontToBackSorting = std::strcmp(sorting, "on") == 0;
+		}
+		else if (std::strcmp(argv[i], "--texture-streaming") == 0 && hasValue)
+		{
+			const char* textureStreaming = argv[++i];
+			if (std::strcmp(textureStreaming, "on") != 0 && std::strcmp(textureStreaming, "off") != 0)
+				return false;
+			arguments.textureStreaming = std::strcmp(textureStreaming, "on") == 0;
+		}
+		else if (std::strcmp(argv[i], "--renderer") == 0 && hasValue)
+		{
+			const char* renderer = argv[++i];
+			if (std::strcmp(renderer, "opengl") == 0)
+				arguments.renderer = dengine::HeadlessRenderer::OpenGl;
+			else if (std::strcmp(renderer, "software") == 0)
+				arguments.renderer = dengine::HeadlessRenderer::SoftwareRasterizer;
+			else if (std::strcmp(renderer, "pathtracer") == 0)
+				arguments.renderer = dengine::HeadlessRenderer::PathTracer;
+			else
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--samples") == 0 && hasValue)
+		{
+			if (!parseValue(argv[++i], arguments.pathTracerSamples))
+				return false;
+		}
+		else if (std::strcmp(argv[i], "--compare-dir") == 0 && hasValue)
+			arguments.compareDirectory = argv[++i];
+		else if (std::strcmp(argv[i], "--software-shading") == 0 && hasValue)
+		{
+			const char* shading = argv[++i];
+			if (std::strcmp(shading, "cook-torrance") == 0)
+				arguments.softwareShading = dengine::SoftwareShading::CookTorrance;
+			else if (std::strcmp(shading, "lambert") == 0)
+				arguments.softwareShading = dengine::SoftwareShading::Lambert;
+			else if (std::strcmp(shading, "blinn-phong") == 0)
+				arguments.softwareShading = dengine::SoftwareShading::BlinnPhong;
+			else
+				return false;
+		}
+		else
+			return false;
+	}
+	return arguments.width > 0 && arguments.height > 0 && arguments.frames > 0 && arguments.timestep > 0.0f &&
+		arguments.benchmark.warmupFrames >= 0 && arguments.pathTracerSamples > 0 && arguments.captureFrame >= 0 &&
+		arguments.captureFrame < arguments.frames;
+}
+
+
+bool dengine::parseRunArguments(int argc, char* argv[], GraphicsEngineRunArguments& runArguments)
+{
+	if (argc < 2)
+		return false;
+	if (std::strcmp(argv[1], "--generate-scene") == 0)
+		return parseGeneratorArguments(argc, argv, runArguments.sceneGenerator);
+	if (std::strcmp(argv[1], "--headless") == 0)
+		return parseHeadlessArguments(argc, argv, runArguments);
+
+	runArguments.pathToModel = argv[1];
+	for (int i = 2; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--environment") == 0 && hasValue)
+			runArguments.environmentPath = argv[++i];
+		else if (std::strcmp(argv[i], "--on-demand") == 0)
+			runArguments.onDemandRendering = true;
+		else if (std::strcmp(argv[i], "--tangents") == 0 && hasValue)
+		{
+			if (!parseTangentGeneration(argv[++i], runArguments.tangentGeneration))
+				return false;
+		}
+		else
+			return false;
+	}
+	return true;
+}
+
+
+void dengine::printUsage()
+{
+	std::printf(
+		"usage:\n"
+		"  graphics-engine <model file | scene.dscene> [--environment <file.hdr>] [--on-demand] [--tangents assimp|batched]\n"
+		"  graphics-engine --generate-scene --output <scene.dscene> --model <path> [--model <path> ...]\n"
+		"                  [--instances N] [--spacing S] [--scale-jitter J] [--lights N] [--seed S]\n"
+		"  graphics-engine --headless <model file | scene.dscene | frame.dstream> [--output-dir DIR] [--width W] [--height H]\n"
+		"                  [--frames N] [--camera-position X Y Z] [--camera-direction X Y Z]\n"
+		"                  [--camera-path <path.campath> | --orbit RADIUS HEIGHT] [--timestep S]\n"
+		"                  [--benchmark-json <file>] [--benchmark-csv <file>] [--warmup N]\n"
+		"                  [--memory-report <file>] [--capture-draw-stream <file.dstream>] [--capture-frame N]\n"
+		"                  [--shading forward|deferred] [--shadows on|off] [--depth-prepass on|off] [--sorting on|off]\n"
+		"                  [--environment <file.hdr>]\n"
+		"                  [--renderer opengl|software|pathtracer] [--software-shading cook-torrance|lambert|blinn-phong]\n"
+		"                  [--samples N] [--compare-dir DIR] [--tangents assimp|batched] [--texture-streaming on|off]\n");
+}
+
+
+int dengine::runSceneGenerator(const SceneGeneratorArguments& arguments)
+{
+	auto sceneDescription = generateGridScene(arguments.modelPaths, arguments.gridSettings);
+	generateRandomLights(sceneDescription, arguments.lightsSettings);
+	if (!writeSceneDescription(arguments.outputPath, sceneDescription))
+	{
+		std::fprintf(stderr, "failed to write scene to %s\n", arguments.outputPath.c_str());
+		return -1;
+	}
+	std::printf("generated %s: %zu instances, %zu lights\n", arguments.outputPath.c_str(),
+		sceneDescription.Instances.size(), sceneDescription.Lights.size());
+	return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef RUN_ARGUMENTS_INCLUDED
+#define RUN_ARGUMENTS_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <scene/scene_generator.h>
+#include <importers/mesh_processing.h>
+#include <rendering/software/software_rasterizer.h>
+
+namespace dengine
+{
+	struct SceneGeneratorArguments {
+		bool enabled{ false };
+		std::pmr::string outputPath;
+		std::pmr::vector<std::pmr::string> modelPaths;
+		GridSceneSettings gridSettings;
+		RandomLightsSettings lightsSettings;
+	};
+
+	struct BenchmarkArguments {
+		//benchmark runs when at least one report path is set
+		std::pmr::string jsonPath;
+		std::pmr::string csvPath;
+		int warmupFrames{ 0 };
+	};
+
+	enum class HeadlessRenderer {
+		OpenGl,
+		SoftwareRasterizer,
+		PathTracer,
+	};
+
+	struct HeadlessArguments {
+		bool enabled{ false };
+		//frames are written when set or when not benchmarking, current directory by default
+		std::pmr::string outputDirectory;
+		int width{ 1920 };
+		int height{ 1080 };
+		int frames{ 1 };
+		//camera path time advances by fixed timestep per frame
+		float timestep{ 1.0f / 60.0f };
+		glm::vec3 cameraPosition{ -2.967f, 2.192f, 1.149f };
+		glm::vec3 cameraDirection{ 0.580f, -0.210f, 0.785f };
+		std::pmr::string cameraPathFile;
+		bool orbit{ false };
+		float orbitRadius{ 10.0f };
+		float orbitHeight{ 5.0f };
+		//memory report of last frame, written before scene is released
+		std::pmr::string memoryReportPath;
+		//dispatch of captureFrame is written as draw stream, replayed by passing .dstream as scene
+		std::pmr::string captureDrawStreamPath;
+		int captureFrame{ 0 };
+		//forward or deferred pbr path, compared across light counts of generated scenes
+		bool deferredShading{ false };
+		bool shadows{ true };
+		//pre-pass and sorting are compared by benchmarking same scene with each of them off, draw streams
+		//replay with pre-pass they were captured with
+		bool depthPrepass{ true };
+		bool frontToBackSorting{ true };
+		//off makes every texture level resident before first frame is drawn, so frames are reproducible; on streams
+		//synchronously, feedback and level bands are waited for instead of depending on gpu and worker timing
+		bool textureStreaming{ false };
+		//software renderers run on cpu without gl context, draw streams are not supported by them
+		HeadlessRenderer renderer{ HeadlessRenderer::OpenGl };
+		SoftwareShading softwareShading{ SoftwareShading::CookTorrance };
+		//samples per pixel added every frame, static camera keeps refining one accumulation
+		int pathTracerSamples{ 16 };
+		//software renderers compare frames with same frame index written by earlier run, e.g. path traced
+		//against rasterized
+		std::pmr::string compareDirectory;
+		BenchmarkArguments benchmark;
+	};
+
+	struct GraphicsEngineRunArguments
+	{
+		//model file, .dscene scene description or .dstream draw stream in headless mode
+		std::pmr::string pathToModel;
+		//overrides environment of scene
+		std::pmr::string environmentPath;
+		//window redraws scene only when camera, scene or ui changed
+		bool onDemandRendering{ false };
+		TangentGeneration tangentGeneration{ TangentGeneration::Assimp };
+		SceneGeneratorArguments sceneGenerator;
+		HeadlessArguments headless;
+	};
+
+	bool parseRunArguments(int argc, char* argv[], GraphicsEngineRunArguments& runArguments);
+	void printUsage();
+	int runSceneGenerator(const SceneGeneratorArguments& arguments);
+}
+
+#endif
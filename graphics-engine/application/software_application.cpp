@@ -0,0 +1,187 @@
+#include <application/software_application.h>
+
+//stl
+#include <algorithm>
+#include <cstdio>
+#include <future>
+#include <limits>
+#include <optional>
+#include <string>
+
+//logging
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/basic_file_sink.h>
+
+//rendering
+#include <rendering/draw_stream.h>
+#include <rendering/software/software_rasterizer.h>
+#include <rendering/software/path_tracer.h>
+#include <stb_image_write.h>
+#include <application/headless_run.h>
+//benchmarking
+#include <benchmarking/image_comparison.h>
+//profiling
+#include <profiling/memory_tracker.h>
+
+
+const char* getSoftwareShadingName(dengine::SoftwareShading shading)
+{
+	switch (shading)
+	{
+	case dengine::SoftwareShading::Lambert:
+		return "lambert";
+	case dengine::SoftwareShading::BlinnPhong:
+		return "blinn-phong";
+	default:
+		return "cook-torrance";
+	}
+}
+
+
+bool dengine::SoftwareApplication::Initialize()
+{
+	//Enable logger
+	spdlog::basic_logger_mt(AppLoggerName, "app-logs.txt", true);
+	return true;
+}
+
+
+bool dengine::SoftwareApplication::Terminate()
+{
+	return true;
+}
+
+
+int dengine::SoftwareApplication::RunInternal(GraphicsEngineRunArguments& runArguments)
+{
+	auto logger = spdlog::get(AppLoggerName);
+	const auto& headlessArguments = runArguments.headless;
+	modelImporter.SetTangentGeneration(runArguments.tangentGeneration);
+	if (isDrawStreamFile(runArguments.pathToModel))
+	{
+		logger->critical("draw streams hold gl dispatch and can not be replayed by software renderer");
+		return -1;
+	}
+	if (!headlessArguments.captureDrawStreamPath.empty())
+		logger->warn("software renderer does not capture draw streams, {} is not written",
+			headlessArguments.captureDrawStreamPath.c_str());
+	if (!runArguments.environmentPath.empty())
+		logger->warn("software renderer has no image based lighting, environment {} is ignored",
+			runArguments.environmentPath.c_str());
+	//same camera as gl headless run, so frames and timings of both renderers can be compared directly
+	HeadlessRun headlessRun(headlessArguments);
+	if (!headlessRun.Prepare())
+		return -1;
+
+	SoftwareScene scene(modelImporter);
+	if (!scene.Load(runArguments.pathToModel))
+		return -1;
+	//only chosen renderer allocates its targets
+	const bool pathTracing = headlessArguments.renderer == HeadlessRenderer::PathTracer;
+	std::optional<SoftwareRasterizer> rasterizer;
+	std::optional<PathTracer> pathTracer;
+	if (pathTracing)
+	{
+		pathTracer.emplace(threadPool);
+		pathTracer->Resize(headlessArguments.width, headlessArguments.height);
+		pathTracer->SetScene(scene);
+		logger->info("bvh of {} triangles built with {} nodes", pathTracer->GetBvh().GetTriangleCount(),
+			pathTracer->GetBvh().GetNodeCount());
+	}
+	else
+	{
+		rasterizer.emplace(threadPool);
+		rasterizer->GetSettings().Shading = headlessArguments.softwareShading;
+		rasterizer->Resize(headlessArguments.width, headlessArguments.height);
+	}
+
+	std::pmr::vector<std::future<bool>> writes;
+	unsigned long long tracedRays = 0;
+	double tracingMilliseconds = 0.0;
+	std::pmr::vector<double> comparisonErrors;
+	double minPeakSignalToNoise = std::numeric_limits<double>::infinity();
+	HeadlessFrameCallbacks callbacks;
+	callbacks.Render = [&](int frame, const Camera& camera)
+	{
+		if (pathTracing)
+			pathTracer->Accumulate(camera, headlessArguments.pathTracerSamples);
+		else
+			rasterizer->Render(scene, camera);
+	};
+	//whole frame is cpu time, wall time equals it and gpu time stays unset
+	callbacks.Record = [&](int frame, FrameSample& sample)
+	{
+		if (pathTracing)
+		{
+			sample.Triangles = pathTracer->GetBvh().GetTriangleCount();
+			tracedRays += pathTracer->GetStatistics().Rays;
+			tracingMilliseconds += pathTracer->GetStatistics().Milliseconds;
+		}
+		else
+		{
+			sample.DrawCalls = static_cast<unsigned int>(rasterizer->GetStatistics().VisibleDrawItems);
+			sample.Instances = rasterizer->GetStatistics().VisibleDrawItems;
+			sample.Triangles = rasterizer->GetStatistics().Triangles;
+		}
+		const auto& pixels = pathTracing ? pathTracer->GetColor() : rasterizer->GetColor();
+
+		if (!headlessArguments.compareDirectory.empty())
+		{
+			const auto comparedPath = HeadlessRun::GetFramePath(headlessArguments.compareDirectory.c_str(), frame).string();
+			ImageDifference difference;
+			if (compareWithImageFile(std::pmr::string(comparedPath), pixels.data(), headlessArguments.width,
+				headlessArguments.height, difference))
+			{
+				comparisonErrors.push_back(difference.RootMeanSquareError);
+				minPeakSignalToNoise = std::min(minPeakSignalToNoise, difference.PeakSignalToNoiseRatio);
+				logger->info("frame {} against {}: rmse {:.3f}, psnr {:.2f} dB", frame, comparedPath,
+					difference.RootMeanSquareError, difference.PeakSignalToNoiseRatio);
+			}
+			else
+				logger->error("failed to compare frame {} with {}, file is missing or has different size", frame,
+					comparedPath);
+		}
+		if (headlessRun.IsWritingFrames())
+		{
+			writes.push_back(threadPool.submit([pixels, width = headlessArguments.width, height = headlessArguments.height,
+				filePath = HeadlessRun::GetFramePath(headlessRun.GetOutputDirectory(), frame).string()]()
+			{
+				return stbi_write_png(filePath.c_str(), width, height, 4, pixels.data(), width * 4) != 0;
+			}));
+		}
+	};
+	headlessRun.RunFrames(callbacks);
+
+	size_t failedWrites = 0;
+	for (auto& write : writes)
+		if (!write.get())
+			failedWrites++;
+	if (failedWrites != 0)
+		logger->error("failed to write {} frame images", failedWrites);
+	if (!headlessArguments.memoryReportPath.empty() &&
+		!writeMemoryReportJson(headlessArguments.memoryReportPath, MemoryTracker::Get().GetReport()))
+		logger->error("failed to write memory report {}", headlessArguments.memoryReportPath.c_str());
+	if (!comparisonErrors.empty())
+	{
+		const auto errorSummary = summarizeValues(std::move(comparisonErrors));
+		std::printf("compared with %s: rmse mean %.3f max %.3f, min psnr %.2f dB\n",
+			headlessArguments.compareDirectory.c_str(), errorSummary.Mean, errorSummary.Max, minPeakSignalToNoise);
+	}
+
+	if (headlessRun.IsBenchmarking())
+	{
+		BenchmarkInfo benchmarkInfo;
+		benchmarkInfo.Scene = runArguments.pathToModel;
+		benchmarkInfo.Renderer = pathTracing ? "dengine path tracer" : "dengine software rasterizer";
+		benchmarkInfo.Shading = pathTracing ? "path traced" : getSoftwareShadingName(headlessArguments.softwareShading);
+		benchmarkInfo.Lights = static_cast<unsigned int>(scene.GetLights().size());
+		benchmarkInfo.Width = headlessArguments.width;
+		benchmarkInfo.Height = headlessArguments.height;
+		benchmarkInfo.Timestep = headlessArguments.timestep;
+		headlessRun.Report(benchmarkInfo, ", " + std::to_string(threadPool.get_thread_count()) + " threads");
+		if (pathTracing && tracingMilliseconds > 0.0)
+			std::printf("%d samples per frame, %.2f Mrays/s\n", headlessArguments.pathTracerSamples,
+				static_cast<double>(tracedRays) / (tracingMilliseconds * 1000.0));
+	}
+	return headlessRun.Finish("software", failedWrites);
+}
@@ -0,0 +1,25 @@
+#ifndef SOFTWARE_APPLICATION_INCLUDED
+#define SOFTWARE_APPLICATION_INCLUDED
+
+#include <application/graphics_engine_application.h>
+
+namespace dengine
+{
+	//headless run on software rasterizer or path tracer, takes same arguments and writes same frames and reports
+	//as HeadlessApplication without creating any gl context
+	class SoftwareApplication : public IApplication<GraphicsEngineRunArguments>
+	{
+	public:
+		SoftwareApplication() = default;
+	protected:
+		bool Terminate() override;
+		int RunInternal(GraphicsEngineRunArguments& arguments) override;
+		bool Initialize() override;
+	private:
+		//declared before importer, which processes meshes on it
+		BS::thread_pool threadPool;
+		AssimpModelImporter modelImporter{ &threadPool };
+	};
+}
+
+#endif
@@ -0,0 +1,137 @@
+#include <benchmarking/camera_path.h>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include <glm/gtc/constants.hpp>
+#include <spdlog/spdlog.h>
+
+constexpr int CameraPathFormatVersion = 1;
+
+
+float dengine::CameraPath::GetDuration() const
+{
+	return Keys.empty() ? 0.0f : Keys.back().Time;
+}
+
+
+glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+{
+	const float t2 = t * t;
+	const float t3 = t2 * t;
+	return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+		(3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+
+dengine::Camera dengine::CameraPath::Sample(float time) const
+{
+	if (Keys.empty())
+		return Camera{};
+	if (Keys.size() == 1 || time <= Keys.front().Time)
+		return Camera{ Keys.front().Position, glm::normalize(Keys.front().Direction), glm::vec3(0, 1, 0) };
+	if (time >= Keys.back().Time)
+		return Camera{ Keys.back().Position, glm::normalize(Keys.back().Direction), glm::vec3(0, 1, 0) };
+
+	const auto next = std::upper_bound(Keys.begin(), Keys.end(), time, [](float value, const CameraKey& key)
+	{
+		return value < key.Time;
+	});
+	const size_t i2 = next - Keys.begin();
+	const size_t i1 = i2 - 1;
+	const size_t i0 = i1 > 0 ? i1 - 1 : i1;
+	const size_t i3 = i2 + 1 < Keys.size() ? i2 + 1 : i2;
+	const float span = Keys[i2].Time - Keys[i1].Time;
+	const float t = span > 0.0f ? (time - Keys[i1].Time) / span : 0.0f;
+
+	const auto position = catmullRom(Keys[i0].Position, Keys[i1].Position, Keys[i2].Position, Keys[i3].Position, t);
+	const auto direction = glm::normalize(glm::mix(glm::normalize(Keys[i1].Direction), glm::normalize(Keys[i2].Direction), t));
+	return Camera{ position, direction, glm::vec3(0, 1, 0) };
+}
+
+
+bool dengine::loadCameraPath(const std::pmr::string& path, CameraPath& cameraPath)
+{
+	auto logger = spdlog::get("app_logger");
+	std::ifstream file(path.c_str());
+	if (!file.is_open())
+	{
+		logger->error("failed to open camera path {}", path.c_str());
+		return false;
+	}
+
+	bool headerFound = false;
+	std::string line;
+	for (int lineNumber = 1; std::getline(file, line); lineNumber++)
+	{
+		std::istringstream reader(line);
+		std::string recordType;
+		if (!(reader >> recordType) || recordType[0] == '#')
+			continue;
+
+		bool parsed = true;
+		if (recordType == "campath")
+		{
+			int version = 0;
+			parsed = (reader >> version) && version == CameraPathFormatVersion;
+			headerFound = parsed;
+		}
+		else if (recordType == "key")
+		{
+			CameraKey key;
+			parsed = static_cast<bool>(reader >> key.Time >> key.Position.x >> key.Position.y >> key.Position.z >>
+				key.Direction.x >> key.Direction.y >> key.Direction.z);
+			parsed = parsed && (cameraPath.Keys.empty() || cameraPath.Keys.back().Time <= key.Time);
+			cameraPath.Keys.push_back(key);
+		}
+		else
+			parsed = false;
+
+		//every record ends with its last value, like lines of scene description
+		std::string token;
+		if (parsed && headerFound && reader >> token)
+		{
+			logger->error("{}:{}: unexpected token {} in camera path record", path.c_str(), lineNumber, token);
+			return false;
+		}
+		if (!parsed || !headerFound)
+		{
+			logger->error("{}:{}: malformed camera path record", path.c_str(), lineNumber);
+			return false;
+		}
+	}
+	return headerFound && !cameraPath.Keys.empty();
+}
+
+
+bool dengine::writeCameraPath(const std::pmr::string& path, const CameraPath& cameraPath)
+{
+	std::ofstream file(path.c_str());
+	if (!file.is_open())
+		return false;
+	//enough digits to read back same floats, so replayed path matches recorded camera exactly
+	file.precision(std::numeric_limits<float>::max_digits10);
+	file << "campath " << CameraPathFormatVersion << "\n";
+	for (auto& key : cameraPath.Keys)
+		file << "key " << key.Time << " " << key.Position.x << " " << key.Position.y << " " << key.Position.z << " "
+			<< key.Direction.x << " " << key.Direction.y << " " << key.Direction.z << "\n";
+	return file.good();
+}
+
+
+dengine::CameraPath dengine::makeOrbitCameraPath(const glm::vec3& center, float radius, float height, float duration,
+	unsigned int keyCount)
+{
+	CameraPath cameraPath;
+	keyCount = std::max(keyCount, 2u);
+	for (unsigned int i = 0; i < keyCount; i++)
+	{
+		const float progress = static_cast<float>(i) / static_cast<float>(keyCount - 1);
+		const float angle = progress * glm::two_pi<float>();
+		const glm::vec3 position = center + glm::vec3(radius * glm::cos(angle), height, radius * glm::sin(angle));
+		cameraPath.Keys.push_back(CameraKey{ progress * duration, position, glm::normalize(center - position) });
+	}
+	return cameraPath;
+}
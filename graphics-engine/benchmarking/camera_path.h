@@ -0,0 +1,37 @@
+#ifndef CAMERA_PATH_INCLUDED
+#define CAMERA_PATH_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <rendering/camera.hpp>
+
+namespace dengine
+{
+	//text format, one record per line:
+	//  campath 1
+	//  key <time> <px> <py> <pz> <dx> <dy> <dz>
+	//keys are sorted by time in seconds, '#' starts a comment line
+	struct CameraKey {
+		float Time{ 0.0f };
+		glm::vec3 Position{ 0.0f };
+		glm::vec3 Direction{ 1.0f, 0.0f, 0.0f };
+	};
+
+	struct CameraPath {
+		std::pmr::vector<CameraKey> Keys;
+
+		float GetDuration() const;
+		//catmull-rom through key positions, clamped to path ends
+		Camera Sample(float time) const;
+	};
+
+	bool loadCameraPath(const std::pmr::string& path, CameraPath& cameraPath);
+	bool writeCameraPath(const std::pmr::string& path, const CameraPath& cameraPath);
+	//circles around center looking at it, first and last key coincide
+	CameraPath makeOrbitCameraPath(const glm::vec3& center, float radius, float height, float duration,
+		unsigned int keyCount = 32);
+}
+
+#endif
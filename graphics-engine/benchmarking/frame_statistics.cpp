@@ -0,0 +1,119 @@
+#include <benchmarking/frame_statistics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+
+dengine::StatisticsSummary dengine::summarizeValues(std::pmr::vector<double> values)
+{
+	StatisticsSummary summary;
+	if (values.empty())
+		return summary;
+
+	std::sort(values.begin(), values.end());
+	auto percentile = [&](double fraction)
+	{
+		const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(values.size())));
+		return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+	};
+	summary.Min = values.front();
+	summary.Max = values.back();
+	summary.Mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+	summary.P50 = percentile(0.50);
+	summary.P95 = percentile(0.95);
+	summary.P99 = percentile(0.99);
+	return summary;
+}
+
+
+template<typename TSelector>
+dengine::StatisticsSummary summarizeSamples(const std::pmr::vector<dengine::FrameSample>& samples, TSelector selector)
+{
+	std::pmr::vector<double> values;
+	values.reserve(samples.size());
+	for (auto& sample : samples)
+	{
+		const double value = selector(sample);
+		if (value >= 0.0)
+			values.push_back(value);
+	}
+	return dengine::summarizeValues(std::move(values));
+}
+
+
+void writeJsonSummary(std::FILE* file, const char* name, const dengine::StatisticsSummary& summary, bool last)
+{
+	std::fprintf(file,
+		"  \"%s\": {\"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+		name, summary.Min, summary.Mean, summary.P50, summary.P95, summary.P99, summary.Max, last ? "" : ",");
+}
+
+
+bool dengine::writeBenchmarkJson(const std::pmr::string& path, const BenchmarkInfo& info,
+	const std::pmr::vector<FrameSample>& samples)
+{
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr)
+		return false;
+
+	std::fprintf(file, "{\n  \"scene\": ");
+	writeJsonString(file, info.Scene);
+	std::fprintf(file, ",\n  \"renderer\": ");
+	writeJsonString(file, info.Renderer);
+	std::fprintf(file, ",\n  \"shading\": ");
+	writeJsonString(file, info.Shading);
+	std::fprintf(file, ",\n  \"cpu_scope\": ");
+	writeJsonString(file, info.CpuScope);
+	std::fprintf(file, ",\n  \"lights\": %u", info.Lights);
+	std::fprintf(file, ",\n  \"depth_prepass\": %s,\n  \"sorting\": %s", info.DepthPrepass ? "true" : "false",
+		info.FrontToBackSorting ? "true" : "false");
+	std::fprintf(file, ",\n  \"width\": %d,\n  \"height\": %d,\n  \"timestep\": %.6f,\n  \"frames\": %zu,\n",
+		info.Width, info.Height, info.Timestep, samples.size());
+	writeJsonSummary(file, "cpu_ms", summarizeSamples(samples, [](auto& sample) { return sample.CpuMilliseconds; }), false);
+	writeJsonSummary(file, "wall_ms", summarizeSamples(samples, [](auto& sample) { return sample.WallMilliseconds; }), false);
+	writeJsonSummary(file, "gpu_ms", summarizeSamples(samples, [](auto& sample) { return sample.GpuMilliseconds; }), false);
+	writeJsonSummary(file, "draw_calls", summarizeSamples(samples, [](auto& sample)
+	{
+		return static_cast<double>(sample.DrawCalls);
+	}), false);
+	writeJsonSummary(file, "instances", summarizeSamples(samples, [](auto& sample)
+	{
+		return static_cast<double>(sample.Instances);
+	}), false);
+	writeJsonSummary(file, "triangles", summarizeSamples(samples, [](auto& sample)
+	{
+		return static_cast<double>(sample.Triangles);
+	}), true);
+	std::fprintf(file, "}\n");
+	return std::fclose(file) == 0;
+}
+
+
+bool dengine::writeBenchmarkCsv(const std::pmr::string& path, const std::pmr::vector<FrameSample>& samples)
+{
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr)
+		return false;
+
+	std::fprintf(file, "frame,cpu_ms,wall_ms,gpu_ms,draw_calls,instances,triangles\n");
+	for (size_t i = 0; i < samples.size(); i++)
+		std::fprintf(file, "%zu,%.4f,%.4f,%.4f,%u,%llu,%llu\n", i, samples[i].CpuMilliseconds, samples[i].WallMilliseconds,
+			samples[i].GpuMilliseconds, samples[i].DrawCalls, samples[i].Instances, samples[i].Triangles);
+	return std::fclose(file) == 0;
+}
+
+
+void dengine::writeJsonString(std::FILE* file, std::string_view value)
+{
+	std::fputc('"', file);
+	for (char character : value)
+	{
+		if (character == '"' || character == '\\')
+			std::fputc('\\', file);
+		if (static_cast<unsigned char>(character) >= 0x20)
+			std::fputc(character, file);
+	}
+	std::fputc('"', file);
+}
@@ -0,0 +1,58 @@
+#ifndef FRAME_STATISTICS_INCLUDED
+#define FRAME_STATISTICS_INCLUDED
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dengine
+{
+	struct FrameSample {
+		//render call on cpu; for gl it is command submission only, gpu may still be drawing when it returns
+		double CpuMilliseconds{ 0.0 };
+		//frame start until its image is finished, cpu and gpu together
+		double WallMilliseconds{ 0.0 };
+		//negative while timer query of frame is not read back
+		double GpuMilliseconds{ -1.0 };
+		unsigned int DrawCalls{ 0 };
+		//instances submitted by instanced draws, equals draw items on renderers without instancing
+		unsigned long long Instances{ 0 };
+		unsigned long long Triangles{ 0 };
+	};
+
+	struct StatisticsSummary {
+		double Min{ 0.0 };
+		double Mean{ 0.0 };
+		double P50{ 0.0 };
+		double P95{ 0.0 };
+		double P99{ 0.0 };
+		double Max{ 0.0 };
+	};
+
+	struct BenchmarkInfo {
+		std::pmr::string Scene;
+		std::pmr::string Renderer;
+		//forward or deferred, shading model of software renderer
+		std::pmr::string Shading;
+		//what cpu_ms covers, "submission" for gl renderers, "frame" for software ones
+		std::pmr::string CpuScope{ "frame" };
+		unsigned int Lights{ 0 };
+		//opengl dispatch options, runs differing only in them compare what pre-pass and sorting cost or save
+		bool DepthPrepass{ false };
+		bool FrontToBackSorting{ false };
+		int Width{ 0 };
+		int Height{ 0 };
+		float Timestep{ 0.0f };
+	};
+
+	//nearest rank percentiles, values are taken by copy because they are sorted
+	StatisticsSummary summarizeValues(std::pmr::vector<double> values);
+	bool writeBenchmarkJson(const std::pmr::string& path, const BenchmarkInfo& info,
+		const std::pmr::vector<FrameSample>& samples);
+	bool writeBenchmarkCsv(const std::pmr::string& path, const std::pmr::vector<FrameSample>& samples);
+	//quoted json string, escapes quotes and backslashes and drops control characters; shared by json reports
+	void writeJsonString(std::FILE* file, std::string_view value);
+}
+
+#endif
@@ -0,0 +1,37 @@
+#include <benchmarking/image_comparison.h>
+
+#include <cmath>
+#include <limits>
+#include <stb_image.h>
+
+
+bool dengine::compareWithImageFile(const std::pmr::string& path, const unsigned char* pixels, int width, int height,
+	ImageDifference& difference)
+{
+	int fileWidth, fileHeight, channels;
+	unsigned char* filePixels = stbi_load(path.c_str(), &fileWidth, &fileHeight, &channels, 4);
+	if (filePixels == nullptr)
+		return false;
+	if (fileWidth != width || fileHeight != height)
+	{
+		stbi_image_free(filePixels);
+		return false;
+	}
+
+	//both images are stored top row first, alpha is ignored
+	double squaredError = 0.0;
+	const size_t pixelCount = static_cast<size_t>(width) * height;
+	for (size_t i = 0; i < pixelCount * 4; i++)
+	{
+		if (i % 4 == 3)
+			continue;
+		const double error = static_cast<double>(pixels[i]) - static_cast<double>(filePixels[i]);
+		squaredError += error * error;
+	}
+	stbi_image_free(filePixels);
+	difference.RootMeanSquareError = std::sqrt(squaredError / (pixelCount * 3));
+	difference.PeakSignalToNoiseRatio = difference.RootMeanSquareError == 0.0
+		? std::numeric_limits<double>::infinity()
+		: 20.0 * std::log10(255.0 / difference.RootMeanSquareError);
+	return true;
+}
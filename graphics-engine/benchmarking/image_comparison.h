@@ -0,0 +1,20 @@
+#ifndef IMAGE_COMPARISON_INCLUDED
+#define IMAGE_COMPARISON_INCLUDED
+
+#include <string>
+
+namespace dengine
+{
+	struct ImageDifference {
+		//over rgb channels in 0..255
+		double RootMeanSquareError{ 0.0 };
+		//infinite for identical images
+		double PeakSignalToNoiseRatio{ 0.0 };
+	};
+
+	//compares rgba8 pixels with image file of same size, false when file can not be loaded or size differs
+	bool compareWithImageFile(const std::pmr::string& path, const unsigned char* pixels, int width, int height,
+		ImageDifference& difference);
+}
+
+#endif
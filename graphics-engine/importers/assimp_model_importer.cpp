@@ -1,5 +1,6 @@
 #include <importers/assimp_model_importer.h>
 
+#include <chrono>
 #include <filesystem>
 namespace fs = std::filesystem;
 
@@ -10,80 +11,142 @@ namespace fs = std::filesystem;
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <glm/gtc/type_ptr.hpp>
+#include <profiling/profiler.h>
+#include <profiling/memory_tracker.h>
 
-constexpr unsigned int ImportFlags = aiProcess_CalcTangentSpace |
-	aiProcess_Triangulate |
+
+constexpr unsigned int ImportFlags = aiProcess_Triangulate |
 	aiProcess_FlipUVs |
 	aiProcess_EmbedTextures;
 
 
 
+dengine::AssimpModelImporter::AssimpModelImporter(BS::thread_pool* threadPool) : threadPool(threadPool)
+{
+}
+
+
 dengine::Model dengine::AssimpModelImporter::Import(std::pmr::string path)
 {
+	DENGINE_PROFILE_SCOPE("import model");
 	std::shared_ptr<spdlog::logger> log = spdlog::get("app_logger");
+	const auto importStart = std::chrono::steady_clock::now();
 	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path.c_str(), ImportFlags);
+	const aiScene* scene = importer.ReadFile(path.c_str(), getImportFlags());
 	if (scene == nullptr)
 	{
 		auto errorString = importer.GetErrorString();
 		log->error("Failed to import model from {} with following error message:'{}'", path.c_str(), errorString);
 		return Model{};
 	}
+	auto model = processScene(scene, std::move(path));
+	const std::chrono::duration<double, std::milli> importTime = std::chrono::steady_clock::now() - importStart;
+	log->info("Imported {} in {:.1f} ms, {} meshes, {} tangents", model.Name.c_str(), importTime.count(),
+		model.Meshes.size(), tangentGeneration == TangentGeneration::Batched ? "batched" : "assimp");
+	return model;
+}
+
+
+dengine::Model dengine::AssimpModelImporter::ImportFromMemory(const void* data, size_t size, const char* extensionHint,
+	std::pmr::string name)
+{
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFileFromMemory(data, size, getImportFlags(), extensionHint);
+	if (scene == nullptr)
+	{
+		spdlog::get("app_logger")->error("Failed to import model {} from memory with following error message:'{}'",
+			name.c_str(), importer.GetErrorString());
+		return Model{};
+	}
+	return processScene(scene, std::move(name));
+}
+
+
+void dengine::AssimpModelImporter::SetTangentGeneration(TangentGeneration tangentGeneration)
+{
+	this->tangentGeneration = tangentGeneration;
+}
+
+
+dengine::Model dengine::AssimpModelImporter::processScene(const aiScene* scene, std::pmr::string path) const
+{
+	//imported data is counted against model until it is released
+	auto& memoryTracker = MemoryTracker::Get();
+	auto meshesResource = memoryTracker.GetCpuResource(MemoryCategory::ImportedMeshes, path);
+	auto texturesResource = memoryTracker.GetCpuResource(MemoryCategory::ImportedTextures, path);
 	//load geometry
-	std::pmr::vector<Mesh> meshes;
-	processNode(scene->mRootNode, scene, meshes);
+	std::pmr::vector<Mesh> meshes(meshesResource);
+	meshes.reserve(scene->mNumMeshes);
+	for (int i = 0; i < scene->mNumMeshes; i++)
+		meshes.push_back(ProcessMesh(scene->mMeshes[i], scene, meshesResource));
+	//bounds are always computed here, tangents only when assimp did not
+	processMeshes(meshes, tangentGeneration == TangentGeneration::Batched, threadPool);
+	//load node hierarchy
+	std::pmr::vector<Node> nodes;
+	processNode(scene->mRootNode, -1, nodes);
 	//load maps and materials
-	auto textures = loadEmbededTextures(scene);
+	auto textures = loadEmbededTextures(scene, texturesResource);
 	auto materials = loadMaterials(scene);
 
-	importer.FreeScene();
+	//moved, copies would fall back to default resource
 	return Model{
-		meshes,
-		materials,
-		textures
+		std::move(meshes),
+		std::move(materials),
+		std::move(textures),
+		std::move(nodes),
+		std::move(path),
 	};
 }
 
-std::pmr::vector<dengine::Texture> dengine::AssimpModelImporter::loadEmbededTextures(const aiScene* scene)
+
+unsigned int dengine::AssimpModelImporter::getImportFlags() const
+{
+	return tangentGeneration == TangentGeneration::Assimp ? ImportFlags | aiProcess_CalcTangentSpace : ImportFlags;
+}
+
+std::pmr::vector<dengine::Texture> dengine::AssimpModelImporter::loadEmbededTextures(const aiScene* scene,
+	std::pmr::memory_resource* resource)
 {
-	std::pmr::vector<Texture> embededTextures;
+	std::pmr::vector<Texture> embededTextures(resource);
 	for (int i = 0; i < scene->mNumTextures; i++)
 	{
 		const aiTexture* aiTexture = scene->mTextures[i];
 		if (aiTexture->mHeight == 0)
 		{
 			const auto zipDataPtr = reinterpret_cast<unsigned char*>(aiTexture->pcData);
-			embededTextures.push_back(loadTextureFromMemmory(zipDataPtr, aiTexture->mWidth));
+			embededTextures.push_back(LoadTextureFromMemory(zipDataPtr, aiTexture->mWidth, resource));
 		}
 		else
 		{
 			const unsigned int textureSizeInBytes = aiTexture->mWidth * aiTexture->mHeight * 4;
-			std::pmr::vector<unsigned char> data(textureSizeInBytes);
+			std::pmr::vector<unsigned char> data(textureSizeInBytes, resource);
 			std::memcpy(&data[0], aiTexture->pcData, textureSizeInBytes);
 			embededTextures.push_back(Texture{
 				RGBA,
 				static_cast<int>(aiTexture->mWidth),
 				static_cast<int>(aiTexture->mHeight),
-				data
+				std::move(data)
 			});
 		}
 	}
 	return embededTextures;
 }
 
-dengine::Texture dengine::AssimpModelImporter::loadTextureFromMemmory(unsigned char* zipData, unsigned len)
+dengine::Texture dengine::AssimpModelImporter::LoadTextureFromMemory(unsigned char* zipData, unsigned len,
+	std::pmr::memory_resource* resource)
 {
 	int width = 0, height = 0, numChannels = 0;
 	unsigned char* data = stbi_load_from_memory(zipData, len, &width, &height, &numChannels, 4);
 	const auto textureSizeInBytes = width * height * 4;
-	std::pmr::vector<unsigned char> textureData(textureSizeInBytes);
+	std::pmr::vector<unsigned char> textureData(textureSizeInBytes, resource);
 	memcpy(&textureData[0], data, textureSizeInBytes);
 	stbi_image_free(data);
 	return Texture{
 		RGBA,
 		width,
 		height,
-		textureData,
+		std::move(textureData),
 	};
 }
 
@@ -93,47 +156,56 @@ std::pmr::vector<dengine::Material> dengine::AssimpModelImporter::loadMaterials(
 	for (int i = 0; i < scene->mNumMaterials; i++)
 	{
 		const aiMaterial* aiMaterial = scene->mMaterials[i];
-		if (aiMaterial->GetTextureCount(aiTextureType_BASE_COLOR) > 0)
+		//every material is kept so mesh material indices stay valid, missing maps stay -1
+		auto getTextureIndex = [&](aiTextureType textureType)
 		{
 			aiString textureName;
-			//get diffuse texture
-			aiMaterial->GetTexture(aiTextureType_BASE_COLOR, 0, &textureName);
-			const auto diffuseTextureIndex = scene->GetEmbeddedTextureAndIndex(textureName.C_Str());
-
-			//get normal texture
-			aiMaterial->GetTexture(aiTextureType_NORMALS, 0, &textureName);
-			const auto normalTextureIndex = scene->GetEmbeddedTextureAndIndex(textureName.C_Str());
-
-			//get normal texture
-			aiMaterial->GetTexture(aiTextureType_METALNESS, 0, &textureName);
-			const auto metalnessTexture = scene->GetEmbeddedTextureAndIndex(textureName.C_Str());
-
-			materials.push_back(Material{ diffuseTextureIndex.second, normalTextureIndex.second, metalnessTexture.second });
-		}
+			if (aiMaterial->GetTextureCount(textureType) == 0 ||
+				aiMaterial->GetTexture(textureType, 0, &textureName) != aiReturn_SUCCESS)
+				return -1;
+			return scene->GetEmbeddedTextureAndIndex(textureName.C_Str()).second;
+		};
+		materials.push_back(Material{
+			getTextureIndex(aiTextureType_BASE_COLOR),
+			getTextureIndex(aiTextureType_NORMALS),
+			getTextureIndex(aiTextureType_METALNESS),
+		});
 	}
 	return materials;
 }
 
-void dengine::AssimpModelImporter::processNode(const aiNode* node, const aiScene* scene, std::pmr::vector<Mesh>& meshes)
+void dengine::AssimpModelImporter::processNode(const aiNode* node, int parentIndex, std::pmr::vector<Node>& nodes)
 {
-	for (int i = 0; i < node->mNumMeshes; i++)
-		meshes.push_back(processMesh(scene->mMeshes[node->mMeshes[i]], scene));
+	//assimp matrices are row major, glm expects column major
+	Node processedNode{ glm::transpose(glm::make_mat4(&node->mTransformation.a1)), parentIndex };
+	processedNode.MeshIndices.assign(node->mMeshes, node->mMeshes + node->mNumMeshes);
+	nodes.push_back(processedNode);
+
+	const int nodeIndex = static_cast<int>(nodes.size()) - 1;
 	for (int i = 0; i < node->mNumChildren; i++)
-		processNode(node->mChildren[i], scene, meshes);
+		processNode(node->mChildren[i], nodeIndex, nodes);
 }
 
-dengine::Mesh dengine::AssimpModelImporter::processMesh(const aiMesh* mesh, const aiScene* scene)
+dengine::Mesh dengine::AssimpModelImporter::ProcessMesh(const aiMesh* mesh, const aiScene* scene,
+	std::pmr::memory_resource* resource)
 {
-	std::pmr::vector<glm::vec3> positions(mesh->mNumVertices);
-	std::pmr::vector<glm::vec3> tangents(mesh->mNumVertices);
-	std::pmr::vector<glm::vec3> normals(mesh->mNumVertices);
-	std::pmr::vector<glm::vec2> uvs(mesh->mNumVertices);
+	std::pmr::vector<glm::vec3> positions(mesh->mNumVertices, resource);
+	std::pmr::vector<glm::vec4> tangents(mesh->mNumVertices, resource);
+	std::pmr::vector<glm::vec3> normals(mesh->mNumVertices, resource);
+	std::pmr::vector<glm::vec2> uvs(mesh->mNumVertices, resource);
 
 
 	const unsigned cmpSize = mesh->mNumVertices * sizeof(glm::vec3);
 	memcpy(&positions[0], mesh->mVertices, mesh->mNumVertices * sizeof(glm::vec3)); //copy positions
 	memcpy(&normals[0], mesh->mNormals, cmpSize); //copy normals
-	memcpy(&tangents[0], mesh->mTangents, cmpSize); //copy normals
+	if (mesh->mTangents != nullptr) //copy tangents with bitangent sign, computed after import when assimp does not
+		for (int i = 0; i < mesh->mNumVertices; i++)
+		{
+			const glm::vec3 normal(normals[i]);
+			const glm::vec3 tangent(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+			const glm::vec3 bitangent(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+			tangents[i] = glm::vec4(tangent, glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f);
+		}
 	for (int i = 0; i < mesh->mNumVertices; i++) //copy UVs
 		uvs[i] = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
 
@@ -142,7 +214,7 @@ dengine::Mesh dengine::AssimpModelImporter::processMesh(const aiMesh* mesh, cons
 	unsigned int indeciesSize = 0;
 	for (int i = 0; i < mesh->mNumFaces; i++)
 		indeciesSize += mesh->mFaces[i].mNumIndices;
-	std::pmr::vector<unsigned int> indecies(indeciesSize);
+	std::pmr::vector<unsigned int> indecies(indeciesSize, resource);
 	unsigned int offset = 0;
 	for (int i = 0; i < mesh->mNumFaces; i++)
 	{
@@ -153,11 +225,11 @@ dengine::Mesh dengine::AssimpModelImporter::processMesh(const aiMesh* mesh, cons
 	}
 
 	return Mesh{
-		positions,
-		normals,
-		tangents,
-		uvs,
-		indecies,
+		std::move(positions),
+		std::move(normals),
+		std::move(tangents),
+		std::move(uvs),
+		std::move(indecies),
 		mesh->mMaterialIndex,
 	};
 }
@@ -3,24 +3,39 @@
 
 #include <spdlog/spdlog.h>
 #include <importers/model_importer.h>
+#include <importers/mesh_processing.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 
 namespace dengine{
 	class AssimpModelImporter : public IModelImporter {
 	public:
-		explicit AssimpModelImporter() = default;
+		//meshes are processed on thread pool when given, serially otherwise
+		explicit AssimpModelImporter(BS::thread_pool* threadPool = nullptr);
 		Model Import(std::pmr::string path) override;
+		//model file already in memory, format is picked by extension hint like "obj", name owns memory of model
+		Model ImportFromMemory(const void* data, size_t size, const char* extensionHint, std::pmr::string name);
+		void SetTangentGeneration(TangentGeneration tangentGeneration);
+
+		//depend only on their input, public so benchmarks can drive them with synthetic data
+		//returned data is allocated from resource
+		static dengine::Texture LoadTextureFromMemory(unsigned char* zipData, unsigned len,
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+		static dengine::Mesh ProcessMesh(const aiMesh* mesh, const  aiScene* scene,
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
 	private:
-		static std::pmr::vector<dengine::Texture> loadEmbededTextures(const aiScene* scene);
-		static dengine::Texture loadTextureFromMemmory(unsigned char* zipData, unsigned len);
+		Model processScene(const aiScene* scene, std::pmr::string path) const;
+		unsigned int getImportFlags() const;
+		static std::pmr::vector<dengine::Texture> loadEmbededTextures(const aiScene* scene,
+			std::pmr::memory_resource* resource);
 		static std::pmr::vector<dengine::Material> loadMaterials(const aiScene* scene);
-		void processNode(const aiNode* node, const aiScene* scene, std::pmr::vector<dengine::Mesh>& meshes);
-		static dengine::Mesh processMesh(const aiMesh* mesh, const  aiScene* scene);
+		static void processNode(const aiNode* node, int parentIndex, std::pmr::vector<dengine::Node>& nodes);
 
 		Assimp::Importer importer;
 		std::shared_ptr<spdlog::logger> log;
+		BS::thread_pool* threadPool;
+		TangentGeneration tangentGeneration{ TangentGeneration::Assimp };
 	};
 	
 }
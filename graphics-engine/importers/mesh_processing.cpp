@@ -0,0 +1,478 @@
+#include <importers/mesh_processing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <profiling/profiler.h>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define DENGINE_MESH_SSE
+#endif
+
+
+constexpr float Infinity = std::numeric_limits<float>::infinity();
+constexpr float Pi = 3.14159265f;
+constexpr int TangentBatchSize = 4;
+//triangles with smaller doubled uv area have no usable tangent direction and add nothing to their vertices
+constexpr float MinUvArea = 1e-12f;
+//squared length of tangent left after projection to tangent plane, shorter ones lie along normal
+constexpr float MinProjectedTangent = 1e-8f;
+//meshes vary a lot in size, more tasks than workers let idle ones pick up remaining meshes
+constexpr size_t MeshTasksPerThread = 8;
+//frames vertex received from its triangles, vertices with both are split
+constexpr unsigned char RegularFrame = 1;
+constexpr unsigned char MirroredFrame = 2;
+
+
+//four triangles with every component in own array, lane i of each array belongs to triangle i
+struct TangentBatch {
+	alignas(16) float Positions[3][3][TangentBatchSize];
+	alignas(16) float Normals[3][3][TangentBatchSize];
+	alignas(16) float UVs[3][2][TangentBatchSize];
+};
+
+
+//tangent of every corner, already projected to plane of corner normal, its weight and bitangent sign,
+//-1 where uv layout is mirrored against corner normal
+struct TangentBatchResult {
+	alignas(16) float Tangents[3][3][TangentBatchSize];
+	alignas(16) float Weights[3][TangentBatchSize];
+	alignas(16) float Signs[3][TangentBatchSize];
+};
+
+
+//abramowitz and stegun 4.4.45, error below 7e-5 radians is far under what angle weights need
+float approximateAcos(float cosine)
+{
+	const float x = std::abs(cosine);
+	const float angle = std::sqrt(1.0f - x) * (1.5707288f + x * (-0.2121144f + x * (0.0742610f - 0.0187293f * x)));
+	return cosine < 0.0f ? Pi - angle : angle;
+}
+
+
+glm::vec3 getPerpendicularTangent(const glm::vec3& normal)
+{
+	//vertices without uv direction get any tangent, so normal maps still have valid frame
+	const glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const glm::vec3 tangent = axis - normal * glm::dot(normal, axis);
+	const float lengthSquared = glm::dot(tangent, tangent);
+	return lengthSquared > 0.0f ? tangent / std::sqrt(lengthSquared) : axis;
+}
+
+
+glm::vec3 finishVertexTangent(const glm::vec3& accumulated, const glm::vec3& normal)
+{
+	const glm::vec3 tangent = accumulated - normal * glm::dot(normal, accumulated);
+	const float lengthSquared = glm::dot(tangent, tangent);
+	return lengthSquared > MinProjectedTangent ? tangent / std::sqrt(lengthSquared) : getPerpendicularTangent(normal);
+}
+
+
+void computeTangentLane(const TangentBatch& batch, int lane, TangentBatchResult& result)
+{
+	glm::vec3 positions[3];
+	glm::vec3 normals[3];
+	glm::vec2 uvs[3];
+	for (int corner = 0; corner < 3; corner++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			positions[corner][axis] = batch.Positions[corner][axis][lane];
+			normals[corner][axis] = batch.Normals[corner][axis][lane];
+		}
+		uvs[corner] = glm::vec2(batch.UVs[corner][0][lane], batch.UVs[corner][1][lane]);
+	}
+	const glm::vec3 edge1 = positions[1] - positions[0];
+	const glm::vec3 edge2 = positions[2] - positions[0];
+	const glm::vec2 uvEdge1 = uvs[1] - uvs[0];
+	const glm::vec2 uvEdge2 = uvs[2] - uvs[0];
+	const float uvArea = uvEdge1.x * uvEdge2.y - uvEdge1.y * uvEdge2.x;
+	//only orientation of uv triangle matters, magnitude is removed by normalization
+	glm::vec3 direction = (edge1 * uvEdge2.y - edge2 * uvEdge1.y) * (uvArea < 0.0f ? -1.0f : 1.0f);
+	const float directionLength = glm::dot(direction, direction);
+	const bool hasDirection = std::abs(uvArea) > MinUvArea && directionLength > 0.0f;
+	if (hasDirection)
+		direction /= std::sqrt(directionLength);
+	//cross of uv derivatives is face normal over uv area, so its side of corner normal gives handedness
+	const glm::vec3 faceNormal = glm::cross(edge1, edge2);
+
+	for (int corner = 0; corner < 3; corner++)
+	{
+		const glm::vec3 toNext = positions[(corner + 1) % 3] - positions[corner];
+		const glm::vec3 toPrevious = positions[(corner + 2) % 3] - positions[corner];
+		const float lengthProduct = std::sqrt(glm::dot(toNext, toNext) * glm::dot(toPrevious, toPrevious));
+		const float angle = lengthProduct > 0.0f ?
+			approximateAcos(std::clamp(glm::dot(toNext, toPrevious) / lengthProduct, -1.0f, 1.0f)) : 0.0f;
+		glm::vec3 tangent = direction - normals[corner] * glm::dot(normals[corner], direction);
+		const float tangentLength = glm::dot(tangent, tangent);
+		const bool valid = hasDirection && tangentLength > MinProjectedTangent;
+		tangent = valid ? tangent / std::sqrt(tangentLength) : glm::vec3(0.0f);
+		for (int axis = 0; axis < 3; axis++)
+			result.Tangents[corner][axis][lane] = tangent[axis];
+		result.Weights[corner][lane] = valid ? angle : 0.0f;
+		result.Signs[corner][lane] = glm::dot(faceNormal, normals[corner]) * uvArea < 0.0f ? -1.0f : 1.0f;
+	}
+}
+
+
+#ifdef DENGINE_MESH_SSE
+struct SimdVector3 {
+	__m128 X;
+	__m128 Y;
+	__m128 Z;
+};
+
+
+SimdVector3 loadSimdVector3(const float (&components)[3][TangentBatchSize])
+{
+	return SimdVector3{ _mm_load_ps(components[0]), _mm_load_ps(components[1]), _mm_load_ps(components[2]) };
+}
+
+
+//four packed glm::vec3 are three registers, shuffled so every register holds one component of all four
+SimdVector3 loadPackedSimdVector3(const glm::vec3* vectors)
+{
+	const float* elements = &vectors[0].x;
+	const __m128 first = _mm_loadu_ps(elements);
+	const __m128 second = _mm_loadu_ps(elements + 4);
+	const __m128 third = _mm_loadu_ps(elements + 8);
+	const __m128 xLow = _mm_shuffle_ps(second, third, _MM_SHUFFLE(1, 1, 2, 2));
+	const __m128 yLow = _mm_shuffle_ps(first, second, _MM_SHUFFLE(0, 0, 1, 1));
+	const __m128 yHigh = _mm_shuffle_ps(second, third, _MM_SHUFFLE(2, 2, 3, 3));
+	const __m128 zLow = _mm_shuffle_ps(first, second, _MM_SHUFFLE(1, 1, 2, 2));
+	return SimdVector3{
+		_mm_shuffle_ps(first, xLow, _MM_SHUFFLE(2, 0, 3, 0)),
+		_mm_shuffle_ps(yLow, yHigh, _MM_SHUFFLE(2, 0, 2, 0)),
+		_mm_shuffle_ps(zLow, third, _MM_SHUFFLE(3, 0, 2, 0)),
+	};
+}
+
+
+void storePackedSimdVector3(glm::vec3* vectors, const SimdVector3& vector)
+{
+	float* elements = &vectors[0].x;
+	const __m128 xy = _mm_shuffle_ps(vector.X, vector.Y, _MM_SHUFFLE(0, 0, 0, 0));
+	const __m128 zx = _mm_shuffle_ps(vector.Z, vector.X, _MM_SHUFFLE(1, 1, 0, 0));
+	const __m128 yz = _mm_shuffle_ps(vector.Y, vector.Z, _MM_SHUFFLE(1, 1, 1, 1));
+	const __m128 xyHigh = _mm_shuffle_ps(vector.X, vector.Y, _MM_SHUFFLE(2, 2, 2, 2));
+	const __m128 zxHigh = _mm_shuffle_ps(vector.Z, vector.X, _MM_SHUFFLE(3, 3, 2, 2));
+	const __m128 yzHigh = _mm_shuffle_ps(vector.Y, vector.Z, _MM_SHUFFLE(3, 3, 3, 3));
+	_mm_storeu_ps(elements, _mm_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(elements + 4, _mm_shuffle_ps(yz, xyHigh, _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(elements + 8, _mm_shuffle_ps(zxHigh, yzHigh, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+
+SimdVector3 subtractSimdVector3(const SimdVector3& left, const SimdVector3& right)
+{
+	return SimdVector3{ _mm_sub_ps(left.X, right.X), _mm_sub_ps(left.Y, right.Y), _mm_sub_ps(left.Z, right.Z) };
+}
+
+
+SimdVector3 scaleSimdVector3(const SimdVector3& vector, __m128 scale)
+{
+	return SimdVector3{ _mm_mul_ps(vector.X, scale), _mm_mul_ps(vector.Y, scale), _mm_mul_ps(vector.Z, scale) };
+}
+
+
+__m128 dotSimdVector3(const SimdVector3& left, const SimdVector3& right)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(left.X, right.X), _mm_mul_ps(left.Y, right.Y)),
+		_mm_mul_ps(left.Z, right.Z));
+}
+
+
+SimdVector3 crossSimdVector3(const SimdVector3& left, const SimdVector3& right)
+{
+	return SimdVector3{
+		_mm_sub_ps(_mm_mul_ps(left.Y, right.Z), _mm_mul_ps(left.Z, right.Y)),
+		_mm_sub_ps(_mm_mul_ps(left.Z, right.X), _mm_mul_ps(left.X, right.Z)),
+		_mm_sub_ps(_mm_mul_ps(left.X, right.Y), _mm_mul_ps(left.Y, right.X)),
+	};
+}
+
+
+//normalizes lanes longer than threshold, returns their mask, shorter lanes are zeroed
+__m128 normalizeSimdVector3(SimdVector3& vector, float minLengthSquared)
+{
+	const __m128 lengthSquared = dotSimdVector3(vector, vector);
+	const __m128 valid = _mm_cmpgt_ps(lengthSquared, _mm_set1_ps(minLengthSquared));
+	const __m128 inverseLength = _mm_and_ps(valid,
+		_mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(lengthSquared, _mm_set1_ps(minLengthSquared)))));
+	vector = scaleSimdVector3(vector, inverseLength);
+	return valid;
+}
+
+
+__m128 approximateAcosSimd(__m128 cosine)
+{
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 x = _mm_andnot_ps(signMask, cosine);
+	__m128 polynomial = _mm_add_ps(_mm_set1_ps(0.0742610f), _mm_mul_ps(x, _mm_set1_ps(-0.0187293f)));
+	polynomial = _mm_add_ps(_mm_set1_ps(-0.2121144f), _mm_mul_ps(x, polynomial));
+	polynomial = _mm_add_ps(_mm_set1_ps(1.5707288f), _mm_mul_ps(x, polynomial));
+	const __m128 angle = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x)), polynomial);
+	const __m128 negative = _mm_cmplt_ps(cosine, _mm_setzero_ps());
+	return _mm_or_ps(_mm_and_ps(negative, _mm_sub_ps(_mm_set1_ps(Pi), angle)), _mm_andnot_ps(negative, angle));
+}
+#endif
+
+
+//same math as computeTangentLane for all four lanes at once
+void computeTangentBatch(const TangentBatch& batch, TangentBatchResult& result)
+{
+#ifdef DENGINE_MESH_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const SimdVector3 positions[3] = {
+		loadSimdVector3(batch.Positions[0]), loadSimdVector3(batch.Positions[1]), loadSimdVector3(batch.Positions[2]),
+	};
+	const SimdVector3 edge1 = subtractSimdVector3(positions[1], positions[0]);
+	const SimdVector3 edge2 = subtractSimdVector3(positions[2], positions[0]);
+	const __m128 uvEdge1X = _mm_sub_ps(_mm_load_ps(batch.UVs[1][0]), _mm_load_ps(batch.UVs[0][0]));
+	const __m128 uvEdge1Y = _mm_sub_ps(_mm_load_ps(batch.UVs[1][1]), _mm_load_ps(batch.UVs[0][1]));
+	const __m128 uvEdge2X = _mm_sub_ps(_mm_load_ps(batch.UVs[2][0]), _mm_load_ps(batch.UVs[0][0]));
+	const __m128 uvEdge2Y = _mm_sub_ps(_mm_load_ps(batch.UVs[2][1]), _mm_load_ps(batch.UVs[0][1]));
+	const __m128 uvArea = _mm_sub_ps(_mm_mul_ps(uvEdge1X, uvEdge2Y), _mm_mul_ps(uvEdge1Y, uvEdge2X));
+	//sign of uv area as +-1
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 orientation = _mm_or_ps(_mm_and_ps(uvArea, signMask), _mm_set1_ps(1.0f));
+	SimdVector3 direction = scaleSimdVector3(subtractSimdVector3(scaleSimdVector3(edge1, uvEdge2Y),
+		scaleSimdVector3(edge2, uvEdge1Y)), orientation);
+	const __m128 hasDirection = _mm_and_ps(_mm_cmpgt_ps(_mm_andnot_ps(signMask, uvArea), _mm_set1_ps(MinUvArea)),
+		normalizeSimdVector3(direction, 0.0f));
+	const SimdVector3 faceNormal = crossSimdVector3(edge1, edge2);
+
+	for (int corner = 0; corner < 3; corner++)
+	{
+		const SimdVector3 normal = loadSimdVector3(batch.Normals[corner]);
+		const SimdVector3 toNext = subtractSimdVector3(positions[(corner + 1) % 3], positions[corner]);
+		const SimdVector3 toPrevious = subtractSimdVector3(positions[(corner + 2) % 3], positions[corner]);
+		const __m128 lengthProduct = _mm_sqrt_ps(_mm_mul_ps(dotSimdVector3(toNext, toNext),
+			dotSimdVector3(toPrevious, toPrevious)));
+		const __m128 hasAngle = _mm_cmpgt_ps(lengthProduct, zero);
+		const __m128 cosine = _mm_div_ps(dotSimdVector3(toNext, toPrevious),
+			_mm_max_ps(lengthProduct, _mm_set1_ps(std::numeric_limits<float>::min())));
+		const __m128 angle = approximateAcosSimd(_mm_min_ps(_mm_max_ps(cosine, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f)));
+		SimdVector3 tangent = subtractSimdVector3(direction, scaleSimdVector3(normal, dotSimdVector3(normal, direction)));
+		const __m128 valid = _mm_and_ps(hasDirection, normalizeSimdVector3(tangent, MinProjectedTangent));
+		tangent = SimdVector3{ _mm_and_ps(tangent.X, valid), _mm_and_ps(tangent.Y, valid), _mm_and_ps(tangent.Z, valid) };
+		_mm_store_ps(result.Tangents[corner][0], tangent.X);
+		_mm_store_ps(result.Tangents[corner][1], tangent.Y);
+		_mm_store_ps(result.Tangents[corner][2], tangent.Z);
+		_mm_store_ps(result.Weights[corner], _mm_and_ps(_mm_and_ps(valid, hasAngle), angle));
+		const __m128 handedness = _mm_mul_ps(dotSimdVector3(faceNormal, normal), uvArea);
+		const __m128 negative = _mm_cmplt_ps(handedness, zero);
+		_mm_store_ps(result.Signs[corner], _mm_or_ps(_mm_and_ps(negative, _mm_set1_ps(-1.0f)),
+			_mm_andnot_ps(negative, _mm_set1_ps(1.0f))));
+	}
+#else
+	for (int lane = 0; lane < TangentBatchSize; lane++)
+		computeTangentLane(batch, lane, result);
+#endif
+}
+
+
+void dengine::computeMeshBounds(Mesh& mesh)
+{
+	const size_t count = mesh.Positions.size();
+	if (count == 0)
+	{
+		mesh.BoundsMin = mesh.BoundsMax = glm::vec3(0.0f);
+		mesh.BoundingSphere = glm::vec4(0.0f);
+		return;
+	}
+	glm::vec3 boundsMin(Infinity);
+	glm::vec3 boundsMax(-Infinity);
+	size_t i = 0;
+#ifdef DENGINE_MESH_SSE
+	//packed positions are loaded as they lie, lane of register r holds component (r * 4 + lane) % 3
+	const float* elements = &mesh.Positions[0].x;
+	__m128 minimums[3] = { _mm_set1_ps(Infinity), _mm_set1_ps(Infinity), _mm_set1_ps(Infinity) };
+	__m128 maximums[3] = { _mm_set1_ps(-Infinity), _mm_set1_ps(-Infinity), _mm_set1_ps(-Infinity) };
+	for (; i + 4 <= count; i += 4)
+		for (int part = 0; part < 3; part++)
+		{
+			const __m128 values = _mm_loadu_ps(elements + i * 3 + part * 4);
+			minimums[part] = _mm_min_ps(minimums[part], values);
+			maximums[part] = _mm_max_ps(maximums[part], values);
+		}
+	alignas(16) float minimumLanes[12];
+	alignas(16) float maximumLanes[12];
+	for (int part = 0; part < 3; part++)
+	{
+		_mm_store_ps(minimumLanes + part * 4, minimums[part]);
+		_mm_store_ps(maximumLanes + part * 4, maximums[part]);
+	}
+	for (int lane = 0; lane < 12; lane++)
+	{
+		boundsMin[lane % 3] = std::min(boundsMin[lane % 3], minimumLanes[lane]);
+		boundsMax[lane % 3] = std::max(boundsMax[lane % 3], maximumLanes[lane]);
+	}
+#endif
+	for (; i < count; i++)
+	{
+		boundsMin = glm::min(boundsMin, mesh.Positions[i]);
+		boundsMax = glm::max(boundsMax, mesh.Positions[i]);
+	}
+
+	//sphere around bounds center, radius of farthest position instead of half diagonal
+	const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radiusSquared = 0.0f;
+	i = 0;
+#ifdef DENGINE_MESH_SSE
+	const SimdVector3 simdCenter{ _mm_set1_ps(center.x), _mm_set1_ps(center.y), _mm_set1_ps(center.z) };
+	__m128 maxDistances = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4)
+	{
+		const SimdVector3 offset = subtractSimdVector3(loadPackedSimdVector3(&mesh.Positions[i]), simdCenter);
+		maxDistances = _mm_max_ps(maxDistances, dotSimdVector3(offset, offset));
+	}
+	alignas(16) float distanceLanes[4];
+	_mm_store_ps(distanceLanes, maxDistances);
+	radiusSquared = std::max({ distanceLanes[0], distanceLanes[1], distanceLanes[2], distanceLanes[3] });
+#endif
+	for (; i < count; i++)
+	{
+		const glm::vec3 offset = mesh.Positions[i] - center;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	mesh.BoundsMin = boundsMin;
+	mesh.BoundsMax = boundsMax;
+	mesh.BoundingSphere = glm::vec4(center, std::sqrt(radiusSquared));
+}
+
+
+void dengine::computeMeshTangents(Mesh& mesh)
+{
+	const size_t vertexCount = mesh.Positions.size();
+	if (mesh.Normals.size() != vertexCount)
+		return;
+	//meshes without uvs still get orthonormal frames from fallback tangents
+	const bool hasUVs = mesh.UVs.size() == vertexCount;
+	const size_t triangleCount = hasUVs ? mesh.Indecies.size() / 3 : 0;
+	//regular and mirrored triangles of vertex are summed apart, they end up on different vertices
+	std::pmr::vector<glm::vec3> accumulated(vertexCount, glm::vec3(0.0f));
+	std::pmr::vector<glm::vec3> mirroredAccumulated(vertexCount, glm::vec3(0.0f));
+	std::pmr::vector<unsigned char> frames(vertexCount, 0);
+	std::pmr::vector<unsigned char> mirroredCorners(triangleCount * 3, 0);
+
+	TangentBatch batch{};
+	TangentBatchResult result;
+	for (size_t firstTriangle = 0; firstTriangle < triangleCount; firstTriangle += TangentBatchSize)
+	{
+		//gathered through index buffer, lanes past last triangle stay zero and come out degenerate
+		const int laneCount = static_cast<int>(std::min<size_t>(TangentBatchSize, triangleCount - firstTriangle));
+		if (laneCount < TangentBatchSize)
+			batch = TangentBatch{};
+		for (int lane = 0; lane < laneCount; lane++)
+			for (int corner = 0; corner < 3; corner++)
+			{
+				const unsigned int vertex = mesh.Indecies[(firstTriangle + lane) * 3 + corner];
+				for (int axis = 0; axis < 3; axis++)
+				{
+					batch.Positions[corner][axis][lane] = mesh.Positions[vertex][axis];
+					batch.Normals[corner][axis][lane] = mesh.Normals[vertex][axis];
+				}
+				batch.UVs[corner][0][lane] = mesh.UVs[vertex].x;
+				batch.UVs[corner][1][lane] = mesh.UVs[vertex].y;
+			}
+		computeTangentBatch(batch, result);
+		for (int lane = 0; lane < laneCount; lane++)
+			for (int corner = 0; corner < 3; corner++)
+			{
+				const size_t cornerIndex = (firstTriangle + lane) * 3 + corner;
+				const unsigned int vertex = mesh.Indecies[cornerIndex];
+				const float weight = result.Weights[corner][lane];
+				//corners without uv direction add nothing, so they never force split
+				if (weight <= 0.0f)
+					continue;
+				const bool mirrored = result.Signs[corner][lane] < 0.0f;
+				mirroredCorners[cornerIndex] = mirrored ? 1 : 0;
+				frames[vertex] |= mirrored ? MirroredFrame : RegularFrame;
+				auto& sum = mirrored ? mirroredAccumulated[vertex] : accumulated[vertex];
+				for (int axis = 0; axis < 3; axis++)
+					sum[axis] += result.Tangents[corner][axis][lane] * weight;
+			}
+	}
+
+	//like mikktspace, vertex shared by regular and mirrored triangles, e.g. on mirrored uv seam, is split and
+	//mirrored triangles move to its copy
+	std::pmr::vector<float> signs(vertexCount, 1.0f);
+	std::pmr::vector<unsigned int> splitVertices;
+	for (size_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		if (frames[vertex] == MirroredFrame)
+		{
+			accumulated[vertex] = mirroredAccumulated[vertex];
+			signs[vertex] = -1.0f;
+		}
+		else if (frames[vertex] == (RegularFrame | MirroredFrame))
+		{
+			if (splitVertices.empty())
+				splitVertices.resize(vertexCount, 0);
+			splitVertices[vertex] = static_cast<unsigned int>(mesh.Positions.size());
+			const glm::vec3 position = mesh.Positions[vertex];
+			const glm::vec3 normal = mesh.Normals[vertex];
+			const glm::vec2 uv = mesh.UVs[vertex];
+			mesh.Positions.push_back(position);
+			mesh.Normals.push_back(normal);
+			mesh.UVs.push_back(uv);
+			accumulated.push_back(mirroredAccumulated[vertex]);
+			signs.push_back(-1.0f);
+		}
+	}
+	if (!splitVertices.empty())
+		for (size_t corner = 0; corner < mirroredCorners.size(); corner++)
+		{
+			auto& vertex = mesh.Indecies[corner];
+			if (mirroredCorners[corner] != 0 && splitVertices[vertex] != 0)
+				vertex = splitVertices[vertex];
+		}
+
+	//normalized in place, then packed with sign
+	const size_t tangentCount = accumulated.size();
+	size_t i = 0;
+#ifdef DENGINE_MESH_SSE
+	for (; i + 4 <= tangentCount; i += 4)
+	{
+		const SimdVector3 normal = loadPackedSimdVector3(&mesh.Normals[i]);
+		const SimdVector3 sum = loadPackedSimdVector3(&accumulated[i]);
+		SimdVector3 tangent = subtractSimdVector3(sum, scaleSimdVector3(normal, dotSimdVector3(normal, sum)));
+		const int validLanes = _mm_movemask_ps(normalizeSimdVector3(tangent, MinProjectedTangent));
+		storePackedSimdVector3(&accumulated[i], tangent);
+		//vertices without uv direction are rare, fixed up one by one
+		if (validLanes != 0xF)
+			for (int lane = 0; lane < 4; lane++)
+				if ((validLanes & (1 << lane)) == 0)
+					accumulated[i + lane] = getPerpendicularTangent(mesh.Normals[i + lane]);
+	}
+#endif
+	for (; i < tangentCount; i++)
+		accumulated[i] = finishVertexTangent(accumulated[i], mesh.Normals[i]);
+	mesh.Tangents.resize(tangentCount);
+	for (i = 0; i < tangentCount; i++)
+		mesh.Tangents[i] = glm::vec4(accumulated[i], signs[i]);
+}
+
+
+void dengine::processMeshes(std::pmr::vector<Mesh>& meshes, bool computeTangents, BS::thread_pool* threadPool)
+{
+	DENGINE_PROFILE_SCOPE("process meshes");
+	auto processRange = [&meshes, computeTangents](size_t first, size_t last)
+	{
+		for (size_t i = first; i < last; i++)
+		{
+			computeMeshBounds(meshes[i]);
+			if (computeTangents)
+				computeMeshTangents(meshes[i]);
+		}
+	};
+	if (threadPool == nullptr || meshes.size() < 2)
+	{
+		processRange(0, meshes.size());
+		return;
+	}
+	const size_t blocks = std::min(meshes.size(), threadPool->get_thread_count() * MeshTasksPerThread);
+	threadPool->parallelize_loop(size_t{ 0 }, meshes.size(), processRange, blocks).wait();
+}
@@ -0,0 +1,29 @@
+#ifndef MESH_PROCESSING_INCLUDED
+#define MESH_PROCESSING_INCLUDED
+
+#include <vector>
+
+#include <BS_thread_pool.hpp>
+#include <importers/model_importer.h>
+
+namespace dengine
+{
+	enum class TangentGeneration {
+		//aiProcess_CalcTangentSpace during import
+		Assimp,
+		//computeMeshTangents over imported meshes, in parallel
+		Batched,
+	};
+
+	//axis aligned bounds and bounding sphere from positions, four positions per sse iteration
+	void computeMeshBounds(Mesh& mesh);
+	//per vertex tangents like mikktspace: uv direction of every triangle is projected to tangent plane of each
+	//corner and weighted by corner angle, four triangles per sse iteration; w is bitangent sign, shaders rebuild
+	//bitangent as cross(N, T) * w, and vertices shared by triangles of opposite handedness are split, so
+	//positions, normals, uvs and indices may grow; normals have to be normalized
+	void computeMeshTangents(Mesh& mesh);
+	//bounds and optionally tangents of every mesh, one mesh per task when thread pool is given
+	void processMeshes(std::pmr::vector<Mesh>& meshes, bool computeTangents, BS::thread_pool* threadPool);
+}
+
+#endif
@@ -22,10 +22,16 @@ namespace dengine
 	struct Mesh {
 		std::pmr::vector<glm::vec3> Positions;
 		std::pmr::vector<glm::vec3> Normals;
-		std::pmr::vector<glm::vec3> Tangents;
+		//w is bitangent sign, bitangent is cross(normal, tangent) * w
+		std::pmr::vector<glm::vec4> Tangents;
 		std::pmr::vector<glm::vec2> UVs;
 		std::pmr::vector<unsigned int> Indecies;
 		unsigned int MaterialIndex;
+		//mesh space bounds, filled by importer
+		glm::vec3 BoundsMin{ 0.0f };
+		glm::vec3 BoundsMax{ 0.0f };
+		//center and radius, encloses every position and is usually tighter than sphere around bounds
+		glm::vec4 BoundingSphere{ 0.0f };
 	};
 
 	struct Material{
@@ -34,10 +40,20 @@ namespace dengine
 		int MetalnessTextureIndex{ -1 };
 	};
 
+	struct Node{
+		glm::mat4 LocalTransform{ 1.0f };
+		//index of parent node, parents always precede children, -1 for root
+		int Parent{ -1 };
+		std::pmr::vector<unsigned int> MeshIndices;
+	};
+
 	struct Model{
 		std::pmr::vector<Mesh> Meshes;
 		std::pmr::vector<Material> Materials;
 		std::pmr::vector<Texture> Textures;
+		std::pmr::vector<Node> Nodes;
+		//source path, owning asset in memory reports
+		std::pmr::string Name;
 	};
 
 
@@ -1,11 +1,28 @@
 #include <graphics-engine/application/graphics_engine_application.h>
+#include <graphics-engine/application/headless_application.h>
+#include <graphics-engine/application/software_application.h>
 
-int main(char* argc, char* argv[])
+int main(int argc, char* argv[])
 {
-	dengine::GraphicsEngineRunArguments arguments{
-	argv[1]
-	};
+	dengine::GraphicsEngineRunArguments arguments;
+	if (!dengine::parseRunArguments(argc, argv, arguments))
+	{
+		dengine::printUsage();
+		return -1;
+	}
+	if (arguments.sceneGenerator.enabled)
+		return dengine::runSceneGenerator(arguments.sceneGenerator);
+	if (arguments.headless.enabled && arguments.headless.renderer != dengine::HeadlessRenderer::OpenGl)
+	{
+		dengine::SoftwareApplication application;
+		return application.Run(arguments);
+	}
+	if (arguments.headless.enabled)
+	{
+		dengine::HeadlessApplication application;
+		return application.Run(arguments);
+	}
 
 	dengine::GraphicsEngineApplication application;
 	return application.Run(arguments);
-}
\ No newline at end of file
+}
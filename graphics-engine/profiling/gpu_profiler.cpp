@@ -0,0 +1,112 @@
+#include <profiling/gpu_profiler.h>
+
+#include <glad/glad.h>
+
+
+dengine::GpuProfiler& dengine::GpuProfiler::Get()
+{
+	static GpuProfiler gpuProfiler;
+	return gpuProfiler;
+}
+
+
+void dengine::GpuProfiler::BeginZone(const char* name)
+{
+	if (!initialized)
+		initialize();
+	auto& frame = frames[currentFrame];
+	if (frame.Zones.size() >= MaxZonesPerFrame)
+	{
+		openZones.push_back(-1);
+		return;
+	}
+	const auto zoneIndex = static_cast<int>(frame.Zones.size());
+	frame.Zones.push_back(Zone{ name, static_cast<unsigned int>(openZones.size()) });
+	openZones.push_back(zoneIndex);
+	glQueryCounter(frame.Queries[zoneIndex * 2], GL_TIMESTAMP);
+}
+
+
+void dengine::GpuProfiler::EndZone()
+{
+	const int zoneIndex = openZones.back();
+	openZones.pop_back();
+	if (zoneIndex < 0)
+		return;
+	glQueryCounter(frames[currentFrame].Queries[zoneIndex * 2 + 1], GL_TIMESTAMP);
+}
+
+
+void dengine::GpuProfiler::NewFrame()
+{
+	if (!initialized)
+		return;
+
+	frames[currentFrame].Pending = !frames[currentFrame].Zones.empty();
+	//oldest frames first, stop at first one GPU has not finished yet
+	for (size_t i = 1; i <= FrameLatency; i++)
+	{
+		auto& frame = frames[(currentFrame + i) % FrameLatency];
+		if (frame.Pending && !readBack(frame))
+			break;
+	}
+
+	//if GPU is still behind, results of reused frame are dropped instead of stalling
+	currentFrame = (currentFrame + 1) % FrameLatency;
+	frames[currentFrame].Zones.clear();
+	frames[currentFrame].Pending = false;
+}
+
+
+void dengine::GpuProfiler::Shutdown()
+{
+	if (!initialized)
+		return;
+	for (auto& frame : frames)
+	{
+		glDeleteQueries(static_cast<GLsizei>(frame.Queries.size()), frame.Queries.data());
+		frame.Zones.clear();
+		frame.Pending = false;
+	}
+	initialized = false;
+}
+
+
+void dengine::GpuProfiler::initialize()
+{
+	for (auto& frame : frames)
+		glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(frame.Queries.size()), frame.Queries.data());
+
+	//gpu timestamps are on their own clock, align them with profiler time once
+	GLint64 gpuTime = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+	gpuToCpuOffset = Profiler::Get().Now() - gpuTime;
+	initialized = true;
+}
+
+
+bool dengine::GpuProfiler::readBack(Frame& frame)
+{
+	//availability is not guaranteed to follow submission order, so every query of frame is checked
+	for (size_t i = 0; i < frame.Zones.size() * 2; i++)
+	{
+		int available = 0;
+		glGetQueryObjectiv(frame.Queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return false;
+	}
+
+	events.clear();
+	for (size_t i = 0; i < frame.Zones.size(); i++)
+	{
+		GLuint64 start = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(frame.Queries[i * 2], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(frame.Queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+		events.push_back(ProfileEvent{ frame.Zones[i].Name, static_cast<long long>(start) + gpuToCpuOffset,
+			static_cast<long long>(end) + gpuToCpuOffset, frame.Zones[i].Depth, GpuProfileThreadIndex });
+	}
+	Profiler::Get().AddGpuEvents(events);
+	frame.Pending = false;
+	return true;
+}
@@ -0,0 +1,78 @@
+#ifndef GPU_PROFILER_INCLUDED
+#define GPU_PROFILER_INCLUDED
+
+#include <array>
+#include <vector>
+
+#include <profiling/profiler.h>
+
+namespace dengine
+{
+	//GL_TIMESTAMP query pool per frame in flight, frames are read back only once their queries are available,
+	//GL thread only and requires current context from first zone until Shutdown
+	class GpuProfiler {
+	public:
+		static GpuProfiler& Get();
+
+		void BeginZone(const char* name);
+		void EndZone();
+		//closes current frame and forwards every finished frame to Profiler without waiting
+		void NewFrame();
+		void Shutdown();
+	private:
+		static constexpr size_t FrameLatency = 4;
+		static constexpr size_t MaxZonesPerFrame = 128;
+
+		struct Zone {
+			const char* Name;
+			unsigned int Depth;
+		};
+
+		struct Frame {
+			//zone i is measured by queries 2 * i and 2 * i + 1
+			std::array<unsigned int, MaxZonesPerFrame * 2> Queries{};
+			std::pmr::vector<Zone> Zones;
+			bool Pending{ false };
+		};
+
+		GpuProfiler() = default;
+		void initialize();
+		bool readBack(Frame& frame);
+
+		std::array<Frame, FrameLatency> frames;
+		size_t currentFrame{ 0 };
+		//zone indices of open zones, -1 for zones dropped because frame was full
+		std::pmr::vector<int> openZones;
+		std::pmr::vector<ProfileEvent> events;
+		long long gpuToCpuOffset{ 0 };
+		bool initialized{ false };
+	};
+
+
+	class GpuProfileScope {
+	public:
+		explicit GpuProfileScope(const char* name)
+		{
+			GpuProfiler::Get().BeginZone(name);
+		}
+
+		~GpuProfileScope()
+		{
+			GpuProfiler::Get().EndZone();
+		}
+
+		GpuProfileScope(const GpuProfileScope&) = delete;
+		GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+	};
+}
+
+#ifdef DENGINE_ENABLE_PROFILING
+#define DENGINE_PROFILE_GPU_SCOPE(name) ::dengine::GpuProfileScope DENGINE_PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+//publishes cpu and gpu zones, placed once at start of frame on GL thread
+#define DENGINE_PROFILE_FRAME() (::dengine::Profiler::Get().NewFrame(), ::dengine::GpuProfiler::Get().NewFrame())
+#else
+#define DENGINE_PROFILE_GPU_SCOPE(name) ((void)0)
+#define DENGINE_PROFILE_FRAME() ((void)0)
+#endif
+
+#endif
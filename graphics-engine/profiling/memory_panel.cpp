@@ -0,0 +1,82 @@
+#include <profiling/memory_panel.h>
+
+#include <imgui.h>
+#include <profiling/memory_tracker.h>
+
+const char* MemoryReportPath = "memory-report.json";
+
+
+double toMegabytes(long long bytes)
+{
+	return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+
+void drawMemoryStatisticsRow(const char* name, const dengine::MemoryStatistics& statistics)
+{
+	ImGui::TableNextRow();
+	ImGui::TableNextColumn();
+	ImGui::TextUnformatted(name);
+	ImGui::TableNextColumn();
+	ImGui::Text("%.2f", toMegabytes(statistics.Live));
+	ImGui::TableNextColumn();
+	ImGui::Text("%.2f", toMegabytes(statistics.Peak));
+	ImGui::TableNextColumn();
+	ImGui::Text("%llu", statistics.Allocations);
+}
+
+
+bool beginMemoryTable(const char* tableId, const char* firstColumn)
+{
+	if (!ImGui::BeginTable(tableId, 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable))
+		return false;
+	ImGui::TableSetupColumn(firstColumn);
+	ImGui::TableSetupColumn("live mb");
+	ImGui::TableSetupColumn("peak mb");
+	ImGui::TableSetupColumn("allocations");
+	ImGui::TableHeadersRow();
+	return true;
+}
+
+
+void dengine::drawMemoryPanel()
+{
+	ImGui::Begin("memory");
+	const auto report = MemoryTracker::Get().GetReport();
+	static bool reportWritten = false;
+	if (ImGui::Button("dump memory report"))
+		reportWritten = writeMemoryReportJson(MemoryReportPath, report);
+	if (reportWritten)
+	{
+		ImGui::SameLine();
+		ImGui::Text("written to %s", MemoryReportPath);
+	}
+
+	if (beginMemoryTable("memory totals", "category"))
+	{
+		drawMemoryStatisticsRow("cpu total", report.Cpu);
+		drawMemoryStatisticsRow("gpu total", report.Gpu);
+		for (size_t i = 0; i < report.Categories.size(); i++)
+			drawMemoryStatisticsRow(getMemoryCategoryName(static_cast<MemoryCategory>(i)), report.Categories[i]);
+		ImGui::EndTable();
+	}
+
+	//assets are sorted by live bytes, largest first
+	if (ImGui::CollapsingHeader("assets", ImGuiTreeNodeFlags_DefaultOpen))
+	{
+		for (auto& asset : report.Assets)
+		{
+			if (!ImGui::TreeNode(asset.Name.c_str()))
+				continue;
+			if (beginMemoryTable("asset memory", "category"))
+			{
+				for (size_t i = 0; i < asset.Categories.size(); i++)
+					if (asset.Categories[i].Allocations > 0)
+						drawMemoryStatisticsRow(getMemoryCategoryName(static_cast<MemoryCategory>(i)), asset.Categories[i]);
+				ImGui::EndTable();
+			}
+			ImGui::TreePop();
+		}
+	}
+	ImGui::End();
+}
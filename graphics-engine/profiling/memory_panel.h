@@ -0,0 +1,10 @@
+#ifndef MEMORY_PANEL_INCLUDED
+#define MEMORY_PANEL_INCLUDED
+
+namespace dengine
+{
+	//dockable imgui window with live and peak memory per category and asset
+	void drawMemoryPanel();
+}
+
+#endif
@@ -0,0 +1,230 @@
+#include <profiling/memory_tracker.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+#include <benchmarking/frame_statistics.h>
+
+constexpr const char* MemoryCategoryNames[] = {
+	"imported meshes",
+	"imported textures",
+	"vertex buffers",
+	"index buffers",
+	"instance buffers",
+	"uniform buffers",
+	"textures",
+	"render targets",
+	"readback buffers",
+};
+static_assert(std::size(MemoryCategoryNames) == dengine::MemoryCategoryCount);
+
+
+const char* dengine::getMemoryCategoryName(MemoryCategory category)
+{
+	return MemoryCategoryNames[static_cast<size_t>(category)];
+}
+
+
+bool dengine::isGpuMemoryCategory(MemoryCategory category)
+{
+	return category >= MemoryCategory::VertexBuffers;
+}
+
+
+long long dengine::getTextureStorageSize(int width, int height, int levels, int bytesPerTexel)
+{
+	long long size = 0;
+	for (int level = 0; level < levels; level++)
+	{
+		size += static_cast<long long>(width) * height * bytesPerTexel;
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	return size;
+}
+
+
+unsigned long long makeMemoryKey(dengine::MemoryCategory category, unsigned long long value)
+{
+	return (static_cast<unsigned long long>(category) << 56) | value;
+}
+
+
+void addBytes(dengine::MemoryStatistics& statistics, long long bytes)
+{
+	statistics.Live += bytes;
+	statistics.Peak = std::max(statistics.Peak, statistics.Live);
+	if (bytes > 0)
+		statistics.Allocations++;
+}
+
+
+dengine::TrackingMemoryResource::TrackingMemoryResource(MemoryTracker& tracker, MemoryCategory category,
+	size_t assetIndex, std::pmr::memory_resource* upstream) :
+	tracker(tracker), category(category), assetIndex(assetIndex), upstream(upstream)
+{
+}
+
+
+void* dengine::TrackingMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	void* pointer = upstream->allocate(bytes, alignment);
+	tracker.accountCpu(category, assetIndex, static_cast<long long>(bytes));
+	return pointer;
+}
+
+
+void dengine::TrackingMemoryResource::do_deallocate(void* pointer, size_t bytes, size_t alignment)
+{
+	upstream->deallocate(pointer, bytes, alignment);
+	tracker.accountCpu(category, assetIndex, -static_cast<long long>(bytes));
+}
+
+
+bool dengine::TrackingMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+
+dengine::MemoryTracker& dengine::MemoryTracker::Get()
+{
+	static MemoryTracker memoryTracker;
+	return memoryTracker;
+}
+
+
+void dengine::MemoryTracker::TrackGpuObject(MemoryCategory category, unsigned int object, long long bytes,
+	std::string_view asset)
+{
+	std::lock_guard lock(mutex);
+	const auto assetIndex = getAssetIndex(asset);
+	auto [objectIter, inserted] = gpuObjects.try_emplace(makeMemoryKey(category, object), GpuObject{ 0, assetIndex });
+	if (!inserted)
+		account(category, objectIter->second.AssetIndex, -objectIter->second.Bytes);
+	objectIter->second = GpuObject{ bytes, assetIndex };
+	account(category, assetIndex, bytes);
+}
+
+
+void dengine::MemoryTracker::ReleaseGpuObject(MemoryCategory category, unsigned int object)
+{
+	std::lock_guard lock(mutex);
+	auto objectIter = gpuObjects.find(makeMemoryKey(category, object));
+	if (objectIter == gpuObjects.end())
+		return;
+	account(category, objectIter->second.AssetIndex, -objectIter->second.Bytes);
+	gpuObjects.erase(objectIter);
+}
+
+
+std::pmr::memory_resource* dengine::MemoryTracker::GetCpuResource(MemoryCategory category, std::string_view asset)
+{
+	std::lock_guard lock(mutex);
+	const auto assetIndex = getAssetIndex(asset);
+	auto& resource = cpuResourceIndices[makeMemoryKey(category, assetIndex)];
+	if (resource == nullptr)
+	{
+		cpuResources.push_back(std::make_unique<TrackingMemoryResource>(*this, category, assetIndex,
+			std::pmr::new_delete_resource()));
+		resource = cpuResources.back().get();
+	}
+	return resource;
+}
+
+
+dengine::MemoryReport dengine::MemoryTracker::GetReport() const
+{
+	std::lock_guard lock(mutex);
+	MemoryReport report;
+	report.Cpu = cpu;
+	report.Gpu = gpu;
+	report.Categories = categories;
+	report.Assets = assets;
+	std::sort(report.Assets.begin(), report.Assets.end(), [](const auto& left, const auto& right)
+	{
+		auto total = [](const AssetMemoryReport& asset)
+		{
+			long long live = 0;
+			for (auto& category : asset.Categories)
+				live += category.Live;
+			return live;
+		};
+		return total(left) > total(right);
+	});
+	return report;
+}
+
+
+size_t dengine::MemoryTracker::getAssetIndex(std::string_view asset)
+{
+	std::pmr::string assetName(asset.empty() ? std::string_view("unnamed") : asset);
+	auto [indexIter, inserted] = assetIndices.try_emplace(assetName, assets.size());
+	if (inserted)
+		assets.push_back(AssetMemoryReport{ std::move(assetName) });
+	return indexIter->second;
+}
+
+
+void dengine::MemoryTracker::accountCpu(MemoryCategory category, size_t assetIndex, long long bytes)
+{
+	std::lock_guard lock(mutex);
+	account(category, assetIndex, bytes);
+}
+
+
+void dengine::MemoryTracker::account(MemoryCategory category, size_t assetIndex, long long bytes)
+{
+	addBytes(isGpuMemoryCategory(category) ? gpu : cpu, bytes);
+	addBytes(categories[static_cast<size_t>(category)], bytes);
+	addBytes(assets[assetIndex].Categories[static_cast<size_t>(category)], bytes);
+}
+
+
+void writeMemoryStatistics(std::FILE* file, const dengine::MemoryStatistics& statistics)
+{
+	std::fprintf(file, "{\"live\": %lld, \"peak\": %lld, \"allocations\": %llu}", statistics.Live, statistics.Peak,
+		statistics.Allocations);
+}
+
+
+void writeMemoryCategories(std::FILE* file, const std::array<dengine::MemoryStatistics, dengine::MemoryCategoryCount>& categories,
+	const char* indent)
+{
+	std::fprintf(file, "{\n");
+	for (size_t i = 0; i < categories.size(); i++)
+	{
+		std::fprintf(file, "%s  \"%s\": ", indent, dengine::getMemoryCategoryName(static_cast<dengine::MemoryCategory>(i)));
+		writeMemoryStatistics(file, categories[i]);
+		std::fprintf(file, "%s\n", i + 1 == categories.size() ? "" : ",");
+	}
+	std::fprintf(file, "%s}", indent);
+}
+
+
+bool dengine::writeMemoryReportJson(const std::pmr::string& path, const MemoryReport& report)
+{
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr)
+		return false;
+
+	std::fprintf(file, "{\n  \"cpu\": ");
+	writeMemoryStatistics(file, report.Cpu);
+	std::fprintf(file, ",\n  \"gpu\": ");
+	writeMemoryStatistics(file, report.Gpu);
+	std::fprintf(file, ",\n  \"categories\": ");
+	writeMemoryCategories(file, report.Categories, "  ");
+	std::fprintf(file, ",\n  \"assets\": [\n");
+	for (size_t i = 0; i < report.Assets.size(); i++)
+	{
+		auto& asset = report.Assets[i];
+		std::fprintf(file, "    {\n      \"name\": ");
+		writeJsonString(file, asset.Name);
+		std::fprintf(file, ",\n      \"categories\": ");
+		writeMemoryCategories(file, asset.Categories, "      ");
+		std::fprintf(file, "\n    }%s\n", i + 1 == report.Assets.size() ? "" : ",");
+	}
+	std::fprintf(file, "  ]\n}\n");
+	return std::fclose(file) == 0;
+}
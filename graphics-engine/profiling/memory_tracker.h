@@ -0,0 +1,118 @@
+#ifndef MEMORY_TRACKER_INCLUDED
+#define MEMORY_TRACKER_INCLUDED
+
+#include <array>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dengine
+{
+	enum class MemoryCategory {
+		//cpu
+		ImportedMeshes,
+		ImportedTextures,
+		//gpu
+		VertexBuffers,
+		IndexBuffers,
+		InstanceBuffers,
+		UniformBuffers,
+		Textures,
+		RenderTargets,
+		ReadbackBuffers,
+		Count,
+	};
+
+	constexpr size_t MemoryCategoryCount = static_cast<size_t>(MemoryCategory::Count);
+
+	const char* getMemoryCategoryName(MemoryCategory category);
+	bool isGpuMemoryCategory(MemoryCategory category);
+	//bytes of immutable storage with levels mips, each mip half size of previous one
+	long long getTextureStorageSize(int width, int height, int levels, int bytesPerTexel);
+
+
+	struct MemoryStatistics {
+		long long Live{ 0 };
+		long long Peak{ 0 };
+		unsigned long long Allocations{ 0 };
+	};
+
+	struct AssetMemoryReport {
+		std::pmr::string Name;
+		std::array<MemoryStatistics, MemoryCategoryCount> Categories;
+	};
+
+	struct MemoryReport {
+		MemoryStatistics Cpu;
+		MemoryStatistics Gpu;
+		std::array<MemoryStatistics, MemoryCategoryCount> Categories;
+		std::pmr::vector<AssetMemoryReport> Assets;
+	};
+
+
+	class MemoryTracker;
+
+	//forwards to upstream and counts every allocation under one category and asset
+	class TrackingMemoryResource : public std::pmr::memory_resource {
+	public:
+		TrackingMemoryResource(MemoryTracker& tracker, MemoryCategory category, size_t assetIndex,
+			std::pmr::memory_resource* upstream);
+	private:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+		MemoryTracker& tracker;
+		MemoryCategory category;
+		size_t assetIndex;
+		std::pmr::memory_resource* upstream;
+	};
+
+
+	//live and peak bytes per category and owning asset, safe to call from any thread
+	class MemoryTracker {
+	public:
+		static MemoryTracker& Get();
+
+		//gl names are unique per object type only, so objects are identified by category and name
+		//tracking already tracked object replaces its previous size, as after glNamedBufferData on same buffer
+		void TrackGpuObject(MemoryCategory category, unsigned int object, long long bytes, std::string_view asset);
+		void ReleaseGpuObject(MemoryCategory category, unsigned int object);
+		//resource lives as long as tracker, containers built with it are counted until they free their memory
+		std::pmr::memory_resource* GetCpuResource(MemoryCategory category, std::string_view asset);
+
+		MemoryReport GetReport() const;
+	private:
+		friend class TrackingMemoryResource;
+
+		struct GpuObject {
+			long long Bytes;
+			size_t AssetIndex;
+		};
+
+		MemoryTracker() = default;
+		size_t getAssetIndex(std::string_view asset);
+		void accountCpu(MemoryCategory category, size_t assetIndex, long long bytes);
+		//caller holds mutex
+		void account(MemoryCategory category, size_t assetIndex, long long bytes);
+
+		mutable std::mutex mutex;
+		MemoryStatistics cpu;
+		MemoryStatistics gpu;
+		std::array<MemoryStatistics, MemoryCategoryCount> categories;
+		std::pmr::vector<AssetMemoryReport> assets;
+		std::pmr::unordered_map<std::pmr::string, size_t> assetIndices;
+		std::pmr::unordered_map<unsigned long long, GpuObject> gpuObjects;
+		std::pmr::vector<std::unique_ptr<TrackingMemoryResource>> cpuResources;
+		std::pmr::unordered_map<unsigned long long, TrackingMemoryResource*> cpuResourceIndices;
+	};
+
+
+	bool writeMemoryReportJson(const std::pmr::string& path, const MemoryReport& report);
+}
+
+#endif
@@ -0,0 +1,164 @@
+#include <profiling/profiler.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+	thread_local dengine::ProfilerThreadBuffer* currentThreadBuffer = nullptr;
+}
+
+
+dengine::Profiler& dengine::Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+
+dengine::Profiler::Profiler() : epoch(std::chrono::steady_clock::now())
+{
+}
+
+
+void dengine::Profiler::BeginZone(const char* name)
+{
+	getThreadBuffer().OpenZones.push_back(ProfilerThreadBuffer::OpenZone{ name, Now() });
+}
+
+
+void dengine::Profiler::EndZone()
+{
+	const long long end = Now();
+	auto& threadBuffer = getThreadBuffer();
+	const auto openZone = threadBuffer.OpenZones.back();
+	threadBuffer.OpenZones.pop_back();
+	//sequence is raised before buffer is picked, so NewFrame either sees write in progress or write sees flip
+	const unsigned int sequence = threadBuffer.WriteSequence.load(std::memory_order_relaxed);
+	threadBuffer.WriteSequence.store(sequence + 1, std::memory_order_seq_cst);
+	auto& events = threadBuffer.Events[threadBuffer.WriteIndex.load(std::memory_order_seq_cst)];
+	events.push_back(ProfileEvent{ openZone.Name, openZone.Start, end,
+		static_cast<unsigned int>(threadBuffer.OpenZones.size()), threadBuffer.ThreadIndex });
+	threadBuffer.WriteSequence.store(sequence + 2, std::memory_order_release);
+}
+
+
+void dengine::Profiler::AddGpuEvents(std::span<const ProfileEvent> events)
+{
+	lastGpuFrame.assign(events.begin(), events.end());
+	if (captureFramesLeft > 0)
+		capturedEvents.insert(capturedEvents.end(), events.begin(), events.end());
+}
+
+
+void dengine::Profiler::NewFrame()
+{
+	lastFrame.clear();
+	{
+		std::lock_guard buffersLock(buffersMutex);
+		for (auto& threadBuffer : threadBuffers)
+		{
+			const unsigned int drainIndex = threadBuffer->WriteIndex.load(std::memory_order_relaxed);
+			threadBuffer->WriteIndex.store(drainIndex ^ 1, std::memory_order_seq_cst);
+			//only write that started before flip can still target drained buffer, later ones go to other one
+			const unsigned int sequence = threadBuffer->WriteSequence.load(std::memory_order_seq_cst);
+			if (sequence % 2 != 0)
+				while (threadBuffer->WriteSequence.load(std::memory_order_acquire) == sequence)
+					std::this_thread::yield();
+			auto& events = threadBuffer->Events[drainIndex];
+			lastFrame.insert(lastFrame.end(), events.begin(), events.end());
+			events.clear();
+		}
+	}
+	//zones finish children first, order them as tree per thread
+	std::sort(lastFrame.begin(), lastFrame.end(), [](const auto& left, const auto& right)
+	{
+		if (left.ThreadIndex != right.ThreadIndex)
+			return left.ThreadIndex < right.ThreadIndex;
+		if (left.Start != right.Start)
+			return left.Start < right.Start;
+		return left.Depth < right.Depth;
+	});
+
+	if (captureFramesLeft == 0)
+		return;
+	capturedEvents.insert(capturedEvents.end(), lastFrame.begin(), lastFrame.end());
+	if (--captureFramesLeft > 0)
+		return;
+	auto logger = spdlog::get("app_logger");
+	if (writeChromeTrace(capturePath, capturedEvents))
+		logger->info("profiler capture written to {}", capturePath.c_str());
+	else
+		logger->error("failed to write profiler capture to {}", capturePath.c_str());
+	capturedEvents.clear();
+}
+
+
+long long dengine::Profiler::Now() const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+
+void dengine::Profiler::StartCapture(unsigned int frameCount, const std::pmr::string& path)
+{
+	capturedEvents.clear();
+	capturePath = path;
+	captureFramesLeft = frameCount;
+}
+
+
+bool dengine::Profiler::IsCapturing() const
+{
+	return captureFramesLeft > 0;
+}
+
+
+const std::pmr::vector<dengine::ProfileEvent>& dengine::Profiler::GetLastFrame() const
+{
+	return lastFrame;
+}
+
+
+const std::pmr::vector<dengine::ProfileEvent>& dengine::Profiler::GetLastGpuFrame() const
+{
+	return lastGpuFrame;
+}
+
+
+dengine::ProfilerThreadBuffer& dengine::Profiler::getThreadBuffer()
+{
+	if (currentThreadBuffer != nullptr)
+		return *currentThreadBuffer;
+
+	//buffers live as long as profiler, so events of finished threads are still collected
+	std::lock_guard lock(buffersMutex);
+	auto& threadBuffer = threadBuffers.emplace_back(std::make_unique<ProfilerThreadBuffer>());
+	threadBuffer->ThreadIndex = static_cast<unsigned int>(threadBuffers.size() - 1);
+	currentThreadBuffer = threadBuffer.get();
+	return *currentThreadBuffer;
+}
+
+
+bool dengine::writeChromeTrace(const std::pmr::string& path, const std::pmr::vector<ProfileEvent>& events)
+{
+	std::FILE* file = std::fopen(path.c_str(), "w");
+	if (file == nullptr)
+		return false;
+
+	//cpu threads share process 0, gpu zones get process 1 so both timelines are shown separately
+	std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"cpu\"}},\n");
+	std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"gpu\"}}");
+	for (auto& event : events)
+	{
+		const bool gpuEvent = event.ThreadIndex == GpuProfileThreadIndex;
+		std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u}",
+			event.Name, static_cast<double>(event.Start) / 1000.0, static_cast<double>(event.End - event.Start) / 1000.0,
+			gpuEvent ? 1 : 0, gpuEvent ? 0u : event.ThreadIndex);
+	}
+	std::fprintf(file, "\n]}\n");
+	return std::fclose(file) == 0;
+}
@@ -0,0 +1,110 @@
+#ifndef PROFILER_INCLUDED
+#define PROFILER_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+//zones are compiled in only where DENGINE_ENABLE_PROFILING is defined: debug configurations of graphics-engine.vcxproj
+//define it, release ones do not, benchmarks build has cmake option of same name
+
+namespace dengine
+{
+	//ThreadIndex of zones measured on GPU
+	constexpr unsigned int GpuProfileThreadIndex = 0xFFFFFFFF;
+
+	//times are nanoseconds since profiler creation, name must be string literal
+	struct ProfileEvent {
+		const char* Name;
+		long long Start;
+		long long End;
+		unsigned int Depth;
+		unsigned int ThreadIndex;
+	};
+
+
+	struct ProfilerThreadBuffer {
+		struct OpenZone {
+			const char* Name;
+			long long Start;
+		};
+
+		unsigned int ThreadIndex{ 0 };
+		//touched only by owning thread
+		std::pmr::vector<OpenZone> OpenZones;
+		//finished zones, owning thread appends to Events[WriteIndex] without locking, NewFrame flips WriteIndex
+		//and drains other buffer once write that may still target it is done
+		std::pmr::vector<ProfileEvent> Events[2];
+		std::atomic<unsigned int> WriteIndex{ 0 };
+		//odd while owning thread appends an event
+		std::atomic<unsigned int> WriteSequence{ 0 };
+	};
+
+
+	//collects scoped zones from every thread, one frame at a time
+	class Profiler {
+	public:
+		static Profiler& Get();
+
+		void BeginZone(const char* name);
+		void EndZone();
+		void AddGpuEvents(std::span<const ProfileEvent> events);
+		//publishes zones finished since previous call as last frame, called once per frame from main thread
+		void NewFrame();
+		long long Now() const;
+
+		//events of next frameCount frames are written to chrome trace json at path
+		void StartCapture(unsigned int frameCount, const std::pmr::string& path);
+		bool IsCapturing() const;
+
+		const std::pmr::vector<ProfileEvent>& GetLastFrame() const;
+		const std::pmr::vector<ProfileEvent>& GetLastGpuFrame() const;
+	private:
+		Profiler();
+		ProfilerThreadBuffer& getThreadBuffer();
+
+		const std::chrono::steady_clock::time_point epoch;
+		std::mutex buffersMutex;
+		std::pmr::vector<std::unique_ptr<ProfilerThreadBuffer>> threadBuffers;
+		std::pmr::vector<ProfileEvent> lastFrame;
+		std::pmr::vector<ProfileEvent> lastGpuFrame;
+		std::pmr::vector<ProfileEvent> capturedEvents;
+		std::pmr::string capturePath;
+		unsigned int captureFramesLeft{ 0 };
+	};
+
+
+	class ProfileScope {
+	public:
+		explicit ProfileScope(const char* name)
+		{
+			Profiler::Get().BeginZone(name);
+		}
+
+		~ProfileScope()
+		{
+			Profiler::Get().EndZone();
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	};
+
+
+	bool writeChromeTrace(const std::pmr::string& path, const std::pmr::vector<ProfileEvent>& events);
+}
+
+#define DENGINE_PROFILE_CONCAT_INTERNAL(a, b) a##b
+#define DENGINE_PROFILE_CONCAT(a, b) DENGINE_PROFILE_CONCAT_INTERNAL(a, b)
+
+#ifdef DENGINE_ENABLE_PROFILING
+#define DENGINE_PROFILE_SCOPE(name) ::dengine::ProfileScope DENGINE_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define DENGINE_PROFILE_SCOPE(name) ((void)0)
+#endif
+
+#endif
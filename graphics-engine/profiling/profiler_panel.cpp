@@ -0,0 +1,64 @@
+#include <profiling/profiler_panel.h>
+
+#include <imgui.h>
+#include <profiling/profiler.h>
+
+const char* ProfilerCapturePath = "profile-trace.json";
+
+
+void drawProfileEvents(const char* tableId, const std::pmr::vector<dengine::ProfileEvent>& events)
+{
+	if (!ImGui::BeginTable(tableId, 2, ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable))
+		return;
+	ImGui::TableSetupColumn("zone");
+	ImGui::TableSetupColumn("ms");
+	ImGui::TableHeadersRow();
+	unsigned int threadIndex = 0;
+	for (size_t i = 0; i < events.size(); i++)
+	{
+		auto& event = events[i];
+		if (i == 0 || event.ThreadIndex != threadIndex)
+		{
+			threadIndex = event.ThreadIndex;
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			if (threadIndex == dengine::GpuProfileThreadIndex)
+				ImGui::Text("gpu");
+			else
+				ImGui::Text("thread %u", threadIndex);
+		}
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::Text("%*s%s", static_cast<int>(event.Depth + 1) * 2, "", event.Name);
+		ImGui::TableNextColumn();
+		ImGui::Text("%.3f", static_cast<double>(event.End - event.Start) / 1'000'000.0);
+	}
+	ImGui::EndTable();
+}
+
+
+void dengine::drawProfilerPanel()
+{
+	ImGui::Begin("profiler");
+#ifdef DENGINE_ENABLE_PROFILING
+	auto& profiler = Profiler::Get();
+	static int captureFrames = 120;
+	ImGui::InputInt("capture frames", &captureFrames);
+	if (profiler.IsCapturing())
+	{
+		ImGui::Text("capturing to %s", ProfilerCapturePath);
+	}
+	else if (ImGui::Button("capture chrome trace") && captureFrames > 0)
+	{
+		profiler.StartCapture(static_cast<unsigned int>(captureFrames), ProfilerCapturePath);
+	}
+
+	if (ImGui::CollapsingHeader("cpu", ImGuiTreeNodeFlags_DefaultOpen))
+		drawProfileEvents("cpu zones", profiler.GetLastFrame());
+	if (ImGui::CollapsingHeader("gpu", ImGuiTreeNodeFlags_DefaultOpen))
+		drawProfileEvents("gpu zones", profiler.GetLastGpuFrame());
+#else
+	ImGui::TextUnformatted("profiling is compiled out, define DENGINE_ENABLE_PROFILING to enable it");
+#endif
+	ImGui::End();
+}
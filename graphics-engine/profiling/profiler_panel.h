@@ -0,0 +1,10 @@
+#ifndef PROFILER_PANEL_INCLUDED
+#define PROFILER_PANEL_INCLUDED
+
+namespace dengine
+{
+	//dockable imgui window with zone tree of last frame and chrome trace capture
+	void drawProfilerPanel();
+}
+
+#endif
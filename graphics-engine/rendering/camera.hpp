@@ -16,6 +16,7 @@ namespace dengine
 			this->Position = other.Position;
 			this->Diraction = other.Diraction;
 			this->Up = other.Up;
+			return *this;
 		};
 	};
 
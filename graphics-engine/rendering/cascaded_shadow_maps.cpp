@@ -0,0 +1,588 @@
+#include <rendering/cascaded_shadow_maps.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <scene/transform_system.h>
+#include <profiling/gpu_profiler.h>
+#include <profiling/memory_tracker.h>
+
+
+//ATTRIBUTE BINDINGS, same locations as depth pre-pass
+constexpr unsigned int AttributePositionLocation = 0;
+constexpr unsigned int AttributeModelMatrixBaseLocation = 4;
+constexpr int AttributeModelRowCount = 3;
+//UNIFORM LOCATIONS
+constexpr int UniformLightViewProjectionLocation = 0;
+//UNIFORM BUFFER BINDINGS, must match pbr.frag and deferred_lighting.comp
+constexpr unsigned int UboShadowCascadesBinding = 2;
+//TEXTURE UNITS
+constexpr unsigned int ShadowMapUnit = 5;
+//cascade spheres are rounded up to this step, so their size does not flicker with float error
+constexpr float CascadeRadiusStep = 1.0f / 16.0f;
+
+
+dengine::CascadedShadowMaps::CascadedShadowMaps(entt::registry& registry) : registry(registry),
+	shadowProgram("shaders/shadow.vert", "shaders/depth.frag")
+{
+	registry.on_construct<PbrRenderingUnit>().connect<&CascadedShadowMaps::onCasterChanged>(*this);
+	registry.on_construct<TransformComponent>().connect<&CascadedShadowMaps::onCasterChanged>(*this);
+	registry.on_update<PbrRenderingUnit>().connect<&CascadedShadowMaps::onCasterChanged>(*this);
+	registry.on_update<TransformComponent>().connect<&CascadedShadowMaps::onTransformUpdated>(*this);
+	registry.on_destroy<PbrRenderingUnit>().connect<&CascadedShadowMaps::onCasterDestroyed>(*this);
+	registry.on_destroy<TransformComponent>().connect<&CascadedShadowMaps::onCasterDestroyed>(*this);
+
+	//entities created before shadow maps existed are static
+	for (auto entity : registry.view<PbrRenderingUnit, TransformComponent>())
+		getState(entity) = EntityState::Static;
+
+	unsigned int buffers[3];
+	glCreateBuffers(3, buffers);
+	instancesBuffer = buffers[0];
+	commandsBuffer = buffers[1];
+	cascadesBuffer = buffers[2];
+	glNamedBufferData(cascadesBuffer, sizeof(ShadowCascadesData), &cascadesData, GL_DYNAMIC_DRAW);
+	MemoryTracker::Get().TrackGpuObject(MemoryCategory::UniformBuffers, cascadesBuffer, sizeof(ShadowCascadesData),
+		"shadow maps");
+
+	//position only, pool buffers are attached when they are allocated
+	glCreateVertexArrays(1, &vao);
+	glVertexArrayAttribFormat(vao, AttributePositionLocation, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(vao, AttributePositionLocation, 0);
+	glEnableVertexArrayAttrib(vao, AttributePositionLocation);
+	for (int i = 0; i < AttributeModelRowCount; i++)
+	{
+		glVertexArrayAttribFormat(vao, AttributeModelMatrixBaseLocation + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4) * i);
+		glVertexArrayAttribBinding(vao, AttributeModelMatrixBaseLocation + i, 1);
+		glEnableVertexArrayAttrib(vao, AttributeModelMatrixBaseLocation + i);
+	}
+	glVertexArrayBindingDivisor(vao, 1, 1);
+	glVertexArrayVertexBuffer(vao, 1, instancesBuffer, 0, sizeof(PbrInstancesData));
+}
+
+
+dengine::CascadedShadowMaps::~CascadedShadowMaps()
+{
+	registry.on_construct<PbrRenderingUnit>().disconnect(*this);
+	registry.on_construct<TransformComponent>().disconnect(*this);
+	registry.on_update<PbrRenderingUnit>().disconnect(*this);
+	registry.on_update<TransformComponent>().disconnect(*this);
+	registry.on_destroy<PbrRenderingUnit>().disconnect(*this);
+	registry.on_destroy<TransformComponent>().disconnect(*this);
+
+	deleteRenderTargets();
+	glDeleteVertexArrays(1, &vao);
+	unsigned int buffers[5] = { instancesBuffer, commandsBuffer, cascadesBuffer, positionsBuffer, indicesBuffer };
+	glDeleteBuffers(5, buffers);
+	auto& memoryTracker = MemoryTracker::Get();
+	memoryTracker.ReleaseGpuObject(MemoryCategory::InstanceBuffers, instancesBuffer);
+	memoryTracker.ReleaseGpuObject(MemoryCategory::InstanceBuffers, commandsBuffer);
+	memoryTracker.ReleaseGpuObject(MemoryCategory::UniformBuffers, cascadesBuffer);
+	memoryTracker.ReleaseGpuObject(MemoryCategory::VertexBuffers, positionsBuffer);
+	memoryTracker.ReleaseGpuObject(MemoryCategory::IndexBuffers, indicesBuffer);
+}
+
+
+void dengine::CascadedShadowMaps::AddModels(std::span<const LoadedSceneModel> models)
+{
+	size_t vertexCount = poolVertices;
+	size_t indexCount = poolIndices;
+	for (size_t i = pooledModels; i < models.size(); i++)
+		for (auto& mesh : models[i].GpuModel.Meshes)
+		{
+			vertexCount += mesh.GetVertexAttributeLayout(Positions).Size / sizeof(glm::vec3);
+			indexCount += mesh.NumElements;
+		}
+	growPool(vertexCount, indexCount);
+
+	//positions are first stream of packed mesh buffer, copied on gpu without cpu round trip
+	for (; pooledModels < models.size(); pooledModels++)
+	{
+		const auto& loadedModel = models[pooledModels];
+		for (size_t i = 0; i < loadedModel.GpuModel.Meshes.size(); i++)
+		{
+			const auto& mesh = loadedModel.GpuModel.Meshes[i];
+			const auto positionsLayout = mesh.GetVertexAttributeLayout(Positions);
+			glCopyNamedBufferSubData(mesh.Vbo, positionsBuffer, positionsLayout.Offset, poolVertices * sizeof(glm::vec3),
+				positionsLayout.Size);
+			glCopyNamedBufferSubData(mesh.Ebo, indicesBuffer, 0, poolIndices * sizeof(unsigned int),
+				mesh.NumElements * sizeof(unsigned int));
+			poolMeshIndices[loadedModel.RenderingUnits[i].DepthVao] = static_cast<unsigned int>(poolMeshes.size());
+			poolMeshes.push_back(PoolMesh{ static_cast<unsigned int>(mesh.NumElements),
+				static_cast<unsigned int>(poolIndices), static_cast<int>(poolVertices) });
+			poolVertices += positionsLayout.Size / sizeof(glm::vec3);
+			poolIndices += mesh.NumElements;
+		}
+	}
+}
+
+
+void dengine::CascadedShadowMaps::Render(const GlobalEnvironment& environment, float fieldOfView, float aspect,
+	float nearPlane, float farPlane)
+{
+	DENGINE_PROFILE_SCOPE("shadow maps");
+	statistics = ShadowStatistics{};
+	const auto program = shadowProgram.Get();
+	if (program == 0 || environment.Sun.Color.a <= 0.0f)
+	{
+		rendered = false;
+		return;
+	}
+
+	const int cascadeCount = std::clamp(settings.CascadeCount, 1, MaxShadowCascades);
+	if (settings.Resolution != resolution || cascadeCount != layers)
+	{
+		deleteRenderTargets();
+		resolution = settings.Resolution;
+		layers = cascadeCount;
+		createRenderTargets();
+		for (auto& cascade : cascades)
+			cascade = Cascade{};
+	}
+
+	for (auto entity : newEntities)
+	{
+		auto& state = getState(entity);
+		if (state == EntityState::New)
+			state = EntityState::Static;
+	}
+	newEntities.clear();
+	//resting casters go back to static layers, which are redrawn with them once
+	const auto staticDelay = static_cast<size_t>(std::max(settings.StaticDelay, 1));
+	const auto restingBegin = std::remove_if(dynamicEntities.begin(), dynamicEntities.end(), [&](entt::entity entity)
+	{
+		if (frame - moveFrames[entt::to_entity(entity)] < staticDelay)
+			return false;
+		getState(entity) = EntityState::Static;
+		return true;
+	});
+	if (restingBegin != dynamicEntities.end())
+	{
+		dynamicEntities.erase(restingBegin, dynamicEntities.end());
+		staticDirty = true;
+	}
+	frame++;
+	if (staticDirty)
+	{
+		collectStaticCasters();
+		for (auto& cascade : cascades)
+			cascade.StaticValid = false;
+		staticDirty = false;
+	}
+	collectDynamicCasters();
+
+	const glm::vec3 sunDirection(environment.Sun.Direction);
+	const glm::vec3 lightDirection = glm::dot(sunDirection, sunDirection) > 0.0f
+		? glm::normalize(sunDirection)
+		: glm::vec3(0.0f, -1.0f, 0.0f);
+	const glm::mat4 inverseView = glm::inverse(environment.ViewMatrix);
+	const float shadowDistance = std::min(settings.MaxDistance, farPlane);
+
+	passes.clear();
+	instancesStaging.clear();
+	commandsStaging.clear();
+	float splitNear = nearPlane;
+	for (int i = 0; i < cascadeCount; i++)
+	{
+		//practical split scheme, blend of uniform and logarithmic splits
+		const float fraction = static_cast<float>(i + 1) / static_cast<float>(cascadeCount);
+		const float uniformSplit = nearPlane + (shadowDistance - nearPlane) * fraction;
+		const float logarithmicSplit = nearPlane * std::pow(shadowDistance / nearPlane, fraction);
+		const float splitFar = glm::mix(uniformSplit, logarithmicSplit, settings.SplitLambda);
+		const auto matrix = computeCascadeMatrix(inverseView, lightDirection, fieldOfView, aspect, splitNear, splitFar);
+		cascadesData.CascadeMatrices[i] = matrix;
+		cascadesData.CascadeSplits[i] = splitFar;
+		splitNear = splitFar;
+
+		auto& cascade = cascades[i];
+		if (matrix != cascade.Matrix)
+		{
+			cascade.Matrix = matrix;
+			cascade.StaticValid = false;
+		}
+		const bool staticChanged = !cascade.StaticValid;
+		if (staticChanged)
+		{
+			const auto firstCommand = static_cast<unsigned int>(commandsStaging.size());
+			passes.push_back(Pass{ i, true, firstCommand, appendCommands(staticCasters, matrix) });
+			cascade.StaticValid = true;
+			statistics.StaticCascadesRendered++;
+		}
+		//cascade that lost its dynamic casters is restored from static layer once more
+		const auto firstCommand = static_cast<unsigned int>(commandsStaging.size());
+		const auto dynamicCommands = appendCommands(dynamicCasters, matrix);
+		if (staticChanged || dynamicCommands > 0 || cascade.HadDynamic)
+		{
+			passes.push_back(Pass{ i, false, firstCommand, dynamicCommands });
+			statistics.CascadesRendered++;
+		}
+		cascade.HadDynamic = dynamicCommands > 0;
+	}
+	cascadesData.Parameters = glm::vec4(static_cast<float>(cascadeCount), 1.0f, 1.0f / static_cast<float>(resolution),
+		0.0f);
+	statistics.DrawCommands = static_cast<unsigned int>(commandsStaging.size());
+	statistics.Instances = instancesStaging.size();
+	statistics.DynamicEntities = dynamicEntities.size();
+	rendered = true;
+	if (passes.empty())
+		return;
+
+	//load data to gpu, both buffers are orphaned and grown geometrically
+	if (!instancesStaging.empty())
+	{
+		if (instancesStaging.size() > instancesCapacity)
+		{
+			instancesCapacity = std::max(instancesStaging.size(), instancesCapacity * 2);
+			MemoryTracker::Get().TrackGpuObject(MemoryCategory::InstanceBuffers, instancesBuffer,
+				static_cast<long long>(instancesCapacity * sizeof(PbrInstancesData)), "shadow maps");
+		}
+		glNamedBufferData(instancesBuffer, instancesCapacity * sizeof(PbrInstancesData), nullptr, GL_STREAM_DRAW);
+		glNamedBufferSubData(instancesBuffer, 0, instancesStaging.size() * sizeof(PbrInstancesData),
+			instancesStaging.data());
+	}
+	if (!commandsStaging.empty())
+	{
+		if (commandsStaging.size() > commandsCapacity)
+		{
+			commandsCapacity = std::max(commandsStaging.size(), commandsCapacity * 2);
+			MemoryTracker::Get().TrackGpuObject(MemoryCategory::InstanceBuffers, commandsBuffer,
+				static_cast<long long>(commandsCapacity * sizeof(IndirectCommand)), "shadow maps");
+		}
+		glNamedBufferData(commandsBuffer, commandsCapacity * sizeof(IndirectCommand), nullptr, GL_STREAM_DRAW);
+		glNamedBufferSubData(commandsBuffer, 0, commandsStaging.size() * sizeof(IndirectCommand), commandsStaging.data());
+	}
+
+	DENGINE_PROFILE_GPU_SCOPE("shadow maps");
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, resolution, resolution);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	//casters between light and cascade are flattened onto near plane instead of being clipped
+	glEnable(GL_DEPTH_CLAMP);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+	glUseProgram(program);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandsBuffer);
+	for (auto& pass : passes)
+	{
+		if (pass.Static)
+		{
+			glNamedFramebufferTextureLayer(fbo, GL_DEPTH_ATTACHMENT, staticShadowMap, 0, pass.Cascade);
+			glClear(GL_DEPTH_BUFFER_BIT);
+		}
+		else
+		{
+			glCopyImageSubData(staticShadowMap, GL_TEXTURE_2D_ARRAY, 0, 0, 0, pass.Cascade,
+				shadowMap, GL_TEXTURE_2D_ARRAY, 0, 0, 0, pass.Cascade, resolution, resolution, 1);
+			glNamedFramebufferTextureLayer(fbo, GL_DEPTH_ATTACHMENT, shadowMap, 0, pass.Cascade);
+		}
+		if (pass.CommandCount == 0)
+			continue;
+		glProgramUniformMatrix4fv(program, UniformLightViewProjectionLocation, 1, GL_FALSE,
+			glm::value_ptr(cascades[pass.Cascade].Matrix));
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			reinterpret_cast<const void*>(pass.FirstCommand * sizeof(IndirectCommand)), pass.CommandCount, 0);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_DEPTH_CLAMP);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+void dengine::CascadedShadowMaps::Bind(bool enabled) const
+{
+	ShadowCascadesData data = cascadesData;
+	data.Parameters.y = enabled && rendered ? 1.0f : 0.0f;
+	glNamedBufferSubData(cascadesBuffer, 0, sizeof(ShadowCascadesData), &data);
+	glBindBufferBase(GL_UNIFORM_BUFFER, UboShadowCascadesBinding, cascadesBuffer);
+	glBindTextureUnit(ShadowMapUnit, shadowMap);
+}
+
+
+void dengine::CascadedShadowMaps::Reload()
+{
+	shadowProgram.Compile();
+}
+
+
+void dengine::CascadedShadowMaps::Update()
+{
+	shadowProgram.Update(false);
+}
+
+
+bool dengine::CascadedShadowMaps::IsCompiling() const
+{
+	return shadowProgram.IsCompiling();
+}
+
+
+dengine::ShadowSettings& dengine::CascadedShadowMaps::GetSettings()
+{
+	return settings;
+}
+
+
+const dengine::ShadowStatistics& dengine::CascadedShadowMaps::GetStatistics() const
+{
+	return statistics;
+}
+
+
+void dengine::CascadedShadowMaps::onCasterChanged(entt::registry&, entt::entity entity)
+{
+	auto& state = getState(entity);
+	if (state == EntityState::Untracked)
+	{
+		state = EntityState::New;
+		newEntities.push_back(entity);
+	}
+	staticDirty = staticDirty || state != EntityState::Dynamic;
+}
+
+
+void dengine::CascadedShadowMaps::onTransformUpdated(entt::registry&, entt::entity entity)
+{
+	//moved static entity leaves static layers, which have to be redrawn without it
+	auto& state = getState(entity);
+	if (state == EntityState::Static)
+	{
+		state = EntityState::Dynamic;
+		dynamicEntities.push_back(entity);
+		staticDirty = true;
+	}
+	if (state == EntityState::Dynamic)
+		moveFrames[entt::to_entity(entity)] = frame;
+	else if (state == EntityState::Untracked)
+	{
+		onCasterChanged(registry, entity);
+	}
+}
+
+
+void dengine::CascadedShadowMaps::onCasterDestroyed(entt::registry&, entt::entity entity)
+{
+	auto& state = getState(entity);
+	if (state == EntityState::Static)
+		staticDirty = true;
+	else if (state == EntityState::Dynamic)
+		dynamicEntities.erase(std::find(dynamicEntities.begin(), dynamicEntities.end(), entity));
+	state = EntityState::Untracked;
+}
+
+
+dengine::CascadedShadowMaps::EntityState& dengine::CascadedShadowMaps::getState(entt::entity entity)
+{
+	const auto entityIndex = entt::to_entity(entity);
+	if (states.size() <= entityIndex)
+	{
+		states.resize(entityIndex + 1, EntityState::Untracked);
+		moveFrames.resize(entityIndex + 1, 0);
+	}
+	return states[entityIndex];
+}
+
+
+glm::vec4 getWorldBoundingSphere(const glm::vec4& boundingSphere, const glm::mat4& modelMatrix)
+{
+	const glm::vec3 center(modelMatrix * glm::vec4(glm::vec3(boundingSphere), 1.0f));
+	const float scale = std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])),
+		glm::length(glm::vec3(modelMatrix[2])) });
+	return glm::vec4(center, boundingSphere.w * scale);
+}
+
+
+void dengine::CascadedShadowMaps::collectStaticCasters()
+{
+	DENGINE_PROFILE_SCOPE("collect static casters");
+	staticCasters.clear();
+	auto view = registry.view<PbrRenderingUnit, TransformComponent>();
+	for (auto entity : view)
+	{
+		if (getState(entity) == EntityState::Dynamic)
+			continue;
+		const auto& [renderingUnit, transform] = view.get<PbrRenderingUnit, TransformComponent>(entity);
+		const auto meshIter = poolMeshIndices.find(renderingUnit.DepthVao);
+		if (meshIter != poolMeshIndices.end())
+			staticCasters.push_back(Caster{ meshIter->second,
+				getWorldBoundingSphere(renderingUnit.BoundingSphere, transform.ModelMatrix),
+				PbrInstancesData{ transform.ModelMatrix } });
+	}
+	std::sort(staticCasters.begin(), staticCasters.end(), [](const auto& left, const auto& right)
+	{
+		return left.Mesh < right.Mesh;
+	});
+}
+
+
+void dengine::CascadedShadowMaps::collectDynamicCasters()
+{
+	dynamicCasters.clear();
+	for (auto entity : dynamicEntities)
+	{
+		if (!registry.all_of<PbrRenderingUnit, TransformComponent>(entity))
+			continue;
+		const auto& renderingUnit = registry.get<PbrRenderingUnit>(entity);
+		const auto meshIter = poolMeshIndices.find(renderingUnit.DepthVao);
+		if (meshIter == poolMeshIndices.end())
+			continue;
+		const auto& modelMatrix = registry.get<TransformComponent>(entity).ModelMatrix;
+		dynamicCasters.push_back(Caster{ meshIter->second, getWorldBoundingSphere(renderingUnit.BoundingSphere, modelMatrix),
+			PbrInstancesData{ modelMatrix } });
+	}
+	std::sort(dynamicCasters.begin(), dynamicCasters.end(), [](const auto& left, const auto& right)
+	{
+		return left.Mesh < right.Mesh;
+	});
+}
+
+
+unsigned int dengine::CascadedShadowMaps::appendCommands(std::span<const Caster> casters, const glm::mat4& cascadeMatrix)
+{
+	//cascade matrix is orthographic, so sphere is tested in clip space with radius scaled per axis,
+	//near side is not tested because casters in front of cascade are clamped onto it
+	const glm::vec3 axisScale(
+		glm::length(glm::vec3(cascadeMatrix[0][0], cascadeMatrix[1][0], cascadeMatrix[2][0])),
+		glm::length(glm::vec3(cascadeMatrix[0][1], cascadeMatrix[1][1], cascadeMatrix[2][1])),
+		glm::length(glm::vec3(cascadeMatrix[0][2], cascadeMatrix[1][2], cascadeMatrix[2][2])));
+	const auto firstCommand = commandsStaging.size();
+	unsigned int lastMesh = std::numeric_limits<unsigned int>::max();
+	for (auto& caster : casters)
+	{
+		const glm::vec3 center(cascadeMatrix * glm::vec4(glm::vec3(caster.BoundingSphere), 1.0f));
+		const glm::vec3 radius = axisScale * caster.BoundingSphere.w;
+		if (std::abs(center.x) > 1.0f + radius.x || std::abs(center.y) > 1.0f + radius.y || center.z - radius.z > 1.0f)
+			continue;
+		if (caster.Mesh != lastMesh || commandsStaging.size() == firstCommand)
+		{
+			const auto& poolMesh = poolMeshes[caster.Mesh];
+			commandsStaging.push_back(IndirectCommand{ poolMesh.IndexCount, 0, poolMesh.FirstIndex, poolMesh.BaseVertex,
+				static_cast<unsigned int>(instancesStaging.size()) });
+			lastMesh = caster.Mesh;
+		}
+		commandsStaging.back().InstanceCount++;
+		instancesStaging.push_back(caster.Instance);
+	}
+	return static_cast<unsigned int>(commandsStaging.size() - firstCommand);
+}
+
+
+glm::mat4 dengine::CascadedShadowMaps::computeCascadeMatrix(const glm::mat4& inverseView,
+	const glm::vec3& lightDirection, float fieldOfView, float aspect, float nearSplit, float farSplit) const
+{
+	//bounding sphere of frustum slice does not change with camera rotation, its center lies on view axis
+	//equally far from near and far corners
+	const float tanHalfFov = std::tan(glm::radians(fieldOfView) * 0.5f);
+	const float diagonalSlope = tanHalfFov * tanHalfFov * (1.0f + aspect * aspect);
+	float centerDepth = (nearSplit + farSplit) * 0.5f * (1.0f + diagonalSlope);
+	float radius;
+	if (centerDepth >= farSplit)
+	{
+		centerDepth = farSplit;
+		radius = farSplit * std::sqrt(diagonalSlope);
+	}
+	else
+	{
+		radius = std::sqrt((farSplit - centerDepth) * (farSplit - centerDepth) + farSplit * farSplit * diagonalSlope);
+	}
+	radius = std::ceil(radius / CascadeRadiusStep) * CascadeRadiusStep;
+	const glm::vec3 center(inverseView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+
+	//light view is fixed for given direction, center snapped to whole texels keeps shadow edges from swimming
+	//and keeps matrix of cascade unchanged while camera moves within one texel
+	const glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+	const float texelSize = 2.0f * radius / static_cast<float>(resolution);
+	glm::vec3 lightCenter(lightView * glm::vec4(center, 1.0f));
+	lightCenter = glm::floor(lightCenter / texelSize) * texelSize;
+	const glm::mat4 projection = glm::ortho(lightCenter.x - radius, lightCenter.x + radius, lightCenter.y - radius,
+		lightCenter.y + radius, -lightCenter.z - radius, -lightCenter.z + radius);
+	return projection * lightView;
+}
+
+
+void dengine::CascadedShadowMaps::createRenderTargets()
+{
+	glCreateFramebuffers(1, &fbo);
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &shadowMap);
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &staticShadowMap);
+	glTextureStorage3D(shadowMap, 1, GL_DEPTH_COMPONENT32F, resolution, resolution, layers);
+	glTextureStorage3D(staticShadowMap, 1, GL_DEPTH_COMPONENT32F, resolution, resolution, layers);
+	//hardware compare, every fetch of pcf kernel is already bilinear
+	glTextureParameteri(shadowMap, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(shadowMap, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(shadowMap, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(shadowMap, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(shadowMap, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTextureParameteri(shadowMap, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	auto& memoryTracker = MemoryTracker::Get();
+	memoryTracker.TrackGpuObject(MemoryCategory::RenderTargets, shadowMap,
+		getTextureStorageSize(resolution, resolution, 1, 4) * layers, "shadow maps");
+	memoryTracker.TrackGpuObject(MemoryCategory::RenderTargets, staticShadowMap,
+		getTextureStorageSize(resolution, resolution, 1, 4) * layers, "shadow maps");
+	glNamedFramebufferDrawBuffer(fbo, GL_NONE);
+	glNamedFramebufferReadBuffer(fbo, GL_NONE);
+}
+
+
+void dengine::CascadedShadowMaps::deleteRenderTargets()
+{
+	if (fbo == 0)
+		return;
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &shadowMap);
+	glDeleteTextures(1, &staticShadowMap);
+	auto& memoryTracker = MemoryTracker::Get();
+	memoryTracker.ReleaseGpuObject(MemoryCategory::RenderTargets, shadowMap);
+	memoryTracker.ReleaseGpuObject(MemoryCategory::RenderTargets, staticShadowMap);
+	fbo = shadowMap = staticShadowMap = 0;
+	rendered = false;
+}
+
+
+void dengine::CascadedShadowMaps::growPool(size_t vertexCount, size_t indexCount)
+{
+	//new buffers receive old content on gpu, vao is pointed at them afterwards
+	auto& memoryTracker = MemoryTracker::Get();
+	if (vertexCount > poolVertexCapacity)
+	{
+		poolVertexCapacity = std::max(vertexCount, poolVertexCapacity * 2);
+		unsigned int buffer;
+		glCreateBuffers(1, &buffer);
+		glNamedBufferData(buffer, poolVertexCapacity * sizeof(glm::vec3), nullptr, GL_STATIC_DRAW);
+		if (positionsBuffer != 0)
+		{
+			glCopyNamedBufferSubData(positionsBuffer, buffer, 0, 0, poolVertices * sizeof(glm::vec3));
+			glDeleteBuffers(1, &positionsBuffer);
+			memoryTracker.ReleaseGpuObject(MemoryCategory::VertexBuffers, positionsBuffer);
+		}
+		positionsBuffer = buffer;
+		memoryTracker.TrackGpuObject(MemoryCategory::VertexBuffers, positionsBuffer,
+			static_cast<long long>(poolVertexCapacity * sizeof(glm::vec3)), "shadow maps");
+		glVertexArrayVertexBuffer(vao, 0, positionsBuffer, 0, sizeof(glm::vec3));
+	}
+	if (indexCount > poolIndexCapacity)
+	{
+		poolIndexCapacity = std::max(indexCount, poolIndexCapacity * 2);
+		unsigned int buffer;
+		glCreateBuffers(1, &buffer);
+		glNamedBufferData(buffer, poolIndexCapacity * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+		if (indicesBuffer != 0)
+		{
+			glCopyNamedBufferSubData(indicesBuffer, buffer, 0, 0, poolIndices * sizeof(unsigned int));
+			glDeleteBuffers(1, &indicesBuffer);
+			memoryTracker.ReleaseGpuObject(MemoryCategory::IndexBuffers, indicesBuffer);
+		}
+		indicesBuffer = buffer;
+		memoryTracker.TrackGpuObject(MemoryCategory::IndexBuffers, indicesBuffer,
+			static_cast<long long>(poolIndexCapacity * sizeof(unsigned int)), "shadow maps");
+		glVertexArrayElementBuffer(vao, indicesBuffer);
+	}
+}
@@ -0,0 +1,182 @@
+#ifndef CASCADED_SHADOW_MAPS_INCLUDED
+#define CASCADED_SHADOW_MAPS_INCLUDED
+
+#include <array>
+#include <span>
+#include <vector>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <rendering/global_environment.h>
+#include <scene/scene_builder.h>
+#include <utils/reloadable_program.h>
+
+namespace dengine
+{
+	constexpr int MaxShadowCascades = 4;
+
+
+	struct ShadowSettings {
+		int CascadeCount{ 4 };
+		int Resolution{ 2048 };
+		//shadows end at this view distance or at far plane, whichever is closer
+		float MaxDistance{ 50.0f };
+		//0 splits cascades uniformly, 1 logarithmically
+		float SplitLambda{ 0.8f };
+		//dynamic casters that did not move for this many frames return to static layers
+		int StaticDelay{ 60 };
+	};
+
+
+	//must match ShadowCascades block of pbr.frag and deferred_lighting.comp
+	struct ShadowCascadesData {
+		glm::mat4 CascadeMatrices[MaxShadowCascades];
+		//far view depth of every cascade
+		glm::vec4 CascadeSplits;
+		//x cascade count, y 1 when shadow maps are valid, z texel size
+		glm::vec4 Parameters;
+	};
+
+
+	//counters of last Render, cascades whose bounds and casters did not change are not drawn at all
+	struct ShadowStatistics {
+		unsigned int CascadesRendered{ 0 };
+		unsigned int StaticCascadesRendered{ 0 };
+		unsigned int DrawCommands{ 0 };
+		unsigned long long Instances{ 0 };
+		size_t DynamicEntities{ 0 };
+	};
+
+
+	//cascaded shadow maps of sun, the directional light of environment.
+	//entities are static until their transform changes after the frame they were created in and become static
+	//again once they rest for StaticDelay frames, static casters
+	//are kept per cascade in separate depth layer and re-rendered only when cascade bounds or static set change,
+	//dynamic casters are drawn over copy of that layer. every pass is single multi-draw over shared position pool
+	class CascadedShadowMaps {
+	public:
+		explicit CascadedShadowMaps(entt::registry& registry);
+		~CascadedShadowMaps();
+		CascadedShadowMaps(const CascadedShadowMaps&) = delete;
+		CascadedShadowMaps& operator=(const CascadedShadowMaps&) = delete;
+
+		//copies positions and indices of models not added yet into shadow geometry pool
+		void AddModels(std::span<const LoadedSceneModel> models);
+		//transforms must be already updated for this frame
+		void Render(const GlobalEnvironment& environment, float fieldOfView, float aspect, float nearPlane,
+			float farPlane);
+		//shaders skip shadowing when disabled or nothing was rendered yet
+		void Bind(bool enabled) const;
+		void Reload();
+		void Update();
+		bool IsCompiling() const;
+		ShadowSettings& GetSettings();
+		const ShadowStatistics& GetStatistics() const;
+	private:
+		struct PoolMesh {
+			unsigned int IndexCount;
+			unsigned int FirstIndex;
+			int BaseVertex;
+		};
+
+		//caster in world space, sorted by Mesh so equal meshes become one indirect command
+		struct Caster {
+			unsigned int Mesh;
+			glm::vec4 BoundingSphere;
+			PbrInstancesData Instance;
+		};
+
+		struct Cascade {
+			glm::mat4 Matrix{ 0.0f };
+			bool StaticValid{ false };
+			bool HadDynamic{ false };
+		};
+
+		//layout of glMultiDrawElementsIndirect
+		struct IndirectCommand {
+			unsigned int Count;
+			unsigned int InstanceCount;
+			unsigned int FirstIndex;
+			int BaseVertex;
+			unsigned int BaseInstance;
+		};
+
+		//static pass redraws cached layer, other pass copies it into shadow map and draws dynamic casters over it
+		struct Pass {
+			int Cascade;
+			bool Static;
+			unsigned int FirstCommand;
+			unsigned int CommandCount;
+		};
+
+		enum class EntityState : unsigned char {
+			Untracked,
+			//created since last Render, transform updates of creation frame are not movement
+			New,
+			Static,
+			Dynamic,
+		};
+
+		void onCasterChanged(entt::registry&, entt::entity entity);
+		void onTransformUpdated(entt::registry&, entt::entity entity);
+		void onCasterDestroyed(entt::registry&, entt::entity entity);
+		EntityState& getState(entt::entity entity);
+		void collectStaticCasters();
+		void collectDynamicCasters();
+		//appends commands of casters intersecting cascade, returns number of appended commands
+		unsigned int appendCommands(std::span<const Caster> casters, const glm::mat4& cascadeMatrix);
+		glm::mat4 computeCascadeMatrix(const glm::mat4& inverseView, const glm::vec3& lightDirection,
+			float fieldOfView, float aspect, float nearSplit, float farSplit) const;
+		void createRenderTargets();
+		void deleteRenderTargets();
+		void growPool(size_t vertexCount, size_t indexCount);
+
+		entt::registry& registry;
+		ShadowSettings settings;
+		ReloadableProgram shadowProgram;
+		std::array<Cascade, MaxShadowCascades> cascades;
+		ShadowCascadesData cascadesData{};
+		ShadowStatistics statistics;
+
+		std::pmr::vector<EntityState> states;
+		//frame of last transform update per entity index, meaningful for dynamic entities only
+		std::pmr::vector<size_t> moveFrames;
+		size_t frame{ 0 };
+		std::pmr::vector<entt::entity> newEntities;
+		std::pmr::vector<entt::entity> dynamicEntities;
+		bool staticDirty{ true };
+		std::pmr::vector<Caster> staticCasters;
+		std::pmr::vector<Caster> dynamicCasters;
+		std::pmr::vector<PbrInstancesData> instancesStaging;
+		std::pmr::vector<IndirectCommand> commandsStaging;
+		std::pmr::vector<Pass> passes;
+
+		std::pmr::vector<PoolMesh> poolMeshes;
+		//depth vao of rendering unit to index into poolMeshes
+		std::unordered_map<unsigned int, unsigned int> poolMeshIndices;
+		size_t pooledModels{ 0 };
+		size_t poolVertices{ 0 };
+		size_t poolIndices{ 0 };
+		size_t poolVertexCapacity{ 0 };
+		size_t poolIndexCapacity{ 0 };
+		unsigned int positionsBuffer{ 0 };
+		unsigned int indicesBuffer{ 0 };
+		unsigned int vao{ 0 };
+		unsigned int instancesBuffer{ 0 };
+		size_t instancesCapacity{ 0 };
+		unsigned int commandsBuffer{ 0 };
+		size_t commandsCapacity{ 0 };
+		unsigned int cascadesBuffer{ 0 };
+
+		//shadowMap is sampled, staticShadowMap caches static casters of every cascade
+		unsigned int fbo{ 0 };
+		unsigned int shadowMap{ 0 };
+		unsigned int staticShadowMap{ 0 };
+		int resolution{ 0 };
+		int layers{ 0 };
+		bool rendered{ false };
+	};
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include <rendering/deferred_shading.h>
+
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <profiling/gpu_profiler.h>
+
+
+//must match local size of deferred_lighting.comp
+constexpr int LightingTileSize = 16;
+//UNIFORM LOCATIONS
+constexpr int UniformInverseProjectionLocation = 0;
+constexpr int UniformInverseViewLocation = 1;
+constexpr int UniformRenderSizeLocation = 2;
+
+
+const dengine::ShaderStage LightingStages[] = { { GL_COMPUTE_SHADER, "shaders/deferred_lighting.comp" } };
+const char* const LambertLightingDefines[] = { "LAMBERT_LIGHTING" };
+
+
+dengine::DeferredShading::DeferredShading(RenderTargetPool& renderTargetPool) :
+	renderTargetPool(renderTargetPool), cookTorranceProgram(LightingStages), lambertProgram(LightingStages, LambertLightingDefines)
+{
+}
+
+
+dengine::DeferredShading::~DeferredShading()
+{
+	deleteRenderTargets();
+}
+
+
+unsigned int dengine::DeferredShading::GetFramebuffer(const RenderTarget& depthTarget)
+{
+	if (fbo == 0 || depthTarget.Texture != this->depthTarget.Texture || depthTarget.Width != this->depthTarget.Width ||
+		depthTarget.Height != this->depthTarget.Height)
+	{
+		deleteRenderTargets();
+		this->depthTarget = depthTarget;
+		createRenderTargets();
+	}
+	return fbo;
+}
+
+
+void dengine::DeferredShading::AccumulateLights(unsigned int colorTexture, glm::ivec2 renderSize,
+	const GlobalEnvironment& environment, PbrLightModel lightModel)
+{
+	DENGINE_PROFILE_SCOPE("light accumulation");
+	DENGINE_PROFILE_GPU_SCOPE("light accumulation");
+	const auto program = lightModel == PbrLightModel::Lambert ? lambertProgram.Get() : cookTorranceProgram.Get();
+	if (program == 0 || fbo == 0)
+		return;
+
+	glProgramUniformMatrix4fv(program, UniformInverseProjectionLocation, 1, GL_FALSE,
+		glm::value_ptr(glm::inverse(environment.ProjectionMatrix)));
+	glProgramUniformMatrix4fv(program, UniformInverseViewLocation, 1, GL_FALSE,
+		glm::value_ptr(glm::inverse(environment.ViewMatrix)));
+	glProgramUniform2i(program, UniformRenderSizeLocation, renderSize.x, renderSize.y);
+	glUseProgram(program);
+	glBindTextureUnit(0, depthTarget.Texture);
+	glBindTextureUnit(1, albedoMetallicTarget.Texture);
+	glBindTextureUnit(2, normalRoughnessTarget.Texture);
+	glBindImageTexture(0, colorTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glDispatchCompute((renderSize.x + LightingTileSize - 1) / LightingTileSize,
+		(renderSize.y + LightingTileSize - 1) / LightingTileSize, 1);
+	//color target is next sampled by ui, blitted or read back
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT);
+}
+
+
+void dengine::DeferredShading::Reload()
+{
+	cookTorranceProgram.Compile();
+	lambertProgram.Compile();
+}
+
+
+void dengine::DeferredShading::Update()
+{
+	cookTorranceProgram.Update(false);
+	lambertProgram.Update(false);
+}
+
+
+bool dengine::DeferredShading::IsCompiling() const
+{
+	return cookTorranceProgram.IsCompiling() || lambertProgram.IsCompiling();
+}
+
+
+void dengine::DeferredShading::createRenderTargets()
+{
+	//8 bytes per pixel besides shared depth, position is reconstructed from depth
+	glCreateFramebuffers(1, &fbo);
+	albedoMetallicTarget = renderTargetPool.Acquire(GL_RGBA8, depthTarget.Width, depthTarget.Height);
+	normalRoughnessTarget = renderTargetPool.Acquire(GL_RGB10_A2, depthTarget.Width, depthTarget.Height);
+	glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, depthTarget.Texture, 0);
+	glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, albedoMetallicTarget.Texture, 0);
+	glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT1, normalRoughnessTarget.Texture, 0);
+
+	GLenum drawBuffs[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glNamedFramebufferDrawBuffers(fbo, 2, drawBuffs);
+}
+
+
+void dengine::DeferredShading::deleteRenderTargets()
+{
+	if (fbo == 0)
+		return;
+	glDeleteFramebuffers(1, &fbo);
+	renderTargetPool.Release(albedoMetallicTarget);
+	renderTargetPool.Release(normalRoughnessTarget);
+	fbo = 0;
+}
@@ -0,0 +1,43 @@
+#ifndef DEFERRED_SHADING_INCLUDED
+#define DEFERRED_SHADING_INCLUDED
+
+#include <rendering/global_environment.h>
+#include <rendering/render_target_pool.h>
+#include <rendering/schemas/pbr_rendering_scheme.h>
+#include <utils/reloadable_program.h>
+
+namespace dengine
+{
+	//g-buffer and tiled light accumulation of deferred pbr path,
+	//g-buffer is allocated on first use so forward only runs do not pay for it
+	class DeferredShading {
+	public:
+		explicit DeferredShading(RenderTargetPool& renderTargetPool);
+		~DeferredShading();
+		DeferredShading(const DeferredShading&) = delete;
+		DeferredShading& operator=(const DeferredShading&) = delete;
+
+		//framebuffer of geometry pass, (re)creates g-buffer of depth target size when shared depth target changed
+		unsigned int GetFramebuffer(const RenderTarget& depthTarget);
+		//shades every pixel of lower left renderSize region covered by geometry pass into colorTexture, other pixels
+		//are left untouched; environment and lights buffers of preceding pbr dispatch have to be still bound
+		void AccumulateLights(unsigned int colorTexture, glm::ivec2 renderSize, const GlobalEnvironment& environment,
+			PbrLightModel lightModel);
+		void Reload();
+		void Update();
+		bool IsCompiling() const;
+	private:
+		void createRenderTargets();
+		void deleteRenderTargets();
+
+		RenderTargetPool& renderTargetPool;
+		ReloadableProgram cookTorranceProgram;
+		ReloadableProgram lambertProgram;
+		unsigned int fbo{ 0 };
+		RenderTarget albedoMetallicTarget;
+		RenderTarget normalRoughnessTarget;
+		RenderTarget depthTarget;
+	};
+}
+
+#endif
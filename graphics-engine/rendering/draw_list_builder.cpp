@@ -0,0 +1,151 @@
+#include <rendering/draw_list_builder.h>
+
+#include <algorithm>
+#include <array>
+#include <scene/transform_system.h>
+#include <profiling/profiler.h>
+
+//below this many entities building on workers costs more than it saves
+constexpr size_t ParallelBuildThreshold = 2048;
+
+
+void dengine::PbrDrawListBucket::Reset(size_t capacity)
+{
+	items.reset();
+	arena.reset();
+	const size_t requiredSize = capacity * sizeof(PbrDrawListItem) + alignof(PbrDrawListItem);
+	if (arenaStorage.size() < requiredSize)
+		arenaStorage.resize(requiredSize);
+	arena.emplace(arenaStorage.data(), arenaStorage.size());
+	items.emplace(&*arena);
+	items->reserve(capacity);
+}
+
+
+void dengine::PbrDrawListBucket::Push(const PbrDrawListItem& item)
+{
+	items->push_back(item);
+}
+
+
+void dengine::PbrDrawListBucket::Sort()
+{
+	std::sort(items->begin(), items->end(), [](const auto& left, const auto& right)
+	{
+		return left.Key < right.Key;
+	});
+}
+
+
+std::span<const dengine::PbrDrawListItem> dengine::PbrDrawListBucket::GetItems() const
+{
+	if (!items)
+		return {};
+	return *items;
+}
+
+
+std::array<glm::vec4, 6> dengine::extractFrustumPlanes(const glm::mat4& viewProjection)
+{
+	const glm::vec4 rowX(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	const glm::vec4 rowY(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	const glm::vec4 rowZ(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	const glm::vec4 rowW(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+	std::array<glm::vec4, 6> planes = {
+		rowW + rowX, rowW - rowX,
+		rowW + rowY, rowW - rowY,
+		rowW + rowZ, rowW - rowZ,
+	};
+	for (auto& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+	return planes;
+}
+
+
+bool isSphereVisible(const std::array<glm::vec4, 6>& planes, const glm::vec4& boundingSphere, const glm::mat4& modelMatrix)
+{
+	const glm::vec3 center(modelMatrix * glm::vec4(glm::vec3(boundingSphere), 1.0f));
+	const float scale = std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])),
+		glm::length(glm::vec3(modelMatrix[2])) });
+	const float radius = boundingSphere.w * scale;
+	for (const auto& plane : planes)
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	return true;
+}
+
+
+dengine::PbrDrawListBuilder::PbrDrawListBuilder(BS::thread_pool& threadPool) : threadPool(threadPool)
+{
+}
+
+
+void dengine::PbrDrawListBuilder::Build(entt::registry& registry, const GlobalEnvironment& environment)
+{
+	DENGINE_PROFILE_SCOPE("build draw lists");
+	auto drawView = registry.view<PbrRenderingUnit, TransformComponent, Material>();
+	const auto& candidates = drawView.handle();
+	const entt::entity* entities = candidates.data();
+	totalCount = candidates.size();
+
+	usedBuckets = totalCount < ParallelBuildThreshold ? 1 : threadPool.get_thread_count();
+	while (buckets.size() < usedBuckets)
+		buckets.push_back(std::make_unique<PbrDrawListBucket>());
+
+	const auto planes = extractFrustumPlanes(environment.ProjectionMatrix * environment.ViewMatrix);
+	const size_t chunkSize = (totalCount + usedBuckets - 1) / usedBuckets;
+	auto buildBucket = [&](size_t bucketIndex)
+	{
+		DENGINE_PROFILE_SCOPE("cull bucket");
+		auto& bucket = *buckets[bucketIndex];
+		const size_t begin = std::min(totalCount, bucketIndex * chunkSize);
+		const size_t end = std::min(totalCount, begin + chunkSize);
+		bucket.Reset(end - begin);
+		for (size_t i = begin; i < end; i++)
+		{
+			const auto entity = entities[i];
+			if (!drawView.contains(entity))
+				continue;
+			const auto& [renderingUnit, transform, material] =
+				drawView.get<PbrRenderingUnit, TransformComponent, Material>(entity);
+			if (!isSphereVisible(planes, renderingUnit.BoundingSphere, transform.ModelMatrix))
+				continue;
+			bucket.Push(PbrDrawListItem{ getPbrCacheId(renderingUnit.Vao, material), renderingUnit,
+				PbrInstancesData{ transform.ModelMatrix } });
+		}
+		bucket.Sort();
+	};
+
+	//every worker owns one bucket, so no synchronization is needed until merge
+	if (usedBuckets == 1)
+		buildBucket(0);
+	else
+		threadPool.parallelize_loop(size_t{ 0 }, usedBuckets, [&](size_t first, size_t last)
+		{
+			for (size_t bucketIndex = first; bucketIndex < last; bucketIndex++)
+				buildBucket(bucketIndex);
+		}).wait();
+}
+
+
+void dengine::PbrDrawListBuilder::Merge(PbrRenderingSubmitter& submitter) const
+{
+	DENGINE_PROFILE_SCOPE("merge draw lists");
+	for (size_t i = 0; i < usedBuckets; i++)
+		submitter.Merge(buckets[i]->GetItems());
+}
+
+
+size_t dengine::PbrDrawListBuilder::GetVisibleCount() const
+{
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < usedBuckets; i++)
+		visibleCount += buckets[i]->GetItems().size();
+	return visibleCount;
+}
+
+
+size_t dengine::PbrDrawListBuilder::GetTotalCount() const
+{
+	return totalCount;
+}
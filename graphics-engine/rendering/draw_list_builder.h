@@ -0,0 +1,54 @@
+#ifndef DRAW_LIST_BUILDER_INCLUDED
+#define DRAW_LIST_BUILDER_INCLUDED
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <memory_resource>
+#include <span>
+
+#include <entt/entt.hpp>
+#include <BS_thread_pool.hpp>
+#include <rendering/global_environment.h>
+#include <rendering/schemas/pbr_rendering_scheme.h>
+
+namespace dengine
+{
+	//draw items written by single worker, backed by its own arena that is rewound every frame
+	class PbrDrawListBucket {
+	public:
+		void Reset(size_t capacity);
+		void Push(const PbrDrawListItem& item);
+		void Sort();
+		std::span<const PbrDrawListItem> GetItems() const;
+	private:
+		std::pmr::vector<std::byte> arenaStorage;
+		std::optional<std::pmr::monotonic_buffer_resource> arena;
+		std::optional<std::pmr::vector<PbrDrawListItem>> items;
+	};
+
+
+	//normalized planes of view volume, xyz points inside
+	std::array<glm::vec4, 6> extractFrustumPlanes(const glm::mat4& viewProjection);
+
+
+	//culls drawable entities and turns them into sorted draw items on worker threads
+	class PbrDrawListBuilder {
+	public:
+		explicit PbrDrawListBuilder(BS::thread_pool& threadPool);
+
+		void Build(entt::registry& registry, const GlobalEnvironment& environment);
+		//feeds buckets into submitter, must be called from GL thread
+		void Merge(PbrRenderingSubmitter& submitter) const;
+		size_t GetVisibleCount() const;
+		size_t GetTotalCount() const;
+	private:
+		BS::thread_pool& threadPool;
+		std::pmr::vector<std::unique_ptr<PbrDrawListBucket>> buckets;
+		size_t usedBuckets{ 0 };
+		size_t totalCount{ 0 };
+	};
+}
+
+#endif
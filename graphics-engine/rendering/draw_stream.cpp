@@ -0,0 +1,229 @@
+#include <rendering/draw_stream.h>
+
+#include <cstring>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+namespace fs = std::filesystem;
+
+#include <spdlog/spdlog.h>
+#include <utils/mapped_file.h>
+
+
+constexpr const char* DrawStreamFileExtension = ".dstream";
+constexpr char DrawStreamMagic[4] = { 'D', 'S', 'T', 'R' };
+//2 packs instances as three matrix rows and stores view projection in environment, 3 adds sun to environment
+constexpr std::uint32_t DrawStreamFormatVersion = 3;
+constexpr unsigned int InvalidModelIndex = std::numeric_limits<unsigned int>::max();
+
+
+struct DrawStreamHeader {
+	char Magic[4];
+	std::uint32_t Version;
+	std::uint32_t DepthPrepass;
+	std::uint32_t ModelCount;
+	std::uint32_t LightCount;
+	std::uint32_t DrawCount;
+	std::uint32_t InstanceCount;
+};
+
+
+//bounds checked cursor over mapped stream file
+class StreamReader {
+public:
+	StreamReader(const char* begin, const char* end) : current(begin), end(end) {}
+
+	template<typename TValue>
+	bool Read(TValue& value)
+	{
+		return Read(&value, sizeof(TValue));
+	}
+
+	bool Read(void* destination, size_t size)
+	{
+		if (static_cast<size_t>(end - current) < size)
+			return false;
+		std::memcpy(destination, current, size);
+		current += size;
+		return true;
+	}
+private:
+	const char* current;
+	const char* end;
+};
+
+
+bool dengine::isDrawStreamFile(const std::pmr::string& path)
+{
+	return fs::path(path.c_str()).extension() == DrawStreamFileExtension;
+}
+
+
+dengine::DrawStream dengine::makeDrawStream(const PbrDispatchCapture& capture, std::span<const LoadedSceneModel> models)
+{
+	DrawStream drawStream;
+	drawStream.Environment = capture.Environment;
+	drawStream.Lights.assign(capture.Lights.begin(), capture.Lights.end());
+	drawStream.DepthPrepass = capture.DepthPrepass;
+
+	struct MeshReference {
+		unsigned int Model;
+		unsigned int Mesh;
+	};
+	std::unordered_map<unsigned int, MeshReference> meshesByVao;
+	for (unsigned int modelIndex = 0; modelIndex < models.size(); modelIndex++)
+	{
+		auto& renderingUnits = models[modelIndex].RenderingUnits;
+		for (unsigned int meshIndex = 0; meshIndex < renderingUnits.size(); meshIndex++)
+			meshesByVao.emplace(renderingUnits[meshIndex].Vao, MeshReference{ modelIndex, meshIndex });
+	}
+
+	//only referenced models are written, stream model indices follow first use
+	std::pmr::vector<unsigned int> streamModelIndices(models.size(), InvalidModelIndex);
+	auto log = spdlog::get("app_logger");
+	for (auto& drawCommand : capture.DrawCommands)
+	{
+		auto meshIter = meshesByVao.find(drawCommand.RenderingUnit.Vao);
+		if (meshIter == meshesByVao.end())
+		{
+			log->warn("Draw stream: skipped draw of vao {}, it does not belong to loaded models", drawCommand.Key.Vao);
+			continue;
+		}
+		const auto [modelIndex, meshIndex] = meshIter->second;
+		auto& materials = models[modelIndex].GpuModel.Materils;
+		unsigned int materialIndex = 0;
+		for (; materialIndex < materials.size(); materialIndex++)
+		{
+			auto& material = materials[materialIndex];
+			if (material.DiffuseTextureId == drawCommand.Key.DiffuseTexture &&
+				material.NormalTextureId == drawCommand.Key.NormalTexture &&
+				material.MetalnessTextureId == drawCommand.Key.MetalnessTexture)
+				break;
+		}
+		if (materialIndex == materials.size())
+		{
+			log->warn("Draw stream: skipped draw of vao {}, its textures match no material of {}", drawCommand.Key.Vao,
+				models[modelIndex].Path.c_str());
+			continue;
+		}
+
+		if (streamModelIndices[modelIndex] == InvalidModelIndex)
+		{
+			streamModelIndices[modelIndex] = static_cast<unsigned int>(drawStream.Models.size());
+			drawStream.Models.push_back(models[modelIndex].Path);
+		}
+		drawStream.Draws.push_back(DrawStreamDraw{ streamModelIndices[modelIndex], meshIndex, materialIndex,
+			static_cast<unsigned int>(drawStream.Instances.size()), drawCommand.InstanceCount });
+		auto instancesBegin = capture.Instances.begin() + drawCommand.FirstInstance;
+		drawStream.Instances.insert(drawStream.Instances.end(), instancesBegin, instancesBegin + drawCommand.InstanceCount);
+	}
+	return drawStream;
+}
+
+
+bool dengine::loadDrawStream(const std::pmr::string& path, DrawStream& drawStream)
+{
+	auto log = spdlog::get("app_logger");
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		log->error("Failed to open draw stream {}", path.c_str());
+		return false;
+	}
+
+	StreamReader reader(file.Data(), file.Data() + file.Size());
+	DrawStreamHeader header;
+	if (!reader.Read(header) || std::memcmp(header.Magic, DrawStreamMagic, sizeof(DrawStreamMagic)) != 0)
+	{
+		log->error("{} is not a draw stream", path.c_str());
+		return false;
+	}
+	if (header.Version != DrawStreamFormatVersion)
+	{
+		log->error("Unsupported draw stream version {} in {}", header.Version, path.c_str());
+		return false;
+	}
+
+	//reject counts that cannot fit in file before allocating for them
+	const auto fits = [&](size_t count, size_t elementSize) { return count <= file.Size() / elementSize; };
+	if (!fits(header.LightCount, sizeof(LightInfo)) || !fits(header.DrawCount, sizeof(DrawStreamDraw)) ||
+		!fits(header.InstanceCount, sizeof(PbrInstancesData)) || !fits(header.ModelCount, sizeof(std::uint32_t)))
+	{
+		log->error("Draw stream {} is truncated", path.c_str());
+		return false;
+	}
+
+	drawStream = DrawStream{};
+	drawStream.DepthPrepass = header.DepthPrepass != 0;
+	drawStream.Lights.resize(header.LightCount);
+	drawStream.Draws.resize(header.DrawCount);
+	drawStream.Instances.resize(header.InstanceCount);
+	bool valid = reader.Read(drawStream.Environment) &&
+		reader.Read(drawStream.Lights.data(), drawStream.Lights.size() * sizeof(LightInfo));
+
+	const fs::path streamDirectory = fs::path(path.c_str()).parent_path();
+	for (std::uint32_t i = 0; valid && i < header.ModelCount; i++)
+	{
+		std::uint32_t pathLength;
+		std::pmr::string relativePath;
+		valid = reader.Read(pathLength) && fits(pathLength, 1);
+		if (!valid)
+			break;
+		relativePath.resize(pathLength);
+		valid = reader.Read(relativePath.data(), pathLength);
+		const auto modelPath = (streamDirectory / fs::path(relativePath.c_str())).lexically_normal();
+		drawStream.Models.push_back(std::pmr::string(modelPath.string()));
+	}
+
+	valid = valid && reader.Read(drawStream.Draws.data(), drawStream.Draws.size() * sizeof(DrawStreamDraw)) &&
+		reader.Read(drawStream.Instances.data(), drawStream.Instances.size() * sizeof(PbrInstancesData));
+	if (!valid)
+	{
+		log->error("Draw stream {} is truncated", path.c_str());
+		return false;
+	}
+	for (auto& draw : drawStream.Draws)
+		if (draw.Model >= drawStream.Models.size() ||
+			static_cast<unsigned long long>(draw.FirstInstance) + draw.InstanceCount > drawStream.Instances.size())
+		{
+			log->error("Draw stream {} references missing model or instances", path.c_str());
+			return false;
+		}
+	return true;
+}
+
+
+bool dengine::writeDrawStream(const std::pmr::string& path, const DrawStream& drawStream)
+{
+	std::ofstream stream(path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+		return false;
+
+	DrawStreamHeader header{};
+	std::memcpy(header.Magic, DrawStreamMagic, sizeof(DrawStreamMagic));
+	header.Version = DrawStreamFormatVersion;
+	header.DepthPrepass = drawStream.DepthPrepass ? 1 : 0;
+	header.ModelCount = static_cast<std::uint32_t>(drawStream.Models.size());
+	header.LightCount = static_cast<std::uint32_t>(drawStream.Lights.size());
+	header.DrawCount = static_cast<std::uint32_t>(drawStream.Draws.size());
+	header.InstanceCount = static_cast<std::uint32_t>(drawStream.Instances.size());
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	stream.write(reinterpret_cast<const char*>(&drawStream.Environment), sizeof(PbrEnvironmentData));
+	stream.write(reinterpret_cast<const char*>(drawStream.Lights.data()), drawStream.Lights.size() * sizeof(LightInfo));
+
+	const fs::path streamDirectory = fs::absolute(fs::path(path.c_str())).parent_path();
+	for (auto& model : drawStream.Models)
+	{
+		const auto modelPath = fs::absolute(fs::path(model.c_str())).lexically_relative(streamDirectory).generic_string();
+		const auto pathLength = static_cast<std::uint32_t>(modelPath.size());
+		stream.write(reinterpret_cast<const char*>(&pathLength), sizeof(pathLength));
+		stream.write(modelPath.data(), modelPath.size());
+	}
+
+	stream.write(reinterpret_cast<const char*>(drawStream.Draws.data()), drawStream.Draws.size() * sizeof(DrawStreamDraw));
+	stream.write(reinterpret_cast<const char*>(drawStream.Instances.data()),
+		drawStream.Instances.size() * sizeof(PbrInstancesData));
+	return stream.good();
+}
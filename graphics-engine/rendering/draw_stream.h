@@ -0,0 +1,47 @@
+#ifndef DRAW_STREAM_INCLUDED
+#define DRAW_STREAM_INCLUDED
+
+#include <vector>
+#include <string>
+#include <span>
+
+#include <rendering/global_environment.h>
+#include <rendering/schemas/pbr_rendering_scheme.h>
+#include <scene/scene_builder.h>
+
+namespace dengine
+{
+	/*
+	 * Binary capture of one pbr dispatch, little endian:
+	 *   header   - "DSTR", version, depth prepass, model/light/draw/instance counts
+	 *   environment, lights
+	 *   models   - path length and path, relative to stream file
+	 *   draws, instances
+	 * Gl names differ between runs, so draws reference meshes and materials by index into models.
+	 */
+	struct DrawStreamDraw {
+		unsigned int Model;
+		unsigned int Mesh;
+		unsigned int Material;
+		unsigned int FirstInstance;
+		unsigned int InstanceCount;
+	};
+
+	struct DrawStream {
+		PbrEnvironmentData Environment;
+		std::pmr::vector<LightInfo> Lights;
+		bool DepthPrepass{ false };
+		std::pmr::vector<std::pmr::string> Models;
+		//in dispatch order, front to back
+		std::pmr::vector<DrawStreamDraw> Draws;
+		std::pmr::vector<PbrInstancesData> Instances;
+	};
+
+	bool isDrawStreamFile(const std::pmr::string& path);
+	//draws whose vao or textures do not belong to any of models are dropped
+	DrawStream makeDrawStream(const PbrDispatchCapture& capture, std::span<const LoadedSceneModel> models);
+	bool loadDrawStream(const std::pmr::string& path, DrawStream& drawStream);
+	bool writeDrawStream(const std::pmr::string& path, const DrawStream& drawStream);
+}
+
+#endif
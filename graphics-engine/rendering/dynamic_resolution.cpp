@@ -0,0 +1,164 @@
+#include <rendering/dynamic_resolution.h>
+
+#include <algorithm>
+#include <cmath>
+#include <glad/glad.h>
+#include <profiling/gpu_profiler.h>
+
+
+//render size is multiple of this, keeps tiles of deferred path and texel snapping of shadows steady
+constexpr int RenderSizeBlock = 8;
+//timings lag behind by frames in flight, scale waits for them to reflect previous change
+constexpr int AdjustmentInterval = 8;
+//scale changes smaller than this are ignored so noise in timings does not resize every few frames
+constexpr float ScaleHysteresis = 0.05f;
+constexpr double TimingSmoothing = 0.2;
+//UNIFORM LOCATIONS
+constexpr int UniformSourceScaleLocation = 0;
+constexpr int UniformSharpnessLocation = 1;
+
+
+dengine::DynamicResolution::DynamicResolution(RenderTargetPool& renderTargetPool) :
+	renderTargetPool(renderTargetPool), upscaleProgram("shaders/upscale.vert", "shaders/upscale.frag")
+{
+	glCreateVertexArrays(1, &emptyVao);
+}
+
+
+dengine::DynamicResolution::~DynamicResolution()
+{
+	deleteRenderTargets();
+	glDeleteVertexArrays(1, &emptyVao);
+}
+
+
+void dengine::DynamicResolution::Adjust(double gpuMilliseconds)
+{
+	if (!settings.Enabled)
+	{
+		scale = settings.MaxScale;
+		smoothedMilliseconds = 0.0;
+		framesSinceChange = 0;
+		return;
+	}
+	smoothedMilliseconds = smoothedMilliseconds == 0.0
+		? gpuMilliseconds
+		: smoothedMilliseconds + (gpuMilliseconds - smoothedMilliseconds) * TimingSmoothing;
+	if (++framesSinceChange < AdjustmentInterval || smoothedMilliseconds <= 0.0)
+		return;
+
+	//gpu time grows roughly with pixel count, which is square of scale
+	const float ratio = static_cast<float>(settings.TargetMilliseconds / smoothedMilliseconds);
+	const float desiredScale = std::clamp(scale * std::sqrt(ratio), settings.MinScale, settings.MaxScale);
+	//small corrections are skipped unless they reach one of bounds
+	const bool atBound = desiredScale == settings.MinScale || desiredScale == settings.MaxScale;
+	if (desiredScale == scale || (std::abs(desiredScale - scale) < ScaleHysteresis && !atBound))
+		return;
+	scale = desiredScale;
+	framesSinceChange = 0;
+}
+
+
+glm::ivec2 dengine::DynamicResolution::GetRenderSize(int width, int height) const
+{
+	if (!settings.Enabled)
+		return glm::ivec2(width, height);
+	const auto scaleSize = [this](int size)
+	{
+		const int scaledSize = static_cast<int>(std::lround(size * scale / RenderSizeBlock)) * RenderSizeBlock;
+		return std::clamp(scaledSize, std::min(size, RenderSizeBlock), size);
+	};
+	return glm::ivec2(scaleSize(width), scaleSize(height));
+}
+
+
+void dengine::DynamicResolution::Upscale(const RenderTarget& source, glm::ivec2 renderSize, int width, int height)
+{
+	DENGINE_PROFILE_GPU_SCOPE("upscale");
+	const auto program = upscaleProgram.Get();
+	if (program == 0)
+		return;
+	//follows source, which is reallocated only once resizing settles
+	if (fbo == 0 || colorTarget.Width != source.Width || colorTarget.Height != source.Height)
+	{
+		deleteRenderTargets();
+		createRenderTargets(source);
+	}
+
+	const glm::vec2 sourceScale = glm::vec2(renderSize) / glm::vec2(source.Width, source.Height);
+	glProgramUniform2f(program, UniformSourceScaleLocation, sourceScale.x, sourceScale.y);
+	glProgramUniform1f(program, UniformSharpnessLocation, std::clamp(settings.Sharpness, 0.0f, 1.0f));
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, width, height);
+	glDisable(GL_DEPTH_TEST);
+	glUseProgram(program);
+	glBindTextureUnit(0, source.Texture);
+	glBindVertexArray(emptyVao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+unsigned int dengine::DynamicResolution::GetFramebuffer() const
+{
+	return fbo;
+}
+
+
+unsigned int dengine::DynamicResolution::GetColorTexture() const
+{
+	return colorTarget.Texture;
+}
+
+
+float dengine::DynamicResolution::GetScale() const
+{
+	return settings.Enabled ? scale : 1.0f;
+}
+
+
+dengine::DynamicResolutionSettings& dengine::DynamicResolution::GetSettings()
+{
+	return settings;
+}
+
+
+void dengine::DynamicResolution::Reload()
+{
+	upscaleProgram.Compile();
+}
+
+
+void dengine::DynamicResolution::Update()
+{
+	upscaleProgram.Update(false);
+}
+
+
+bool dengine::DynamicResolution::IsCompiling() const
+{
+	return upscaleProgram.IsCompiling();
+}
+
+
+void dengine::DynamicResolution::createRenderTargets(const RenderTarget& source)
+{
+	//allocated on first upscale, so runs at native resolution never pay for it
+	glCreateFramebuffers(1, &fbo);
+	colorTarget = renderTargetPool.Acquire(GL_RGBA8, source.Width, source.Height);
+	glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, colorTarget.Texture, 0);
+	glNamedFramebufferDrawBuffer(fbo, GL_COLOR_ATTACHMENT0);
+	glNamedFramebufferReadBuffer(fbo, GL_COLOR_ATTACHMENT0);
+}
+
+
+void dengine::DynamicResolution::deleteRenderTargets()
+{
+	if (fbo == 0)
+		return;
+	glDeleteFramebuffers(1, &fbo);
+	renderTargetPool.Release(colorTarget);
+	fbo = 0;
+}
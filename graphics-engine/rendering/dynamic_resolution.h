@@ -0,0 +1,61 @@
+#ifndef DYNAMIC_RESOLUTION_INCLUDED
+#define DYNAMIC_RESOLUTION_INCLUDED
+
+#include <glm/glm.hpp>
+#include <rendering/render_target_pool.h>
+#include <utils/reloadable_program.h>
+
+namespace dengine
+{
+	struct DynamicResolutionSettings {
+		bool Enabled{ false };
+		//gpu time of scene rendering the scale is driven towards
+		float TargetMilliseconds{ 1000.0f / 60.0f };
+		float MinScale{ 0.5f };
+		float MaxScale{ 1.0f };
+		//0 keeps plain bilinear upscale, 1 sharpens most
+		float Sharpness{ 0.5f };
+	};
+
+
+	//scales scene rendering within render targets allocated for full output size, so scale changes only move
+	//viewport and never reallocate; scaled region is upscaled to output target with contrast adaptive sharpening
+	class DynamicResolution {
+	public:
+		explicit DynamicResolution(RenderTargetPool& renderTargetPool);
+		~DynamicResolution();
+		DynamicResolution(const DynamicResolution&) = delete;
+		DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+		//gpu time of finished frame, timings arrive few frames late so scale settles between adjustments
+		void Adjust(double gpuMilliseconds);
+		//scaled size rounded to whole blocks, output size while disabled
+		glm::ivec2 GetRenderSize(int width, int height) const;
+		//upscales lower left renderSize region of source into lower left width x height region of output target,
+		//output target is allocated with same size as source
+		void Upscale(const RenderTarget& source, glm::ivec2 renderSize, int width, int height);
+		unsigned int GetFramebuffer() const;
+		unsigned int GetColorTexture() const;
+		float GetScale() const;
+		DynamicResolutionSettings& GetSettings();
+		void Reload();
+		void Update();
+		bool IsCompiling() const;
+	private:
+		void createRenderTargets(const RenderTarget& source);
+		void deleteRenderTargets();
+
+		RenderTargetPool& renderTargetPool;
+		DynamicResolutionSettings settings;
+		ReloadableProgram upscaleProgram;
+		float scale{ 1.0f };
+		double smoothedMilliseconds{ 0.0 };
+		int framesSinceChange{ 0 };
+		//full screen triangle is generated from vertex id, core profile still needs vao bound
+		unsigned int emptyVao{ 0 };
+		unsigned int fbo{ 0 };
+		RenderTarget colorTarget;
+	};
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include <rendering/frame_readback.h>
+
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <profiling/profiler.h>
+#include <profiling/memory_tracker.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+constexpr int ReadbackChannels = 4;
+constexpr GLuint64 ReadbackWaitTimeout = 5'000'000'000ull;
+
+
+dengine::FrameReadback::FrameReadback(BS::thread_pool& threadPool) : threadPool(threadPool)
+{
+	for (auto& pendingFrame : pendingFrames)
+		glCreateBuffers(1, &pendingFrame.PixelBuffer);
+}
+
+
+dengine::FrameReadback::~FrameReadback()
+{
+	Poll(true);
+	for (auto& pendingFrame : pendingFrames)
+	{
+		glDeleteBuffers(1, &pendingFrame.PixelBuffer);
+		MemoryTracker::Get().ReleaseGpuObject(MemoryCategory::ReadbackBuffers, pendingFrame.PixelBuffer);
+	}
+}
+
+
+void dengine::FrameReadback::Queue(unsigned int framebuffer, int width, int height, const std::pmr::string& filePath)
+{
+	DENGINE_PROFILE_SCOPE("queue readback");
+	//reuse oldest slot, normally its copy finished frames ago
+	auto& pendingFrame = pendingFrames[nextFrame];
+	if (pendingFrame.Fence != nullptr)
+		complete(pendingFrame, true);
+	nextFrame = (nextFrame + 1) % pendingFrames.size();
+
+	const size_t size = static_cast<size_t>(width) * height * ReadbackChannels;
+	if (size > pendingFrame.Capacity)
+	{
+		glNamedBufferData(pendingFrame.PixelBuffer, size, nullptr, GL_STREAM_READ);
+		pendingFrame.Capacity = size;
+		MemoryTracker::Get().TrackGpuObject(MemoryCategory::ReadbackBuffers, pendingFrame.PixelBuffer,
+			static_cast<long long>(size), "frame readback");
+	}
+	pendingFrame.Width = width;
+	pendingFrame.Height = height;
+	pendingFrame.FilePath = filePath;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pendingFrame.PixelBuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	pendingFrame.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+
+void dengine::FrameReadback::Poll(bool wait)
+{
+	for (size_t i = 0; i < pendingFrames.size(); i++)
+	{
+		auto& pendingFrame = pendingFrames[(nextFrame + i) % pendingFrames.size()];
+		if (pendingFrame.Fence != nullptr && !complete(pendingFrame, wait))
+			break;
+	}
+	collectWrites(wait);
+}
+
+
+size_t dengine::FrameReadback::GetFailedWrites() const
+{
+	return failedWrites;
+}
+
+
+bool dengine::FrameReadback::complete(PendingFrame& pendingFrame, bool wait)
+{
+	const auto status = glClientWaitSync(pendingFrame.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? ReadbackWaitTimeout : 0);
+	if (status == GL_TIMEOUT_EXPIRED && !wait)
+		return false;
+	glDeleteSync(pendingFrame.Fence);
+	pendingFrame.Fence = nullptr;
+
+	if (status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED)
+	{
+		spdlog::get("app_logger")->error("failed to read back frame {}", pendingFrame.FilePath);
+		failedWrites++;
+		return true;
+	}
+
+	//flip rows while copying out, gl origin is bottom left
+	const size_t rowSize = static_cast<size_t>(pendingFrame.Width) * ReadbackChannels;
+	std::pmr::vector<unsigned char> pixels(rowSize * pendingFrame.Height);
+	auto mapped = static_cast<const unsigned char*>(glMapNamedBufferRange(pendingFrame.PixelBuffer, 0,
+		pixels.size(), GL_MAP_READ_BIT));
+	if (mapped == nullptr)
+	{
+		spdlog::get("app_logger")->error("failed to map read back buffer of frame {}", pendingFrame.FilePath);
+		failedWrites++;
+		return true;
+	}
+	for (int row = 0; row < pendingFrame.Height; row++)
+		std::memcpy(pixels.data() + row * rowSize, mapped + (pendingFrame.Height - 1 - row) * rowSize, rowSize);
+	glUnmapNamedBuffer(pendingFrame.PixelBuffer);
+
+	writes.push_back(threadPool.submit([pixels = std::move(pixels), width = pendingFrame.Width,
+		height = pendingFrame.Height, filePath = pendingFrame.FilePath]()
+	{
+		return stbi_write_png(filePath.c_str(), width, height, ReadbackChannels, pixels.data(),
+			width * ReadbackChannels) != 0;
+	}));
+	return true;
+}
+
+
+void dengine::FrameReadback::collectWrites(bool wait)
+{
+	auto logger = spdlog::get("app_logger");
+	std::erase_if(writes, [&](std::future<bool>& write)
+	{
+		if (!wait && write.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return false;
+		if (!write.get())
+		{
+			logger->error("failed to write frame image");
+			failedWrites++;
+		}
+		return true;
+	});
+}
@@ -0,0 +1,49 @@
+#ifndef FRAME_READBACK_INCLUDED
+#define FRAME_READBACK_INCLUDED
+
+#include <array>
+#include <future>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <BS_thread_pool.hpp>
+
+namespace dengine
+{
+	//copies color attachment to pixel buffers without stalling GPU,
+	//finished copies are encoded to png on thread pool
+	class FrameReadback {
+	public:
+		explicit FrameReadback(BS::thread_pool& threadPool);
+		~FrameReadback();
+		FrameReadback(const FrameReadback&) = delete;
+		FrameReadback& operator=(const FrameReadback&) = delete;
+
+		void Queue(unsigned int framebuffer, int width, int height, const std::pmr::string& filePath);
+		//collects finished copies, blocks until every queued frame is written when wait is set
+		void Poll(bool wait);
+		size_t GetFailedWrites() const;
+	private:
+		struct PendingFrame {
+			unsigned int PixelBuffer{ 0 };
+			size_t Capacity{ 0 };
+			GLsync Fence{ nullptr };
+			int Width{ 0 };
+			int Height{ 0 };
+			std::pmr::string FilePath;
+		};
+
+		bool complete(PendingFrame& pendingFrame, bool wait);
+		void collectWrites(bool wait);
+
+		BS::thread_pool& threadPool;
+		//ring of frames in flight, oldest frame is at nextFrame
+		std::array<PendingFrame, 3> pendingFrames;
+		size_t nextFrame{ 0 };
+		std::pmr::vector<std::future<bool>> writes;
+		size_t failedWrites{ 0 };
+	};
+}
+
+#endif
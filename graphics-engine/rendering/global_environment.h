@@ -12,11 +12,20 @@ namespace dengine
 		glm::vec4 Color;
 	};
 
+	//light at infinity, only light that casts shadows
+	struct DirectionalLight {
+		//direction light travels in, world space
+		glm::vec4 Direction{ 0.0f, -1.0f, 0.0f, 0.0f };
+		//alpha is intensity, 0 turns light off
+		glm::vec4 Color{ 0.0f };
+	};
+
 	struct GlobalEnvironment{
 		glm::vec4 CameraPostion;
 		glm::mat4 ProjectionMatrix;
 		glm::mat4 ViewMatrix;
 		std::pmr::vector<LightInfo> Lights;
+		DirectionalLight Sun;
 		float AmbientStrength;
 		float DiffuseStrength;
 		float SpecularStrength;
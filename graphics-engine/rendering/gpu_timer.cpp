@@ -0,0 +1,66 @@
+#include <rendering/gpu_timer.h>
+
+#include <glad/glad.h>
+
+
+dengine::GpuFrameTimer::GpuFrameTimer()
+{
+	for (auto& query : queries)
+		glCreateQueries(GL_TIME_ELAPSED, 1, &query.Id);
+}
+
+
+dengine::GpuFrameTimer::~GpuFrameTimer()
+{
+	for (auto& query : queries)
+		glDeleteQueries(1, &query.Id);
+}
+
+
+void dengine::GpuFrameTimer::Begin(size_t frameIndex)
+{
+	//ring is full, GPU is more frames behind than ring holds, only now we have to wait
+	auto& query = queries[nextQuery];
+	if (query.Pending)
+		read(query, true, overflowTimings);
+	query.FrameIndex = frameIndex;
+	query.Pending = true;
+	glBeginQuery(GL_TIME_ELAPSED, query.Id);
+}
+
+
+void dengine::GpuFrameTimer::End()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	nextQuery = (nextQuery + 1) % queries.size();
+}
+
+
+void dengine::GpuFrameTimer::Collect(bool wait, std::pmr::vector<GpuTiming>& timings)
+{
+	timings.insert(timings.end(), overflowTimings.begin(), overflowTimings.end());
+	overflowTimings.clear();
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		auto& query = queries[(nextQuery + i) % queries.size()];
+		if (query.Pending && !read(query, wait, timings))
+			break;
+	}
+}
+
+
+bool dengine::GpuFrameTimer::read(Query& query, bool wait, std::pmr::vector<GpuTiming>& timings)
+{
+	if (!wait)
+	{
+		int available = 0;
+		glGetQueryObjectiv(query.Id, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return false;
+	}
+	GLuint64 elapsedNanoseconds = 0;
+	glGetQueryObjectui64v(query.Id, GL_QUERY_RESULT, &elapsedNanoseconds);
+	timings.push_back(GpuTiming{ query.FrameIndex, static_cast<double>(elapsedNanoseconds) / 1'000'000.0 });
+	query.Pending = false;
+	return true;
+}
@@ -0,0 +1,44 @@
+#ifndef GPU_TIMER_INCLUDED
+#define GPU_TIMER_INCLUDED
+
+#include <array>
+#include <vector>
+
+namespace dengine
+{
+	struct GpuTiming {
+		size_t FrameIndex;
+		double Milliseconds;
+	};
+
+
+	//measures GPU time of whole frames with GL_TIME_ELAPSED queries,
+	//results are read frames later so GPU is never stalled while ring has free queries
+	class GpuFrameTimer {
+	public:
+		GpuFrameTimer();
+		~GpuFrameTimer();
+		GpuFrameTimer(const GpuFrameTimer&) = delete;
+		GpuFrameTimer& operator=(const GpuFrameTimer&) = delete;
+
+		void Begin(size_t frameIndex);
+		void End();
+		//appends finished timings, blocks until every query is finished when wait is set
+		void Collect(bool wait, std::pmr::vector<GpuTiming>& timings);
+	private:
+		struct Query {
+			unsigned int Id{ 0 };
+			size_t FrameIndex{ 0 };
+			bool Pending{ false };
+		};
+
+		bool read(Query& query, bool wait, std::pmr::vector<GpuTiming>& timings);
+
+		//ring of queries in flight, oldest query is at nextQuery
+		std::array<Query, 4> queries;
+		size_t nextQuery{ 0 };
+		std::pmr::vector<GpuTiming> overflowTimings;
+	};
+}
+
+#endif
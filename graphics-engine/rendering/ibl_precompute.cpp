@@ -0,0 +1,592 @@
+#include <rendering/ibl_precompute.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <glm/gtc/constants.hpp>
+#include <spdlog/spdlog.h>
+#include <stb_image.h>
+#include <utils/mapped_file.h>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define DENGINE_IBL_SSE
+#endif
+
+constexpr char IblCacheMagic[4] = { 'D', 'I', 'B', 'L' };
+constexpr unsigned int IblCacheVersion = 1;
+const float Pi = glm::pi<float>();
+//sh projection needs no detail, it runs on first pyramid level not wider than this
+constexpr int ShProjectionMaxWidth = 128;
+//prefilter samples and sh texels handled per sse iteration
+constexpr int IblBatchSize = 4;
+
+
+struct IblCacheHeader {
+	char Magic[4];
+	unsigned int Version;
+	unsigned long long Key;
+	int SpecularSize;
+	int SpecularLevels;
+	int BrdfLutSize;
+	int Padding;
+};
+
+
+//ggx direction in tangent space with lod of source pyramid that covers its solid angle
+struct PrefilterSample {
+	glm::vec3 Direction;
+	float Weight;
+	float Lod;
+};
+
+
+//structure of arrays over IblBatchSize samples, padding lanes have zero weight
+struct PrefilterSampleBatch {
+	alignas(16) float X[IblBatchSize];
+	alignas(16) float Y[IblBatchSize];
+	alignas(16) float Z[IblBatchSize];
+	alignas(16) float Weight[IblBatchSize];
+	alignas(16) float Lod[IblBatchSize];
+};
+
+
+using ShCoefficients = std::array<glm::vec3, 9>;
+
+
+size_t getSpecularTexelCount(int size, int levels)
+{
+	size_t count = 0;
+	for (int level = 0; level < levels; level++)
+	{
+		const size_t levelSize = std::max(size >> level, 1);
+		count += 6 * levelSize * levelSize;
+	}
+	return count;
+}
+
+
+//box filtered chain down to single row, lets samples of wide lobes read one texel instead of thousands
+std::pmr::vector<dengine::EnvironmentImage> buildEnvironmentPyramid(const dengine::EnvironmentImage& environment)
+{
+	std::pmr::vector<dengine::EnvironmentImage> pyramid;
+	pyramid.push_back(environment);
+	while (pyramid.back().Height > 1)
+	{
+		const auto& source = pyramid.back();
+		dengine::EnvironmentImage level;
+		level.Width = std::max(source.Width / 2, 1);
+		level.Height = std::max(source.Height / 2, 1);
+		level.Texels.resize(static_cast<size_t>(level.Width) * level.Height);
+		for (int y = 0; y < level.Height; y++)
+			for (int x = 0; x < level.Width; x++)
+			{
+				glm::vec3 sum(0.0f);
+				for (int dy = 0; dy < 2; dy++)
+					for (int dx = 0; dx < 2; dx++)
+					{
+						const int sourceX = std::min(x * 2 + dx, source.Width - 1);
+						const int sourceY = std::min(y * 2 + dy, source.Height - 1);
+						sum += source.Texels[static_cast<size_t>(sourceY) * source.Width + sourceX];
+					}
+				level.Texels[static_cast<size_t>(y) * level.Width + x] = sum * 0.25f;
+			}
+		pyramid.push_back(std::move(level));
+	}
+	return pyramid;
+}
+
+
+//bilinear with wrap around horizontally
+glm::vec3 sampleEquirect(const dengine::EnvironmentImage& image, float u, float v)
+{
+	const float x = u * image.Width - 0.5f;
+	const float y = v * image.Height - 0.5f;
+	const int x0 = static_cast<int>(std::floor(x));
+	const int y0 = static_cast<int>(std::floor(y));
+	const float fx = x - x0;
+	const float fy = y - y0;
+	const auto texel = [&](int tx, int ty)
+	{
+		tx = (tx % image.Width + image.Width) % image.Width;
+		ty = std::clamp(ty, 0, image.Height - 1);
+		return image.Texels[static_cast<size_t>(ty) * image.Width + tx];
+	};
+	return glm::mix(glm::mix(texel(x0, y0), texel(x0 + 1, y0), fx),
+		glm::mix(texel(x0, y0 + 1), texel(x0 + 1, y0 + 1), fx), fy);
+}
+
+
+glm::vec3 samplePyramid(std::span<const dengine::EnvironmentImage> pyramid, float u, float v, float lod)
+{
+	lod = std::clamp(lod, 0.0f, static_cast<float>(pyramid.size() - 1));
+	const auto level = static_cast<size_t>(lod);
+	const float blend = lod - level;
+	const auto color = sampleEquirect(pyramid[level], u, v);
+	if (blend <= 0.0f || level + 1 >= pyramid.size())
+		return color;
+	return glm::mix(color, sampleEquirect(pyramid[level + 1], u, v), blend);
+}
+
+
+glm::vec3 samplePyramid(std::span<const dengine::EnvironmentImage> pyramid, const glm::vec3& direction, float lod)
+{
+	//columns go around y from phi -pi, rows from theta 0 at +y
+	const float u = std::atan2(direction.z, direction.x) / (2.0f * Pi) + 0.5f;
+	const float v = std::acos(std::clamp(direction.y, -1.0f, 1.0f)) / Pi;
+	return samplePyramid(pyramid, u, v, lod);
+}
+
+
+//gl cube map face order +x -x +y -y +z -z, rows go along t
+glm::vec3 getCubeTexelDirection(int face, int x, int y, int size)
+{
+	const float u = 2.0f * (x + 0.5f) / size - 1.0f;
+	const float v = 2.0f * (y + 0.5f) / size - 1.0f;
+	glm::vec3 direction;
+	switch (face)
+	{
+	case 0: direction = glm::vec3(1.0f, -v, -u); break;
+	case 1: direction = glm::vec3(-1.0f, -v, u); break;
+	case 2: direction = glm::vec3(u, 1.0f, v); break;
+	case 3: direction = glm::vec3(u, -1.0f, -v); break;
+	case 4: direction = glm::vec3(u, -v, 1.0f); break;
+	default: direction = glm::vec3(-u, -v, -1.0f); break;
+	}
+	return glm::normalize(direction);
+}
+
+
+glm::vec2 hammersley(unsigned int index, unsigned int count)
+{
+	unsigned int bits = index;
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return glm::vec2(static_cast<float>(index) / count, static_cast<float>(bits) * 2.3283064365386963e-10f);
+}
+
+
+//half vector around +z
+glm::vec3 importanceSampleGgx(const glm::vec2& xi, float roughness)
+{
+	const float a = roughness * roughness;
+	const float phi = 2.0f * Pi * xi.x;
+	const float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (a * a - 1.0f) * xi.y));
+	const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+	return glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+}
+
+
+//prefiltering assumes view along normal, so samples depend only on roughness and are shared by every texel of level
+std::pmr::vector<PrefilterSample> makePrefilterSamples(float roughness, unsigned int sampleCount,
+	float cubeTexelSolidAngle, float sourceTexelSolidAngle)
+{
+	std::pmr::vector<PrefilterSample> samples;
+	if (roughness <= 0.0f)
+	{
+		//mirror level reads source at resolution of cube texel
+		const float lod = std::max(0.5f * std::log2(cubeTexelSolidAngle / sourceTexelSolidAngle), 0.0f);
+		samples.push_back(PrefilterSample{ glm::vec3(0.0f, 0.0f, 1.0f), 1.0f, lod });
+		return samples;
+	}
+
+	const float a2 = roughness * roughness * roughness * roughness;
+	samples.reserve(sampleCount);
+	for (unsigned int i = 0; i < sampleCount; i++)
+	{
+		const auto halfVector = importanceSampleGgx(hammersley(i, sampleCount), roughness);
+		const auto direction = 2.0f * halfVector.z * halfVector - glm::vec3(0.0f, 0.0f, 1.0f);
+		if (direction.z <= 0.0f)
+			continue;
+		//pdf of ggx over reflected directions is D / 4 when view equals normal
+		const float denominator = halfVector.z * halfVector.z * (a2 - 1.0f) + 1.0f;
+		const float pdf = a2 / (Pi * denominator * denominator) * 0.25f;
+		const float sampleSolidAngle = 1.0f / (sampleCount * pdf + 0.0001f);
+		const float lod = std::max(0.5f * std::log2(sampleSolidAngle / sourceTexelSolidAngle) + 1.0f, 0.0f);
+		samples.push_back(PrefilterSample{ direction, direction.z, lod });
+	}
+	return samples;
+}
+
+
+std::pmr::vector<PrefilterSampleBatch> packPrefilterSamples(const std::pmr::vector<PrefilterSample>& samples)
+{
+	std::pmr::vector<PrefilterSampleBatch> batches((samples.size() + IblBatchSize - 1) / IblBatchSize);
+	for (size_t i = 0; i < batches.size() * IblBatchSize; i++)
+	{
+		//padding looks along normal with zero weight, so it stays finite and adds nothing
+		const auto sample = i < samples.size() ? samples[i] : PrefilterSample{ glm::vec3(0.0f, 0.0f, 1.0f), 0.0f, 0.0f };
+		auto& batch = batches[i / IblBatchSize];
+		const size_t lane = i % IblBatchSize;
+		batch.X[lane] = sample.Direction.x;
+		batch.Y[lane] = sample.Direction.y;
+		batch.Z[lane] = sample.Direction.z;
+		batch.Weight[lane] = sample.Weight;
+		batch.Lod[lane] = sample.Lod;
+	}
+	return batches;
+}
+
+
+//weighted sum of samples rotated into tangent frame of texel, not yet divided by total weight
+glm::vec3 prefilterTexel(std::span<const dengine::EnvironmentImage> pyramid,
+	const std::pmr::vector<PrefilterSample>& samples, const glm::vec3& tangent, const glm::vec3& bitangent,
+	const glm::vec3& normal)
+{
+	glm::vec3 color(0.0f);
+	for (auto& sample : samples)
+	{
+		const auto direction = tangent * sample.Direction.x + bitangent * sample.Direction.y +
+			normal * sample.Direction.z;
+		color += samplePyramid(pyramid, direction, sample.Lod) * sample.Weight;
+	}
+	return color;
+}
+
+
+#ifdef DENGINE_IBL_SSE
+__m128 selectSimd(__m128 mask, __m128 ifTrue, __m128 ifFalse)
+{
+	return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+}
+
+
+//polynomial atan on [0, 1] folded to all quadrants, error is about 1e-5 rad, far under texel of any
+//environment map; zero for zero vector like std::atan2
+__m128 approximateAtan2Simd(__m128 y, __m128 x)
+{
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 absX = _mm_andnot_ps(signMask, x);
+	const __m128 absY = _mm_andnot_ps(signMask, y);
+	const __m128 maxValue = _mm_max_ps(absX, absY);
+	const __m128 ratio = _mm_and_ps(_mm_div_ps(_mm_min_ps(absX, absY), maxValue), _mm_cmpgt_ps(maxValue, zero));
+	const __m128 ratioSquared = _mm_mul_ps(ratio, ratio);
+	__m128 angle = _mm_set1_ps(0.0208351f);
+	angle = _mm_add_ps(_mm_mul_ps(angle, ratioSquared), _mm_set1_ps(-0.085133f));
+	angle = _mm_add_ps(_mm_mul_ps(angle, ratioSquared), _mm_set1_ps(0.180141f));
+	angle = _mm_add_ps(_mm_mul_ps(angle, ratioSquared), _mm_set1_ps(-0.3302995f));
+	angle = _mm_add_ps(_mm_mul_ps(angle, ratioSquared), _mm_set1_ps(0.999866f));
+	angle = _mm_mul_ps(angle, ratio);
+	angle = selectSimd(_mm_cmpgt_ps(absY, absX), _mm_sub_ps(_mm_set1_ps(0.5f * Pi), angle), angle);
+	angle = selectSimd(_mm_cmplt_ps(x, zero), _mm_sub_ps(_mm_set1_ps(Pi), angle), angle);
+	return _mm_or_ps(angle, _mm_and_ps(y, signMask));
+}
+
+
+//rotation and equirect coordinates of four samples at once, bilinear fetches stay scalar as sse has no gather
+glm::vec3 prefilterTexelSimd(std::span<const dengine::EnvironmentImage> pyramid,
+	const std::pmr::vector<PrefilterSampleBatch>& batches, const glm::vec3& tangent, const glm::vec3& bitangent,
+	const glm::vec3& normal)
+{
+	const __m128 tangentX = _mm_set1_ps(tangent.x), tangentY = _mm_set1_ps(tangent.y), tangentZ = _mm_set1_ps(tangent.z);
+	const __m128 bitangentX = _mm_set1_ps(bitangent.x), bitangentY = _mm_set1_ps(bitangent.y),
+		bitangentZ = _mm_set1_ps(bitangent.z);
+	const __m128 normalX = _mm_set1_ps(normal.x), normalY = _mm_set1_ps(normal.y), normalZ = _mm_set1_ps(normal.z);
+	const __m128 inverseTwoPi = _mm_set1_ps(0.5f / Pi);
+	const __m128 inversePi = _mm_set1_ps(1.0f / Pi);
+	const __m128 half = _mm_set1_ps(0.5f);
+	alignas(16) float u[IblBatchSize];
+	alignas(16) float v[IblBatchSize];
+	glm::vec3 color(0.0f);
+	for (auto& batch : batches)
+	{
+		const __m128 sampleX = _mm_load_ps(batch.X);
+		const __m128 sampleY = _mm_load_ps(batch.Y);
+		const __m128 sampleZ = _mm_load_ps(batch.Z);
+		const __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tangentX, sampleX), _mm_mul_ps(bitangentX, sampleY)),
+			_mm_mul_ps(normalX, sampleZ));
+		const __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tangentY, sampleX), _mm_mul_ps(bitangentY, sampleY)),
+			_mm_mul_ps(normalY, sampleZ));
+		const __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tangentZ, sampleX), _mm_mul_ps(bitangentZ, sampleY)),
+			_mm_mul_ps(normalZ, sampleZ));
+		//acos(y) of unit direction is angle between y and its length in xz plane
+		_mm_store_ps(u, _mm_add_ps(_mm_mul_ps(approximateAtan2Simd(z, x), inverseTwoPi), half));
+		_mm_store_ps(v, _mm_mul_ps(approximateAtan2Simd(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(z, z))), y),
+			inversePi));
+		for (int lane = 0; lane < IblBatchSize; lane++)
+			if (batch.Weight[lane] > 0.0f)
+				color += samplePyramid(pyramid, u[lane], v[lane], batch.Lod[lane]) * batch.Weight[lane];
+	}
+	return color;
+}
+#endif
+
+
+ShCoefficients projectIrradianceSh(const dengine::EnvironmentImage& image, BS::thread_pool& threadPool)
+{
+	//azimuth of column is same in every row
+	std::pmr::vector<float> cosPhi(image.Width);
+	std::pmr::vector<float> sinPhi(image.Width);
+	for (int x = 0; x < image.Width; x++)
+	{
+		const float phi = ((x + 0.5f) / image.Width - 0.5f) * 2.0f * Pi;
+		cosPhi[x] = std::cos(phi);
+		sinPhi[x] = std::sin(phi);
+	}
+
+	auto partialSums = threadPool.parallelize_loop(0, image.Height, [&](int first, int last)
+	{
+		ShCoefficients sum;
+		sum.fill(glm::vec3(0.0f));
+#ifdef DENGINE_IBL_SSE
+		//four texels per lane set, rgb of every basis function summed apart and reduced at end
+		__m128 simdSum[9][3];
+		for (auto& basisSum : simdSum)
+			for (auto& channelSum : basisSum)
+				channelSum = _mm_setzero_ps();
+#endif
+		for (int y = first; y < last; y++)
+		{
+			const float theta = (y + 0.5f) / image.Height * Pi;
+			const float sinTheta = std::sin(theta);
+			const float cosTheta = std::cos(theta);
+			const float solidAngle = (2.0f * Pi / image.Width) * (Pi / image.Height) * sinTheta;
+			const glm::vec3* row = image.Texels.data() + static_cast<size_t>(y) * image.Width;
+			int x = 0;
+#ifdef DENGINE_IBL_SSE
+			const __m128 dy = _mm_set1_ps(cosTheta);
+			const __m128 simdSinTheta = _mm_set1_ps(sinTheta);
+			const __m128 simdSolidAngle = _mm_set1_ps(solidAngle);
+			for (; x + IblBatchSize <= image.Width; x += IblBatchSize)
+			{
+				const __m128 dx = _mm_mul_ps(simdSinTheta, _mm_loadu_ps(&cosPhi[x]));
+				const __m128 dz = _mm_mul_ps(simdSinTheta, _mm_loadu_ps(&sinPhi[x]));
+				const __m128 radiance[3] = {
+					_mm_mul_ps(_mm_setr_ps(row[x].r, row[x + 1].r, row[x + 2].r, row[x + 3].r), simdSolidAngle),
+					_mm_mul_ps(_mm_setr_ps(row[x].g, row[x + 1].g, row[x + 2].g, row[x + 3].g), simdSolidAngle),
+					_mm_mul_ps(_mm_setr_ps(row[x].b, row[x + 1].b, row[x + 2].b, row[x + 3].b), simdSolidAngle),
+				};
+				const __m128 basis[9] = {
+					_mm_set1_ps(0.282095f),
+					_mm_mul_ps(_mm_set1_ps(0.488603f), dy), _mm_mul_ps(_mm_set1_ps(0.488603f), dz),
+					_mm_mul_ps(_mm_set1_ps(0.488603f), dx),
+					_mm_mul_ps(_mm_set1_ps(1.092548f), _mm_mul_ps(dx, dy)),
+					_mm_mul_ps(_mm_set1_ps(1.092548f), _mm_mul_ps(dy, dz)),
+					_mm_mul_ps(_mm_set1_ps(0.315392f), _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(dz, dz)),
+						_mm_set1_ps(1.0f))),
+					_mm_mul_ps(_mm_set1_ps(1.092548f), _mm_mul_ps(dx, dz)),
+					_mm_mul_ps(_mm_set1_ps(0.546274f), _mm_sub_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))),
+				};
+				for (int i = 0; i < 9; i++)
+					for (int channel = 0; channel < 3; channel++)
+						simdSum[i][channel] = _mm_add_ps(simdSum[i][channel], _mm_mul_ps(radiance[channel], basis[i]));
+			}
+#endif
+			for (; x < image.Width; x++)
+			{
+				const glm::vec3 d(sinTheta * cosPhi[x], cosTheta, sinTheta * sinPhi[x]);
+				const auto radiance = row[x] * solidAngle;
+				const float basis[9] = {
+					0.282095f,
+					0.488603f * d.y, 0.488603f * d.z, 0.488603f * d.x,
+					1.092548f * d.x * d.y, 1.092548f * d.y * d.z, 0.315392f * (3.0f * d.z * d.z - 1.0f),
+					1.092548f * d.x * d.z, 0.546274f * (d.x * d.x - d.y * d.y),
+				};
+				for (int i = 0; i < 9; i++)
+					sum[i] += radiance * basis[i];
+			}
+		}
+#ifdef DENGINE_IBL_SSE
+		alignas(16) float lanes[IblBatchSize];
+		for (int i = 0; i < 9; i++)
+			for (int channel = 0; channel < 3; channel++)
+			{
+				_mm_store_ps(lanes, simdSum[i][channel]);
+				sum[i][channel] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+			}
+#endif
+		return sum;
+	}).get();
+
+	//clamped cosine convolution per band turns radiance into irradiance
+	const float bandWeights[9] = { Pi, 2.0f * Pi / 3.0f, 2.0f * Pi / 3.0f, 2.0f * Pi / 3.0f,
+		Pi / 4.0f, Pi / 4.0f, Pi / 4.0f, Pi / 4.0f, Pi / 4.0f };
+	ShCoefficients coefficients;
+	coefficients.fill(glm::vec3(0.0f));
+	for (auto& partialSum : partialSums)
+		for (int i = 0; i < 9; i++)
+			coefficients[i] += partialSum[i];
+	for (int i = 0; i < 9; i++)
+		coefficients[i] *= bandWeights[i];
+	return coefficients;
+}
+
+
+float geometrySchlickGgxIbl(float NdotX, float roughness)
+{
+	const float k = roughness * roughness * 0.5f;
+	return NdotX / (NdotX * (1.0f - k) + k);
+}
+
+
+bool dengine::loadEnvironmentImage(const char* data, size_t size, EnvironmentImage& image)
+{
+	int width = 0, height = 0, numChannels = 0;
+	float* texels = stbi_loadf_from_memory(reinterpret_cast<const unsigned char*>(data), static_cast<int>(size),
+		&width, &height, &numChannels, 3);
+	if (texels == nullptr)
+	{
+		spdlog::get("app_logger")->error("Failed to decode environment map: {}", stbi_failure_reason());
+		return false;
+	}
+	image.Width = width;
+	image.Height = height;
+	image.Texels.resize(static_cast<size_t>(width) * height);
+	std::memcpy(image.Texels.data(), texels, image.Texels.size() * sizeof(glm::vec3));
+	stbi_image_free(texels);
+	return true;
+}
+
+
+dengine::PrecomputedIbl dengine::precomputeIbl(const EnvironmentImage& environment, const IblSettings& settings,
+	BS::thread_pool& threadPool)
+{
+	PrecomputedIbl ibl;
+	const auto pyramid = buildEnvironmentPyramid(environment);
+	const auto shLevel = std::find_if(pyramid.begin(), pyramid.end(), [](const auto& level)
+	{
+		return level.Width <= ShProjectionMaxWidth;
+	});
+	ibl.IrradianceSh = projectIrradianceSh(shLevel != pyramid.end() ? *shLevel : pyramid.back(), threadPool);
+
+	//level is never smaller than one texel
+	ibl.SpecularSize = settings.SpecularSize;
+	ibl.SpecularLevels = std::max(std::min(settings.SpecularLevels,
+		static_cast<int>(std::log2(settings.SpecularSize)) + 1), 1);
+	ibl.Specular.resize(getSpecularTexelCount(ibl.SpecularSize, ibl.SpecularLevels));
+	const float sourceTexelSolidAngle = 4.0f * Pi / (static_cast<float>(environment.Width) * environment.Height);
+	size_t levelOffset = 0;
+	for (int level = 0; level < ibl.SpecularLevels; level++)
+	{
+		const int size = std::max(ibl.SpecularSize >> level, 1);
+		const float roughness = ibl.SpecularLevels > 1 ? static_cast<float>(level) / (ibl.SpecularLevels - 1) : 0.0f;
+		const auto samples = makePrefilterSamples(roughness, settings.SpecularSamples,
+			4.0f * Pi / (6.0f * size * size), sourceTexelSolidAngle);
+		//weights depend only on roughness, so every texel divides by same total
+		float weight = 0.0f;
+		for (auto& sample : samples)
+			weight += sample.Weight;
+#ifdef DENGINE_IBL_SSE
+		const auto batches = packPrefilterSamples(samples);
+#endif
+		glm::vec3* levelTexels = ibl.Specular.data() + levelOffset;
+		//rows of all faces are independent
+		threadPool.parallelize_loop(0, 6 * size, [&](int first, int last)
+		{
+			for (int row = first; row < last; row++)
+			{
+				const int face = row / size;
+				const int y = row % size;
+				for (int x = 0; x < size; x++)
+				{
+					const auto normal = getCubeTexelDirection(face, x, y, size);
+					const auto up = std::abs(normal.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+					const auto tangent = glm::normalize(glm::cross(up, normal));
+					const auto bitangent = glm::cross(normal, tangent);
+#ifdef DENGINE_IBL_SSE
+					const auto color = prefilterTexelSimd(pyramid, batches, tangent, bitangent, normal);
+#else
+					const auto color = prefilterTexel(pyramid, samples, tangent, bitangent, normal);
+#endif
+					levelTexels[static_cast<size_t>(row) * size + x] = weight > 0.0f ? color / weight : color;
+				}
+			}
+		}).wait();
+		levelOffset += 6 * static_cast<size_t>(size) * size;
+	}
+
+	ibl.BrdfLutSize = settings.BrdfLutSize;
+	ibl.BrdfLut.resize(static_cast<size_t>(ibl.BrdfLutSize) * ibl.BrdfLutSize);
+	threadPool.parallelize_loop(0, ibl.BrdfLutSize, [&](int first, int last)
+	{
+		const unsigned int sampleCount = settings.BrdfSamples;
+		for (int y = first; y < last; y++)
+		{
+			const float roughness = (y + 0.5f) / ibl.BrdfLutSize;
+			for (int x = 0; x < ibl.BrdfLutSize; x++)
+			{
+				const float NdotV = (x + 0.5f) / ibl.BrdfLutSize;
+				const glm::vec3 view(std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+				glm::vec2 scaleBias(0.0f);
+				for (unsigned int i = 0; i < sampleCount; i++)
+				{
+					const auto halfVector = importanceSampleGgx(hammersley(i, sampleCount), roughness);
+					const float VdotH = glm::dot(view, halfVector);
+					const auto light = 2.0f * VdotH * halfVector - view;
+					const float NdotL = light.z;
+					if (NdotL <= 0.0f || VdotH <= 0.0f)
+						continue;
+					const float visibility = geometrySchlickGgxIbl(NdotV, roughness) *
+						geometrySchlickGgxIbl(NdotL, roughness) * VdotH / (halfVector.z * NdotV);
+					const float fresnel = std::pow(1.0f - VdotH, 5.0f);
+					scaleBias += glm::vec2(1.0f - fresnel, fresnel) * visibility;
+				}
+				ibl.BrdfLut[static_cast<size_t>(y) * ibl.BrdfLutSize + x] = scaleBias / static_cast<float>(sampleCount);
+			}
+		}
+	}).wait();
+	return ibl;
+}
+
+
+bool dengine::loadIblCache(const std::pmr::string& path, unsigned long long key, PrecomputedIbl& ibl)
+{
+	MappedFile file;
+	if (!file.Open(path))
+		return false;
+
+	IblCacheHeader header;
+	if (file.Size() < sizeof(header))
+		return false;
+	std::memcpy(&header, file.Data(), sizeof(header));
+	if (std::memcmp(header.Magic, IblCacheMagic, sizeof(IblCacheMagic)) != 0 || header.Version != IblCacheVersion ||
+		header.Key != key || header.SpecularSize <= 0 || header.SpecularLevels <= 0 || header.SpecularLevels > 16 ||
+		header.BrdfLutSize <= 0)
+		return false;
+
+	const size_t specularCount = getSpecularTexelCount(header.SpecularSize, header.SpecularLevels);
+	const size_t brdfLutCount = static_cast<size_t>(header.BrdfLutSize) * header.BrdfLutSize;
+	if (file.Size() != sizeof(header) + sizeof(ibl.IrradianceSh) + specularCount * sizeof(glm::vec3) +
+		brdfLutCount * sizeof(glm::vec2))
+		return false;
+
+	const char* data = file.Data() + sizeof(header);
+	std::memcpy(ibl.IrradianceSh.data(), data, sizeof(ibl.IrradianceSh));
+	data += sizeof(ibl.IrradianceSh);
+	ibl.SpecularSize = header.SpecularSize;
+	ibl.SpecularLevels = header.SpecularLevels;
+	ibl.Specular.resize(specularCount);
+	std::memcpy(ibl.Specular.data(), data, specularCount * sizeof(glm::vec3));
+	data += specularCount * sizeof(glm::vec3);
+	ibl.BrdfLutSize = header.BrdfLutSize;
+	ibl.BrdfLut.resize(brdfLutCount);
+	std::memcpy(ibl.BrdfLut.data(), data, brdfLutCount * sizeof(glm::vec2));
+	return true;
+}
+
+
+bool dengine::writeIblCache(const std::pmr::string& path, unsigned long long key, const PrecomputedIbl& ibl)
+{
+	std::ofstream stream(path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+		return false;
+
+	IblCacheHeader header{};
+	std::memcpy(header.Magic, IblCacheMagic, sizeof(IblCacheMagic));
+	header.Version = IblCacheVersion;
+	header.Key = key;
+	header.SpecularSize = ibl.SpecularSize;
+	header.SpecularLevels = ibl.SpecularLevels;
+	header.BrdfLutSize = ibl.BrdfLutSize;
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	stream.write(reinterpret_cast<const char*>(ibl.IrradianceSh.data()), sizeof(ibl.IrradianceSh));
+	stream.write(reinterpret_cast<const char*>(ibl.Specular.data()), ibl.Specular.size() * sizeof(glm::vec3));
+	stream.write(reinterpret_cast<const char*>(ibl.BrdfLut.data()), ibl.BrdfLut.size() * sizeof(glm::vec2));
+	return stream.good();
+}
@@ -0,0 +1,51 @@
+#ifndef IBL_PRECOMPUTE_INCLUDED
+#define IBL_PRECOMPUTE_INCLUDED
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <BS_thread_pool.hpp>
+
+namespace dengine
+{
+	//equirectangular radiance, rows from top to bottom, +y is up
+	struct EnvironmentImage {
+		int Width{ 0 };
+		int Height{ 0 };
+		std::pmr::vector<glm::vec3> Texels;
+	};
+
+	struct IblSettings {
+		int SpecularSize{ 128 };
+		//roughness of level is level / (levels - 1)
+		int SpecularLevels{ 6 };
+		unsigned int SpecularSamples{ 128 };
+		int BrdfLutSize{ 128 };
+		unsigned int BrdfSamples{ 256 };
+	};
+
+	struct PrecomputedIbl {
+		//irradiance E(n) = sum of coefficients times real sh basis of n, cosine lobe is already convolved
+		std::array<glm::vec3, 9> IrradianceSh{};
+		int SpecularSize{ 0 };
+		int SpecularLevels{ 0 };
+		//ggx prefiltered cube map, level after level, every level holds 6 faces in gl face order
+		std::pmr::vector<glm::vec3> Specular;
+		int BrdfLutSize{ 0 };
+		//split sum scale and bias of F0, x by NdotV and y by roughness
+		std::pmr::vector<glm::vec2> BrdfLut;
+	};
+
+	//radiance hdr or any other format stb decodes to float
+	bool loadEnvironmentImage(const char* data, size_t size, EnvironmentImage& image);
+	//rows of every level are spread over thread pool, blocks until done
+	PrecomputedIbl precomputeIbl(const EnvironmentImage& environment, const IblSettings& settings,
+		BS::thread_pool& threadPool);
+	//key identifies source and settings, mismatching or truncated cache is rejected
+	bool loadIblCache(const std::pmr::string& path, unsigned long long key, PrecomputedIbl& ibl);
+	bool writeIblCache(const std::pmr::string& path, unsigned long long key, const PrecomputedIbl& ibl);
+}
+
+#endif
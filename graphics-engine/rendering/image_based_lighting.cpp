@@ -0,0 +1,149 @@
+#include <rendering/image_based_lighting.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+#include <profiling/memory_tracker.h>
+#include <utils/hash_utils.h>
+#include <utils/mapped_file.h>
+namespace fs = std::filesystem;
+
+
+//prefiltered data is relative to working directory like shader cache
+constexpr const char* IblCacheDirectory = "ibl-cache";
+//UNIFORM BUFFER BINDINGS, must match pbr.frag and deferred_lighting.comp
+constexpr unsigned int UboImageBasedLightingBinding = 1;
+//TEXTURE UNITS
+constexpr unsigned int SpecularEnvironmentUnit = 3;
+constexpr unsigned int BrdfLutUnit = 4;
+
+
+dengine::ImageBasedLighting::ImageBasedLighting(BS::thread_pool& threadPool, IblSettings settings) :
+	threadPool(threadPool), settings(settings)
+{
+	IblEnvironmentData environmentData{};
+	glCreateBuffers(1, &environmentBuffer);
+	glNamedBufferData(environmentBuffer, sizeof(IblEnvironmentData), &environmentData, GL_DYNAMIC_DRAW);
+	MemoryTracker::Get().TrackGpuObject(MemoryCategory::UniformBuffers, environmentBuffer, sizeof(IblEnvironmentData),
+		"image based lighting");
+}
+
+
+dengine::ImageBasedLighting::~ImageBasedLighting()
+{
+	deleteTextures();
+	glDeleteBuffers(1, &environmentBuffer);
+	MemoryTracker::Get().ReleaseGpuObject(MemoryCategory::UniformBuffers, environmentBuffer);
+}
+
+
+bool dengine::ImageBasedLighting::Load(const std::pmr::string& path)
+{
+	auto log = spdlog::get("app_logger");
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		log->error("Failed to open environment map {}", path.c_str());
+		return false;
+	}
+
+	//content rather than path keys cache, so edited environment is never served stale
+	const auto key = hashBytes(&settings, sizeof(settings), hashBytes(file.Data(), file.Size()));
+	char fileName[32];
+	std::snprintf(fileName, sizeof(fileName), "%016llx.ibl", key);
+	const std::pmr::string cachePath((fs::path(IblCacheDirectory) / fileName).string());
+	PrecomputedIbl ibl;
+	if (loadIblCache(cachePath, key, ibl))
+	{
+		log->info("Loaded prefiltered environment {} from {}", path.c_str(), cachePath.c_str());
+	}
+	else
+	{
+		EnvironmentImage environment;
+		if (!loadEnvironmentImage(file.Data(), file.Size(), environment))
+			return false;
+		const auto start = std::chrono::steady_clock::now();
+		ibl = precomputeIbl(environment, settings, threadPool);
+		log->info("Prefiltered environment {} in {:.1f} ms", path.c_str(),
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		std::error_code error;
+		fs::create_directories(IblCacheDirectory, error);
+		if (!writeIblCache(cachePath, key, ibl))
+			log->warn("Failed to write prefiltered environment to {}", cachePath.c_str());
+	}
+	upload(ibl, path);
+	return true;
+}
+
+
+void dengine::ImageBasedLighting::Bind(float intensity) const
+{
+	const glm::vec4 parameters(maxSpecularLod, intensity, IsLoaded() ? 1.0f : 0.0f, 0.0f);
+	glNamedBufferSubData(environmentBuffer, offsetof(IblEnvironmentData, Parameters), sizeof(parameters), &parameters);
+	glBindBufferBase(GL_UNIFORM_BUFFER, UboImageBasedLightingBinding, environmentBuffer);
+	glBindTextureUnit(SpecularEnvironmentUnit, specularTexture);
+	glBindTextureUnit(BrdfLutUnit, brdfLutTexture);
+}
+
+
+bool dengine::ImageBasedLighting::IsLoaded() const
+{
+	return specularTexture != 0;
+}
+
+
+void dengine::ImageBasedLighting::upload(const PrecomputedIbl& ibl, const std::pmr::string& path)
+{
+	deleteTextures();
+	//11 11 10 float keeps hdr range at 4 bytes per texel
+	glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &specularTexture);
+	glTextureStorage2D(specularTexture, ibl.SpecularLevels, GL_R11F_G11F_B10F, ibl.SpecularSize, ibl.SpecularSize);
+	size_t levelOffset = 0;
+	for (int level = 0; level < ibl.SpecularLevels; level++)
+	{
+		const int size = std::max(ibl.SpecularSize >> level, 1);
+		glTextureSubImage3D(specularTexture, level, 0, 0, 0, size, size, 6, GL_RGB, GL_FLOAT,
+			ibl.Specular.data() + levelOffset);
+		levelOffset += 6 * static_cast<size_t>(size) * size;
+	}
+	glTextureParameteri(specularTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTextureParameteri(specularTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &brdfLutTexture);
+	glTextureStorage2D(brdfLutTexture, 1, GL_RG16F, ibl.BrdfLutSize, ibl.BrdfLutSize);
+	glTextureSubImage2D(brdfLutTexture, 0, 0, 0, ibl.BrdfLutSize, ibl.BrdfLutSize, GL_RG, GL_FLOAT, ibl.BrdfLut.data());
+	glTextureParameteri(brdfLutTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(brdfLutTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(brdfLutTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(brdfLutTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	auto& memoryTracker = MemoryTracker::Get();
+	memoryTracker.TrackGpuObject(MemoryCategory::Textures, specularTexture,
+		6 * getTextureStorageSize(ibl.SpecularSize, ibl.SpecularSize, ibl.SpecularLevels, 4), path);
+	memoryTracker.TrackGpuObject(MemoryCategory::Textures, brdfLutTexture,
+		getTextureStorageSize(ibl.BrdfLutSize, ibl.BrdfLutSize, 1, 4), path);
+
+	IblEnvironmentData environmentData{};
+	for (int i = 0; i < 9; i++)
+		environmentData.IrradianceSh[i] = glm::vec4(ibl.IrradianceSh[i], 0.0f);
+	maxSpecularLod = static_cast<float>(ibl.SpecularLevels - 1);
+	glNamedBufferSubData(environmentBuffer, 0, sizeof(environmentData.IrradianceSh), environmentData.IrradianceSh);
+}
+
+
+void dengine::ImageBasedLighting::deleteTextures()
+{
+	if (specularTexture == 0)
+		return;
+	glDeleteTextures(1, &specularTexture);
+	glDeleteTextures(1, &brdfLutTexture);
+	auto& memoryTracker = MemoryTracker::Get();
+	memoryTracker.ReleaseGpuObject(MemoryCategory::Textures, specularTexture);
+	memoryTracker.ReleaseGpuObject(MemoryCategory::Textures, brdfLutTexture);
+	specularTexture = brdfLutTexture = 0;
+}
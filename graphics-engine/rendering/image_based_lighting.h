@@ -0,0 +1,46 @@
+#ifndef IMAGE_BASED_LIGHTING_INCLUDED
+#define IMAGE_BASED_LIGHTING_INCLUDED
+
+#include <string>
+
+#include <glm/glm.hpp>
+#include <BS_thread_pool.hpp>
+#include <rendering/ibl_precompute.h>
+
+namespace dengine
+{
+	struct IblEnvironmentData {
+		glm::vec4 IrradianceSh[9];
+		//x max specular lod, y intensity, z 1 when environment is loaded
+		glm::vec4 Parameters;
+	};
+
+
+	//gpu side of precomputed environment lighting sampled by pbr shaders,
+	//prefiltering runs once per environment and settings, later runs read it from ibl-cache
+	class ImageBasedLighting {
+	public:
+		explicit ImageBasedLighting(BS::thread_pool& threadPool, IblSettings settings = {});
+		~ImageBasedLighting();
+		ImageBasedLighting(const ImageBasedLighting&) = delete;
+		ImageBasedLighting& operator=(const ImageBasedLighting&) = delete;
+
+		//equirectangular .hdr environment, replaces previously loaded one
+		bool Load(const std::pmr::string& path);
+		//shaders fall back to flat ambient term while nothing is loaded
+		void Bind(float intensity) const;
+		bool IsLoaded() const;
+	private:
+		void upload(const PrecomputedIbl& ibl, const std::pmr::string& path);
+		void deleteTextures();
+
+		BS::thread_pool& threadPool;
+		IblSettings settings;
+		unsigned int environmentBuffer{ 0 };
+		unsigned int specularTexture{ 0 };
+		unsigned int brdfLutTexture{ 0 };
+		float maxSpecularLod{ 0.0f };
+	};
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include <rendering/render_target_pool.h>
+
+#include <algorithm>
+#include <glad/glad.h>
+#include <profiling/memory_tracker.h>
+
+
+//sizes are rounded up to multiple of this, so viewport dragged by few pixels still fits its targets
+constexpr int RenderTargetSizeStep = 128;
+//released targets survive this many frames, enough for resize to settle and pick them up again
+constexpr size_t FreeTargetLifetime = 120;
+
+
+int getBytesPerTexel(unsigned int format)
+{
+	switch (format)
+	{
+	case GL_RGBA16F:
+		return 8;
+	case GL_R8:
+		return 1;
+	default:
+		//rgba8, rgb10_a2, depth24_stencil8 and depth32f
+		return 4;
+	}
+}
+
+
+dengine::RenderTargetPool::~RenderTargetPool()
+{
+	for (auto& freeTarget : freeTargets)
+		deleteTarget(freeTarget.Target);
+}
+
+
+dengine::RenderTarget dengine::RenderTargetPool::Acquire(unsigned int format, int width, int height)
+{
+	const auto size = GetSizeClass(width, height);
+	auto freeIter = std::find_if(freeTargets.begin(), freeTargets.end(), [&](const FreeTarget& freeTarget)
+	{
+		return freeTarget.Target.Format == format && freeTarget.Target.Width == size.x &&
+			freeTarget.Target.Height == size.y;
+	});
+	if (freeIter != freeTargets.end())
+	{
+		const auto target = freeIter->Target;
+		freeTargets.erase(freeIter);
+		return target;
+	}
+
+	RenderTarget target{ 0, format, size.x, size.y };
+	glCreateTextures(GL_TEXTURE_2D, 1, &target.Texture);
+	glTextureStorage2D(target.Texture, 1, format, size.x, size.y);
+	MemoryTracker::Get().TrackGpuObject(MemoryCategory::RenderTargets, target.Texture,
+		getTextureStorageSize(size.x, size.y, 1, getBytesPerTexel(format)), "render target pool");
+	return target;
+}
+
+
+void dengine::RenderTargetPool::Release(RenderTarget& target)
+{
+	if (target.Texture != 0)
+		freeTargets.push_back(FreeTarget{ target, frame });
+	target = RenderTarget{};
+}
+
+
+void dengine::RenderTargetPool::NewFrame()
+{
+	frame++;
+	const auto expiredBegin = std::partition(freeTargets.begin(), freeTargets.end(), [&](const FreeTarget& freeTarget)
+	{
+		return frame - freeTarget.ReleasedFrame < FreeTargetLifetime;
+	});
+	for (auto freeIter = expiredBegin; freeIter != freeTargets.end(); ++freeIter)
+		deleteTarget(freeIter->Target);
+	freeTargets.erase(expiredBegin, freeTargets.end());
+}
+
+
+size_t dengine::RenderTargetPool::GetFreeCount() const
+{
+	return freeTargets.size();
+}
+
+
+glm::ivec2 dengine::RenderTargetPool::GetSizeClass(int width, int height)
+{
+	const auto roundUp = [](int size)
+	{
+		return (std::max(size, 1) + RenderTargetSizeStep - 1) / RenderTargetSizeStep * RenderTargetSizeStep;
+	};
+	return glm::ivec2(roundUp(width), roundUp(height));
+}
+
+
+void dengine::RenderTargetPool::deleteTarget(const RenderTarget& target)
+{
+	glDeleteTextures(1, &target.Texture);
+	MemoryTracker::Get().ReleaseGpuObject(MemoryCategory::RenderTargets, target.Texture);
+}
@@ -0,0 +1,48 @@
+#ifndef RENDER_TARGET_POOL_INCLUDED
+#define RENDER_TARGET_POOL_INCLUDED
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace dengine
+{
+	struct RenderTarget {
+		unsigned int Texture{ 0 };
+		unsigned int Format{ 0 };
+		//allocated size, users render into lower left part of it
+		int Width{ 0 };
+		int Height{ 0 };
+	};
+
+
+	//2d render targets rounded up to size classes, released targets are kept for a while and handed out again
+	//to any request of same format and size class, so resizing back and forth does not allocate
+	class RenderTargetPool {
+	public:
+		RenderTargetPool() = default;
+		~RenderTargetPool();
+		RenderTargetPool(const RenderTargetPool&) = delete;
+		RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+		RenderTarget Acquire(unsigned int format, int width, int height);
+		//target is reset, its texture must not be attached or sampled afterwards
+		void Release(RenderTarget& target);
+		//deletes targets nobody acquired for several frames
+		void NewFrame();
+		size_t GetFreeCount() const;
+		static glm::ivec2 GetSizeClass(int width, int height);
+	private:
+		struct FreeTarget {
+			RenderTarget Target;
+			size_t ReleasedFrame;
+		};
+
+		void deleteTarget(const RenderTarget& target);
+
+		std::pmr::vector<FreeTarget> freeTargets;
+		size_t frame{ 0 };
+	};
+}
+
+#endif
@@ -1,98 +1,74 @@
 #include <rendering/rendering_tmp.h>
+#include <rendering/texture_streamer.h>
+#include <cstring>
 #include <glad/glad.h>
+#include <profiling/profiler.h>
+#include <profiling/memory_tracker.h>
 
 
 unsigned dengine::calculateBufferSize(const Mesh& mesh)
 {
 	return mesh.Positions.size() * sizeof(glm::vec3) + mesh.Normals.size() * sizeof(glm::vec3) + mesh.UVs.size() *
-		sizeof(glm::vec2) + mesh.Tangents.size() * sizeof(glm::vec3);
+		sizeof(glm::vec2) + mesh.Tangents.size() * sizeof(glm::vec4);
 }
 
 
-std::pmr::vector<dengine::LoadedMaterial> dengine::loadMaterialsToGpu(const Model& model)
+template<typename T>
+dengine::VertexLayout packVertexStream(const std::pmr::vector<T>& stream, unsigned char* destination, unsigned int& offset)
 {
-	std::pmr::vector<LoadedMaterial> materials;
-	std::pmr::map<unsigned int, unsigned int> loadedTextures;
+	const dengine::VertexLayout vertexLayout{ sizeof(T), offset, stream.size() * sizeof(T) };
+	if (!stream.empty())
+		std::memcpy(destination + offset, stream.data(), vertexLayout.Size);
+	offset += static_cast<unsigned int>(vertexLayout.Size);
+	return vertexLayout;
+}
+
 
+std::array<dengine::VertexLayout, 4> dengine::packVertexData(const Mesh& mesh, unsigned char* destination)
+{
+	std::array<VertexLayout, 4> vertexLayouts;
+	unsigned int offset = 0;
+	vertexLayouts[Positions] = packVertexStream(mesh.Positions, destination, offset);
+	vertexLayouts[Normals] = packVertexStream(mesh.Normals, destination, offset);
+	vertexLayouts[UVs] = packVertexStream(mesh.UVs, destination, offset);
+	vertexLayouts[Tangents] = packVertexStream(mesh.Tangents, destination, offset);
+	return vertexLayouts;
+}
+
+
+std::pmr::vector<dengine::LoadedMaterial> dengine::loadMaterialsToGpu(Model& model, TextureStreamer& textureStreamer)
+{
+	//every referenced texture is registered once, all of model at once so their mip chains are built in parallel
+	std::pmr::vector<int> textureIndices;
+	std::pmr::map<int, size_t> registeredTextures;
 	for (auto& material : model.Materials)
+		for (int textureIndex : { material.DiffuseTextureIndex, material.NormalTextureIndex, material.MetalnessTextureIndex })
+			if (textureIndex >= 0 && textureIndex < model.Textures.size() &&
+				registeredTextures.emplace(textureIndex, textureIndices.size()).second)
+				textureIndices.push_back(textureIndex);
+	const auto textureNames = textureStreamer.Register(model.Textures, textureIndices, model.Name);
+
+	//missing texture is name 0, shaders pick variant without that map
+	auto getTextureName = [&](int textureIndex)
 	{
-		auto& texture = model.Textures[material.DiffuseTextureIndex];
-
-		unsigned int diffuseTexture, normalTexture, metalnessTexture;
-		auto index = loadedTextures.find(material.DiffuseTextureIndex);
-		//load diffuse texture to gpu
-		if (index == loadedTextures.end())
-		{
-			auto& textureToLoad = model.Textures[material.DiffuseTextureIndex];
-			glCreateTextures(GL_TEXTURE_2D, 1, &diffuseTexture);
-			glTextureStorage2D(diffuseTexture, 4, GL_RGBA8, textureToLoad.Width, textureToLoad.Height);
-
-			auto textureFormat = GL_RGBA;
-			glTextureSubImage2D(diffuseTexture, 0, 0, 0, textureToLoad.Width, textureToLoad.Height, textureFormat,
-			                    GL_UNSIGNED_BYTE, &textureToLoad.Data[0]);
-
-			glTextureParameteri(diffuseTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTextureParameteri(diffuseTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glTextureParameteri(diffuseTexture, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTextureParameteri(diffuseTexture, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glGenerateTextureMipmap(diffuseTexture);
-		}
-		else
-			diffuseTexture = index->second;
-
-		index = loadedTextures.find(material.NormalTextureIndex);
-		//load normal texture to gpu
-		if (index == loadedTextures.end())
-		{
-			auto& textureToLoad = model.Textures[material.NormalTextureIndex];
-			glCreateTextures(GL_TEXTURE_2D, 1, &normalTexture);
-			glTextureStorage2D(normalTexture, 1, GL_RGBA8, textureToLoad.Width, textureToLoad.Height);
-
-			auto textureFormat = GL_RGBA;
-			glTextureSubImage2D(normalTexture, 0, 0, 0, textureToLoad.Width, textureToLoad.Height, textureFormat,
-				GL_UNSIGNED_BYTE, &textureToLoad.Data[0]);
-
-			glTextureParameteri(normalTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTextureParameteri(normalTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glTextureParameteri(normalTexture, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTextureParameteri(normalTexture, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		}
-		else
-			normalTexture = index->second;
-
-		index = loadedTextures.find(material.MetalnessTextureIndex);
-		//load normal texture to gpu
-		if (index == loadedTextures.end())
-		{
-			auto& textureToLoad = model.Textures[material.MetalnessTextureIndex];
-			glCreateTextures(GL_TEXTURE_2D, 1, &metalnessTexture);
-			glTextureStorage2D(metalnessTexture, 1, GL_RGBA8, textureToLoad.Width, textureToLoad.Height);
-
-			auto textureFormat = GL_RGBA;
-			glTextureSubImage2D(metalnessTexture, 0, 0, 0, textureToLoad.Width, textureToLoad.Height, textureFormat,
-				GL_UNSIGNED_BYTE, &textureToLoad.Data[0]);
-
-			glTextureParameteri(metalnessTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTextureParameteri(metalnessTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glTextureParameteri(metalnessTexture, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTextureParameteri(metalnessTexture, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		}
-		else
-			normalTexture = index->second;
-
+		auto registeredIter = registeredTextures.find(textureIndex);
+		return registeredIter == registeredTextures.end() ? 0 : static_cast<int>(textureNames[registeredIter->second]);
+	};
+	std::pmr::vector<LoadedMaterial> materials;
+	for (auto& material : model.Materials)
 		materials.push_back(LoadedMaterial{
-			static_cast<int>(diffuseTexture),
-			static_cast<int>(normalTexture),
-		static_cast<int>(metalnessTexture)});
-	}
+			getTextureName(material.DiffuseTextureIndex),
+			getTextureName(material.NormalTextureIndex),
+			getTextureName(material.MetalnessTextureIndex)});
 	return materials;
 }
 
 
-dengine::OpenglModel dengine::loadModelToGpu(const Model& model)
+dengine::OpenglModel dengine::loadModelToGpu(Model& model, TextureStreamer& textureStreamer)
 {
+	DENGINE_PROFILE_SCOPE("upload model");
 	std::pmr::vector<BufferedMesh> bufferedMeshes;
-	std::array<VertexLayout, 4> vertexLayouts;
+	std::pmr::vector<unsigned char> stagingBuffer;
 	for (const auto& mesh : model.Meshes)
 	{
 		unsigned int buffers[2];
@@ -100,32 +76,46 @@ dengine::OpenglModel dengine::loadModelToGpu(const Model& model)
 		unsigned int* eboPtr = &buffers[1];
 		glCreateBuffers(2, buffers);
 
+		//pack all attribute streams on cpu and upload them with one call
 		auto bufferSize = calculateBufferSize(mesh);
-		glNamedBufferData(*vboPtr, bufferSize, nullptr, GL_STATIC_DRAW);
-		//load postions
-		unsigned int offset = 0;
-		glNamedBufferSubData(*vboPtr, offset, mesh.Positions.size() * sizeof(glm::vec3), &mesh.Positions[0]);
-		vertexLayouts[Positions] = VertexLayout{sizeof(glm::vec3), offset, mesh.Positions.size() * sizeof(glm::vec3)};
-		offset += mesh.Positions.size() * sizeof(glm::vec3);
-		//load normals
-		glNamedBufferSubData(*vboPtr, offset, mesh.Normals.size() * sizeof(glm::vec3), &mesh.Normals[0]);
-		vertexLayouts[Normals] = VertexLayout{sizeof(glm::vec3), offset, mesh.Normals.size() * sizeof(glm::vec3)};
-		offset += mesh.Normals.size() * sizeof(glm::vec3);
-		//load uvs
-		glNamedBufferSubData(*vboPtr, offset, mesh.UVs.size() * sizeof(glm::vec2), &mesh.UVs[0]);
-		vertexLayouts[UVs] = VertexLayout{sizeof(glm::vec2), offset, mesh.UVs.size() * sizeof(glm::vec2)};
-		offset += mesh.UVs.size() * sizeof(glm::vec2);
-		//load tangents
-		glNamedBufferSubData(*vboPtr, offset, mesh.Tangents.size() * sizeof(glm::vec3), &mesh.Tangents[0]);
-		vertexLayouts[Tangents] = VertexLayout{ sizeof(glm::vec3), offset, mesh.Tangents.size() * sizeof(glm::vec3) };
-		offset += mesh.Tangents.size() * sizeof(glm::vec3);
+		stagingBuffer.resize(bufferSize);
+		const auto vertexLayouts = packVertexData(mesh, stagingBuffer.data());
+		glNamedBufferData(*vboPtr, bufferSize, stagingBuffer.data(), GL_STATIC_DRAW);
 		//load elements
 		glNamedBufferData(*eboPtr, mesh.Indecies.size() * sizeof(unsigned), &mesh.Indecies[0], GL_STATIC_DRAW);
-		bufferedMeshes.push_back(BufferedMesh{
+		MemoryTracker::Get().TrackGpuObject(MemoryCategory::VertexBuffers, *vboPtr, bufferSize, model.Name);
+		MemoryTracker::Get().TrackGpuObject(MemoryCategory::IndexBuffers, *eboPtr,
+			static_cast<long long>(mesh.Indecies.size() * sizeof(unsigned)), model.Name);
+		auto& bufferedMesh = bufferedMeshes.emplace_back(BufferedMesh{
 			*vboPtr, *eboPtr, mesh.MaterialIndex, mesh.Indecies.size(), vertexLayouts
 		});
+		bufferedMesh.BoundsMin = mesh.BoundsMin;
+		bufferedMesh.BoundsMax = mesh.BoundsMax;
+		bufferedMesh.BoundingSphere = mesh.BoundingSphere;
 	}
 
-	auto materials = loadMaterialsToGpu(model);
+	auto materials = loadMaterialsToGpu(model, textureStreamer);
 	return OpenglModel{bufferedMeshes, materials,};
 }
+
+
+void dengine::unloadModelFromGpu(OpenglModel& model, TextureStreamer& textureStreamer)
+{
+	auto& memoryTracker = MemoryTracker::Get();
+	for (auto& bufferedMesh : model.Meshes)
+	{
+		const unsigned int buffers[2] = { bufferedMesh.Vbo, bufferedMesh.Ebo };
+		glDeleteBuffers(2, buffers);
+		memoryTracker.ReleaseGpuObject(MemoryCategory::VertexBuffers, bufferedMesh.Vbo);
+		memoryTracker.ReleaseGpuObject(MemoryCategory::IndexBuffers, bufferedMesh.Ebo);
+	}
+
+	std::pmr::vector<unsigned int> textureNames;
+	for (auto& material : model.Materils)
+		for (int textureName : { material.DiffuseTextureId, material.NormalTextureId, material.MetalnessTextureId })
+			if (textureName > 0)
+				textureNames.push_back(static_cast<unsigned int>(textureName));
+	textureStreamer.Unregister(textureNames);
+	model.Meshes.clear();
+	model.Materils.clear();
+}
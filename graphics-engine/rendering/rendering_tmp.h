@@ -42,6 +42,11 @@ namespace dengine
 		unsigned int Ebo;
 		unsigned int MaterialIndex;
 		unsigned long long NumElements;
+		//mesh space axis aligned bounds
+		glm::vec3 BoundsMin{ 0.0f };
+		glm::vec3 BoundsMax{ 0.0f };
+		//mesh space center and radius, culling and shadow caster sphere
+		glm::vec4 BoundingSphere{ 0.0f };
 
 		VertexLayout GetVertexAttributeLayout(VertexDataType vertexDataType) const
 		{
@@ -56,9 +61,16 @@ namespace dengine
 		std::pmr::vector<LoadedMaterial> Materils;
 	};
 
+	class TextureStreamer;
+
 	unsigned int calculateBufferSize(const dengine::Mesh& mesh);
-	std::pmr::vector<LoadedMaterial> loadMaterialsToGpu(const dengine::Model& model);
-	OpenglModel loadModelToGpu(const dengine::Model& model);
+	//writes attribute streams back to back into destination, which must hold calculateBufferSize bytes
+	std::array<VertexLayout, 4> packVertexData(const dengine::Mesh& mesh, unsigned char* destination);
+	//textures referenced by materials move into streamer, which uploads them starting from their coarse levels
+	std::pmr::vector<LoadedMaterial> loadMaterialsToGpu(dengine::Model& model, TextureStreamer& textureStreamer);
+	OpenglModel loadModelToGpu(dengine::Model& model, TextureStreamer& textureStreamer);
+	//deletes buffers of model and unregisters its textures, model is left empty
+	void unloadModelFromGpu(OpenglModel& model, TextureStreamer& textureStreamer);
 }
 
 #endif
@@ -0,0 +1,264 @@
+#include <rendering/retained_draw_list.h>
+
+#include <algorithm>
+#include <limits>
+#include <glad/glad.h>
+#include <scene/transform_system.h>
+#include <profiling/profiler.h>
+#include <profiling/memory_tracker.h>
+
+constexpr unsigned int InvalidIndex = std::numeric_limits<unsigned int>::max();
+
+
+//box is outside when its corner furthest along plane normal is behind plane
+bool isBoxVisible(const std::array<glm::vec4, 6>& planes, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	for (const auto& plane : planes)
+	{
+		const glm::vec3 normal(plane);
+		const glm::vec3 furthest(normal.x >= 0.0f ? boundsMax.x : boundsMin.x, normal.y >= 0.0f ? boundsMax.y : boundsMin.y,
+			normal.z >= 0.0f ? boundsMax.z : boundsMin.z);
+		if (glm::dot(normal, furthest) + plane.w < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+
+dengine::PbrRetainedDrawList::PbrRetainedDrawList(entt::registry& registry) : registry(registry)
+{
+	registry.on_construct<PbrRenderingUnit>().connect<&PbrRetainedDrawList::onDrawableChanged>(*this);
+	registry.on_construct<Material>().connect<&PbrRetainedDrawList::onDrawableChanged>(*this);
+	registry.on_construct<TransformComponent>().connect<&PbrRetainedDrawList::onDrawableChanged>(*this);
+	registry.on_update<PbrRenderingUnit>().connect<&PbrRetainedDrawList::onDrawableChanged>(*this);
+	registry.on_update<Material>().connect<&PbrRetainedDrawList::onDrawableChanged>(*this);
+	registry.on_update<TransformComponent>().connect<&PbrRetainedDrawList::onTransformUpdated>(*this);
+	registry.on_destroy<PbrRenderingUnit>().connect<&PbrRetainedDrawList::onDrawableDestroyed>(*this);
+	registry.on_destroy<Material>().connect<&PbrRetainedDrawList::onDrawableDestroyed>(*this);
+	registry.on_destroy<TransformComponent>().connect<&PbrRetainedDrawList::onDrawableDestroyed>(*this);
+
+	//pick up entities created before list existed
+	for (auto entity : registry.view<PbrRenderingUnit, TransformComponent, Material>())
+		insert(entity);
+}
+
+
+dengine::PbrRetainedDrawList::~PbrRetainedDrawList()
+{
+	registry.on_construct<PbrRenderingUnit>().disconnect(*this);
+	registry.on_construct<Material>().disconnect(*this);
+	registry.on_construct<TransformComponent>().disconnect(*this);
+	registry.on_update<PbrRenderingUnit>().disconnect(*this);
+	registry.on_update<Material>().disconnect(*this);
+	registry.on_update<TransformComponent>().disconnect(*this);
+	registry.on_destroy<PbrRenderingUnit>().disconnect(*this);
+	registry.on_destroy<Material>().disconnect(*this);
+	registry.on_destroy<TransformComponent>().disconnect(*this);
+
+	for (auto& batch : batches)
+		if (batch.InstancesBuffer != 0)
+		{
+			glDeleteBuffers(1, &batch.InstancesBuffer);
+			MemoryTracker::Get().ReleaseGpuObject(MemoryCategory::InstanceBuffers, batch.InstancesBuffer);
+		}
+}
+
+
+void dengine::PbrRetainedDrawList::Update()
+{
+	DENGINE_PROFILE_SCOPE("update retained draw lists");
+	for (auto batchIndex : dirtyBatches)
+	{
+		auto& batch = batches[batchIndex];
+		batch.Queued = false;
+		if (batch.Instances.empty())
+			continue;
+
+		//grow geometrically, new buffer needs full upload
+		if (batch.Instances.size() > batch.GpuCapacity)
+		{
+			if (batch.InstancesBuffer != 0)
+			{
+				glDeleteBuffers(1, &batch.InstancesBuffer);
+				MemoryTracker::Get().ReleaseGpuObject(MemoryCategory::InstanceBuffers, batch.InstancesBuffer);
+			}
+			batch.GpuCapacity = std::max(batch.Instances.size(), batch.GpuCapacity * 2);
+			glCreateBuffers(1, &batch.InstancesBuffer);
+			glNamedBufferData(batch.InstancesBuffer, batch.GpuCapacity * sizeof(PbrInstancesData), nullptr, GL_DYNAMIC_DRAW);
+			MemoryTracker::Get().TrackGpuObject(MemoryCategory::InstanceBuffers, batch.InstancesBuffer,
+				static_cast<long long>(batch.GpuCapacity * sizeof(PbrInstancesData)), "retained draw list");
+			batch.DirtyBegin = 0;
+			batch.DirtyEnd = batch.Instances.size();
+		}
+		batch.DirtyEnd = std::min(batch.DirtyEnd, batch.Instances.size());
+		if (batch.DirtyBegin < batch.DirtyEnd)
+			glNamedBufferSubData(batch.InstancesBuffer, batch.DirtyBegin * sizeof(PbrInstancesData),
+				(batch.DirtyEnd - batch.DirtyBegin) * sizeof(PbrInstancesData), batch.Instances.data() + batch.DirtyBegin);
+		batch.DirtyBegin = batch.DirtyEnd = 0;
+
+		//instance positions widened by mesh bounding sphere scaled with instance
+		const glm::vec4 boundingSphere = batch.RenderingUnit.BoundingSphere;
+		batch.BoundsMin = glm::vec3(std::numeric_limits<float>::max());
+		batch.BoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+		for (auto& instance : batch.Instances)
+		{
+			const glm::vec3 center(glm::dot(instance.ModelRows[0], glm::vec4(glm::vec3(boundingSphere), 1.0f)),
+				glm::dot(instance.ModelRows[1], glm::vec4(glm::vec3(boundingSphere), 1.0f)),
+				glm::dot(instance.ModelRows[2], glm::vec4(glm::vec3(boundingSphere), 1.0f)));
+			const glm::vec3 columnX(instance.ModelRows[0].x, instance.ModelRows[1].x, instance.ModelRows[2].x);
+			const glm::vec3 columnY(instance.ModelRows[0].y, instance.ModelRows[1].y, instance.ModelRows[2].y);
+			const glm::vec3 columnZ(instance.ModelRows[0].z, instance.ModelRows[1].z, instance.ModelRows[2].z);
+			const float radius = boundingSphere.w * std::max({ glm::length(columnX), glm::length(columnY),
+				glm::length(columnZ) });
+			batch.BoundsMin = glm::min(batch.BoundsMin, center - radius);
+			batch.BoundsMax = glm::max(batch.BoundsMax, center + radius);
+		}
+	}
+	dirtyBatches.clear();
+}
+
+
+void dengine::PbrRetainedDrawList::CollectDrawCommands(const glm::vec3& cameraPosition,
+	const std::array<glm::vec4, 6>& frustumPlanes, std::pmr::vector<PbrDrawCommand>& drawCommands) const
+{
+	for (auto& batch : batches)
+	{
+		if (batch.Instances.empty() || !isBoxVisible(frustumPlanes, batch.BoundsMin, batch.BoundsMax))
+			continue;
+		const glm::vec3 toBounds = glm::clamp(cameraPosition, batch.BoundsMin, batch.BoundsMax) - cameraPosition;
+		drawCommands.push_back(PbrDrawCommand{ glm::dot(toBounds, toBounds), batch.RenderingUnit, batch.Key,
+			batch.InstancesBuffer, 0, static_cast<unsigned int>(batch.Instances.size()) });
+	}
+}
+
+
+size_t dengine::PbrRetainedDrawList::GetInstanceCount() const
+{
+	return instanceCount;
+}
+
+
+std::span<const dengine::PbrInstancesData> dengine::PbrRetainedDrawList::GetInstances(unsigned int instancesBuffer) const
+{
+	for (auto& batch : batches)
+		if (batch.InstancesBuffer == instancesBuffer && instancesBuffer != 0)
+			return batch.Instances;
+	return {};
+}
+
+
+void dengine::PbrRetainedDrawList::onDrawableChanged(entt::registry&, entt::entity entity)
+{
+	remove(entity);
+	if (registry.all_of<PbrRenderingUnit, TransformComponent, Material>(entity))
+		insert(entity);
+}
+
+
+void dengine::PbrRetainedDrawList::onTransformUpdated(entt::registry&, entt::entity entity)
+{
+	auto location = findLocation(entity);
+	if (location == nullptr)
+	{
+		onDrawableChanged(registry, entity);
+		return;
+	}
+	batches[location->BatchIndex].Instances[location->InstanceIndex] =
+		PbrInstancesData{ registry.get<TransformComponent>(entity).ModelMatrix };
+	markDirty(location->BatchIndex, location->InstanceIndex, location->InstanceIndex + 1);
+}
+
+
+void dengine::PbrRetainedDrawList::onDrawableDestroyed(entt::registry&, entt::entity entity)
+{
+	remove(entity);
+}
+
+
+void dengine::PbrRetainedDrawList::insert(entt::entity entity)
+{
+	const auto& renderingUnit = registry.get<PbrRenderingUnit>(entity);
+	const auto key = getPbrCacheId(renderingUnit.Vao, registry.get<Material>(entity));
+	auto findIter = batchIndices.find(key);
+	if (findIter == batchIndices.end())
+	{
+		findIter = batchIndices.emplace(key, static_cast<unsigned int>(batches.size())).first;
+		auto& batch = batches.emplace_back();
+		batch.Key = key;
+		batch.RenderingUnit = renderingUnit;
+	}
+
+	const auto batchIndex = findIter->second;
+	auto& batch = batches[batchIndex];
+	const auto instanceIndex = static_cast<unsigned int>(batch.Instances.size());
+	batch.Instances.push_back(PbrInstancesData{ registry.get<TransformComponent>(entity).ModelMatrix });
+	batch.Entities.push_back(entity);
+	markDirty(batchIndex, instanceIndex, instanceIndex + 1);
+
+	const auto entityIndex = entt::to_entity(entity);
+	if (locations.size() <= entityIndex)
+		locations.resize(entityIndex + 1, Location{ InvalidIndex, 0 });
+	locations[entityIndex] = Location{ batchIndex, instanceIndex };
+	instanceCount++;
+}
+
+
+void dengine::PbrRetainedDrawList::remove(entt::entity entity)
+{
+	auto location = findLocation(entity);
+	if (location == nullptr)
+		return;
+
+	//swap with last instance so batch stays dense
+	auto& batch = batches[location->BatchIndex];
+	const auto instanceIndex = location->InstanceIndex;
+	const auto lastIndex = batch.Instances.size() - 1;
+	if (instanceIndex != lastIndex)
+	{
+		batch.Instances[instanceIndex] = batch.Instances[lastIndex];
+		batch.Entities[instanceIndex] = batch.Entities[lastIndex];
+		locations[entt::to_entity(batch.Entities[instanceIndex])].InstanceIndex = instanceIndex;
+		markDirty(location->BatchIndex, instanceIndex, instanceIndex + 1);
+	}
+	else
+	{
+		markDirty(location->BatchIndex, instanceIndex, instanceIndex);
+	}
+	batch.Instances.pop_back();
+	batch.Entities.pop_back();
+	location->BatchIndex = InvalidIndex;
+	instanceCount--;
+}
+
+
+void dengine::PbrRetainedDrawList::markDirty(unsigned int batchIndex, size_t begin, size_t end)
+{
+	auto& batch = batches[batchIndex];
+	if (batch.DirtyBegin >= batch.DirtyEnd)
+	{
+		batch.DirtyBegin = begin;
+		batch.DirtyEnd = end;
+	}
+	else if (begin < end)
+	{
+		batch.DirtyBegin = std::min(batch.DirtyBegin, begin);
+		batch.DirtyEnd = std::max(batch.DirtyEnd, end);
+	}
+	if (!batch.Queued)
+	{
+		batch.Queued = true;
+		dirtyBatches.push_back(batchIndex);
+	}
+}
+
+
+dengine::PbrRetainedDrawList::Location* dengine::PbrRetainedDrawList::findLocation(entt::entity entity)
+{
+	const auto entityIndex = entt::to_entity(entity);
+	if (entityIndex >= locations.size() || locations[entityIndex].BatchIndex == InvalidIndex)
+		return nullptr;
+	auto& location = locations[entityIndex];
+	if (batches[location.BatchIndex].Entities[location.InstanceIndex] != entity)
+		return nullptr;
+	return &location;
+}
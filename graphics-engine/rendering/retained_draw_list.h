@@ -0,0 +1,72 @@
+#ifndef RETAINED_DRAW_LIST_INCLUDED
+#define RETAINED_DRAW_LIST_INCLUDED
+
+#include <array>
+#include <vector>
+#include <span>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <rendering/schemas/pbr_rendering_scheme.h>
+
+namespace dengine
+{
+	//persistent instanced batches kept in sync with registry through component signals,
+	//frames without changes only collect one draw command per batch
+	class PbrRetainedDrawList {
+	public:
+		explicit PbrRetainedDrawList(entt::registry& registry);
+		~PbrRetainedDrawList();
+		PbrRetainedDrawList(const PbrRetainedDrawList&) = delete;
+		PbrRetainedDrawList& operator=(const PbrRetainedDrawList&) = delete;
+
+		//uploads instances changed since last call, must be called from GL thread
+		void Update();
+		//one command per batch whose bounds intersect frustum planes
+		void CollectDrawCommands(const glm::vec3& cameraPosition, const std::array<glm::vec4, 6>& frustumPlanes,
+			std::pmr::vector<PbrDrawCommand>& drawCommands) const;
+		size_t GetInstanceCount() const;
+		//cpu copy of instances stored in one of batch buffers, empty for unknown buffer
+		std::span<const PbrInstancesData> GetInstances(unsigned int instancesBuffer) const;
+	private:
+		struct Batch {
+			PbrBatchKey Key;
+			PbrRenderingUnit RenderingUnit;
+			std::pmr::vector<PbrInstancesData> Instances;
+			std::pmr::vector<entt::entity> Entities;
+			unsigned int InstancesBuffer{ 0 };
+			size_t GpuCapacity{ 0 };
+			//instance range not yet uploaded, empty when DirtyBegin >= DirtyEnd
+			size_t DirtyBegin{ 0 };
+			size_t DirtyEnd{ 0 };
+			bool Queued{ false };
+			//world bounds of every instance mesh, used for culling and as sort key
+			glm::vec3 BoundsMin{ 0.0f };
+			glm::vec3 BoundsMax{ 0.0f };
+		};
+
+		struct Location {
+			unsigned int BatchIndex;
+			unsigned int InstanceIndex;
+		};
+
+		void onDrawableChanged(entt::registry&, entt::entity entity);
+		void onTransformUpdated(entt::registry&, entt::entity entity);
+		void onDrawableDestroyed(entt::registry&, entt::entity entity);
+		void insert(entt::entity entity);
+		void remove(entt::entity entity);
+		void markDirty(unsigned int batchIndex, size_t begin, size_t end);
+		Location* findLocation(entt::entity entity);
+
+		entt::registry& registry;
+		std::pmr::vector<Batch> batches;
+		std::unordered_map<PbrBatchKey, unsigned int, PbrBatchKeyHash> batchIndices;
+		//indexed by entity index, BatchIndex of untracked entities is InvalidIndex
+		std::pmr::vector<Location> locations;
+		std::pmr::vector<unsigned int> dirtyBatches;
+		size_t instanceCount{ 0 };
+	};
+}
+
+#endif
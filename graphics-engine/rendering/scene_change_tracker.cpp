@@ -0,0 +1,69 @@
+#include <rendering/scene_change_tracker.h>
+
+#include <rendering/schemas/pbr_rendering_scheme.h>
+#include <scene/scene_components.h>
+#include <scene/transform_system.h>
+
+
+dengine::SceneChangeTracker::SceneChangeTracker(entt::registry& registry) : registry(registry)
+{
+	registry.on_construct<PbrRenderingUnit>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_construct<Material>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_construct<TransformComponent>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_construct<LightComponent>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_construct<DirectionalLightComponent>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_update<PbrRenderingUnit>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_update<Material>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_update<TransformComponent>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_update<LightComponent>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_update<DirectionalLightComponent>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_destroy<PbrRenderingUnit>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_destroy<Material>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_destroy<TransformComponent>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_destroy<LightComponent>().connect<&SceneChangeTracker::onChanged>(*this);
+	registry.on_destroy<DirectionalLightComponent>().connect<&SceneChangeTracker::onChanged>(*this);
+}
+
+
+dengine::SceneChangeTracker::~SceneChangeTracker()
+{
+	registry.on_construct<PbrRenderingUnit>().disconnect(*this);
+	registry.on_construct<Material>().disconnect(*this);
+	registry.on_construct<TransformComponent>().disconnect(*this);
+	registry.on_construct<LightComponent>().disconnect(*this);
+	registry.on_construct<DirectionalLightComponent>().disconnect(*this);
+	registry.on_update<PbrRenderingUnit>().disconnect(*this);
+	registry.on_update<Material>().disconnect(*this);
+	registry.on_update<TransformComponent>().disconnect(*this);
+	registry.on_update<LightComponent>().disconnect(*this);
+	registry.on_update<DirectionalLightComponent>().disconnect(*this);
+	registry.on_destroy<PbrRenderingUnit>().disconnect(*this);
+	registry.on_destroy<Material>().disconnect(*this);
+	registry.on_destroy<TransformComponent>().disconnect(*this);
+	registry.on_destroy<LightComponent>().disconnect(*this);
+	registry.on_destroy<DirectionalLightComponent>().disconnect(*this);
+}
+
+
+void dengine::SceneChangeTracker::Invalidate()
+{
+	dirty = true;
+}
+
+
+void dengine::SceneChangeTracker::Clear()
+{
+	dirty = false;
+}
+
+
+bool dengine::SceneChangeTracker::IsDirty() const
+{
+	return dirty;
+}
+
+
+void dengine::SceneChangeTracker::onChanged(entt::registry&, entt::entity)
+{
+	dirty = true;
+}
@@ -0,0 +1,29 @@
+#ifndef SCENE_CHANGE_TRACKER_INCLUDED
+#define SCENE_CHANGE_TRACKER_INCLUDED
+
+#include <entt/entt.hpp>
+
+namespace dengine
+{
+	//remembers whether any component affecting rendered image was constructed, patched or destroyed since last
+	//Clear; components edited in place through a reference emit no signal and have to be reported by Invalidate
+	class SceneChangeTracker {
+	public:
+		explicit SceneChangeTracker(entt::registry& registry);
+		~SceneChangeTracker();
+		SceneChangeTracker(const SceneChangeTracker&) = delete;
+		SceneChangeTracker& operator=(const SceneChangeTracker&) = delete;
+
+		void Invalidate();
+		void Clear();
+		bool IsDirty() const;
+	private:
+		void onChanged(entt::registry&, entt::entity);
+
+		entt::registry& registry;
+		//freshly created tracker knows nothing about what was last rendered
+		bool dirty{ true };
+	};
+}
+
+#endif
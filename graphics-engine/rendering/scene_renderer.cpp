@@ -0,0 +1,490 @@
+#include <rendering/scene_renderer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+#include <scene/scene_components.h>
+#include <scene/scene_description.h>
+#include <profiling/gpu_profiler.h>
+
+
+//frames output size has to stay unchanged before targets shrink to it, dragging a splitter renders into part of
+//current targets instead of reallocating every frame
+constexpr int ResizeSettleFrames = 30;
+
+
+bool isCameraMoved(const dengine::Camera& camera, const dengine::Camera& renderedCamera)
+{
+	return camera.Position != renderedCamera.Position || camera.Diraction != renderedCamera.Diraction ||
+		camera.Up != renderedCamera.Up;
+}
+
+
+dengine::SceneRenderer::SceneRenderer(entt::registry& registry, BS::thread_pool& threadPool,
+	IModelImporter& modelImporter, OpenglSettings openglSettings) :
+	registry(registry), changeTracker(registry), transformSystem(registry, threadPool), textureStreamer(threadPool),
+	sceneBuilder(registry, transformSystem, modelImporter, textureStreamer, openglSettings),
+	renderingSubmitter(openglSettings),
+	drawListBuilder(threadPool), retainedDrawList(registry),
+	depthPrepassProgram("shaders/depth.vert", "shaders/depth.frag", {}, &PbrRenderingScheme::SetupDepthPrepassProgram),
+	deferredShading(renderTargetPool), cascadedShadowMaps(registry), dynamicResolution(renderTargetPool),
+	imageBasedLighting(threadPool)
+{
+	//pbr variants are compiled in background once scene tells which ones it needs
+	createRenderTargets();
+}
+
+
+dengine::SceneRenderer::~SceneRenderer()
+{
+	deleteRenderTargets();
+}
+
+
+bool dengine::SceneRenderer::LoadScene(const std::pmr::string& path)
+{
+	//a plain model is treated as scene with single instance
+	SceneDescription sceneDescription;
+	if (isSceneDescriptionFile(path))
+	{
+		if (!loadSceneDescription(path, sceneDescription))
+			return false;
+	}
+	else
+	{
+		sceneDescription.Models.push_back(SceneModel{ path });
+		sceneDescription.Instances.push_back(SceneInstance{});
+	}
+	if (sceneDescription.Lights.empty())
+		sceneDescription.Lights.push_back(SceneLight{ glm::vec4(5, 3, 1, 0), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f) });
+	if (!sceneDescription.Sun)
+		sceneDescription.Sun = SceneDirectionalLight{ glm::vec4(-0.4f, -1.0f, -0.3f, 0.0f), glm::vec4(1.0f) };
+	if (!sceneBuilder.Build(sceneDescription))
+		return false;
+	cascadedShadowMaps.AddModels(sceneBuilder.GetLoadedModels());
+	//scene still renders with flat ambient when its environment fails to load
+	if (!sceneDescription.EnvironmentMap.empty())
+		LoadEnvironment(sceneDescription.EnvironmentMap);
+	prepareProgramVariants();
+	return true;
+}
+
+
+bool dengine::SceneRenderer::LoadEnvironment(const std::pmr::string& path)
+{
+	changeTracker.Invalidate();
+	return imageBasedLighting.Load(path);
+}
+
+
+void dengine::SceneRenderer::Resize(int width, int height)
+{
+	if (width != this->width || height != this->height)
+	{
+		this->width = width;
+		this->height = height;
+		framesSinceResize = 0;
+	}
+	else if (framesSinceResize < ResizeSettleFrames)
+	{
+		framesSinceResize++;
+	}
+	if (needsRenderTargets())
+	{
+		deleteRenderTargets();
+		createRenderTargets();
+	}
+}
+
+
+void dengine::SceneRenderer::Render(const Camera& camera)
+{
+	DENGINE_PROFILE_SCOPE("render scene");
+	DENGINE_PROFILE_GPU_SCOPE("scene");
+	updatePrograms();
+	//new view or scene gets feedback pass of its own, on demand rendering keeps going until it is read back
+	if (isCameraMoved(camera, renderedCamera) || changeTracker.IsDirty() || transformSystem.IsDirty())
+		textureStreamer.Invalidate();
+	textureStreamer.Stream();
+	const float aspect = static_cast<float>(width) / static_cast<float>(height);
+	globalEnvironment.CameraPostion = glm::vec4(camera.Position, 1.0f);
+	globalEnvironment.ProjectionMatrix = glm::perspective(glm::radians(settings.FieldOfView), aspect,
+		settings.NearPlane, settings.FarPlane);
+	globalEnvironment.ViewMatrix = CameraControl::GetLookAtMatrix(camera);
+
+	renderTargetPool.NewFrame();
+	transformSystem.Update();
+	if (settings.RetainedDrawing)
+	{
+		retainedDrawList.Update();
+	}
+	else
+	{
+		drawListBuilder.Build(registry, globalEnvironment);
+		drawListBuilder.Merge(renderingSubmitter);
+	}
+
+	auto view = registry.view<LightComponent>();
+	globalEnvironment.Lights.clear();
+	for (auto entity : view)
+	{
+		const auto& lightComponent = view.get<LightComponent>(entity);
+		globalEnvironment.Lights.push_back(LightInfo{ lightComponent.Position, lightComponent.Color });
+	}
+	//first sun of scene lights it, scenes without one have no shadows
+	globalEnvironment.Sun = DirectionalLight{};
+	const auto sunEntity = registry.view<DirectionalLightComponent>().front();
+	if (sunEntity != entt::null)
+	{
+		const auto& sunComponent = registry.get<DirectionalLightComponent>(sunEntity);
+		globalEnvironment.Sun = DirectionalLight{ sunComponent.Direction, sunComponent.Color };
+	}
+	//shadow maps use their own framebuffer, so they are drawn before scene framebuffer is bound
+	if (settings.Shadows)
+		cascadedShadowMaps.Render(globalEnvironment, settings.FieldOfView, aspect, settings.NearPlane,
+			settings.FarPlane);
+
+	beginSceneFramebuffer();
+	if (!drawStreamCapturePath.empty())
+		renderingSubmitter.CaptureNextDispatch(&dispatchCapture);
+	dispatch(settings.DepthPrepass, settings.RetainedDrawing ? &retainedDrawList : nullptr, settings.Shadows);
+	if (!drawStreamCapturePath.empty())
+		writeDrawStreamCapture();
+	//transform updates published above belong to this frame
+	changeTracker.Clear();
+	renderedCamera = camera;
+}
+
+
+bool dengine::SceneRenderer::NeedsRender(const Camera& camera) const
+{
+	const bool cameraMoved = isCameraMoved(camera, renderedCamera);
+	//targets are still settling after resize, programs waiting to link, dynamic resolution rescaled or texture levels
+	//still streaming in
+	const bool pendingWork = framesSinceResize < ResizeSettleFrames || IsCompilingShaders() ||
+		renderSize != dynamicResolution.GetRenderSize(width, height) || !drawStreamCapturePath.empty() ||
+		textureStreamer.IsStreaming();
+	return cameraMoved || pendingWork || changeTracker.IsDirty() || transformSystem.IsDirty();
+}
+
+
+void dengine::SceneRenderer::Invalidate()
+{
+	changeTracker.Invalidate();
+}
+
+
+void dengine::SceneRenderer::CaptureDrawStream(const std::pmr::string& path)
+{
+	drawStreamCapturePath = path;
+}
+
+
+bool dengine::SceneRenderer::LoadDrawStream(const std::pmr::string& path)
+{
+	//stream, items and models are committed only after whole stream is checked, failed load keeps previous one
+	DrawStream loadedStream;
+	if (!loadDrawStream(path, loadedStream))
+		return false;
+
+	//models are loaded without instances, stream carries its own instance data
+	SceneDescription sceneDescription;
+	for (auto& modelPath : loadedStream.Models)
+		sceneDescription.Models.push_back(SceneModel{ modelPath });
+	const size_t firstModel = sceneBuilder.GetLoadedModels().size();
+	if (!sceneBuilder.Build(sceneDescription))
+		return false;
+
+	auto& loadedModels = sceneBuilder.GetLoadedModels();
+	std::pmr::vector<PbrDrawListItem> loadedItems;
+	loadedItems.reserve(loadedStream.Instances.size());
+	for (auto& draw : loadedStream.Draws)
+	{
+		auto& loadedModel = loadedModels[firstModel + draw.Model];
+		if (draw.Mesh >= loadedModel.RenderingUnits.size() || draw.Material >= loadedModel.GpuModel.Materils.size())
+		{
+			spdlog::get("app_logger")->error("Draw stream {} does not match model {}", path.c_str(),
+				loadedModel.Path.c_str());
+			sceneBuilder.UnloadModels(firstModel);
+			return false;
+		}
+		const auto& renderingUnit = loadedModel.RenderingUnits[draw.Mesh];
+		const auto& loadedMaterial = loadedModel.GpuModel.Materils[draw.Material];
+		const auto key = getPbrCacheId(renderingUnit.Vao, Material{
+			loadedMaterial.DiffuseTextureId,
+			loadedMaterial.NormalTextureId,
+			loadedMaterial.MetalnessTextureId,
+		});
+		for (unsigned int i = 0; i < draw.InstanceCount; i++)
+			loadedItems.push_back(PbrDrawListItem{ key, renderingUnit, loadedStream.Instances[draw.FirstInstance + i] });
+	}
+	std::stable_sort(loadedItems.begin(), loadedItems.end(), [](const auto& left, const auto& right)
+	{
+		return left.Key < right.Key;
+	});
+	drawStream = std::move(loadedStream);
+	drawStreamItems = std::move(loadedItems);
+	prepareProgramVariants();
+	return true;
+}
+
+
+void dengine::SceneRenderer::RenderDrawStream()
+{
+	DENGINE_PROFILE_SCOPE("render draw stream");
+	DENGINE_PROFILE_GPU_SCOPE("draw stream");
+	updatePrograms();
+	textureStreamer.Stream();
+	beginSceneFramebuffer();
+
+	globalEnvironment.CameraPostion = drawStream.Environment.CameraPosition;
+	//stream may come from other output size, vertical field of view and depth range are kept and horizontal
+	//scale follows current aspect like glm::perspective would
+	const float aspect = static_cast<float>(width) / static_cast<float>(height);
+	globalEnvironment.ProjectionMatrix = drawStream.Environment.ProjectionMatrix;
+	globalEnvironment.ProjectionMatrix[0][0] = globalEnvironment.ProjectionMatrix[1][1] / aspect;
+	globalEnvironment.ViewMatrix = drawStream.Environment.ViewMatrix;
+	globalEnvironment.Lights.assign(drawStream.Lights.begin(), drawStream.Lights.end());
+	globalEnvironment.Sun = DirectionalLight{ drawStream.Environment.SunDirection, drawStream.Environment.SunColor };
+
+	//stream carries no casters of its own, so replay is unshadowed
+	renderingSubmitter.Merge(drawStreamItems);
+	dispatch(drawStream.DepthPrepass, nullptr, false);
+	changeTracker.Clear();
+}
+
+
+dengine::SceneRendererSettings& dengine::SceneRenderer::GetSettings()
+{
+	return settings;
+}
+
+
+unsigned int dengine::SceneRenderer::GetFramebuffer() const
+{
+	return upscaled ? dynamicResolution.GetFramebuffer() : fbo;
+}
+
+
+unsigned int dengine::SceneRenderer::GetColorTexture() const
+{
+	return upscaled ? dynamicResolution.GetColorTexture() : colorTarget.Texture;
+}
+
+
+glm::vec2 dengine::SceneRenderer::GetColorTextureRegion() const
+{
+	//upscale output has same size as scene targets
+	return glm::vec2(width, height) / glm::vec2(colorTarget.Width, colorTarget.Height);
+}
+
+
+int dengine::SceneRenderer::GetWidth() const
+{
+	return width;
+}
+
+
+int dengine::SceneRenderer::GetHeight() const
+{
+	return height;
+}
+
+
+glm::ivec2 dengine::SceneRenderer::GetRenderSize() const
+{
+	return renderSize;
+}
+
+
+dengine::DynamicResolution& dengine::SceneRenderer::GetDynamicResolution()
+{
+	return dynamicResolution;
+}
+
+
+const dengine::PbrDrawListBuilder& dengine::SceneRenderer::GetDrawListBuilder() const
+{
+	return drawListBuilder;
+}
+
+
+const dengine::PbrRetainedDrawList& dengine::SceneRenderer::GetRetainedDrawList() const
+{
+	return retainedDrawList;
+}
+
+
+const dengine::PbrDispatchStatistics& dengine::SceneRenderer::GetDispatchStatistics() const
+{
+	return renderingSubmitter.GetStatistics();
+}
+
+
+const dengine::PbrProgramVariants& dengine::SceneRenderer::GetProgramVariants() const
+{
+	return programVariants;
+}
+
+
+dengine::ShadowSettings& dengine::SceneRenderer::GetShadowSettings()
+{
+	return cascadedShadowMaps.GetSettings();
+}
+
+
+const dengine::ShadowStatistics& dengine::SceneRenderer::GetShadowStatistics() const
+{
+	return cascadedShadowMaps.GetStatistics();
+}
+
+
+dengine::TextureStreamingSettings& dengine::SceneRenderer::GetTextureStreamingSettings()
+{
+	return textureStreamer.GetSettings();
+}
+
+
+const dengine::TextureStreamingStatistics& dengine::SceneRenderer::GetTextureStreamingStatistics() const
+{
+	return textureStreamer.GetStatistics();
+}
+
+
+void dengine::SceneRenderer::ReloadShaders()
+{
+	spdlog::get("app_logger")->info("Reloading shaders");
+	programVariants.Reload();
+	depthPrepassProgram.Compile();
+	deferredShading.Reload();
+	cascadedShadowMaps.Reload();
+	dynamicResolution.Reload();
+	textureStreamer.Reload();
+	changeTracker.Invalidate();
+}
+
+
+bool dengine::SceneRenderer::IsCompilingShaders() const
+{
+	return programVariants.IsCompiling() || depthPrepassProgram.IsCompiling() || deferredShading.IsCompiling() ||
+		cascadedShadowMaps.IsCompiling() || dynamicResolution.IsCompiling() || textureStreamer.IsCompiling();
+}
+
+
+void dengine::SceneRenderer::FinishShaderCompilation()
+{
+	while (IsCompilingShaders())
+	{
+		updatePrograms();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+
+void dengine::SceneRenderer::prepareProgramVariants()
+{
+	//all variants of scene compile in parallel instead of one by one on first draws
+	for (auto& loadedModel : sceneBuilder.GetLoadedModels())
+		for (auto& material : loadedModel.GpuModel.Materils)
+		{
+			const PbrBatchKey key{ 0, material.DiffuseTextureId, material.NormalTextureId, material.MetalnessTextureId };
+			programVariants.Prepare(getPbrShaderFeatures(key, settings.LightModel, settings.ShadingPath));
+		}
+}
+
+
+void dengine::SceneRenderer::updatePrograms()
+{
+	programVariants.Update();
+	depthPrepassProgram.Update(false);
+	deferredShading.Update();
+	cascadedShadowMaps.Update();
+	dynamicResolution.Update();
+	textureStreamer.Update();
+}
+
+
+void dengine::SceneRenderer::dispatch(bool depthPrepass, const PbrRetainedDrawList* retainedDrawList, bool shadows)
+{
+	//main pass tests depth for equality, so it must not rely on pre-pass whose program has not linked yet
+	const unsigned int prepassProgram = depthPrepassProgram.Get();
+	const PbrDispatchSettings dispatchSettings{ depthPrepass && prepassProgram != 0, prepassProgram,
+		settings.LightModel, settings.ShadingPath, settings.FrontToBackSorting };
+	const bool deferred = settings.ShadingPath == PbrShadingPath::Deferred;
+	//g-buffer shares depth of scene framebuffer and needs no clear, light accumulation only reads covered pixels
+	if (deferred)
+		glBindFramebuffer(GL_FRAMEBUFFER, deferredShading.GetFramebuffer(depthTarget));
+	imageBasedLighting.Bind(settings.EnvironmentIntensity);
+	cascadedShadowMaps.Bind(shadows);
+	renderingSubmitter.DispatchDrawCall(programVariants, globalEnvironment, dispatchSettings, retainedDrawList);
+	renderingSubmitter.Clear();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (deferred)
+		deferredShading.AccumulateLights(colorTarget.Texture, renderSize, globalEnvironment, settings.LightModel);
+	upscaled = renderSize != glm::ivec2(width, height);
+	if (upscaled)
+		dynamicResolution.Upscale(colorTarget, renderSize, width, height);
+	//feedback of this frame picks levels of coming ones
+	textureStreamer.RenderFeedback(renderingSubmitter, renderSize);
+}
+
+
+void dengine::SceneRenderer::beginSceneFramebuffer()
+{
+	//scale and output size changes only move viewport, render targets keep their size
+	renderSize = dynamicResolution.GetRenderSize(width, height);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, renderSize.x, renderSize.y);
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(settings.ClearColor.r, settings.ClearColor.g, settings.ClearColor.b, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+}
+
+
+void dengine::SceneRenderer::createRenderTargets()
+{
+	glCreateFramebuffers(1, &fbo);
+	depthTarget = renderTargetPool.Acquire(GL_DEPTH24_STENCIL8, width, height);
+	colorTarget = renderTargetPool.Acquire(GL_RGBA8, width, height);
+	glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, depthTarget.Texture, 0);
+	glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, colorTarget.Texture, 0);
+
+	GLenum drawBuffs[1] = { GL_COLOR_ATTACHMENT0 };
+	glNamedFramebufferDrawBuffers(fbo, 1, drawBuffs);
+	glNamedFramebufferReadBuffer(fbo, GL_COLOR_ATTACHMENT0);
+}
+
+
+void dengine::SceneRenderer::writeDrawStreamCapture()
+{
+	auto log = spdlog::get("app_logger");
+	const auto capturedStream = makeDrawStream(dispatchCapture, sceneBuilder.GetLoadedModels());
+	if (writeDrawStream(drawStreamCapturePath, capturedStream))
+		log->info("Captured {} draws with {} instances to {}", capturedStream.Draws.size(),
+			capturedStream.Instances.size(), drawStreamCapturePath.c_str());
+	else
+		log->error("Failed to write draw stream {}", drawStreamCapturePath.c_str());
+	drawStreamCapturePath.clear();
+	dispatchCapture = PbrDispatchCapture{};
+}
+
+
+void dengine::SceneRenderer::deleteRenderTargets()
+{
+	glDeleteFramebuffers(1, &fbo);
+	renderTargetPool.Release(colorTarget);
+	renderTargetPool.Release(depthTarget);
+}
+
+
+bool dengine::SceneRenderer::needsRenderTargets() const
+{
+	//growing cannot wait, there is nothing to render outer pixels into
+	if (width > colorTarget.Width || height > colorTarget.Height)
+		return true;
+	//shrinking waits until output size settles, then frees memory of larger size class
+	const auto sizeClass = RenderTargetPool::GetSizeClass(width, height);
+	return framesSinceResize == ResizeSettleFrames && sizeClass != glm::ivec2(colorTarget.Width, colorTarget.Height);
+}
@@ -0,0 +1,149 @@
+#ifndef SCENE_RENDERER_INCLUDED
+#define SCENE_RENDERER_INCLUDED
+
+#include <string>
+
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <BS_thread_pool.hpp>
+#include <importers/model_importer.h>
+#include <rendering/camera.hpp>
+#include <rendering/cascaded_shadow_maps.h>
+#include <rendering/deferred_shading.h>
+#include <rendering/dynamic_resolution.h>
+#include <rendering/global_environment.h>
+#include <rendering/image_based_lighting.h>
+#include <rendering/render_target_pool.h>
+#include <rendering/scene_change_tracker.h>
+#include <rendering/draw_list_builder.h>
+#include <rendering/draw_stream.h>
+#include <rendering/retained_draw_list.h>
+#include <rendering/texture_streamer.h>
+#include <rendering/schemas/pbr_rendering_scheme.h>
+#include <scene/transform_system.h>
+#include <scene/scene_builder.h>
+
+namespace dengine
+{
+	struct SceneRendererSettings {
+		bool DepthPrepass{ true };
+		bool FrontToBackSorting{ true };
+		//retained list is patched by registry signals, immediate mode rebuilds and culls draw lists every frame
+		bool RetainedDrawing{ true };
+		//materials still get minimal variant for their textures under either model
+		PbrLightModel LightModel{ PbrLightModel::CookTorrance };
+		//deferred path shades each pixel once per light reaching its screen tile, pays off with many lights
+		PbrShadingPath ShadingPath{ PbrShadingPath::Forward };
+		float EnvironmentIntensity{ 1.0f };
+		//cascaded shadow maps cast by directional sun of environment
+		bool Shadows{ true };
+		glm::vec3 ClearColor{ 33.0f / 255.0f, 33.0f / 255.0f, 33.0f / 255.0f };
+		float FieldOfView{ 55.0f };
+		float NearPlane{ 0.01f };
+		float FarPlane{ 100.0f };
+	};
+
+
+	//owns scene systems and offscreen framebuffer, independent of window and ui,
+	//requires current GL context for its whole lifetime
+	class SceneRenderer {
+	public:
+		SceneRenderer(entt::registry& registry, BS::thread_pool& threadPool, IModelImporter& modelImporter,
+			OpenglSettings openglSettings);
+		~SceneRenderer();
+		SceneRenderer(const SceneRenderer&) = delete;
+		SceneRenderer& operator=(const SceneRenderer&) = delete;
+
+		//model file or .dscene scene description
+		bool LoadScene(const std::pmr::string& path);
+		//equirectangular hdr for image based lighting, scene environment record loads it as well
+		bool LoadEnvironment(const std::pmr::string& path);
+		void Resize(int width, int height);
+		void Render(const Camera& camera);
+		//image of last Render is still current, unless camera moved or scene, size, programs or settings changed
+		bool NeedsRender(const Camera& camera) const;
+		//reports changes tracking cannot see, settings and components edited in place
+		void Invalidate();
+		//dispatch of next Render is written to .dstream file at path
+		void CaptureDrawStream(const std::pmr::string& path);
+		//loads captured stream with its models, replaces previously loaded stream
+		bool LoadDrawStream(const std::pmr::string& path);
+		//re-executes loaded stream with its captured camera and lights, scene logic is skipped
+		void RenderDrawStream();
+
+		SceneRendererSettings& GetSettings();
+		//final image of last frame covers lower left output size region of framebuffer and color texture,
+		//upscaled when dynamic resolution rendered it smaller
+		unsigned int GetFramebuffer() const;
+		unsigned int GetColorTexture() const;
+		//part of color texture holding final image, targets stay larger than output until resizing settles
+		glm::vec2 GetColorTextureRegion() const;
+		int GetWidth() const;
+		int GetHeight() const;
+		//size scene was last rendered at
+		glm::ivec2 GetRenderSize() const;
+		DynamicResolution& GetDynamicResolution();
+		const PbrDrawListBuilder& GetDrawListBuilder() const;
+		const PbrRetainedDrawList& GetRetainedDrawList() const;
+		const PbrDispatchStatistics& GetDispatchStatistics() const;
+		const PbrProgramVariants& GetProgramVariants() const;
+		ShadowSettings& GetShadowSettings();
+		const ShadowStatistics& GetShadowStatistics() const;
+		//applies to textures of scenes loaded afterwards as well as to streaming of loaded ones
+		TextureStreamingSettings& GetTextureStreamingSettings();
+		const TextureStreamingStatistics& GetTextureStreamingStatistics() const;
+		//recompiles programs from shader files, frames keep using current programs until new ones link
+		void ReloadShaders();
+		bool IsCompilingShaders() const;
+		//blocks until every started program links, frames rendered before may skip draws whose program is missing
+		void FinishShaderCompilation();
+	private:
+		void createRenderTargets();
+		void deleteRenderTargets();
+		bool needsRenderTargets() const;
+		void writeDrawStreamCapture();
+		void beginSceneFramebuffer();
+		void dispatch(bool depthPrepass, const PbrRetainedDrawList* retainedDrawList, bool shadows);
+		void prepareProgramVariants();
+		void updatePrograms();
+
+		entt::registry& registry;
+		SceneChangeTracker changeTracker;
+		TransformSystem transformSystem;
+		//owns scene textures, outlives scene builder registering them
+		TextureStreamer textureStreamer;
+		SceneBuilder sceneBuilder;
+		PbrRenderingSubmitter renderingSubmitter;
+		PbrDrawListBuilder drawListBuilder;
+		PbrRetainedDrawList retainedDrawList;
+		GlobalEnvironment globalEnvironment;
+		SceneRendererSettings settings;
+		PbrProgramVariants programVariants;
+		ReloadableProgram depthPrepassProgram;
+		//outlives every target owner below
+		RenderTargetPool renderTargetPool;
+		DeferredShading deferredShading;
+		CascadedShadowMaps cascadedShadowMaps;
+		DynamicResolution dynamicResolution;
+		ImageBasedLighting imageBasedLighting;
+
+		std::pmr::string drawStreamCapturePath;
+		PbrDispatchCapture dispatchCapture;
+		DrawStream drawStream;
+		//draw stream resolved against loaded models and sorted by key, ready for Merge
+		std::pmr::vector<PbrDrawListItem> drawStreamItems;
+
+		unsigned int fbo{ 0 };
+		RenderTarget depthTarget;
+		RenderTarget colorTarget;
+		//render targets are allocated at size class of settled output size, scene covers renderSize part of them
+		int width{ 1920 };
+		int height{ 1080 };
+		int framesSinceResize{ 0 };
+		glm::ivec2 renderSize{ 1920, 1080 };
+		bool upscaled{ false };
+		Camera renderedCamera;
+	};
+}
+
+#endif
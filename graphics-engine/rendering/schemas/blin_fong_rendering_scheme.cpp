@@ -81,7 +81,7 @@ dengine::BlinFongRenderingUnit dengine::BlinFongRenderingScheme::CreateRendering
 	//tangents binding
 	auto tangentLayout = mesh.GetVertexAttributeLayout(Tangents);
 	glVertexArrayVertexBuffer(vao, AttributeTangentLocation, vbo, tangentLayout.Offset, tangentLayout.Stride);
-	glVertexArrayAttribFormat(vao, AttributeTangentLocation, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribFormat(vao, AttributeTangentLocation, 4, GL_FLOAT, GL_FALSE, 0);
 	glVertexArrayAttribBinding(vao, AttributeTangentLocation, 3);
 	glEnableVertexArrayAttrib(vao, AttributeTangentLocation);
 
@@ -1,7 +1,15 @@
 #include <rendering/schemas/pbr_rendering_scheme.h>
 #include <rendering/schemas/blin_fong_rendering_scheme.h>
-#include <sstream>
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <cstring>
+#include <iterator>
 #include <utils/shader_load_utils.h>
+#include <rendering/retained_draw_list.h>
+#include <rendering/draw_list_builder.h>
+#include <profiling/gpu_profiler.h>
+#include <profiling/memory_tracker.h>
 #include <glad/glad.h>
 
 
@@ -11,6 +19,8 @@ constexpr unsigned int AttributeNormalLocation = 1;
 constexpr unsigned int AttributeUVsLocation = 2;
 constexpr unsigned int AttributeTangentLocation = 3;
 constexpr unsigned int AttributeModelMatrixBaseLocation = 4;
+//rows of PbrInstancesData, one attribute location each
+constexpr int AttributeModelRowCount = 3;
 //UNIFORM BUFFER BINDINGS
 constexpr unsigned int UboEnvironmentsBinding = 0;
 //SHADER STORAGE BUFFER BINDINGS
@@ -19,30 +29,169 @@ constexpr unsigned int SsboLightsInfosBinding = 0;
 
 unsigned dengine::PbrRenderingScheme::LoadShaderProgram()
 {
-	auto program = uploadAndCompileShaders("shaders/pbr.vert", "shaders/pbr.frag");
-	glUniformBlockBinding(program, 0, UboEnvironmentsBinding);
+	return LoadShaderProgram(PbrAllShaderFeatures);
+}
+
+
+unsigned dengine::PbrRenderingScheme::LoadShaderProgram(unsigned int features)
+{
+	const bool gBufferOutput = (features & PbrGBufferOutput) != 0;
+	auto program = uploadAndCompileShaders("shaders/pbr.vert", gBufferOutput ? "shaders/gbuffer.frag" : "shaders/pbr.frag",
+		getPbrShaderDefines(features));
+	if (program != 0 && gBufferOutput)
+		SetupGBufferProgram(program);
+	else if (program != 0)
+		SetupShaderProgram(program);
+	return program;
+}
+
+
+void dengine::PbrRenderingScheme::SetupShaderProgram(unsigned int program)
+{
+	//pbr.frag declares image based lighting block too, so block index of environment is looked up
+	glUniformBlockBinding(program, glGetUniformBlockIndex(program, "GlobalEnv"), UboEnvironmentsBinding);
 	glShaderStorageBlockBinding(program, 0, SsboLightsInfosBinding);
+}
+
+
+void dengine::PbrRenderingScheme::SetupGBufferProgram(unsigned int program)
+{
+	//lights are read by light accumulation, g-buffer programs have no storage block
+	glUniformBlockBinding(program, 0, UboEnvironmentsBinding);
+}
+
+
+std::pmr::vector<const char*> dengine::getPbrShaderDefines(unsigned int features)
+{
+	std::pmr::vector<const char*> defines;
+	if (features & PbrAlbedoMap)
+		defines.push_back("HAS_ALBEDO_MAP");
+	if (features & PbrNormalMap)
+		defines.push_back("HAS_NORMAL_MAP");
+	if (features & PbrMetalnessMap)
+		defines.push_back("HAS_METALNESS_MAP");
+	if (features & PbrLambertLighting)
+		defines.push_back("LAMBERT_LIGHTING");
+	return defines;
+}
+
+
+unsigned int dengine::getPbrShaderFeatures(const PbrBatchKey& key, PbrLightModel lightModel,
+	PbrShadingPath shadingPath)
+{
+	unsigned int features = 0;
+	if (key.DiffuseTexture > 0)
+		features |= PbrAlbedoMap;
+	if (key.NormalTexture > 0)
+		features |= PbrNormalMap;
+	if (key.MetalnessTexture > 0)
+		features |= PbrMetalnessMap;
+	if (shadingPath == PbrShadingPath::Deferred)
+		features |= PbrGBufferOutput;
+	else if (lightModel == PbrLightModel::Lambert)
+		features |= PbrLambertLighting;
+	return features;
+}
+
+
+void dengine::PbrProgramVariants::Prepare(unsigned int features)
+{
+	getVariant(features);
+}
+
+
+unsigned int dengine::PbrProgramVariants::Get(unsigned int features)
+{
+	//failed variant stays 0 and is not recompiled every frame
+	auto& variant = getVariant(features);
+	const unsigned int program = variant.Get();
+	if (program != 0 || !variant.IsCompiling())
+		return program;
+
+	//closest linked variant, so switching light model or shading path does not stall frame on compilation
+	unsigned int fallbackProgram = 0;
+	int fallbackSharedFeatures = -1;
+	for (auto& candidate : programs)
+	{
+		const unsigned int candidateFeatures = candidate.first;
+		if ((candidateFeatures & PbrGBufferOutput) != (features & PbrGBufferOutput) ||
+			(candidateFeatures & PbrAllShaderFeatures & ~features) != 0)
+			continue;
+		const int sharedFeatures = std::popcount(candidateFeatures & features);
+		const unsigned int candidateProgram = candidate.second.Get();
+		if (candidateProgram != 0 && sharedFeatures > fallbackSharedFeatures)
+		{
+			fallbackProgram = candidateProgram;
+			fallbackSharedFeatures = sharedFeatures;
+		}
+	}
+	return fallbackProgram;
+}
+
+
+void dengine::PbrProgramVariants::Reload()
+{
+	for (auto& variant : programs)
+		variant.second.Compile();
+}
+
+
+void dengine::PbrProgramVariants::Update()
+{
+	for (auto& variant : programs)
+		variant.second.Update(false);
+}
+
+
+size_t dengine::PbrProgramVariants::GetCount() const
+{
+	return programs.size();
+}
+
+
+bool dengine::PbrProgramVariants::IsCompiling() const
+{
+	return std::any_of(programs.begin(), programs.end(), [](const auto& variant)
+	{
+		return variant.second.IsCompiling();
+	});
+}
+
+
+dengine::ReloadableProgram& dengine::PbrProgramVariants::getVariant(unsigned int features)
+{
+	auto variantIter = programs.find(features);
+	if (variantIter == programs.end())
+	{
+		const bool gBufferOutput = (features & PbrGBufferOutput) != 0;
+		variantIter = programs.try_emplace(features, "shaders/pbr.vert",
+			gBufferOutput ? "shaders/gbuffer.frag" : "shaders/pbr.frag", getPbrShaderDefines(features),
+			gBufferOutput ? &PbrRenderingScheme::SetupGBufferProgram : &PbrRenderingScheme::SetupShaderProgram).first;
+	}
+	return variantIter->second;
+}
+
+
+unsigned dengine::PbrRenderingScheme::LoadDepthPrepassProgram()
+{
+	auto program = uploadAndCompileShaders("shaders/depth.vert", "shaders/depth.frag");
+	if (program != 0)
+		SetupDepthPrepassProgram(program);
 	return program;
 }
 
 
+void dengine::PbrRenderingScheme::SetupDepthPrepassProgram(unsigned int program)
+{
+	glUniformBlockBinding(program, 0, UboEnvironmentsBinding);
+}
+
+
 dengine::PbrRenderingUnit dengine::PbrRenderingScheme::CreateRenderingUnit(const BufferedMesh& mesh, OpenglSettings openglSettings)
 {
 	unsigned int vbo = mesh.Vbo;
 	unsigned int vao;
 
-	unsigned int buffers[3];
-	glCreateBuffers(3, buffers);
-	unsigned int instanceBuffer = buffers[0];
-	unsigned int environmentBuffer = buffers[1];
-	unsigned int lightsBuffer = buffers[2];
-
-
-	//InitializeBuffers
-	glNamedBufferData(instanceBuffer, sizeof(PbrInstancesData) * 16, nullptr, GL_STREAM_DRAW);
-	glNamedBufferData(environmentBuffer, sizeof(PbrEnvironmentData), nullptr, GL_STREAM_DRAW);
-	glNamedBufferData(lightsBuffer, sizeof(PbrLightsInfo), nullptr, GL_STREAM_DRAW);
-
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 
@@ -68,105 +217,279 @@ dengine::PbrRenderingUnit dengine::PbrRenderingScheme::CreateRenderingUnit(const
 	//tangents binding
 	auto tangentLayout = mesh.GetVertexAttributeLayout(Tangents);
 	glVertexArrayVertexBuffer(vao, AttributeTangentLocation, vbo, tangentLayout.Offset, tangentLayout.Stride);
-	glVertexArrayAttribFormat(vao, AttributeTangentLocation, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribFormat(vao, AttributeTangentLocation, 4, GL_FLOAT, GL_FALSE, 0);
 	glVertexArrayAttribBinding(vao, AttributeTangentLocation, 3);
 	glEnableVertexArrayAttrib(vao, AttributeTangentLocation);
 
 
-	//Bind instance buffer
-	glVertexArrayVertexBuffer(vao, AttributeModelMatrixBaseLocation, instanceBuffer, 0, sizeof(glm::mat4));
-	for (int i = 0; i < 4; i++)
+	//instance layout, buffer itself is bound by submitter at dispatch
+	for (int i = 0; i < AttributeModelRowCount; i++)
 	{
 		glVertexArrayAttribFormat(vao, AttributeModelMatrixBaseLocation + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4) * i);
 		glVertexArrayAttribBinding(vao, AttributeModelMatrixBaseLocation + i, AttributeModelMatrixBaseLocation);
 		glEnableVertexArrayAttrib(vao, AttributeModelMatrixBaseLocation + i);
-		glVertexArrayBindingDivisor(vao, AttributeModelMatrixBaseLocation + i, 1);
 	}
+	glVertexArrayBindingDivisor(vao, AttributeModelMatrixBaseLocation, 1);
 	glVertexArrayElementBuffer(vao, mesh.Ebo);
 
-
-	glBindBufferRange(GL_UNIFORM_BUFFER, UboEnvironmentsBinding, environmentBuffer, 0, openglSettings.uniformAlignment);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, lightsBuffer);
+	//position only vao for depth pre-pass, shares vertex and instance buffers with main vao
+	unsigned int depthVao;
+	glCreateVertexArrays(1, &depthVao);
+	glVertexArrayVertexBuffer(depthVao, 0, vbo, positionVertexLayout.Offset, positionVertexLayout.Stride);
+	glVertexArrayAttribFormat(depthVao, AttributePositionLocation, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(depthVao, AttributePositionLocation, 0);
+	glEnableVertexArrayAttrib(depthVao, AttributePositionLocation);
+	for (int i = 0; i < AttributeModelRowCount; i++)
+	{
+		glVertexArrayAttribFormat(depthVao, AttributeModelMatrixBaseLocation + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4) * i);
+		glVertexArrayAttribBinding(depthVao, AttributeModelMatrixBaseLocation + i, AttributeModelMatrixBaseLocation);
+		glEnableVertexArrayAttrib(depthVao, AttributeModelMatrixBaseLocation + i);
+	}
+	glVertexArrayBindingDivisor(depthVao, AttributeModelMatrixBaseLocation, 1);
+	glVertexArrayElementBuffer(depthVao, mesh.Ebo);
 	glBindVertexArray(0);
 
-	return PbrRenderingUnit{ vao, mesh.NumElements, instanceBuffer, environmentBuffer, lightsBuffer };
+	return PbrRenderingUnit{ vao, depthVao, mesh.NumElements, mesh.BoundingSphere };
+}
+
+
+void dengine::PbrRenderingScheme::DeleteRenderingUnit(PbrRenderingUnit& renderingUnit)
+{
+	const unsigned int vaos[2] = { renderingUnit.Vao, renderingUnit.DepthVao };
+	glDeleteVertexArrays(2, vaos);
+	renderingUnit.Vao = 0;
+	renderingUnit.DepthVao = 0;
 }
 
 
-dengine::PbrRenderingSubmitter::PbrRenderingSubmitter(OpenglSettings openglSettings) : openglSettings(openglSettings) {}
+dengine::PbrRenderingSubmitter::PbrRenderingSubmitter(OpenglSettings openglSettings) : openglSettings(openglSettings)
+{
+	unsigned int buffers[3];
+	glCreateBuffers(3, buffers);
+	instancesBuffer = buffers[0];
+	environmentBuffer = buffers[1];
+	lightsBuffer = buffers[2];
+	glNamedBufferData(environmentBuffer, sizeof(PbrEnvironmentData), nullptr, GL_STREAM_DRAW);
+	glNamedBufferData(lightsBuffer, sizeof(PbrLightsInfo), nullptr, GL_STREAM_DRAW);
+	auto& memoryTracker = MemoryTracker::Get();
+	memoryTracker.TrackGpuObject(MemoryCategory::UniformBuffers, environmentBuffer, sizeof(PbrEnvironmentData), "pbr submitter");
+	memoryTracker.TrackGpuObject(MemoryCategory::UniformBuffers, lightsBuffer, sizeof(PbrLightsInfo), "pbr submitter");
+}
+
+
+dengine::PbrRenderingSubmitter::~PbrRenderingSubmitter()
+{
+	unsigned int buffers[3] = { instancesBuffer, environmentBuffer, lightsBuffer };
+	glDeleteBuffers(3, buffers);
+	auto& memoryTracker = MemoryTracker::Get();
+	memoryTracker.ReleaseGpuObject(MemoryCategory::InstanceBuffers, instancesBuffer);
+	memoryTracker.ReleaseGpuObject(MemoryCategory::UniformBuffers, environmentBuffer);
+	memoryTracker.ReleaseGpuObject(MemoryCategory::UniformBuffers, lightsBuffer);
+}
+
+
+dengine::PbrBatchKey dengine::getPbrCacheId(unsigned int vaoId, const Material& material)
+{
+	return PbrBatchKey{ vaoId, material.DiffuseTextureIndex, material.NormalTextureIndex, material.MetalnessTextureIndex };
+}
 
 
-std::pmr::string getPbrCacheId(unsigned int vaoId, const dengine::Material& material)
+size_t dengine::PbrBatchKeyHash::operator()(const PbrBatchKey& key) const noexcept
 {
-	std::stringstream ss;
-	ss << "vao:{" << vaoId << "}" << "-" << "diffuseTexture:{"
-		<< material.DiffuseTextureIndex << "}" << "-" << "normalTexture:{"
-		<< material.NormalTextureIndex << "}" << "-" << "metalinessTexture:{"
-		<< material.MetalnessTextureIndex << "}";
-	return std::pmr::string(ss.str());
+	size_t hash = std::hash<unsigned int>{}(key.Vao);
+	for (int textureId : { key.DiffuseTexture, key.NormalTexture, key.MetalnessTexture })
+		hash ^= std::hash<int>{}(textureId) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	return hash;
 }
 
 
-void dengine::PbrRenderingSubmitter::Submit(PbrRenderingUnit renderingUnit, Material material,
-	glm::mat4 modelMatrix)
+dengine::PbrRenderingSubmitter::DrawBatch& dengine::PbrRenderingSubmitter::getBatch(const PbrBatchKey& key,
+	const PbrRenderingUnit& renderingUnit)
 {
-	auto cacheId = getPbrCacheId(renderingUnit.Vao, material);
-	auto findIter = instancedToDraw.find(cacheId);
-	if (findIter == instancedToDraw.end())
+	auto findIter = instancedToDraw.find(key);
+	if (findIter != instancedToDraw.end())
+		return findIter->second;
+
+	PbrSubmitInfo submitInfo{};
+	submitInfo.DiffuseTexture = key.DiffuseTexture;
+	submitInfo.NormalTexture = key.NormalTexture;
+	submitInfo.MetalnessTexture = key.MetalnessTexture;
+	return instancedToDraw.emplace(key, DrawBatch{ renderingUnit, std::move(submitInfo) }).first->second;
+}
+
+
+void dengine::PbrRenderingSubmitter::Submit(const PbrRenderingUnit& renderingUnit, const Material& material,
+	const glm::mat4& modelMatrix)
+{
+	auto& drawInstance = getBatch(getPbrCacheId(renderingUnit.Vao, material), renderingUnit);
+	drawInstance.second.InstanceDatas.push_back(PbrInstancesData{ modelMatrix });
+}
+
+
+void dengine::PbrRenderingSubmitter::Merge(std::span<const PbrDrawListItem> sortedItems)
+{
+	for (size_t begin = 0; begin < sortedItems.size();)
 	{
-		PbrSubmitInfo submitInfo{};
-		submitInfo.DiffuseTexture = material.DiffuseTextureIndex;
-		submitInfo.NormalTexture = material.NormalTextureIndex;
-		submitInfo.MetalnessTexture = material.MetalnessTextureIndex;
-		instancedToDraw[cacheId] = { renderingUnit, submitInfo };
+		const auto& key = sortedItems[begin].Key;
+		auto& instanceDatas = getBatch(key, sortedItems[begin].RenderingUnit).second.InstanceDatas;
+		size_t end = begin;
+		while (end < sortedItems.size() && sortedItems[end].Key == key)
+			end++;
+		instanceDatas.reserve(instanceDatas.size() + (end - begin));
+		for (; begin < end; begin++)
+			instanceDatas.push_back(sortedItems[begin].InstanceData);
 	}
-	auto& drawInstance = instancedToDraw[cacheId];
-	drawInstance.second.InstanceDatas.push_back(PbrInstancesData{ modelMatrix });
 }
 
 
-void dengine::PbrRenderingSubmitter::DispatchDrawCall(unsigned programId,
-	const GlobalEnvironment& environment) const
+float getNearestInstanceDistance(const dengine::PbrSubmitInfo& submitInfo, const glm::vec3& cameraPosition)
 {
-	glUseProgram(programId);
+	float nearestDistance = std::numeric_limits<float>::max();
+	for (auto& instanceData : submitInfo.InstanceDatas)
+	{
+		const glm::vec3 toInstance = instanceData.GetPosition() - cameraPosition;
+		nearestDistance = std::min(nearestDistance, glm::dot(toInstance, toInstance));
+	}
+	return nearestDistance;
+}
 
+
+void dengine::PbrRenderingSubmitter::DispatchDrawCall(PbrProgramVariants& programVariants,
+	const GlobalEnvironment& environment, const PbrDispatchSettings& dispatchSettings,
+	const PbrRetainedDrawList* retainedDrawList)
+{
+	DENGINE_PROFILE_SCOPE("dispatch");
 	PbrLightsInfo lightsInfo;
-	lightsInfo.Info.Count = environment.Lights.size();
-	memcpy(lightsInfo.LightsInfos, &environment.Lights[0],
-		environment.Lights.size() * sizeof(LightInfo));
+	lightsInfo.Info.Count = std::min<int>(environment.Lights.size(), std::size(lightsInfo.LightsInfos));
+	memcpy(lightsInfo.LightsInfos, environment.Lights.data(), lightsInfo.Info.Count * sizeof(LightInfo));
 
 	PbrEnvironmentData environmentData;
 	environmentData.CameraPosition = environment.CameraPostion;
 	environmentData.ProjectionMatrix = environment.ProjectionMatrix;
 	environmentData.ViewMatrix = environment.ViewMatrix;
+	environmentData.ViewProjectionMatrix = environment.ProjectionMatrix * environment.ViewMatrix;
+	environmentData.SunDirection = environment.Sun.Direction;
+	environmentData.SunColor = environment.Sun.Color;
 
-	//load data to gpu
-	auto sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	//pack submitted instances and sort opaque batches roughly front to back by their nearest instance
+	const glm::vec3 cameraPosition(environment.CameraPostion);
+	drawCommands.clear();
+	instancesStaging.clear();
 	for (auto& index : instancedToDraw)
 	{
-		auto& submitInfo = index.second.second;
-		auto& renderingUnit = index.second.first;
-		glNamedBufferSubData(renderingUnit.EnvironmentBuffer, 0, sizeof(PbrEnvironmentData), &environmentData);
-		glNamedBufferSubData(renderingUnit.InstaciesBuffer, 0,
-			sizeof(PbrInstancesData) * submitInfo.InstanceDatas.size(),
-			&submitInfo.InstanceDatas[0]); //Update model matricies
-		glNamedBufferSubData(renderingUnit.LightsBuffer, 0, sizeof(PbrLightsInfo), &lightsInfo);//Update lights information
+		auto& instanceDatas = index.second.second.InstanceDatas;
+		if (instanceDatas.empty())
+			continue;
+		drawCommands.push_back(PbrDrawCommand{ getNearestInstanceDistance(index.second.second, cameraPosition),
+			index.second.first, index.first, instancesBuffer, static_cast<unsigned int>(instancesStaging.size()),
+			static_cast<unsigned int>(instanceDatas.size()) });
+		instancesStaging.insert(instancesStaging.end(), instanceDatas.begin(), instanceDatas.end());
+	}
+	if (retainedDrawList != nullptr)
+		retainedDrawList->CollectDrawCommands(cameraPosition, extractFrustumPlanes(environmentData.ViewProjectionMatrix),
+			drawCommands);
+	if (dispatchSettings.FrontToBackSorting)
+		std::sort(drawCommands.begin(), drawCommands.end(), [](const auto& left, const auto& right)
+		{
+			return left.Distance < right.Distance;
+		});
+	statistics = PbrDispatchStatistics{};
+	for (auto& drawCommand : drawCommands)
+	{
+		statistics.Instances += drawCommand.InstanceCount;
+		statistics.Triangles += drawCommand.RenderingUnit.IndeciesSize / 3 * drawCommand.InstanceCount;
+	}
+	statistics.DrawCalls = static_cast<unsigned int>(drawCommands.size());
+	statistics.Lights = static_cast<unsigned int>(lightsInfo.Info.Count);
+	if (pendingCapture != nullptr)
+	{
+		captureDispatch(*pendingCapture, environmentData, environment, dispatchSettings, retainedDrawList);
+		pendingCapture = nullptr;
+	}
+
+	//load data to gpu, instance buffer is orphaned and grown geometrically
+	if (!instancesStaging.empty())
+	{
+		if (instancesStaging.size() > instancesCapacity)
+		{
+			instancesCapacity = std::max(instancesStaging.size(), instancesCapacity * 2);
+			MemoryTracker::Get().TrackGpuObject(MemoryCategory::InstanceBuffers, instancesBuffer,
+				static_cast<long long>(instancesCapacity * sizeof(PbrInstancesData)), "pbr submitter");
+		}
+		glNamedBufferData(instancesBuffer, instancesCapacity * sizeof(PbrInstancesData), nullptr, GL_STREAM_DRAW);
+		glNamedBufferSubData(instancesBuffer, 0, instancesStaging.size() * sizeof(PbrInstancesData), instancesStaging.data());
+	}
+	glNamedBufferSubData(environmentBuffer, 0, sizeof(PbrEnvironmentData), &environmentData);
+	glNamedBufferSubData(lightsBuffer, 0, sizeof(PbrLightsInfo), &lightsInfo);
+	glBindBufferBase(GL_UNIFORM_BUFFER, UboEnvironmentsBinding, environmentBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SsboLightsInfosBinding, lightsBuffer);
+
+	if (dispatchSettings.DepthPrepass)
+	{
+		//depth only pass, fills depth buffer so main pass shades every pixel once
+		DENGINE_PROFILE_GPU_SCOPE("depth pre-pass");
+		glUseProgram(dispatchSettings.DepthPrepassProgram);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+		for (auto& drawCommand : drawCommands)
+		{
+			auto& renderingUnit = drawCommand.RenderingUnit;
+			glVertexArrayVertexBuffer(renderingUnit.DepthVao, AttributeModelMatrixBaseLocation, drawCommand.InstancesBuffer, 0, sizeof(PbrInstancesData));
+			glBindVertexArray(renderingUnit.DepthVao);
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLES, renderingUnit.IndeciesSize, GL_UNSIGNED_INT, nullptr,
+				drawCommand.InstanceCount, drawCommand.FirstInstance);
+		}
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		statistics.DrawCalls *= 2;
+		statistics.Triangles *= 2;
+
+		//depth is resolved, order main pass by state instead to minimize program and texture rebinds
+		std::stable_sort(drawCommands.begin(), drawCommands.end(), [&](const auto& left, const auto& right)
+		{
+			const auto leftFeatures = getPbrShaderFeatures(left.Key, dispatchSettings.LightModel,
+				dispatchSettings.ShadingPath);
+			const auto rightFeatures = getPbrShaderFeatures(right.Key, dispatchSettings.LightModel,
+				dispatchSettings.ShadingPath);
+			if (leftFeatures != rightFeatures)
+				return leftFeatures < rightFeatures;
+			return left.Key.DiffuseTexture < right.Key.DiffuseTexture;
+		});
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
 	}
-	glWaitSync(sync, 0, GL_TIMEOUT_IGNORED);
-	glDeleteSync(sync);
 
 	//render all
-	for (auto& index : instancedToDraw)
 	{
-		auto& submitInfo = index.second.second;
-		auto& renderingUnit = index.second.first;
+		DENGINE_PROFILE_GPU_SCOPE("main pass");
+		unsigned int boundProgram = 0;
+		for (auto& drawCommand : drawCommands)
+		{
+			auto& renderingUnit = drawCommand.RenderingUnit;
+			const auto program = programVariants.Get(getPbrShaderFeatures(drawCommand.Key, dispatchSettings.LightModel,
+				dispatchSettings.ShadingPath));
+			if (program == 0)
+				continue;
+			if (program != boundProgram)
+			{
+				glUseProgram(program);
+				boundProgram = program;
+			}
 
-		glBindTextureUnit(0, index.second.second.DiffuseTexture);
-		glBindTextureUnit(1, index.second.second.NormalTexture);
-		glBindTextureUnit(2, index.second.second.MetalnessTexture);
-		glBindVertexArray(renderingUnit.Vao);
-		glDrawElementsInstanced(GL_TRIANGLES, renderingUnit.IndeciesSize, GL_UNSIGNED_INT, nullptr,
-			submitInfo.InstanceDatas.size());
+			glBindTextureUnit(0, drawCommand.Key.DiffuseTexture);
+			glBindTextureUnit(1, drawCommand.Key.NormalTexture);
+			glBindTextureUnit(2, drawCommand.Key.MetalnessTexture);
+			glVertexArrayVertexBuffer(renderingUnit.Vao, AttributeModelMatrixBaseLocation, drawCommand.InstancesBuffer, 0, sizeof(PbrInstancesData));
+			glBindVertexArray(renderingUnit.Vao);
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLES, renderingUnit.IndeciesSize, GL_UNSIGNED_INT, nullptr,
+				drawCommand.InstanceCount, drawCommand.FirstInstance);
+		}
+	}
+
+	if (dispatchSettings.DepthPrepass)
+	{
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
 	}
 }
 
@@ -179,3 +502,59 @@ void dengine::PbrRenderingSubmitter::Clear()
 		submitInfo.InstanceDatas.clear();
 	}
 }
+
+
+const dengine::PbrDispatchStatistics& dengine::PbrRenderingSubmitter::GetStatistics() const
+{
+	return statistics;
+}
+
+
+void dengine::PbrRenderingSubmitter::CaptureNextDispatch(PbrDispatchCapture* capture)
+{
+	pendingCapture = capture;
+}
+
+
+void dengine::PbrRenderingSubmitter::RedrawLastDispatch(
+	const std::function<bool(const PbrDrawCommand&)>& prepareDraw) const
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, UboEnvironmentsBinding, environmentBuffer);
+	for (auto& drawCommand : drawCommands)
+	{
+		if (!prepareDraw(drawCommand))
+			continue;
+		auto& renderingUnit = drawCommand.RenderingUnit;
+		glVertexArrayVertexBuffer(renderingUnit.Vao, AttributeModelMatrixBaseLocation, drawCommand.InstancesBuffer, 0, sizeof(PbrInstancesData));
+		glBindVertexArray(renderingUnit.Vao);
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, renderingUnit.IndeciesSize, GL_UNSIGNED_INT, nullptr,
+			drawCommand.InstanceCount, drawCommand.FirstInstance);
+	}
+}
+
+
+void dengine::PbrRenderingSubmitter::captureDispatch(PbrDispatchCapture& capture, const PbrEnvironmentData& environmentData,
+	const GlobalEnvironment& environment, const PbrDispatchSettings& dispatchSettings,
+	const PbrRetainedDrawList* retainedDrawList) const
+{
+	capture.Environment = environmentData;
+	capture.Lights.assign(environment.Lights.begin(), environment.Lights.end());
+	capture.DepthPrepass = dispatchSettings.DepthPrepass;
+	capture.DrawCommands.clear();
+	capture.Instances.clear();
+	for (auto drawCommand : drawCommands)
+	{
+		std::span<const PbrInstancesData> instances;
+		if (drawCommand.InstancesBuffer == instancesBuffer)
+			instances = instancesStaging;
+		else if (retainedDrawList != nullptr)
+			instances = retainedDrawList->GetInstances(drawCommand.InstancesBuffer);
+		if (instances.size() < static_cast<size_t>(drawCommand.FirstInstance) + drawCommand.InstanceCount)
+			continue;
+		instances = instances.subspan(drawCommand.FirstInstance, drawCommand.InstanceCount);
+		drawCommand.InstancesBuffer = 0;
+		drawCommand.FirstInstance = static_cast<unsigned int>(capture.Instances.size());
+		capture.Instances.insert(capture.Instances.end(), instances.begin(), instances.end());
+		capture.DrawCommands.push_back(drawCommand);
+	}
+}
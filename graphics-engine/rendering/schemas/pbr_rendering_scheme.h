@@ -3,11 +3,15 @@
 
 
 #include <vector>
+#include <span>
+#include <compare>
+#include <functional>
 #include <glm/glm.hpp>
 
 #include <rendering/schemas/rendering_scheme.h>
 #include <rendering/global_environment.h>
 #include <rendering/rendering_tmp.h>
+#include <utils/reloadable_program.h>
 #include <unordered_map>
 
 namespace dengine
@@ -21,23 +25,66 @@ namespace dengine
 	};
 
 
+	//affine model matrix as its first three rows, last row is always 0 0 0 1; 48 instead of 64 bytes per instance,
+	//shaders read rows as mat3x4 and multiply position from left
 	struct PbrInstancesData {
-		glm::mat4 ModelMatrix;
+		glm::vec4 ModelRows[3];
+
+		PbrInstancesData() = default;
+		explicit PbrInstancesData(const glm::mat4& modelMatrix)
+		{
+			for (int row = 0; row < 3; row++)
+				ModelRows[row] = glm::vec4(modelMatrix[0][row], modelMatrix[1][row], modelMatrix[2][row], modelMatrix[3][row]);
+		}
+
+		glm::vec3 GetPosition() const
+		{
+			return glm::vec3(ModelRows[0].w, ModelRows[1].w, ModelRows[2].w);
+		}
 	};
 
 	struct PbrEnvironmentData {
 		glm::vec4 CameraPosition;
 		glm::mat4 ProjectionMatrix;
 		glm::mat4 ViewMatrix;
+		//premultiplied once per dispatch instead of per vertex
+		glm::mat4 ViewProjectionMatrix;
+		//xyz direction sun light travels in
+		glm::vec4 SunDirection;
+		//alpha is intensity
+		glm::vec4 SunColor;
 	};
 
 
 	struct PbrRenderingUnit {
 		unsigned int Vao;
+		unsigned int DepthVao;
 		unsigned long long IndeciesSize;
-		unsigned int InstaciesBuffer;
-		unsigned int EnvironmentBuffer;
-		unsigned int LightsBuffer;
+		//mesh space bounding sphere, xyz center and w radius
+		glm::vec4 BoundingSphere{ 0.0f };
+	};
+
+
+	//identifies instanced batch, units with equal key are drawn with one call
+	struct PbrBatchKey {
+		unsigned int Vao;
+		int DiffuseTexture;
+		int NormalTexture;
+		int MetalnessTexture;
+
+		auto operator<=>(const PbrBatchKey&) const = default;
+	};
+
+
+	struct PbrBatchKeyHash {
+		size_t operator()(const PbrBatchKey& key) const noexcept;
+	};
+
+
+	struct PbrDrawListItem {
+		PbrBatchKey Key;
+		PbrRenderingUnit RenderingUnit;
+		PbrInstancesData InstanceData;
 	};
 
 
@@ -55,22 +102,161 @@ namespace dengine
 	};
 
 
+	//single instanced draw, instances are read from InstancesBuffer starting at FirstInstance
+	struct PbrDrawCommand {
+		float Distance;
+		PbrRenderingUnit RenderingUnit;
+		PbrBatchKey Key;
+		unsigned int InstancesBuffer;
+		unsigned int FirstInstance;
+		unsigned int InstanceCount;
+	};
+
+
+	enum class PbrLightModel {
+		CookTorrance,
+		//diffuse only, skips specular brdf
+		Lambert,
+	};
+
+
+	enum class PbrShadingPath {
+		Forward,
+		//geometry pass writes g-buffer, lights are accumulated per screen tile afterwards
+		Deferred,
+	};
+
+
+	//bits of pbr shader variant, every set bit injects its define into pbr shaders
+	enum PbrShaderFeature : unsigned int {
+		PbrAlbedoMap = 1 << 0,
+		PbrNormalMap = 1 << 1,
+		PbrMetalnessMap = 1 << 2,
+		PbrLambertLighting = 1 << 3,
+		//gbuffer.frag instead of pbr.frag, light model is applied by light accumulation
+		PbrGBufferOutput = 1 << 4,
+	};
+
+	constexpr unsigned int PbrAllShaderFeatures = PbrAlbedoMap | PbrNormalMap | PbrMetalnessMap;
+
+	//minimal variant for batch, missing textures have name 0
+	unsigned int getPbrShaderFeatures(const PbrBatchKey& key, PbrLightModel lightModel,
+		PbrShadingPath shadingPath = PbrShadingPath::Forward);
+
+
+	std::pmr::vector<const char*> getPbrShaderDefines(unsigned int features);
+
+
+	//pbr programs by feature set, every variant is compiled once and kept until destruction
+	class PbrProgramVariants {
+	public:
+		//starts compilation in background, so first Get of variant does not stall whole frame
+		void Prepare(unsigned int features);
+		//starts variant on first use and never waits for it, until it links a linked variant with same output and
+		//no texture maps batch lacks stands in; 0 when there is none or variant failed to compile
+		unsigned int Get(unsigned int features);
+		//recompiles every variant from current files, old programs stay in use until new ones link
+		void Reload();
+		//swaps in finished variants, called once per frame
+		void Update();
+		size_t GetCount() const;
+		bool IsCompiling() const;
+	private:
+		ReloadableProgram& getVariant(unsigned int features);
+
+		std::unordered_map<unsigned int, ReloadableProgram> programs;
+	};
+
+
+	struct PbrDispatchSettings {
+		bool DepthPrepass{ false };
+		unsigned int DepthPrepassProgram{ 0 };
+		PbrLightModel LightModel{ PbrLightModel::CookTorrance };
+		//deferred dispatch expects g-buffer framebuffer to be bound
+		PbrShadingPath ShadingPath{ PbrShadingPath::Forward };
+		//off keeps batches in submission order, baseline for measuring what sorting saves
+		bool FrontToBackSorting{ true };
+	};
+
+
+	//counters of last dispatch, depth pre-pass draws included
+	struct PbrDispatchStatistics {
+		unsigned int DrawCalls{ 0 };
+		unsigned long long Instances{ 0 };
+		unsigned long long Triangles{ 0 };
+		unsigned int Lights{ 0 };
+	};
+
+
+	//one dispatch with instances copied out of gpu buffers, FirstInstance of draw commands indexes Instances
+	struct PbrDispatchCapture {
+		PbrEnvironmentData Environment;
+		std::pmr::vector<LightInfo> Lights;
+		bool DepthPrepass{ false };
+		std::pmr::vector<PbrDrawCommand> DrawCommands;
+		std::pmr::vector<PbrInstancesData> Instances;
+	};
+
+
 	class PbrRenderingScheme : public IRenderingScheme {
 	public:
+		//full featured variant
 		unsigned LoadShaderProgram() override;
+		static unsigned LoadShaderProgram(unsigned int features);
+		static unsigned LoadDepthPrepassProgram();
+		//block bindings of freshly linked programs
+		static void SetupShaderProgram(unsigned int program);
+		static void SetupGBufferProgram(unsigned int program);
+		static void SetupDepthPrepassProgram(unsigned int program);
 		static PbrRenderingUnit CreateRenderingUnit(const BufferedMesh& mesh, OpenglSettings openglSettings);
+		//deletes vertex arrays, buffers belong to mesh
+		static void DeleteRenderingUnit(PbrRenderingUnit& renderingUnit);
 	};
 
 
+	class PbrRetainedDrawList;
+	PbrBatchKey getPbrCacheId(unsigned int vaoId, const Material& material);
+
+
 	class PbrRenderingSubmitter {
 	public:
 		explicit PbrRenderingSubmitter(OpenglSettings openglSettings);
-		void Submit(PbrRenderingUnit renderingUnit, Material material, glm::mat4 modelMatrix);
-		void DispatchDrawCall(unsigned programId, const GlobalEnvironment& environment) const;
+		~PbrRenderingSubmitter();
+		PbrRenderingSubmitter(const PbrRenderingSubmitter&) = delete;
+		PbrRenderingSubmitter& operator=(const PbrRenderingSubmitter&) = delete;
+
+		void Submit(const PbrRenderingUnit& renderingUnit, const Material& material, const glm::mat4& modelMatrix);
+		//items must be sorted by key, every run of equal keys is appended to its batch at once
+		void Merge(std::span<const PbrDrawListItem> sortedItems);
+		//retained draw list, when given, is drawn together with submitted instances
+		void DispatchDrawCall(PbrProgramVariants& programVariants, const GlobalEnvironment& environment,
+			const PbrDispatchSettings& dispatchSettings = {}, const PbrRetainedDrawList* retainedDrawList = nullptr);
 		void Clear();
+		const PbrDispatchStatistics& GetStatistics() const;
+		//next dispatch fills capture, capture must outlive that dispatch
+		void CaptureNextDispatch(PbrDispatchCapture* capture);
+		//draws commands of last dispatch again through their main vaos with currently bound program, environment of
+		//that dispatch is bound again; prepareDraw runs before every draw and skips it by returning false
+		void RedrawLastDispatch(const std::function<bool(const PbrDrawCommand&)>& prepareDraw) const;
 	private:
-		std::unordered_map<std::pmr::string, std::pair<PbrRenderingUnit, PbrSubmitInfo>> instancedToDraw;
+		using DrawBatch = std::pair<PbrRenderingUnit, PbrSubmitInfo>;
+
+		DrawBatch& getBatch(const PbrBatchKey& key, const PbrRenderingUnit& renderingUnit);
+		void captureDispatch(PbrDispatchCapture& capture, const PbrEnvironmentData& environmentData,
+			const GlobalEnvironment& environment, const PbrDispatchSettings& dispatchSettings,
+			const PbrRetainedDrawList* retainedDrawList) const;
+
+		std::unordered_map<PbrBatchKey, DrawBatch, PbrBatchKeyHash> instancedToDraw;
 		OpenglSettings openglSettings;
+		//instances of all batches are packed into one buffer and selected by base instance
+		unsigned int instancesBuffer;
+		unsigned int environmentBuffer;
+		unsigned int lightsBuffer;
+		size_t instancesCapacity{ 0 };
+		std::pmr::vector<PbrInstancesData> instancesStaging;
+		std::pmr::vector<PbrDrawCommand> drawCommands;
+		PbrDispatchStatistics statistics;
+		PbrDispatchCapture* pendingCapture{ nullptr };
 	};
 	
 }
@@ -1,4 +1,4 @@
-#version 460
+#version 450
 
 in VS_OUT {
 	vec3 normal;
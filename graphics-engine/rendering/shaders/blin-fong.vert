@@ -1,9 +1,10 @@
-#version 460
+#version 450
 
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aUV;
-layout (location = 3) in vec3 aTangent;
+//w is bitangent sign, negative where uvs are mirrored
+layout (location = 3) in vec4 aTangent;
 //instanced
 layout (location = 4) in mat4 aModel;
 
@@ -27,12 +28,13 @@ void main()
 {
 	gl_Position = uProjectionMatrix * uViewMatrix * aModel * vec4(aPosition, 1.0f);
 
-	vec3 T = normalize(vec3(aModel * vec4(aTangent, 0.0)));
+	vec3 T = normalize(vec3(aModel * vec4(aTangent.xyz, 0.0)));
 	vec3 N = normalize(vec3(aModel * vec4(aNormal, 0.0)));
 	// re-orthogonalize T with respect to N
 	T = normalize(T - dot(T, N) * N);
 	// then retrieve perpendicular vector B with the cross product of T and N
-	vec3 B = cross(N, T);
+	//mirrored instances flip bitangent like handedness in pbr.vert
+	vec3 B = cross(N, T) * (aTangent.w * sign(determinant(mat3(aModel))));
 	mat3 TBN = mat3(T, B, N)  ;
 	
 	vsOut.TBN = transpose(TBN);
@@ -0,0 +1,62 @@
+#version 450
+//geometry pass of deferred path, same inputs and variant defines as pbr.frag
+//rt0 rgba8 - albedo, metallic
+//rt1 rgb10_a2 - octahedral world normal, roughness
+#ifdef HAS_ALBEDO_MAP
+layout (binding = 0) uniform sampler2D sAlbeidoMap;
+#endif
+#ifdef HAS_NORMAL_MAP
+layout (binding = 1) uniform sampler2D sNormalMap;
+#endif
+#ifdef HAS_METALNESS_MAP
+layout (binding = 2) uniform sampler2D sMetalnessMap;
+#endif
+
+in VS_OUT {
+	vec3 normal;
+	vec2 uv;
+	vec3 cameraPos;
+	vec3 fragPos;
+	mat3 TBN;
+} fsIn;
+
+layout (location = 0) out vec4 AlbedoMetallic;
+layout (location = 1) out vec4 NormalRoughness;
+
+
+//unit vector to [0, 1] square, lower hemisphere is folded over diagonals
+vec2 encodeOctahedral(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 folded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return (n.z >= 0.0 ? n.xy : folded) * 0.5 + 0.5;
+}
+
+
+void main()
+{
+#ifdef HAS_ALBEDO_MAP
+	vec3 albedo = texture(sAlbeidoMap, fsIn.uv).rgb;
+#else
+	vec3 albedo = vec3(0.8);
+#endif
+#ifdef HAS_NORMAL_MAP
+	vec3 norm = texture(sNormalMap, fsIn.uv).rgb;
+	norm = normalize(norm * 2.0 - 1.0);
+#else
+	vec3 norm = vec3(0.0, 0.0, 1.0);
+#endif
+#ifdef HAS_METALNESS_MAP
+	vec3 metalnessCfs = texture(sMetalnessMap, fsIn.uv).rgb;
+	float metallic  = metalnessCfs.b;
+	float roughness = metalnessCfs.g;
+#else
+	float metallic  = 0.0;
+	float roughness = 1.0;
+#endif
+
+	//TBN of vertex stage maps world to tangent space, its transpose brings normal back to world
+	vec3 worldNormal = normalize(transpose(fsIn.TBN) * norm);
+	AlbedoMetallic = vec4(albedo, metallic);
+	NormalRoughness = vec4(encodeOctahedral(worldNormal), roughness, 0.0);
+}
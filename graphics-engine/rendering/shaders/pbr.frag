@@ -1,7 +1,17 @@
-#version 460
+#version 450
+//variant defines HAS_ALBEDO_MAP, HAS_NORMAL_MAP, HAS_METALNESS_MAP and LAMBERT_LIGHTING are injected by engine
+#ifdef HAS_ALBEDO_MAP
 layout (binding = 0) uniform sampler2D sAlbeidoMap;
+#endif
+#ifdef HAS_NORMAL_MAP
 layout (binding = 1) uniform sampler2D sNormalMap;
+#endif
+#ifdef HAS_METALNESS_MAP
 layout (binding = 2) uniform sampler2D sMetalnessMap;
+#endif
+layout (binding = 3) uniform samplerCube sSpecularEnvironment;
+layout (binding = 4) uniform sampler2D sBrdfLut;
+layout (binding = 5) uniform sampler2DArrayShadow sShadowMap;
 
 in VS_OUT {
 	vec3 normal;
@@ -13,6 +23,8 @@ in VS_OUT {
 
 out vec4 FragmentColor;
 const float PI = 3.14159265359;
+//radiance below one step of 8 bit target is dropped, same cutoff bounds light volumes of deferred tiles
+const float LightCutoff = 1.0 / 256.0;
 
 struct LightInfo{
 	vec4 Position;	
@@ -25,6 +37,41 @@ layout (binding = 0) buffer LightsEnvironment
 	LightInfo lights[];
 };
 
+//precomputed on cpu, see ibl_precompute
+layout (binding = 1) uniform ImageBasedLighting
+{
+	vec4 uIrradianceSh[9];
+	//x max specular lod, y intensity, z 1 when environment is loaded
+	vec4 uIblParameters;
+};
+
+//declared same as in pbr.vert
+layout (binding = 0) uniform GlobalEnv
+{
+	vec4 uCameraPostion;
+	mat4 uProjectionMatrix;
+	mat4 uViewMatrix;
+	mat4 uViewProjectionMatrix;
+	//xyz direction sun light travels in, alpha of color is intensity
+	vec4 uSunDirection;
+	vec4 uSunColor;
+};
+
+//cascades of sun, see cascaded_shadow_maps
+layout (binding = 2) uniform ShadowCascades
+{
+	mat4 uCascadeMatrices[4];
+	vec4 uCascadeSplits;
+	//x cascade count, y 1 when shadow maps are valid, z texel size
+	vec4 uShadowParameters;
+};
+
+float getLightRadius(LightInfo lightInfo)
+{
+	float peak = max(max(lightInfo.Color.r, lightInfo.Color.g), lightInfo.Color.b) * lightInfo.Color.a;
+	return sqrt(max(peak, 0.0) / LightCutoff);
+}
+
 //PBR calculation functions
 float DistributionGGX(vec3 N, vec3 H, float roughness)
 {
@@ -62,15 +109,110 @@ vec3 fresnelSchlick(float cosTheta, vec3 F0)
 {
     return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }  
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
+{
+    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+//IBL functions, N and V in world space
+vec3 evaluateIrradiance(vec3 n)
+{
+    return max(uIrradianceSh[0].rgb * 0.282095
+        + uIrradianceSh[1].rgb * 0.488603 * n.y + uIrradianceSh[2].rgb * 0.488603 * n.z
+        + uIrradianceSh[3].rgb * 0.488603 * n.x
+        + uIrradianceSh[4].rgb * 1.092548 * n.x * n.y + uIrradianceSh[5].rgb * 1.092548 * n.y * n.z
+        + uIrradianceSh[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0)
+        + uIrradianceSh[7].rgb * 1.092548 * n.x * n.z + uIrradianceSh[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y),
+        vec3(0.0));
+}
+vec3 ambientLighting(vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0)
+{
+    if (uIblParameters.z == 0.0)
+        return vec3(0.02) * albedo;
+    vec3 diffuse = evaluateIrradiance(N) * albedo / PI;
+#ifdef LAMBERT_LIGHTING
+    return (1.0 - metallic) * diffuse * uIblParameters.y;
+#else
+    // split sum specular
+    float NdotV = max(dot(N, V), 0.0);
+    vec3 F = fresnelSchlickRoughness(NdotV, F0, roughness);
+    vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+    vec3 prefiltered = textureLod(sSpecularEnvironment, reflect(-V, N), roughness * uIblParameters.x).rgb;
+    vec2 brdf = texture(sBrdfLut, vec2(NdotV, roughness)).rg;
+    return (kD * diffuse + prefiltered * (F * brdf.x + brdf.y)) * uIblParameters.y;
+#endif
+}
+
+//shadow of sun, 3x3 pcf of hardware compared taps
+float evaluateShadow(vec3 worldPos)
+{
+    if (uShadowParameters.y == 0.0)
+        return 1.0;
+    float viewDepth = -(uViewMatrix * vec4(worldPos, 1.0)).z;
+    int cascadeCount = int(uShadowParameters.x);
+    int cascade = 0;
+    while (cascade < cascadeCount && viewDepth > uCascadeSplits[cascade])
+        cascade++;
+    if (cascade == cascadeCount)
+        return 1.0;
+    vec3 coords = (uCascadeMatrices[cascade] * vec4(worldPos, 1.0)).xyz * 0.5 + 0.5;
+    if (coords.z > 1.0)
+        return 1.0;
+    float shadow = 0.0;
+    for (int x = -1; x <= 1; x++)
+        for (int y = -1; y <= 1; y++)
+            shadow += texture(sShadowMap, vec4(coords.xy + vec2(x, y) * uShadowParameters.z, cascade, coords.z));
+    return shadow / 9.0;
+}
+
+//outgoing radiance of single light, all vectors in tangent space
+vec3 evaluateLight(vec3 norm, vec3 viewDir, vec3 lightDir, vec3 radiance, vec3 albedo, float metallic, float roughness,
+    vec3 F0)
+{
+    float NdotL = max(dot(norm, lightDir), 0.0);                
+#ifdef LAMBERT_LIGHTING
+    return (1.0 - metallic) * albedo / PI * radiance * NdotL;
+#else
+    // cook-torrance brdf
+    vec3 halfWayVL = normalize(viewDir + lightDir);
+    float NDF = DistributionGGX(norm, halfWayVL, roughness);        
+    float G   = GeometrySmith(norm, viewDir, lightDir, roughness);      
+    vec3 F    = fresnelSchlick(max(dot(halfWayVL, viewDir), 0.0), F0);       
+    
+    vec3 kS = F;
+    vec3 kD = vec3(1.0) - kS;
+    kD *= (1.0 - metallic);	  
+    
+    vec3 numerator    = NDF * G * F;
+    float denominator = 4.0 * max(dot(norm, viewDir), 0.0) * NdotL + 0.0001;
+    vec3 specular     = numerator / denominator;  
+        
+    return (kD * albedo / PI + specular) * radiance * NdotL; 
+#endif
+}
 
 void main()
 {
+#ifdef HAS_ALBEDO_MAP
     vec3 albedo = texture(sAlbeidoMap, fsIn.uv).rgb; 
+#else
+    vec3 albedo = vec3(0.8);
+#endif
+#ifdef HAS_NORMAL_MAP
     vec3 norm = texture(sNormalMap, fsIn.uv).rgb;
     norm = normalize(norm * 2.0 - 1.0);  
+#else
+    //lighting is done in tangent space, unperturbed normal is z
+    vec3 norm = vec3(0.0, 0.0, 1.0);
+#endif
+#ifdef HAS_METALNESS_MAP
 	vec3 metalnessCfs = texture(sMetalnessMap, fsIn.uv).rgb;
     float metallic  = metalnessCfs.b;
     float roughness = metalnessCfs.g;
+#else
+    float metallic  = 0.0;
+    float roughness = 1.0;
+#endif
 
 
     vec3 viewDir  = fsIn.TBN * normalize(fsIn.cameraPos - fsIn.fragPos); 
@@ -80,36 +222,27 @@ void main()
 
 	           
     // reflectance equation
+    float shadow = evaluateShadow(fsIn.fragPos);
     vec3 Lo = vec3(0.0);
     for(int i = 0; i < lightsCount; ++i) 
     {
         LightInfo lightInfo = lights[i];
+        float distance = length(lightInfo.Position.xyz - fsIn.fragPos);
+        if (distance > getLightRadius(lightInfo))
+            continue;
         // calculate per-light radiance
         vec3 lightDir = fsIn.TBN * normalize(lightInfo.Position.xyz - fsIn.fragPos);
-        vec3 halfWayVL = normalize(viewDir + lightDir);
-        float distance = length(lightInfo.Position.xyz - fsIn.fragPos);
         float attenuation = 1.0 / pow(distance, 2);
         vec3 radiance = lightInfo.Color.xyz * attenuation * lightInfo.Color.a;        
-        
-        // cook-torrance brdf
-        float NDF = DistributionGGX(norm, halfWayVL, roughness);        
-        float G   = GeometrySmith(norm, viewDir, lightDir, roughness);      
-        vec3 F    = fresnelSchlick(max(dot(halfWayVL, viewDir), 0.0), F0);       
-        
-        vec3 kS = F;
-        vec3 kD = vec3(1.0) - kS;
-        kD *= (1.0 - metallic);	  
-        
-        vec3 numerator    = NDF * G * F;
-        float denominator = 4.0 * max(dot(norm, viewDir), 0.0) * max(dot(norm, lightDir), 0.0) + 0.0001;
-        vec3 specular     = numerator / denominator;  
-            
-        // add to outgoing radiance Lo
-        float NdotL = max(dot(norm, lightDir), 0.0);                
-        Lo += (kD * albedo / PI + specular) * radiance * NdotL; 
+        Lo += evaluateLight(norm, viewDir, lightDir, radiance, albedo, metallic, roughness, F0);
     }   
+    //sun is only shadowed light
+    if (uSunColor.a > 0.0)
+        Lo += evaluateLight(norm, viewDir, fsIn.TBN * normalize(-uSunDirection.xyz), uSunColor.rgb * uSunColor.a * shadow,
+            albedo, metallic, roughness, F0);
 
-    vec3 ambient = vec3(0.02) * albedo;
+    vec3 ambient = ambientLighting(normalize(transpose(fsIn.TBN) * norm), transpose(fsIn.TBN) * viewDir, albedo,
+        metallic, roughness, F0);
     vec3 color = ambient + Lo;
     FragmentColor = vec4(color, 1.0);
 }
\ No newline at end of file
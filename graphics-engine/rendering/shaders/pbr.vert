@@ -1,17 +1,23 @@
-#version 460
+#version 450
 
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aUV;
-layout (location = 3) in vec3 aTangent;
-//instanced
-layout (location = 4) in mat4 aModel;
+//w is bitangent sign, negative where uvs are mirrored
+layout (location = 3) in vec4 aTangent;
+//instanced, first three rows of model matrix, vector multiplied from left gives transformed xyz
+layout (location = 4) in mat3x4 aModel;
 
+//declared same as in pbr.frag, stages of one program have to agree on members of block or it fails to link
 layout (binding = 0) uniform GlobalEnv
 {
 	vec4 uCameraPostion;
 	mat4 uProjectionMatrix;
 	mat4 uViewMatrix;
+	mat4 uViewProjectionMatrix;
+	//xyz direction sun light travels in, alpha of color is intensity
+	vec4 uSunDirection;
+	vec4 uSunColor;
 };
 
 out VS_OUT {
@@ -22,22 +28,34 @@ out VS_OUT {
 	mat3 TBN;
 } vsOut;
 
+//must match depth.vert bit for bit, main pass runs with GL_EQUAL depth test
+invariant gl_Position;
+
 
 void main()
 {
-	gl_Position = uProjectionMatrix * uViewMatrix * aModel * vec4(aPosition, 1.0f);
+	vec3 worldPosition = vec4(aPosition, 1.0f) * aModel;
+	gl_Position = uViewProjectionMatrix * vec4(worldPosition, 1.0f);
 
-	vec3 T = normalize(vec3(aModel * vec4(aTangent, 0.0)));
-	vec3 N = normalize(vec3(aModel * vec4(aNormal, 0.0)));
+	//normals go through inverse transpose of model matrix, its cofactor matrix differs only by determinant,
+	//so it stays correct under non-uniform scale without inverse per vertex or per instance
+	mat3 model = mat3(transpose(aModel));
+	mat3 normalMatrix = mat3(cross(model[1], model[2]), cross(model[2], model[0]), cross(model[0], model[1]));
+	//mirrored instances have negative determinant, which would flip normals
+	float handedness = sign(dot(model[0], normalMatrix[0]));
+	vec3 T = normalize(model * aTangent.xyz);
+	vec3 N = normalize(normalMatrix * aNormal * handedness);
 	// re-orthogonalize T with respect to N
 	T = normalize(T - dot(T, N) * N);
-	// then retrieve perpendicular vector B with the cross product of T and N
-	vec3 B = cross(N, T);
+	// then retrieve perpendicular vector B with the cross product of T and N, mirrored uvs and mirrored
+	// instances each flip it
+	vec3 B = cross(N, T) * (aTangent.w * handedness);
 	mat3 TBN = mat3(T, B, N)  ;
 	
 	vsOut.TBN = transpose(TBN);
 	vsOut.normal = aNormal;
 	vsOut.uv = aUV;
 	vsOut.cameraPos = uCameraPostion.xyz;
-	vsOut.fragPos = aPosition;
+	//world space like light positions and camera
+	vsOut.fragPos = worldPosition;
 }
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 450
+
+layout (location = 0) in vec3 aPosition;
+//instanced, first three rows of model matrix like in pbr.vert
+layout (location = 4) in mat3x4 aModel;
+
+layout (location = 0) uniform mat4 uLightViewProjection;
+
+void main()
+{
+	gl_Position = uLightViewProjection * vec4(vec4(aPosition, 1.0f) * aModel, 1.0f);
+}
@@ -0,0 +1,38 @@
+#version 450
+//records finest mip level each streamed texture of draw is sampled at, feedback target has no color attachment
+//and hidden fragments are rejected before they reach atomics
+layout (early_fragment_tests) in;
+
+in vec2 uv;
+
+//finest requested level per streamed texture, cleared to max uint before pass
+layout (std430, binding = 0) buffer TextureFeedback
+{
+	uint desiredLevels[];
+};
+//slots of diffuse, normal and metalness texture, -1 when draw has none
+layout (location = 0) uniform ivec3 uSlots;
+//level 0 sizes of same textures
+layout (location = 1) uniform vec2 uSizes[3];
+//log2 of feedback divisor, derivatives of feedback pixel span that many more texels than full resolution pixel
+layout (location = 4) uniform float uLevelBias;
+
+
+void recordLevel(int slot, vec2 size)
+{
+	if (slot < 0)
+		return;
+	//same lod as hardware picks, trilinear filtering reads this level and next coarser one
+	vec2 texelDx = dFdx(uv) * size;
+	vec2 texelDy = dFdy(uv) * size;
+	float lod = 0.5f * log2(max(max(dot(texelDx, texelDx), dot(texelDy, texelDy)), 1e-8f)) - uLevelBias;
+	atomicMin(desiredLevels[slot], uint(clamp(floor(lod), 0.0f, 31.0f)));
+}
+
+
+void main()
+{
+	recordLevel(uSlots.x, uSizes[0]);
+	recordLevel(uSlots.y, uSizes[1]);
+	recordLevel(uSlots.z, uSizes[2]);
+}
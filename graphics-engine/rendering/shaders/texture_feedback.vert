@@ -0,0 +1,24 @@
+#version 450
+
+layout (location = 0) in vec3 aPosition;
+layout (location = 2) in vec2 aUV;
+//instanced, first three rows of model matrix like in pbr.vert
+layout (location = 4) in mat3x4 aModel;
+
+layout (binding = 0) uniform GlobalEnv
+{
+	vec4 uCameraPostion;
+	mat4 uProjectionMatrix;
+	mat4 uViewMatrix;
+	mat4 uViewProjectionMatrix;
+};
+
+out vec2 uv;
+
+
+void main()
+{
+	vec3 worldPosition = vec4(aPosition, 1.0f) * aModel;
+	gl_Position = uViewProjectionMatrix * vec4(worldPosition, 1.0f);
+	uv = aUV;
+}
@@ -0,0 +1,37 @@
+#version 450
+//bilinear upscale of scaled scene region with contrast adaptive sharpening,
+//sharpening is weaker where neighbourhood already has high contrast, so edges do not ring
+layout (binding = 0) uniform sampler2D sColor;
+
+//render size divided by texture size
+layout (location = 0) uniform vec2 uSourceScale;
+layout (location = 1) uniform float uSharpness;
+
+in vec2 uv;
+out vec4 FragmentColor;
+
+
+vec3 sampleSource(vec2 sourceUv, vec2 texel)
+{
+	//taps stay inside rendered region, rest of texture holds stale pixels
+	return texture(sColor, clamp(sourceUv, texel * 0.5, uSourceScale - texel * 0.5)).rgb;
+}
+
+
+void main()
+{
+	vec2 texel = 1.0 / vec2(textureSize(sColor, 0));
+	vec2 sourceUv = uv * uSourceScale;
+	vec3 center = sampleSource(sourceUv, texel);
+	vec3 north = sampleSource(sourceUv + vec2(0.0, texel.y), texel);
+	vec3 south = sampleSource(sourceUv - vec2(0.0, texel.y), texel);
+	vec3 east = sampleSource(sourceUv + vec2(texel.x, 0.0), texel);
+	vec3 west = sampleSource(sourceUv - vec2(texel.x, 0.0), texel);
+
+	vec3 minColor = min(center, min(min(north, south), min(east, west)));
+	vec3 maxColor = max(center, max(max(north, south), max(east, west)));
+	vec3 amplitude = sqrt(clamp(min(minColor, 1.0 - maxColor) / max(maxColor, vec3(0.0001)), 0.0, 1.0));
+	vec3 weight = -amplitude * mix(0.125, 0.2, uSharpness) * step(0.0001, uSharpness);
+	vec3 color = (center + (north + south + east + west) * weight) / (1.0 + 4.0 * weight);
+	FragmentColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,10 @@
+#version 450
+
+out vec2 uv;
+
+//single triangle covering whole target, no vertex buffers
+void main()
+{
+	uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,355 @@
+#include <rendering/software/path_tracer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <rendering/software/software_shading.h>
+#include <profiling/profiler.h>
+
+
+constexpr int PathTileSize = 16;
+//secondary rays start this far above surface relative to its distance from origin, so they miss own triangle
+constexpr float RayOffsetScale = 1e-4f;
+constexpr float MinPathRoughness = 0.02f;
+constexpr float MinSurvivalProbability = 0.05f;
+
+
+unsigned int pcgHash(unsigned int value)
+{
+	const unsigned int state = value * 747796405u + 2891336453u;
+	const unsigned int word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+
+float randomFloat(unsigned int& state)
+{
+	state = pcgHash(state);
+	return static_cast<float>(state >> 8) * (1.0f / 16777216.0f);
+}
+
+
+//orthonormal basis around normal without branching on its direction, local z maps to normal
+glm::vec3 alignToNormal(const glm::vec3& local, const glm::vec3& N)
+{
+	const float sign = std::copysign(1.0f, N.z);
+	const float a = -1.0f / (sign + N.z);
+	const float b = N.x * N.y * a;
+	const glm::vec3 T(1.0f + sign * N.x * N.x * a, sign * b, -sign * N.x);
+	const glm::vec3 B(b, sign + N.y * N.y * a, -N.y);
+	return T * local.x + B * local.y + N * local.z;
+}
+
+
+//half vector around +z distributed by ggx, same mapping as prefiltering of specular environment
+glm::vec3 sampleGgxHalfVector(float u, float v, float roughness)
+{
+	const float a = roughness * roughness;
+	const float phi = 2.0f * dengine::SoftwarePi * u;
+	const float cosTheta = std::sqrt((1.0f - v) / (1.0f + (a * a - 1.0f) * v));
+	const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+	return glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+}
+
+
+glm::vec3 sampleCosineHemisphere(float u, float v)
+{
+	const float radius = std::sqrt(u);
+	const float phi = 2.0f * dengine::SoftwarePi * v;
+	return glm::vec3(radius * std::cos(phi), radius * std::sin(phi), std::sqrt(std::max(1.0f - u, 0.0f)));
+}
+
+
+float getMaxComponent(const glm::vec3& value)
+{
+	return std::max({ value.x, value.y, value.z });
+}
+
+
+dengine::PathTracer::PathTracer(BS::thread_pool& threadPool) : threadPool(threadPool), bvh(threadPool)
+{
+	Resize(1920, 1080);
+}
+
+
+void dengine::PathTracer::Resize(int width, int height)
+{
+	width = std::max(width, 1);
+	height = std::max(height, 1);
+	if (width == this->width && height == this->height)
+		return;
+	this->width = width;
+	this->height = height;
+	tilesX = (width + PathTileSize - 1) / PathTileSize;
+	tilesY = (height + PathTileSize - 1) / PathTileSize;
+	color.assign(static_cast<size_t>(width) * height * 4, 0);
+	Reset();
+}
+
+
+void dengine::PathTracer::SetScene(const SoftwareScene& scene)
+{
+	this->scene = &scene;
+	bvh.Build(scene);
+	Reset();
+}
+
+
+void dengine::PathTracer::Accumulate(const Camera& camera, int samples)
+{
+	DENGINE_PROFILE_SCOPE("path trace");
+	if (scene == nullptr || samples <= 0)
+		return;
+	const bool cameraMoved = camera.Position != accumulatedCamera.Position ||
+		camera.Diraction != accumulatedCamera.Diraction || camera.Up != accumulatedCamera.Up;
+	if (cameraMoved)
+		Reset();
+	if (statistics.Samples == 0)
+	{
+		accumulatedCamera = camera;
+		//same vertical field of view and aspect as perspective projection of rasterizers
+		const float imagePlaneHeight = std::tan(glm::radians(settings.FieldOfView) * 0.5f);
+		const float aspect = static_cast<float>(width) / static_cast<float>(height);
+		cameraForward = glm::normalize(camera.Diraction);
+		const glm::vec3 right = glm::normalize(glm::cross(cameraForward, camera.Up));
+		cameraRight = right * imagePlaneHeight * aspect;
+		cameraUp = glm::cross(right, cameraForward) * imagePlaneHeight;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	std::atomic<unsigned long long> rays{ 0 };
+	const size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+	threadPool.parallelize_loop(size_t{ 0 }, tileCount, [&](size_t first, size_t last)
+	{
+		unsigned long long tileRays = 0;
+		for (size_t tileIndex = first; tileIndex < last; tileIndex++)
+			traceTile(tileIndex, samples, tileRays);
+		rays += tileRays;
+	}, tileCount).wait();
+	statistics.Samples += samples;
+	statistics.Rays = rays;
+	statistics.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+void dengine::PathTracer::Reset()
+{
+	statistics = PathTracerStatistics{};
+	accumulation.assign(static_cast<size_t>(width) * height, glm::vec3(0.0f));
+}
+
+
+const std::pmr::vector<unsigned char>& dengine::PathTracer::GetColor() const
+{
+	return color;
+}
+
+
+int dengine::PathTracer::GetWidth() const
+{
+	return width;
+}
+
+
+int dengine::PathTracer::GetHeight() const
+{
+	return height;
+}
+
+
+dengine::PathTracerSettings& dengine::PathTracer::GetSettings()
+{
+	return settings;
+}
+
+
+const dengine::PathTracerStatistics& dengine::PathTracer::GetStatistics() const
+{
+	return statistics;
+}
+
+
+const dengine::TriangleBvh& dengine::PathTracer::GetBvh() const
+{
+	return bvh;
+}
+
+
+void dengine::PathTracer::traceTile(size_t tileIndex, int samples, unsigned long long& rays)
+{
+	const int tileMinX = static_cast<int>(tileIndex % tilesX) * PathTileSize;
+	const int tileMinY = static_cast<int>(tileIndex / tilesX) * PathTileSize;
+	const int tileMaxX = std::min(tileMinX + PathTileSize, width);
+	const int tileMaxY = std::min(tileMinY + PathTileSize, height);
+	const int totalSamples = statistics.Samples + samples;
+	for (int y = tileMinY; y < tileMaxY; y++)
+	{
+		for (int x = tileMinX; x < tileMaxX; x++)
+		{
+			const size_t pixel = static_cast<size_t>(y) * width + x;
+			glm::vec3 sum(0.0f);
+			for (int sample = statistics.Samples; sample < totalSamples; sample++)
+			{
+				//sequence depends only on pixel and sample index, so images are reproducible across thread counts
+				unsigned int randomState = pcgHash(static_cast<unsigned int>(pixel) ^ pcgHash(static_cast<unsigned int>(sample)));
+				const float jitterX = randomFloat(randomState);
+				const float jitterY = randomFloat(randomState);
+				const float ndcX = (x + jitterX) / width * 2.0f - 1.0f;
+				const float ndcY = 1.0f - (y + jitterY) / height * 2.0f;
+				const BvhRay ray{ accumulatedCamera.Position,
+					glm::normalize(cameraForward + cameraRight * ndcX + cameraUp * ndcY),
+					std::numeric_limits<float>::infinity() };
+				const glm::vec3 radiance = tracePath(ray, randomState, rays);
+				if (std::isfinite(radiance.x) && std::isfinite(radiance.y) && std::isfinite(radiance.z))
+					sum += glm::min(radiance, glm::vec3(settings.MaxSampleRadiance));
+			}
+			accumulation[pixel] += sum;
+
+			//no tone mapping, same as linear output of pbr.frag into rgba8 target
+			const glm::vec3 average = glm::clamp(accumulation[pixel] / static_cast<float>(totalSamples), 0.0f, 1.0f);
+			unsigned char* output = color.data() + pixel * 4;
+			output[0] = static_cast<unsigned char>(average.r * 255.0f + 0.5f);
+			output[1] = static_cast<unsigned char>(average.g * 255.0f + 0.5f);
+			output[2] = static_cast<unsigned char>(average.b * 255.0f + 0.5f);
+			output[3] = 255;
+		}
+	}
+}
+
+
+glm::vec3 dengine::PathTracer::tracePath(BvhRay ray, unsigned int& randomState, unsigned long long& rays) const
+{
+	glm::vec3 radiance(0.0f);
+	glm::vec3 throughput(1.0f);
+	for (int bounce = 0;; bounce++)
+	{
+		BvhHit hit;
+		rays++;
+		if (!bvh.Intersect(ray, hit))
+		{
+			radiance += throughput * settings.EnvironmentRadiance;
+			break;
+		}
+		const auto surface = getSurface(ray, hit);
+		const glm::vec3 V = -ray.Direction;
+		const float offset = RayOffsetScale * std::max(1.0f, getMaxComponent(glm::abs(surface.Position)));
+		const glm::vec3 origin = surface.Position + surface.GeometricNormal * offset;
+
+		//next event estimation, point lights can not be hit by sampled directions
+		for (const auto& light : scene->GetLights())
+		{
+			const glm::vec3 toLight = glm::vec3(light.Position) - origin;
+			const float distanceSquared = glm::dot(toLight, toLight);
+			const float distance = std::sqrt(distanceSquared);
+			const glm::vec3 L = toLight / distance;
+			if (glm::dot(surface.GeometricNormal, L) <= 0.0f)
+				continue;
+			const glm::vec3 reflected = evaluateCookTorrance(surface.Normal, V, L, surface.Albedo, surface.Metallic,
+				surface.Roughness);
+			if (getMaxComponent(reflected) <= 0.0f)
+				continue;
+			rays++;
+			if (bvh.IsOccluded(BvhRay{ origin, L, distance }))
+				continue;
+			radiance += throughput * reflected * glm::vec3(light.Color) * light.Color.a / distanceSquared;
+		}
+		const auto& sun = scene->GetSun();
+		const glm::vec3 toSun = -glm::vec3(sun.Direction);
+		if (sun.Color.a > 0.0f && glm::dot(surface.GeometricNormal, toSun) > 0.0f)
+		{
+			const glm::vec3 reflected = evaluateCookTorrance(surface.Normal, V, toSun, surface.Albedo, surface.Metallic,
+				surface.Roughness);
+			if (getMaxComponent(reflected) > 0.0f)
+			{
+				rays++;
+				if (!bvh.IsOccluded(BvhRay{ origin, toSun, std::numeric_limits<float>::max() }))
+					radiance += throughput * reflected * glm::vec3(sun.Color) * sun.Color.a;
+			}
+		}
+		if (bounce >= settings.MaxBounces)
+			break;
+
+		//one lobe is sampled, picked by rough estimate of its reflectance, pdf is mixture of both lobes
+		const float NdotV = std::max(glm::dot(surface.Normal, V), 1e-4f);
+		const glm::vec3 F0 = glm::mix(glm::vec3(0.04f), surface.Albedo, surface.Metallic);
+		const float specularWeight = getMaxComponent(fresnelSchlick(NdotV, F0));
+		const float diffuseWeight = (1.0f - surface.Metallic) * getMaxComponent(surface.Albedo);
+		if (specularWeight + diffuseWeight <= 0.0f)
+			break;
+		const float specularProbability = specularWeight / (specularWeight + diffuseWeight);
+		const float lobe = randomFloat(randomState);
+		const float u = randomFloat(randomState);
+		const float v = randomFloat(randomState);
+		const glm::vec3 L = lobe < specularProbability
+			? glm::reflect(-V, alignToNormal(sampleGgxHalfVector(u, v, surface.Roughness), surface.Normal))
+			: alignToNormal(sampleCosineHemisphere(u, v), surface.Normal);
+		const float NdotL = glm::dot(surface.Normal, L);
+		if (NdotL <= 0.0f || glm::dot(surface.GeometricNormal, L) <= 0.0f)
+			break;
+		const glm::vec3 H = glm::normalize(V + L);
+		const float NdotH = std::max(glm::dot(surface.Normal, H), 0.0f);
+		const float VdotH = std::max(glm::dot(V, H), 1e-4f);
+		const float pdf = specularProbability * distributionGgx(NdotH, surface.Roughness) * NdotH / (4.0f * VdotH) +
+			(1.0f - specularProbability) * NdotL / SoftwarePi;
+		if (pdf <= 0.0f)
+			break;
+		throughput *= evaluateCookTorrance(surface.Normal, V, L, surface.Albedo, surface.Metallic, surface.Roughness) / pdf;
+
+		if (bounce + 1 >= settings.RussianRouletteBounce)
+		{
+			const float survival = std::clamp(getMaxComponent(throughput), MinSurvivalProbability, 1.0f);
+			if (randomFloat(randomState) >= survival)
+				break;
+			throughput /= survival;
+		}
+		ray = BvhRay{ origin, L, std::numeric_limits<float>::infinity() };
+	}
+	return radiance;
+}
+
+
+dengine::PathTracer::Surface dengine::PathTracer::getSurface(const BvhRay& ray, const BvhHit& hit) const
+{
+	const auto& drawItem = scene->GetDrawItems()[hit.DrawItem];
+	const auto& mesh = *drawItem.SourceMesh;
+	const unsigned int* indices = mesh.Indecies.data() + static_cast<size_t>(hit.Triangle) * 3;
+	const float weights[3] = { 1.0f - hit.U - hit.V, hit.U, hit.V };
+	glm::vec3 normal(0.0f);
+	glm::vec4 tangent(0.0f);
+	glm::vec2 uv(0.0f);
+	for (int k = 0; k < 3; k++)
+	{
+		if (mesh.Normals.size() == mesh.Positions.size())
+			normal += mesh.Normals[indices[k]] * weights[k];
+		if (mesh.Tangents.size() == mesh.Positions.size())
+			tangent += mesh.Tangents[indices[k]] * weights[k];
+		if (mesh.UVs.size() == mesh.Positions.size())
+			uv += mesh.UVs[indices[k]] * weights[k];
+	}
+
+	Surface surface;
+	surface.Position = ray.Origin + ray.Direction * hit.Distance;
+	//both faces are shaded like on gpu, normals are turned towards ray
+	surface.GeometricNormal = glm::dot(hit.GeometricNormal, ray.Direction) > 0.0f ? -hit.GeometricNormal : hit.GeometricNormal;
+	normal = drawItem.NormalMatrix * normal;
+	//mirrored draws flip bitangent like handedness in pbr.vert
+	const float handedness = glm::determinant(glm::mat3(drawItem.ModelMatrix)) < 0.0f ? -1.0f : 1.0f;
+	tangent = glm::vec4(glm::vec3(drawItem.ModelMatrix * glm::vec4(glm::vec3(tangent), 0.0f)), tangent.w * handedness);
+	surface.Normal = glm::dot(normal, normal) > 0.0f ? glm::normalize(normal) : surface.GeometricNormal;
+	if (glm::dot(surface.Normal, surface.GeometricNormal) < 0.0f)
+		surface.Normal = -surface.Normal;
+
+	//rays carry no differentials, maps are sampled at base level
+	const auto& material = drawItem.Material;
+	if (material.Normal != nullptr)
+		surface.Normal = perturbNormal(surface.Normal, tangent, glm::vec3(material.Normal->Sample(uv, 0.0f)));
+	surface.Albedo = material.Albedo != nullptr ? glm::vec3(material.Albedo->Sample(uv, 0.0f)) : glm::vec3(0.8f);
+	const glm::vec3 metalness = material.Metalness != nullptr ? glm::vec3(material.Metalness->Sample(uv, 0.0f))
+		: glm::vec3(0.0f, 1.0f, 0.0f);
+	surface.Metallic = metalness.b;
+	//perfect mirrors have no finite ggx pdf
+	surface.Roughness = std::max(metalness.g, MinPathRoughness);
+	return surface;
+}
@@ -0,0 +1,90 @@
+#ifndef PATH_TRACER_INCLUDED
+#define PATH_TRACER_INCLUDED
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <BS_thread_pool.hpp>
+#include <rendering/camera.hpp>
+#include <rendering/software/software_scene.h>
+#include <rendering/software/triangle_bvh.h>
+
+namespace dengine
+{
+	struct PathTracerSettings {
+		float FieldOfView{ 55.0f };
+		int MaxBounces{ 4 };
+		//paths are ended by russian roulette from this bounce on
+		int RussianRouletteBounce{ 2 };
+		//uniform sky, default matches flat ambient of pbr.frag without environment
+		glm::vec3 EnvironmentRadiance{ 0.02f };
+		//sample radiance is clamped, suppresses fireflies of small bright lights at cost of slight bias
+		float MaxSampleRadiance{ 10.0f };
+	};
+
+	struct PathTracerStatistics {
+		//accumulated samples per pixel
+		int Samples{ 0 };
+		//primary, bounce and shadow rays of last accumulation
+		unsigned long long Rays{ 0 };
+		double Milliseconds{ 0.0 };
+	};
+
+
+	//reference renderer for pbr shading, traces paths through scene bvh with next event estimation towards point
+	//lights and accumulates samples progressively over tiles on thread pool until camera or scene changes
+	class PathTracer {
+	public:
+		explicit PathTracer(BS::thread_pool& threadPool);
+		PathTracer(const PathTracer&) = delete;
+		PathTracer& operator=(const PathTracer&) = delete;
+
+		void Resize(int width, int height);
+		//builds bvh, scene has to outlive tracer or next call
+		void SetScene(const SoftwareScene& scene);
+		//adds samples per pixel, accumulation restarts when camera moved
+		void Accumulate(const Camera& camera, int samples);
+		void Reset();
+		//average of accumulated samples, rgba8 rows from top to bottom
+		const std::pmr::vector<unsigned char>& GetColor() const;
+		int GetWidth() const;
+		int GetHeight() const;
+		PathTracerSettings& GetSettings();
+		const PathTracerStatistics& GetStatistics() const;
+		const TriangleBvh& GetBvh() const;
+	private:
+		struct Surface {
+			glm::vec3 Position;
+			//shading normal and geometric normal, both facing incoming ray
+			glm::vec3 Normal;
+			glm::vec3 GeometricNormal;
+			glm::vec3 Albedo;
+			float Metallic;
+			float Roughness;
+		};
+
+		void traceTile(size_t tileIndex, int samples, unsigned long long& rays);
+		glm::vec3 tracePath(BvhRay ray, unsigned int& randomState, unsigned long long& rays) const;
+		Surface getSurface(const BvhRay& ray, const BvhHit& hit) const;
+
+		BS::thread_pool& threadPool;
+		PathTracerSettings settings;
+		PathTracerStatistics statistics;
+		TriangleBvh bvh;
+		const SoftwareScene* scene{ nullptr };
+		int width{ 0 };
+		int height{ 0 };
+		int tilesX{ 0 };
+		int tilesY{ 0 };
+		//sums of samples, averaged into color after every accumulation
+		std::pmr::vector<glm::vec3> accumulation;
+		std::pmr::vector<unsigned char> color;
+		Camera accumulatedCamera;
+		//camera ray basis, forward plus scaled right and up span image plane at distance 1
+		glm::vec3 cameraForward{ 0.0f };
+		glm::vec3 cameraRight{ 0.0f };
+		glm::vec3 cameraUp{ 0.0f };
+	};
+}
+
+#endif
@@ -0,0 +1,658 @@
+#include <rendering/software/software_rasterizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glm/gtc/type_ptr.hpp>
+#include <rendering/draw_list_builder.h>
+#include <rendering/software/software_shading.h>
+#include <profiling/profiler.h>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define DENGINE_SOFTWARE_SSE
+#endif
+
+
+//tiles are square, big enough to amortize bin walking and small enough to spread over workers
+constexpr int TileSize = 64;
+//fixed point precision of screen coordinates, edge functions stay exact in 64 bits
+constexpr int SubpixelBits = 8;
+constexpr long long SubpixelScale = 1ll << SubpixelBits;
+constexpr size_t ChunkTriangleCount = 4096;
+constexpr unsigned int ClippedVertexBit = 1u << 31;
+constexpr unsigned int EmptyPixel = std::numeric_limits<unsigned int>::max();
+//x and y are clipped only outside this multiple of w, keeps fixed point coordinates from overflowing while
+//most triangles crossing screen edges are just clamped to screen by their bounds
+constexpr float GuardBand = 64.0f;
+constexpr int ClipPlaneCount = 6;
+//each clip plane adds at most one vertex to polygon
+constexpr int MaxClipVertices = 3 + ClipPlaneCount;
+
+
+//matrix columns kept in registers, transform is four multiply adds of broadcast vector components
+struct SimdMatrix {
+#ifdef DENGINE_SOFTWARE_SSE
+	__m128 Columns[4];
+#else
+	glm::mat4 Matrix;
+#endif
+};
+
+
+SimdMatrix makeSimdMatrix(const glm::mat4& matrix)
+{
+	SimdMatrix simdMatrix;
+#ifdef DENGINE_SOFTWARE_SSE
+	const float* elements = glm::value_ptr(matrix);
+	for (int column = 0; column < 4; column++)
+		simdMatrix.Columns[column] = _mm_loadu_ps(elements + column * 4);
+#else
+	simdMatrix.Matrix = matrix;
+#endif
+	return simdMatrix;
+}
+
+
+glm::vec4 transformSimd(const SimdMatrix& matrix, const glm::vec3& vector, float w)
+{
+#ifdef DENGINE_SOFTWARE_SSE
+	const __m128 xy = _mm_add_ps(_mm_mul_ps(matrix.Columns[0], _mm_set1_ps(vector.x)),
+		_mm_mul_ps(matrix.Columns[1], _mm_set1_ps(vector.y)));
+	const __m128 zw = _mm_add_ps(_mm_mul_ps(matrix.Columns[2], _mm_set1_ps(vector.z)),
+		_mm_mul_ps(matrix.Columns[3], _mm_set1_ps(w)));
+	glm::vec4 result;
+	_mm_storeu_ps(&result.x, _mm_add_ps(xy, zw));
+	return result;
+#else
+	return matrix.Matrix * glm::vec4(vector, w);
+#endif
+}
+
+
+bool isWorldSphereVisible(const std::array<glm::vec4, 6>& planes, const glm::vec4& sphere)
+{
+	for (const auto& plane : planes)
+		if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w)
+			return false;
+	return true;
+}
+
+
+//signed distance to clip plane, negative outside; x and y planes are scaled by bound, z planes are exact
+float getClipDistance(const glm::vec4& position, int plane, float bound)
+{
+	switch (plane)
+	{
+	case 0: return position.x + bound * position.w;
+	case 1: return bound * position.w - position.x;
+	case 2: return position.y + bound * position.w;
+	case 3: return bound * position.w - position.y;
+	case 4: return position.z + position.w;
+	default: return position.w - position.z;
+	}
+}
+
+
+unsigned int getClipCodes(const glm::vec4& position, float bound)
+{
+	unsigned int codes = 0;
+	for (int plane = 0; plane < ClipPlaneCount; plane++)
+		if (getClipDistance(position, plane, bound) < 0.0f)
+			codes |= 1u << plane;
+	return codes;
+}
+
+
+unsigned char toColorByte(float value)
+{
+	return static_cast<unsigned char>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+
+dengine::SoftwareRasterizer::SoftwareRasterizer(BS::thread_pool& threadPool) : threadPool(threadPool)
+{
+	Resize(1920, 1080);
+}
+
+
+void dengine::SoftwareRasterizer::Resize(int width, int height)
+{
+	width = std::max(width, 1);
+	height = std::max(height, 1);
+	if (width == this->width && height == this->height)
+		return;
+	this->width = width;
+	this->height = height;
+	tilesX = (width + TileSize - 1) / TileSize;
+	tilesY = (height + TileSize - 1) / TileSize;
+	const size_t pixelCount = static_cast<size_t>(width) * height;
+	color.assign(pixelCount * 4, 0);
+	depth.assign(pixelCount, 1.0f);
+	visibility.assign(pixelCount, TriangleReference{ EmptyPixel, 0 });
+}
+
+
+void dengine::SoftwareRasterizer::Render(const SoftwareScene& scene, const Camera& camera)
+{
+	DENGINE_PROFILE_SCOPE("software render");
+	this->scene = &scene;
+	const float aspect = static_cast<float>(width) / static_cast<float>(height);
+	viewProjection = glm::perspective(glm::radians(settings.FieldOfView), aspect, settings.NearPlane,
+		settings.FarPlane) * CameraControl::GetLookAtMatrix(camera);
+	cameraPosition = camera.Position;
+
+	const auto& drawItems = scene.GetDrawItems();
+	const auto frustumPlanes = extractFrustumPlanes(viewProjection);
+	visibleDraws.clear();
+	vertexOffsets.assign(1, 0);
+	triangleOffsets.assign(1, 0);
+	for (unsigned int drawIndex = 0; drawIndex < drawItems.size(); drawIndex++)
+	{
+		const auto& drawItem = drawItems[drawIndex];
+		if (!isWorldSphereVisible(frustumPlanes, drawItem.BoundingSphere))
+			continue;
+		visibleDraws.push_back(drawIndex);
+		vertexOffsets.push_back(vertexOffsets.back() + drawItem.SourceMesh->Positions.size());
+		triangleOffsets.push_back(triangleOffsets.back() + drawItem.SourceMesh->Indecies.size() / 3);
+	}
+	statistics = SoftwareRasterizerStatistics{ drawItems.size(), visibleDraws.size(), triangleOffsets.back() };
+
+	{
+		DENGINE_PROFILE_SCOPE("software vertices");
+		vertices.resize(vertexOffsets.back());
+		threadPool.parallelize_loop(size_t{ 0 }, visibleDraws.size(), [this](size_t first, size_t last)
+		{
+			transformVertices(first, last);
+		}, std::min<size_t>(visibleDraws.size(), threadPool.get_thread_count() * 4)).wait();
+	}
+	{
+		DENGINE_PROFILE_SCOPE("software setup");
+		chunkCount = (triangleOffsets.back() + ChunkTriangleCount - 1) / ChunkTriangleCount;
+		if (chunks.size() < chunkCount)
+			chunks.resize(chunkCount);
+		threadPool.parallelize_loop(size_t{ 0 }, chunkCount, [this](size_t first, size_t last)
+		{
+			for (size_t chunkIndex = first; chunkIndex < last; chunkIndex++)
+				setupChunk(chunkIndex);
+		}, chunkCount).wait();
+	}
+	{
+		DENGINE_PROFILE_SCOPE("software tiles");
+		const size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+		threadPool.parallelize_loop(size_t{ 0 }, tileCount, [this](size_t first, size_t last)
+		{
+			for (size_t tileIndex = first; tileIndex < last; tileIndex++)
+				rasterizeTile(tileIndex);
+		}, tileCount).wait();
+	}
+
+	for (size_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+	{
+		statistics.RasterizedTriangles += chunks[chunkIndex].Triangles.size();
+		for (const auto& bin : chunks[chunkIndex].Bins)
+			statistics.BinnedTriangles += bin.size();
+	}
+}
+
+
+const std::pmr::vector<unsigned char>& dengine::SoftwareRasterizer::GetColor() const
+{
+	return color;
+}
+
+
+int dengine::SoftwareRasterizer::GetWidth() const
+{
+	return width;
+}
+
+
+int dengine::SoftwareRasterizer::GetHeight() const
+{
+	return height;
+}
+
+
+dengine::SoftwareRendererSettings& dengine::SoftwareRasterizer::GetSettings()
+{
+	return settings;
+}
+
+
+const dengine::SoftwareRasterizerStatistics& dengine::SoftwareRasterizer::GetStatistics() const
+{
+	return statistics;
+}
+
+
+void dengine::SoftwareRasterizer::transformVertices(size_t firstDraw, size_t lastDraw)
+{
+	const auto& drawItems = scene->GetDrawItems();
+	for (size_t draw = firstDraw; draw < lastDraw; draw++)
+	{
+		const auto& drawItem = drawItems[visibleDraws[draw]];
+		const auto& mesh = *drawItem.SourceMesh;
+		const auto modelMatrix = makeSimdMatrix(drawItem.ModelMatrix);
+		const auto clipMatrix = makeSimdMatrix(viewProjection * drawItem.ModelMatrix);
+		const auto normalMatrix = makeSimdMatrix(glm::mat4(drawItem.NormalMatrix));
+		const bool hasNormals = mesh.Normals.size() == mesh.Positions.size();
+		const bool hasTangents = mesh.Tangents.size() == mesh.Positions.size();
+		const bool hasUVs = mesh.UVs.size() == mesh.Positions.size();
+		//mirrored draws flip bitangent like handedness in pbr.vert
+		const float handedness = glm::determinant(glm::mat3(drawItem.ModelMatrix)) < 0.0f ? -1.0f : 1.0f;
+		Vertex* drawVertices = vertices.data() + vertexOffsets[draw];
+		for (size_t i = 0; i < mesh.Positions.size(); i++)
+		{
+			auto& vertex = drawVertices[i];
+			vertex.ClipPosition = transformSimd(clipMatrix, mesh.Positions[i], 1.0f);
+			vertex.WorldPosition = glm::vec3(transformSimd(modelMatrix, mesh.Positions[i], 1.0f));
+			//tangents go through model matrix and normals through normal matrix like in pbr.vert
+			vertex.Normal = hasNormals ? glm::vec3(transformSimd(normalMatrix, mesh.Normals[i], 0.0f)) : glm::vec3(0.0f);
+			vertex.Tangent = hasTangents ? glm::vec4(glm::vec3(transformSimd(modelMatrix, glm::vec3(mesh.Tangents[i]), 0.0f)),
+				mesh.Tangents[i].w * handedness) : glm::vec4(0.0f);
+			vertex.UV = hasUVs ? mesh.UVs[i] : glm::vec2(0.0f);
+		}
+	}
+}
+
+
+void dengine::SoftwareRasterizer::setupChunk(size_t chunkIndex)
+{
+	auto& chunk = chunks[chunkIndex];
+	chunk.Triangles.clear();
+	chunk.ClippedVertices.clear();
+	chunk.Bins.resize(static_cast<size_t>(tilesX) * tilesY);
+	for (auto& bin : chunk.Bins)
+		bin.clear();
+
+	const size_t first = chunkIndex * ChunkTriangleCount;
+	const size_t last = std::min(first + ChunkTriangleCount, triangleOffsets.back());
+	const auto& drawItems = scene->GetDrawItems();
+	//last draw starting at or before first triangle of chunk
+	size_t draw = std::upper_bound(triangleOffsets.begin(), triangleOffsets.end(), first) - triangleOffsets.begin() - 1;
+	for (size_t triangle = first; triangle < last; triangle++)
+	{
+		while (triangle >= triangleOffsets[draw + 1])
+			draw++;
+		const auto& indices = drawItems[visibleDraws[draw]].SourceMesh->Indecies;
+		const size_t index = (triangle - triangleOffsets[draw]) * 3;
+		const auto vertexOffset = static_cast<unsigned int>(vertexOffsets[draw]);
+		const unsigned int vertexIndices[3] = { vertexOffset + indices[index], vertexOffset + indices[index + 1],
+			vertexOffset + indices[index + 2] };
+		setupTriangle(chunk, static_cast<unsigned int>(draw), vertexIndices);
+	}
+}
+
+
+void dengine::SoftwareRasterizer::setupTriangle(Chunk& chunk, unsigned int drawItem, const unsigned int (&vertexIndices)[3])
+{
+	const Vertex* triangleVertices[3] = { &vertices[vertexIndices[0]], &vertices[vertexIndices[1]],
+		&vertices[vertexIndices[2]] };
+	unsigned int outsideCodes = ~0u;
+	unsigned int clipCodes = 0;
+	for (const auto* vertex : triangleVertices)
+	{
+		outsideCodes &= getClipCodes(vertex->ClipPosition, 1.0f);
+		clipCodes |= getClipCodes(vertex->ClipPosition, GuardBand);
+	}
+	//all vertices outside of same frustum plane
+	if (outsideCodes != 0)
+		return;
+	if (clipCodes == 0)
+	{
+		addTriangle(chunk, drawItem, vertexIndices, triangleVertices);
+		return;
+	}
+
+	//sutherland-hodgman against planes some vertex is outside of, new vertices have no index yet
+	constexpr unsigned int NewVertex = ~0u;
+	Vertex polygons[2][MaxClipVertices];
+	unsigned int polygonIndices[2][MaxClipVertices];
+	int vertexCount = 3;
+	int current = 0;
+	for (int k = 0; k < 3; k++)
+	{
+		polygons[0][k] = *triangleVertices[k];
+		polygonIndices[0][k] = vertexIndices[k];
+	}
+	for (int plane = 0; plane < ClipPlaneCount; plane++)
+	{
+		if ((clipCodes & (1u << plane)) == 0)
+			continue;
+		const auto& polygon = polygons[current];
+		auto& clipped = polygons[1 - current];
+		auto& clippedIndices = polygonIndices[1 - current];
+		int clippedCount = 0;
+		for (int i = 0; i < vertexCount; i++)
+		{
+			const auto& start = polygon[i];
+			const auto& end = polygon[(i + 1) % vertexCount];
+			const float startDistance = getClipDistance(start.ClipPosition, plane, GuardBand);
+			const float endDistance = getClipDistance(end.ClipPosition, plane, GuardBand);
+			if (startDistance >= 0.0f)
+			{
+				clipped[clippedCount] = start;
+				clippedIndices[clippedCount++] = polygonIndices[current][i];
+			}
+			if ((startDistance >= 0.0f) == (endDistance >= 0.0f))
+				continue;
+			//attributes are interpolated linearly in clip space, perspective division happens afterwards
+			const float t = startDistance / (startDistance - endDistance);
+			auto& vertex = clipped[clippedCount];
+			vertex.ClipPosition = glm::mix(start.ClipPosition, end.ClipPosition, t);
+			vertex.WorldPosition = glm::mix(start.WorldPosition, end.WorldPosition, t);
+			vertex.Normal = glm::mix(start.Normal, end.Normal, t);
+			vertex.Tangent = glm::mix(start.Tangent, end.Tangent, t);
+			vertex.UV = glm::mix(start.UV, end.UV, t);
+			clippedIndices[clippedCount++] = NewVertex;
+		}
+		current = 1 - current;
+		vertexCount = clippedCount;
+		if (vertexCount < 3)
+			return;
+	}
+
+	auto& polygon = polygons[current];
+	auto& indices = polygonIndices[current];
+	for (int i = 0; i < vertexCount; i++)
+	{
+		if (indices[i] != NewVertex)
+			continue;
+		indices[i] = static_cast<unsigned int>(chunk.ClippedVertices.size()) | ClippedVertexBit;
+		chunk.ClippedVertices.push_back(polygon[i]);
+	}
+	for (int i = 1; i + 1 < vertexCount; i++)
+	{
+		const unsigned int fanIndices[3] = { indices[0], indices[i], indices[i + 1] };
+		const Vertex* fanVertices[3] = { &polygon[0], &polygon[i], &polygon[i + 1] };
+		addTriangle(chunk, drawItem, fanIndices, fanVertices);
+	}
+}
+
+
+void dengine::SoftwareRasterizer::addTriangle(Chunk& chunk, unsigned int drawItem, const unsigned int (&vertexIndices)[3],
+	const Vertex* (&triangleVertices)[3])
+{
+	Triangle triangle;
+	triangle.DrawItem = drawItem;
+	long long x[3];
+	long long y[3];
+	for (int k = 0; k < 3; k++)
+	{
+		const auto& position = triangleVertices[k]->ClipPosition;
+		const float inverseW = 1.0f / position.w;
+		//rows go from top to bottom, so y of normalized device coordinates is flipped
+		x[k] = std::llround((position.x * inverseW * 0.5f + 0.5f) * width * SubpixelScale);
+		y[k] = std::llround((0.5f - position.y * inverseW * 0.5f) * height * SubpixelScale);
+		triangle.Vertices[k] = vertexIndices[k];
+		triangle.Depth[k] = position.z * inverseW * 0.5f + 0.5f;
+		triangle.InverseW[k] = inverseW;
+	}
+
+	long long doubleArea = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (doubleArea == 0)
+		return;
+	//gl path draws both faces, edge functions are set up for one winding only
+	if (doubleArea < 0)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(triangle.Vertices[1], triangle.Vertices[2]);
+		std::swap(triangle.Depth[1], triangle.Depth[2]);
+		std::swap(triangle.InverseW[1], triangle.InverseW[2]);
+		doubleArea = -doubleArea;
+	}
+
+	//pixels whose centers lie within bounds of vertices
+	constexpr long long halfPixel = SubpixelScale / 2;
+	const auto firstPixel = [](long long coordinate)
+	{
+		return (coordinate - halfPixel + SubpixelScale - 1) >> SubpixelBits;
+	};
+	const auto lastPixel = [](long long coordinate)
+	{
+		return (coordinate - halfPixel) >> SubpixelBits;
+	};
+	triangle.MinX = static_cast<int>(std::max(firstPixel(std::min({ x[0], x[1], x[2] })), 0ll));
+	triangle.MinY = static_cast<int>(std::max(firstPixel(std::min({ y[0], y[1], y[2] })), 0ll));
+	triangle.MaxX = static_cast<int>(std::min(lastPixel(std::max({ x[0], x[1], x[2] })), static_cast<long long>(width - 1)));
+	triangle.MaxY = static_cast<int>(std::min(lastPixel(std::max({ y[0], y[1], y[2] })), static_cast<long long>(height - 1)));
+	if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+		return;
+
+	for (int i = 0; i < 3; i++)
+	{
+		const int a = (i + 1) % 3;
+		const int b = (i + 2) % 3;
+		triangle.EdgeA[i] = y[a] - y[b];
+		triangle.EdgeB[i] = x[b] - x[a];
+		triangle.EdgeC[i] = -triangle.EdgeB[i] * y[a] - triangle.EdgeA[i] * x[a];
+		//top-left rule, pixel center lying exactly on shared edge belongs to only one of its triangles
+		if (!(triangle.EdgeA[i] > 0 || (triangle.EdgeA[i] == 0 && triangle.EdgeB[i] < 0)))
+			triangle.EdgeC[i] -= 1;
+	}
+	triangle.InverseArea = 1.0f / static_cast<float>(doubleArea);
+	chunk.Triangles.push_back(triangle);
+	binTriangle(chunk, static_cast<unsigned int>(chunk.Triangles.size() - 1));
+}
+
+
+void dengine::SoftwareRasterizer::binTriangle(Chunk& chunk, unsigned int triangleIndex)
+{
+	const auto& triangle = chunk.Triangles[triangleIndex];
+	const int firstTileX = triangle.MinX / TileSize;
+	const int firstTileY = triangle.MinY / TileSize;
+	const int lastTileX = triangle.MaxX / TileSize;
+	const int lastTileY = triangle.MaxY / TileSize;
+	const bool singleTile = firstTileX == lastTileX && firstTileY == lastTileY;
+	//tile is skipped when its pixel center most inside of some edge is still outside of it
+	const auto overlapsTile = [&](int tileX, int tileY)
+	{
+		const long long minX = (static_cast<long long>(tileX * TileSize) << SubpixelBits) + SubpixelScale / 2;
+		const long long minY = (static_cast<long long>(tileY * TileSize) << SubpixelBits) + SubpixelScale / 2;
+		const long long maxX = (static_cast<long long>(std::min((tileX + 1) * TileSize, width) - 1) << SubpixelBits) + SubpixelScale / 2;
+		const long long maxY = (static_cast<long long>(std::min((tileY + 1) * TileSize, height) - 1) << SubpixelBits) + SubpixelScale / 2;
+		for (int i = 0; i < 3; i++)
+		{
+			const long long x = triangle.EdgeA[i] > 0 ? maxX : minX;
+			const long long y = triangle.EdgeB[i] > 0 ? maxY : minY;
+			if (triangle.EdgeA[i] * x + triangle.EdgeB[i] * y + triangle.EdgeC[i] < 0)
+				return false;
+		}
+		return true;
+	};
+	for (int tileY = firstTileY; tileY <= lastTileY; tileY++)
+		for (int tileX = firstTileX; tileX <= lastTileX; tileX++)
+			if (singleTile || overlapsTile(tileX, tileY))
+				chunk.Bins[static_cast<size_t>(tileY) * tilesX + tileX].push_back(triangleIndex);
+}
+
+
+void dengine::SoftwareRasterizer::rasterizeTile(size_t tileIndex)
+{
+	const int tileMinX = static_cast<int>(tileIndex % tilesX) * TileSize;
+	const int tileMinY = static_cast<int>(tileIndex / tilesX) * TileSize;
+	const int tileMaxX = std::min(tileMinX + TileSize, width) - 1;
+	const int tileMaxY = std::min(tileMinY + TileSize, height) - 1;
+	for (int y = tileMinY; y <= tileMaxY; y++)
+	{
+		const size_t row = static_cast<size_t>(y) * width;
+		std::fill(depth.begin() + row + tileMinX, depth.begin() + row + tileMaxX + 1, 1.0f);
+		std::fill(visibility.begin() + row + tileMinX, visibility.begin() + row + tileMaxX + 1,
+			TriangleReference{ EmptyPixel, 0 });
+	}
+
+	//chunks and their bins are walked in submission order, so equal depths resolve like on gpu
+	for (unsigned int chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+	{
+		const auto& chunk = chunks[chunkIndex];
+		for (const auto triangleIndex : chunk.Bins[tileIndex])
+		{
+			const auto& triangle = chunk.Triangles[triangleIndex];
+			const int minX = std::max(triangle.MinX, tileMinX);
+			const int minY = std::max(triangle.MinY, tileMinY);
+			const int maxX = std::min(triangle.MaxX, tileMaxX);
+			const int maxY = std::min(triangle.MaxY, tileMaxY);
+			const long long centerX = (static_cast<long long>(minX) << SubpixelBits) + SubpixelScale / 2;
+			const long long centerY = (static_cast<long long>(minY) << SubpixelBits) + SubpixelScale / 2;
+			long long rowEdges[3];
+			for (int i = 0; i < 3; i++)
+				rowEdges[i] = triangle.EdgeA[i] * centerX + triangle.EdgeB[i] * centerY + triangle.EdgeC[i];
+			for (int y = minY; y <= maxY; y++)
+			{
+				long long edge0 = rowEdges[0];
+				long long edge1 = rowEdges[1];
+				long long edge2 = rowEdges[2];
+				size_t pixel = static_cast<size_t>(y) * width + minX;
+				for (int x = minX; x <= maxX; x++, pixel++)
+				{
+					if ((edge0 | edge1 | edge2) >= 0)
+					{
+						const float pixelDepth = (triangle.Depth[0] * static_cast<float>(edge0) +
+							triangle.Depth[1] * static_cast<float>(edge1) +
+							triangle.Depth[2] * static_cast<float>(edge2)) * triangle.InverseArea;
+						if (pixelDepth < depth[pixel])
+						{
+							depth[pixel] = pixelDepth;
+							visibility[pixel] = TriangleReference{ chunkIndex, triangleIndex };
+						}
+					}
+					edge0 += triangle.EdgeA[0] * SubpixelScale;
+					edge1 += triangle.EdgeA[1] * SubpixelScale;
+					edge2 += triangle.EdgeA[2] * SubpixelScale;
+				}
+				for (int i = 0; i < 3; i++)
+					rowEdges[i] += triangle.EdgeB[i] * SubpixelScale;
+			}
+		}
+	}
+
+	//every pixel is shaded once, after its visible triangle is known
+	for (int y = tileMinY; y <= tileMaxY; y++)
+	{
+		for (int x = tileMinX; x <= tileMaxX; x++)
+		{
+			const size_t pixel = static_cast<size_t>(y) * width + x;
+			const auto& reference = visibility[pixel];
+			const glm::vec3 pixelColor = reference.Chunk == EmptyPixel ? settings.ClearColor : shadePixel(x, y, reference);
+			unsigned char* output = color.data() + pixel * 4;
+			output[0] = toColorByte(pixelColor.r);
+			output[1] = toColorByte(pixelColor.g);
+			output[2] = toColorByte(pixelColor.b);
+			output[3] = 255;
+		}
+	}
+}
+
+
+glm::vec3 dengine::SoftwareRasterizer::shadePixel(int x, int y, const TriangleReference& reference) const
+{
+	const auto& chunk = chunks[reference.Chunk];
+	const auto& triangle = chunk.Triangles[reference.Triangle];
+	const auto& material = scene->GetDrawItems()[visibleDraws[triangle.DrawItem]].Material;
+	const Vertex* triangleVertices[3];
+	for (int k = 0; k < 3; k++)
+	{
+		const auto index = triangle.Vertices[k];
+		triangleVertices[k] = (index & ClippedVertexBit) != 0 ? &chunk.ClippedVertices[index & ~ClippedVertexBit] : &vertices[index];
+	}
+
+	//screen space barycentrics divided by w are linear over screen, so are their steps to neighbour pixels
+	const long long centerX = (static_cast<long long>(x) << SubpixelBits) + SubpixelScale / 2;
+	const long long centerY = (static_cast<long long>(y) << SubpixelBits) + SubpixelScale / 2;
+	float weights[3];
+	float weightsDx[3];
+	float weightsDy[3];
+	float inverseW = 0.0f;
+	float inverseWDx = 0.0f;
+	float inverseWDy = 0.0f;
+	for (int i = 0; i < 3; i++)
+	{
+		const float edge = static_cast<float>(triangle.EdgeA[i] * centerX + triangle.EdgeB[i] * centerY + triangle.EdgeC[i]);
+		weights[i] = edge * triangle.InverseArea * triangle.InverseW[i];
+		weightsDx[i] = static_cast<float>(triangle.EdgeA[i] * SubpixelScale) * triangle.InverseArea * triangle.InverseW[i];
+		weightsDy[i] = static_cast<float>(triangle.EdgeB[i] * SubpixelScale) * triangle.InverseArea * triangle.InverseW[i];
+		inverseW += weights[i];
+		inverseWDx += weightsDx[i];
+		inverseWDy += weightsDy[i];
+	}
+	const float w = 1.0f / inverseW;
+	glm::vec3 position(0.0f);
+	glm::vec3 normal(0.0f);
+	glm::vec4 tangent(0.0f);
+	glm::vec2 uv(0.0f);
+	glm::vec2 uvOverWDx(0.0f);
+	glm::vec2 uvOverWDy(0.0f);
+	for (int i = 0; i < 3; i++)
+	{
+		const float weight = weights[i] * w;
+		position += triangleVertices[i]->WorldPosition * weight;
+		normal += triangleVertices[i]->Normal * weight;
+		tangent += triangleVertices[i]->Tangent * weight;
+		uv += triangleVertices[i]->UV * weight;
+		uvOverWDx += triangleVertices[i]->UV * weightsDx[i];
+		uvOverWDy += triangleVertices[i]->UV * weightsDy[i];
+	}
+	//quotient rule on uv / w over 1 / w gives exact uv change per pixel, which selects mip level
+	const glm::vec2 uvDx = (uvOverWDx - uv * inverseWDx) * w;
+	const glm::vec2 uvDy = (uvOverWDy - uv * inverseWDy) * w;
+	const auto sample = [&](const SoftwareTexture& texture)
+	{
+		return glm::vec3(texture.Sample(uv, texture.GetLod(uvDx, uvDy)));
+	};
+
+	const glm::vec3 viewDirection = glm::normalize(cameraPosition - position);
+	glm::vec3 N = glm::dot(normal, normal) > 0.0f ? glm::normalize(normal) : viewDirection;
+	//world space tbn instead of moving view and lights into tangent space, same result
+	if (material.Normal != nullptr)
+		N = perturbNormal(N, tangent, sample(*material.Normal));
+	const glm::vec3 albedo = material.Albedo != nullptr ? sample(*material.Albedo) : glm::vec3(0.8f);
+	const glm::vec3 metalness = material.Metalness != nullptr ? sample(*material.Metalness) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const auto& lights = scene->GetLights();
+
+	if (settings.Shading == SoftwareShading::BlinnPhong)
+	{
+		//port of blin-fong.frag
+		const float specularMask = material.Metalness != nullptr ? metalness.b : 1.0f;
+		glm::vec3 diffuse(0.0f);
+		glm::vec3 specular(0.0f);
+		for (const auto& light : lights)
+		{
+			const glm::vec3 lightDirection = glm::normalize(glm::vec3(light.Position) - position);
+			diffuse += std::max(glm::dot(N, lightDirection), 0.0f) * glm::vec3(light.Color);
+			const glm::vec3 reflected = glm::reflect(-lightDirection, N);
+			specular += std::pow(std::max(glm::dot(viewDirection, reflected), 0.0f), static_cast<float>(settings.SpecularPower)) *
+				glm::vec3(light.Color) * specularMask;
+		}
+		return (glm::vec3(settings.AmbientStrength) + settings.DiffuseStrength * diffuse +
+			settings.SpecularStrength * specular) * albedo;
+	}
+
+	//port of pbr.frag without image based lighting and shadows, ambient is its fallback without environment
+	const float metallic = metalness.b;
+	const float roughness = metalness.g;
+	glm::vec3 outgoing(0.0f);
+	for (const auto& light : lights)
+	{
+		const glm::vec3 toLight = glm::vec3(light.Position) - position;
+		const float distanceSquared = glm::dot(toLight, toLight);
+		const glm::vec3 lightDirection = toLight / std::sqrt(distanceSquared);
+		const glm::vec3 radiance = glm::vec3(light.Color) * light.Color.a / distanceSquared;
+		if (settings.Shading == SoftwareShading::Lambert)
+			outgoing += (1.0f - metallic) * albedo / SoftwarePi * radiance * std::max(glm::dot(N, lightDirection), 0.0f);
+		else
+			outgoing += evaluateCookTorrance(N, viewDirection, lightDirection, albedo, metallic, roughness) * radiance;
+	}
+	const auto& sun = scene->GetSun();
+	if (sun.Color.a > 0.0f)
+	{
+		const glm::vec3 lightDirection = -glm::vec3(sun.Direction);
+		const glm::vec3 radiance = glm::vec3(sun.Color) * sun.Color.a;
+		if (settings.Shading == SoftwareShading::Lambert)
+			outgoing += (1.0f - metallic) * albedo / SoftwarePi * radiance * std::max(glm::dot(N, lightDirection), 0.0f);
+		else
+			outgoing += evaluateCookTorrance(N, viewDirection, lightDirection, albedo, metallic, roughness) * radiance;
+	}
+	return glm::vec3(0.02f) * albedo + outgoing;
+}
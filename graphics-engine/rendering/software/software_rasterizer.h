@@ -0,0 +1,136 @@
+#ifndef SOFTWARE_RASTERIZER_INCLUDED
+#define SOFTWARE_RASTERIZER_INCLUDED
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <BS_thread_pool.hpp>
+#include <rendering/camera.hpp>
+#include <rendering/software/software_scene.h>
+
+namespace dengine
+{
+	enum class SoftwareShading {
+		CookTorrance,
+		Lambert,
+		BlinnPhong,
+	};
+
+	struct SoftwareRendererSettings {
+		SoftwareShading Shading{ SoftwareShading::CookTorrance };
+		glm::vec3 ClearColor{ 33.0f / 255.0f, 33.0f / 255.0f, 33.0f / 255.0f };
+		float FieldOfView{ 55.0f };
+		float NearPlane{ 0.01f };
+		float FarPlane{ 100.0f };
+		//light settings of blinn-phong shading
+		float AmbientStrength{ 0.1f };
+		float DiffuseStrength{ 1.0f };
+		float SpecularStrength{ 0.5f };
+		int SpecularPower{ 32 };
+	};
+
+	struct SoftwareRasterizerStatistics {
+		size_t DrawItems{ 0 };
+		size_t VisibleDrawItems{ 0 };
+		size_t Triangles{ 0 };
+		//set up triangles left after culling, clipping and dropping of degenerate ones
+		size_t RasterizedTriangles{ 0 };
+		//triangle references over all tile bins
+		size_t BinnedTriangles{ 0 };
+	};
+
+
+	//renders software scene on thread pool in three passes: vertices of visible draw items are transformed,
+	//triangle chunks are set up and binned into screen tiles, then every tile resolves depth of its bins into
+	//a visibility buffer and shades each covered pixel once
+	class SoftwareRasterizer {
+	public:
+		explicit SoftwareRasterizer(BS::thread_pool& threadPool);
+		SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+		SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+		void Resize(int width, int height);
+		void Render(const SoftwareScene& scene, const Camera& camera);
+		//rgba8 rows from top to bottom, as image files store them
+		const std::pmr::vector<unsigned char>& GetColor() const;
+		int GetWidth() const;
+		int GetHeight() const;
+		SoftwareRendererSettings& GetSettings();
+		const SoftwareRasterizerStatistics& GetStatistics() const;
+	private:
+		struct Vertex {
+			glm::vec4 ClipPosition;
+			glm::vec3 WorldPosition;
+			glm::vec3 Normal;
+			//w is bitangent sign
+			glm::vec4 Tangent;
+			glm::vec2 UV;
+		};
+
+		struct Triangle {
+			//index into transformed vertices, or into clipped vertices of chunk when ClippedVertexBit is set
+			unsigned int Vertices[3];
+			//index into visible draw items
+			unsigned int DrawItem;
+			//edge functions a * x + b * y + c over subpixel coordinates, edge i is opposite of vertex i,
+			//so its value is barycentric weight of vertex i times twice the area
+			long long EdgeA[3];
+			long long EdgeB[3];
+			long long EdgeC[3];
+			float InverseArea;
+			float Depth[3];
+			float InverseW[3];
+			//inclusive pixel bounds clamped to screen
+			int MinX;
+			int MinY;
+			int MaxX;
+			int MaxY;
+		};
+
+		//consecutive triangles set up by one worker, bins keep submission order within chunk
+		struct Chunk {
+			std::pmr::vector<Triangle> Triangles;
+			std::pmr::vector<Vertex> ClippedVertices;
+			std::pmr::vector<std::pmr::vector<unsigned int>> Bins;
+		};
+
+		struct TriangleReference {
+			unsigned int Chunk;
+			unsigned int Triangle;
+		};
+
+		void transformVertices(size_t firstDraw, size_t lastDraw);
+		void setupChunk(size_t chunkIndex);
+		void setupTriangle(Chunk& chunk, unsigned int drawItem, const unsigned int (&vertexIndices)[3]);
+		void addTriangle(Chunk& chunk, unsigned int drawItem, const unsigned int (&vertexIndices)[3],
+			const Vertex* (&triangleVertices)[3]);
+		void binTriangle(Chunk& chunk, unsigned int triangleIndex);
+		void rasterizeTile(size_t tileIndex);
+		glm::vec3 shadePixel(int x, int y, const TriangleReference& reference) const;
+
+		BS::thread_pool& threadPool;
+		SoftwareRendererSettings settings;
+		SoftwareRasterizerStatistics statistics;
+		int width{ 0 };
+		int height{ 0 };
+		int tilesX{ 0 };
+		int tilesY{ 0 };
+		std::pmr::vector<unsigned char> color;
+		std::pmr::vector<float> depth;
+		std::pmr::vector<TriangleReference> visibility;
+
+		//per frame state shared by passes
+		const SoftwareScene* scene{ nullptr };
+		glm::mat4 viewProjection{ 1.0f };
+		glm::vec3 cameraPosition{ 0.0f };
+		std::pmr::vector<unsigned int> visibleDraws;
+		//prefix sums over visible draws, one extra element holds total
+		std::pmr::vector<size_t> vertexOffsets;
+		std::pmr::vector<size_t> triangleOffsets;
+		std::pmr::vector<Vertex> vertices;
+		std::pmr::vector<Chunk> chunks;
+		size_t chunkCount{ 0 };
+	};
+}
+
+#endif
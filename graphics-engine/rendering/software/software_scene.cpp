@@ -0,0 +1,163 @@
+#include <rendering/software/software_scene.h>
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/transform.hpp>
+#include <profiling/profiler.h>
+
+
+//cofactor matrix like in pbr.vert, points same way as inverse transpose and has no infinities for zero scale
+glm::mat3 getNormalMatrix(const glm::mat4& modelMatrix)
+{
+	const glm::mat3 model(modelMatrix);
+	const glm::mat3 cofactors(glm::cross(model[1], model[2]), glm::cross(model[2], model[0]), glm::cross(model[0], model[1]));
+	return glm::dot(model[0], cofactors[0]) < 0.0f ? -cofactors : cofactors;
+}
+
+
+const dengine::SoftwareTexture* getMaterialTexture(const std::pmr::vector<dengine::SoftwareTexture>& textures,
+	int textureIndex)
+{
+	return textureIndex >= 0 && textureIndex < textures.size() ? &textures[textureIndex] : nullptr;
+}
+
+
+dengine::SoftwareScene::SoftwareScene(IModelImporter& modelImporter) : modelImporter(modelImporter)
+{
+}
+
+
+bool dengine::SoftwareScene::Load(const std::pmr::string& path)
+{
+	//a plain model is treated as scene with single instance, like SceneRenderer does
+	SceneDescription sceneDescription;
+	if (isSceneDescriptionFile(path))
+	{
+		if (!loadSceneDescription(path, sceneDescription))
+			return false;
+	}
+	else
+	{
+		sceneDescription.Models.push_back(SceneModel{ path });
+		sceneDescription.Instances.push_back(SceneInstance{});
+	}
+	if (sceneDescription.Lights.empty())
+		sceneDescription.Lights.push_back(SceneLight{ glm::vec4(5, 3, 1, 0), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f) });
+	if (!sceneDescription.Sun)
+		sceneDescription.Sun = SceneDirectionalLight{ glm::vec4(-0.4f, -1.0f, -0.3f, 0.0f), glm::vec4(1.0f) };
+	if (!sceneDescription.EnvironmentMap.empty())
+		spdlog::get("app_logger")->info("Software renderer ignores environment {}, ambient stays flat",
+			sceneDescription.EnvironmentMap.c_str());
+	return Build(sceneDescription);
+}
+
+
+bool dengine::SoftwareScene::Build(const SceneDescription& sceneDescription)
+{
+	DENGINE_PROFILE_SCOPE("build software scene");
+	drawItems.clear();
+	lights.clear();
+	//sized once, draw items keep pointers into models
+	models.clear();
+	models.resize(sceneDescription.Models.size());
+	for (size_t i = 0; i < sceneDescription.Models.size(); i++)
+		if (!loadModel(sceneDescription.Models[i], models[i]))
+		{
+			models.clear();
+			return false;
+		}
+
+	for (auto& instance : sceneDescription.Instances)
+		if (instance.ModelIndex < models.size())
+			instantiate(models[instance.ModelIndex], instance);
+	for (auto& light : sceneDescription.Lights)
+		lights.push_back(LightInfo{ light.Position, light.Color });
+	sun = DirectionalLight{};
+	if (sceneDescription.Sun)
+		sun = DirectionalLight{ glm::vec4(glm::normalize(glm::vec3(sceneDescription.Sun->Direction)), 0.0f),
+			sceneDescription.Sun->Color };
+	return true;
+}
+
+
+const std::pmr::vector<dengine::SoftwareDrawItem>& dengine::SoftwareScene::GetDrawItems() const
+{
+	return drawItems;
+}
+
+
+const std::pmr::vector<dengine::LightInfo>& dengine::SoftwareScene::GetLights() const
+{
+	return lights;
+}
+
+
+const dengine::DirectionalLight& dengine::SoftwareScene::GetSun() const
+{
+	return sun;
+}
+
+
+size_t dengine::SoftwareScene::GetTriangleCount() const
+{
+	size_t triangleCount = 0;
+	for (auto& drawItem : drawItems)
+		triangleCount += drawItem.SourceMesh->Indecies.size() / 3;
+	return triangleCount;
+}
+
+
+bool dengine::SoftwareScene::loadModel(const SceneModel& sceneModel, LoadedModel& loadedModel)
+{
+	loadedModel.CpuModel = modelImporter.Import(sceneModel.Path);
+	if (loadedModel.CpuModel.Meshes.empty())
+		return false;
+
+	loadedModel.Textures.reserve(loadedModel.CpuModel.Textures.size());
+	for (auto& texture : loadedModel.CpuModel.Textures)
+		loadedModel.Textures.emplace_back(texture);
+	//mip chains hold their own copy of base level
+	loadedModel.CpuModel.Textures.clear();
+	loadedModel.CpuModel.Textures.shrink_to_fit();
+	for (auto& material : loadedModel.CpuModel.Materials)
+		loadedModel.Materials.push_back(SoftwareMaterial{
+			getMaterialTexture(loadedModel.Textures, material.DiffuseTextureIndex),
+			getMaterialTexture(loadedModel.Textures, material.NormalTextureIndex),
+			getMaterialTexture(loadedModel.Textures, material.MetalnessTextureIndex),
+		});
+	return true;
+}
+
+
+void dengine::SoftwareScene::instantiate(const LoadedModel& loadedModel, const SceneInstance& instance)
+{
+	const glm::mat4 instanceMatrix = glm::translate(instance.Position) * glm::mat4_cast(instance.Rotation) *
+		glm::scale(instance.Scale);
+	const auto& materials = loadedModel.Materials;
+
+	//parents precede children, so world matrices resolve in one pass
+	const auto& nodes = loadedModel.CpuModel.Nodes;
+	std::pmr::vector<glm::mat4> worldMatrices(nodes.size());
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		const auto& node = nodes[i];
+		worldMatrices[i] = (node.Parent >= 0 ? worldMatrices[node.Parent] : instanceMatrix) * node.LocalTransform;
+		const float maxScale = std::max({ glm::length(glm::vec3(worldMatrices[i][0])),
+			glm::length(glm::vec3(worldMatrices[i][1])), glm::length(glm::vec3(worldMatrices[i][2])) });
+		for (auto meshIndex : node.MeshIndices)
+		{
+			const auto& mesh = loadedModel.CpuModel.Meshes[meshIndex];
+			const bool overrideMaterial = instance.MaterialOverride >= 0 && instance.MaterialOverride < materials.size();
+			const auto materialIndex = overrideMaterial ? instance.MaterialOverride : mesh.MaterialIndex;
+			const auto& bounds = mesh.BoundingSphere;
+			drawItems.push_back(SoftwareDrawItem{
+				&mesh,
+				materialIndex < materials.size() ? materials[materialIndex] : SoftwareMaterial{},
+				worldMatrices[i],
+				getNormalMatrix(worldMatrices[i]),
+				glm::vec4(glm::vec3(worldMatrices[i] * glm::vec4(glm::vec3(bounds), 1.0f)), bounds.w * maxScale),
+			});
+		}
+	}
+}
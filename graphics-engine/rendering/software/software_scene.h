@@ -0,0 +1,66 @@
+#ifndef SOFTWARE_SCENE_INCLUDED
+#define SOFTWARE_SCENE_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <importers/model_importer.h>
+#include <rendering/global_environment.h>
+#include <rendering/software/software_texture.h>
+#include <scene/scene_description.h>
+
+namespace dengine
+{
+	//null maps fall back to same constants as pbr variants without them
+	struct SoftwareMaterial {
+		const SoftwareTexture* Albedo{ nullptr };
+		const SoftwareTexture* Normal{ nullptr };
+		const SoftwareTexture* Metalness{ nullptr };
+	};
+
+	struct SoftwareDrawItem {
+		const Mesh* SourceMesh;
+		SoftwareMaterial Material;
+		glm::mat4 ModelMatrix;
+		//transforms normals, stays perpendicular to surface under non-uniform scale; not normalized
+		glm::mat3 NormalMatrix;
+		//world space, xyz center and w radius
+		glm::vec4 BoundingSphere;
+	};
+
+
+	//cpu side counterpart of SceneBuilder, expands same scene files and model node trees into flat draw items
+	//which keep pointing at imported meshes and textures
+	class SoftwareScene {
+	public:
+		explicit SoftwareScene(IModelImporter& modelImporter);
+		SoftwareScene(const SoftwareScene&) = delete;
+		SoftwareScene& operator=(const SoftwareScene&) = delete;
+
+		//model file or .dscene scene description, replaces previously loaded scene
+		bool Load(const std::pmr::string& path);
+		bool Build(const SceneDescription& sceneDescription);
+		const std::pmr::vector<SoftwareDrawItem>& GetDrawItems() const;
+		const std::pmr::vector<LightInfo>& GetLights() const;
+		const DirectionalLight& GetSun() const;
+		size_t GetTriangleCount() const;
+	private:
+		struct LoadedModel {
+			Model CpuModel;
+			std::pmr::vector<SoftwareTexture> Textures;
+			std::pmr::vector<SoftwareMaterial> Materials;
+		};
+
+		bool loadModel(const SceneModel& sceneModel, LoadedModel& loadedModel);
+		void instantiate(const LoadedModel& loadedModel, const SceneInstance& instance);
+
+		IModelImporter& modelImporter;
+		std::pmr::vector<LoadedModel> models;
+		std::pmr::vector<SoftwareDrawItem> drawItems;
+		std::pmr::vector<LightInfo> lights;
+		DirectionalLight sun;
+	};
+}
+
+#endif
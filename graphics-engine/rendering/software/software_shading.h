@@ -0,0 +1,70 @@
+#ifndef SOFTWARE_SHADING_INCLUDED
+#define SOFTWARE_SHADING_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+namespace dengine
+{
+	constexpr float SoftwarePi = 3.14159265359f;
+
+	//cpu copies of shading terms in pbr.frag, shared by software rasterizer and path tracer so both match gpu
+	inline float distributionGgx(float NdotH, float roughness)
+	{
+		const float a = roughness * roughness;
+		const float a2 = a * a;
+		const float denominator = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+		return a2 / (SoftwarePi * denominator * denominator);
+	}
+
+
+	inline float geometrySchlickGgx(float NdotV, float roughness)
+	{
+		const float r = roughness + 1.0f;
+		const float k = r * r / 8.0f;
+		return NdotV / (NdotV * (1.0f - k) + k);
+	}
+
+
+	inline glm::vec3 fresnelSchlick(float cosTheta, const glm::vec3& F0)
+	{
+		return F0 + (glm::vec3(1.0f) - F0) * std::pow(std::clamp(1.0f - cosTheta, 0.0f, 1.0f), 5.0f);
+	}
+
+
+	//cook-torrance brdf times cosine of light, light and view directions point away from surface
+	inline glm::vec3 evaluateCookTorrance(const glm::vec3& N, const glm::vec3& V, const glm::vec3& L,
+		const glm::vec3& albedo, float metallic, float roughness)
+	{
+		const float NdotL = std::max(glm::dot(N, L), 0.0f);
+		if (NdotL == 0.0f)
+			return glm::vec3(0.0f);
+		const float NdotV = std::max(glm::dot(N, V), 0.0f);
+		const glm::vec3 F0 = glm::mix(glm::vec3(0.04f), albedo, metallic);
+		const glm::vec3 H = glm::normalize(V + L);
+		const float NDF = distributionGgx(std::max(glm::dot(N, H), 0.0f), roughness);
+		const float G = geometrySchlickGgx(NdotV, roughness) * geometrySchlickGgx(NdotL, roughness);
+		const glm::vec3 F = fresnelSchlick(std::max(glm::dot(H, V), 0.0f), F0);
+		const glm::vec3 kD = (glm::vec3(1.0f) - F) * (1.0f - metallic);
+		const glm::vec3 specular = NDF * G * F / (4.0f * NdotV * NdotL + 0.0001f);
+		return (kD * albedo / SoftwarePi + specular) * NdotL;
+	}
+
+
+	//tangent space normal from map is moved to world space by tbn, tangent is orthogonalized against normal first,
+	//w of tangent is bitangent sign already including mirrored model matrix
+	inline glm::vec3 perturbNormal(const glm::vec3& N, const glm::vec4& tangent, const glm::vec3& mappedNormal)
+	{
+		const glm::vec3 orthogonalTangent = glm::vec3(tangent) - N * glm::dot(N, glm::vec3(tangent));
+		if (glm::dot(orthogonalTangent, orthogonalTangent) == 0.0f)
+			return N;
+		const glm::vec3 T = glm::normalize(orthogonalTangent);
+		const glm::vec3 B = glm::cross(N, T) * (tangent.w < 0.0f ? -1.0f : 1.0f);
+		const glm::vec3 mapped = glm::normalize(mappedNormal * 2.0f - 1.0f);
+		return glm::normalize(T * mapped.x + B * mapped.y + N * mapped.z);
+	}
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include <rendering/software/software_texture.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <rendering/texture_streamer.h>
+
+constexpr int TexelSize = 4;
+
+
+int wrapCoordinate(int coordinate, int size)
+{
+	const int wrapped = coordinate % size;
+	return wrapped < 0 ? wrapped + size : wrapped;
+}
+
+
+dengine::SoftwareTexture::SoftwareTexture(const Texture& texture)
+{
+	if (texture.Width <= 0 || texture.Height <= 0)
+		return;
+	//importer expands every texture to rgba, same data gpu path uploads
+	size_t size = 0;
+	for (int width = texture.Width, height = texture.Height;; width = std::max(width / 2, 1), height = std::max(height / 2, 1))
+	{
+		levels.push_back(Level{ width, height, size });
+		size += static_cast<size_t>(width) * height * TexelSize;
+		if (width == 1 && height == 1)
+			break;
+	}
+	texels.resize(size);
+	std::memcpy(texels.data(), texture.Data.data(), static_cast<size_t>(texture.Width) * texture.Height * TexelSize);
+
+	//same box filter as streamed gpu textures
+	for (size_t i = 1; i < levels.size(); i++)
+	{
+		const auto& source = levels[i - 1];
+		downsampleTextureLevel(texels.data() + source.Offset, source.Width, source.Height, texels.data() + levels[i].Offset);
+	}
+}
+
+
+glm::vec4 dengine::SoftwareTexture::Sample(glm::vec2 uv, float lod) const
+{
+	if (levels.empty())
+		return glm::vec4(1.0f);
+	lod = std::clamp(lod, 0.0f, static_cast<float>(levels.size() - 1));
+	const auto baseLevel = static_cast<size_t>(lod);
+	const float blend = lod - static_cast<float>(baseLevel);
+	const auto color = sampleBilinear(levels[baseLevel], uv);
+	if (blend == 0.0f || baseLevel + 1 == levels.size())
+		return color;
+	return color + (sampleBilinear(levels[baseLevel + 1], uv) - color) * blend;
+}
+
+
+float dengine::SoftwareTexture::GetLod(glm::vec2 uvDx, glm::vec2 uvDy) const
+{
+	if (levels.empty())
+		return 0.0f;
+	const glm::vec2 size(static_cast<float>(levels[0].Width), static_cast<float>(levels[0].Height));
+	const auto texelDx = uvDx * size;
+	const auto texelDy = uvDy * size;
+	const float footprint = std::max(glm::dot(texelDx, texelDx), glm::dot(texelDy, texelDy));
+	//half of log2 of squared length
+	return footprint > 0.0f ? 0.5f * std::log2(footprint) : 0.0f;
+}
+
+
+glm::vec4 dengine::SoftwareTexture::sampleBilinear(const Level& level, glm::vec2 uv) const
+{
+	const float x = uv.x * static_cast<float>(level.Width) - 0.5f;
+	const float y = uv.y * static_cast<float>(level.Height) - 0.5f;
+	const float floorX = std::floor(x), floorY = std::floor(y);
+	const float blendX = x - floorX, blendY = y - floorY;
+	const int x0 = wrapCoordinate(static_cast<int>(floorX), level.Width);
+	const int y0 = wrapCoordinate(static_cast<int>(floorY), level.Height);
+	const int x1 = x0 + 1 == level.Width ? 0 : x0 + 1;
+	const int y1 = y0 + 1 == level.Height ? 0 : y0 + 1;
+
+	const unsigned char* levelTexels = texels.data() + level.Offset;
+	const auto fetch = [&](int texelX, int texelY)
+	{
+		const unsigned char* texel = levelTexels + (static_cast<size_t>(texelY) * level.Width + texelX) * TexelSize;
+		return glm::vec4(texel[0], texel[1], texel[2], texel[3]);
+	};
+	const auto top = fetch(x0, y0) + (fetch(x1, y0) - fetch(x0, y0)) * blendX;
+	const auto bottom = fetch(x0, y1) + (fetch(x1, y1) - fetch(x0, y1)) * blendX;
+	return (top + (bottom - top) * blendY) * (1.0f / 255.0f);
+}
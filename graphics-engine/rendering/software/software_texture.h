@@ -0,0 +1,37 @@
+#ifndef SOFTWARE_TEXTURE_INCLUDED
+#define SOFTWARE_TEXTURE_INCLUDED
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <importers/model_importer.h>
+
+namespace dengine
+{
+	//rgba8 texture with full box filtered mip chain, sampled with repeat wrapping and trilinear filtering
+	//like scene textures on gpu
+	class SoftwareTexture {
+	public:
+		SoftwareTexture() = default;
+		explicit SoftwareTexture(const Texture& texture);
+
+		//lod is log2 of texels per pixel, clamped to mip chain
+		glm::vec4 Sample(glm::vec2 uv, float lod) const;
+		//lod of pixel footprint, derivatives are uv change per pixel step
+		float GetLod(glm::vec2 uvDx, glm::vec2 uvDy) const;
+	private:
+		struct Level {
+			int Width;
+			int Height;
+			size_t Offset;
+		};
+
+		glm::vec4 sampleBilinear(const Level& level, glm::vec2 uv) const;
+
+		std::pmr::vector<Level> levels;
+		//all levels back to back, 4 bytes per texel
+		std::pmr::vector<unsigned char> texels;
+	};
+}
+
+#endif
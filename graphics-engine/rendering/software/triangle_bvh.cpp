@@ -0,0 +1,484 @@
+#include <rendering/software/triangle_bvh.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <profiling/profiler.h>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define DENGINE_BVH_SSE
+#endif
+
+
+constexpr int SahBinCount = 16;
+//leaves are never bigger, even when splitting costs more by heuristic
+constexpr unsigned int MaxLeafTriangles = 8;
+//deeper nodes become leaves, bounds traversal stack
+constexpr unsigned int MaxBuildDepth = 64;
+constexpr size_t TraversalStackSize = MaxBuildDepth * 3 + 1;
+//top of tree is split serially until subtrees are this small or there are enough of them for every worker
+constexpr size_t MinParallelSubtree = 4096;
+constexpr unsigned int EmptyChild = std::numeric_limits<unsigned int>::max();
+constexpr float Infinity = std::numeric_limits<float>::infinity();
+
+
+float getBoundsArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	const glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+
+dengine::TriangleBvh::TriangleBvh(BS::thread_pool& threadPool) : threadPool(threadPool)
+{
+}
+
+
+void dengine::TriangleBvh::Build(const SoftwareScene& scene)
+{
+	DENGINE_PROFILE_SCOPE("build bvh");
+	const auto& drawItems = scene.GetDrawItems();
+	std::pmr::vector<size_t> triangleOffsets(drawItems.size() + 1, 0);
+	for (size_t i = 0; i < drawItems.size(); i++)
+		triangleOffsets[i + 1] = triangleOffsets[i] + drawItems[i].SourceMesh->Indecies.size() / 3;
+	const size_t triangleCount = triangleOffsets.back();
+	triangles.resize(triangleCount);
+	sources.resize(triangleCount);
+	primitiveBounds.resize(triangleCount);
+	primitiveIndices.resize(triangleCount);
+	wideNodes.clear();
+
+	//vertices are moved to world space once, instances of same mesh get their own triangles
+	threadPool.parallelize_loop(size_t{ 0 }, drawItems.size(), [&](size_t first, size_t last)
+	{
+		for (size_t draw = first; draw < last; draw++)
+		{
+			const auto& mesh = *drawItems[draw].SourceMesh;
+			const auto& modelMatrix = drawItems[draw].ModelMatrix;
+			for (size_t triangle = 0; triangle < mesh.Indecies.size() / 3; triangle++)
+			{
+				glm::vec3 positions[3];
+				for (int k = 0; k < 3; k++)
+					positions[k] = glm::vec3(modelMatrix * glm::vec4(mesh.Positions[mesh.Indecies[triangle * 3 + k]], 1.0f));
+				const size_t index = triangleOffsets[draw] + triangle;
+				triangles[index] = Triangle{ positions[0], positions[1] - positions[0], positions[2] - positions[0] };
+				sources[index] = TriangleSource{ static_cast<unsigned int>(draw), static_cast<unsigned int>(triangle) };
+				const glm::vec3 boundsMin = glm::min(positions[0], glm::min(positions[1], positions[2]));
+				const glm::vec3 boundsMax = glm::max(positions[0], glm::max(positions[1], positions[2]));
+				primitiveBounds[index] = PrimitiveBounds{ boundsMin, boundsMax, (boundsMin + boundsMax) * 0.5f };
+				primitiveIndices[index] = static_cast<unsigned int>(index);
+			}
+		}
+	}).wait();
+	if (triangleCount == 0)
+		return;
+
+	std::pmr::vector<BuildNode> nodes(1);
+	nodes[0] = BuildNode{ glm::vec3(0.0f), glm::vec3(0.0f), 0, static_cast<unsigned int>(triangleCount), 0 };
+	computeBounds(0, nodes[0].Count, nodes[0].BoundsMin, nodes[0].BoundsMax);
+
+	//serial splits of top levels leave disjoint ranges of primitives that workers split further on their own
+	const size_t parallelSubtree = std::max(triangleCount / (threadPool.get_thread_count() * 4 + 1), MinParallelSubtree);
+	std::pmr::vector<unsigned int> subtreeRoots;
+	std::pmr::vector<unsigned int> pendingNodes{ 0 };
+	while (!pendingNodes.empty())
+	{
+		const auto nodeIndex = pendingNodes.back();
+		pendingNodes.pop_back();
+		if (nodes[nodeIndex].Count <= parallelSubtree)
+			subtreeRoots.push_back(nodeIndex);
+		else if (splitNode(nodes, nodeIndex))
+		{
+			pendingNodes.push_back(nodes[nodeIndex].First);
+			pendingNodes.push_back(nodes[nodeIndex].First + 1);
+		}
+	}
+
+	std::pmr::vector<std::pmr::vector<BuildNode>> subtrees(subtreeRoots.size());
+	threadPool.parallelize_loop(size_t{ 0 }, subtreeRoots.size(), [&](size_t first, size_t last)
+	{
+		for (size_t subtree = first; subtree < last; subtree++)
+		{
+			auto& subtreeNodes = subtrees[subtree];
+			subtreeNodes.push_back(nodes[subtreeRoots[subtree]]);
+			std::pmr::vector<unsigned int> subtreePending{ 0 };
+			while (!subtreePending.empty())
+			{
+				const auto nodeIndex = subtreePending.back();
+				subtreePending.pop_back();
+				if (splitNode(subtreeNodes, nodeIndex))
+				{
+					subtreePending.push_back(subtreeNodes[nodeIndex].First);
+					subtreePending.push_back(subtreeNodes[nodeIndex].First + 1);
+				}
+			}
+		}
+	}, subtreeRoots.size()).wait();
+
+	//subtree root replaces its placeholder, other nodes are appended with child indices moved to their new place
+	for (size_t subtree = 0; subtree < subtreeRoots.size(); subtree++)
+	{
+		const auto& subtreeNodes = subtrees[subtree];
+		const auto base = static_cast<unsigned int>(nodes.size()) - 1;
+		for (size_t i = 0; i < subtreeNodes.size(); i++)
+		{
+			auto node = subtreeNodes[i];
+			if (node.Count == 0)
+				node.First += base;
+			if (i == 0)
+				nodes[subtreeRoots[subtree]] = node;
+			else
+				nodes.push_back(node);
+		}
+	}
+
+	//leaves reference contiguous triangle ranges after reordering by final primitive order
+	std::pmr::vector<Triangle> orderedTriangles(triangleCount);
+	std::pmr::vector<TriangleSource> orderedSources(triangleCount);
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		orderedTriangles[i] = triangles[primitiveIndices[i]];
+		orderedSources[i] = sources[primitiveIndices[i]];
+	}
+	triangles = std::move(orderedTriangles);
+	sources = std::move(orderedSources);
+	collapseNode(nodes, 0);
+	primitiveBounds.clear();
+	primitiveIndices.clear();
+}
+
+
+bool dengine::TriangleBvh::Intersect(const BvhRay& ray, BvhHit& hit) const
+{
+	return traverse<false>(ray, hit);
+}
+
+
+bool dengine::TriangleBvh::IsOccluded(const BvhRay& ray) const
+{
+	BvhHit hit;
+	return traverse<true>(ray, hit);
+}
+
+
+size_t dengine::TriangleBvh::GetTriangleCount() const
+{
+	return triangles.size();
+}
+
+
+size_t dengine::TriangleBvh::GetNodeCount() const
+{
+	return wideNodes.size();
+}
+
+
+bool dengine::TriangleBvh::splitNode(std::pmr::vector<BuildNode>& nodes, unsigned int nodeIndex)
+{
+	const auto node = nodes[nodeIndex];
+	if (node.Count <= 1 || node.Depth >= MaxBuildDepth)
+		return false;
+
+	glm::vec3 centroidMin(Infinity);
+	glm::vec3 centroidMax(-Infinity);
+	for (unsigned int i = node.First; i < node.First + node.Count; i++)
+	{
+		centroidMin = glm::min(centroidMin, primitiveBounds[primitiveIndices[i]].Centroid);
+		centroidMax = glm::max(centroidMax, primitiveBounds[primitiveIndices[i]].Centroid);
+	}
+	const glm::vec3 centroidExtent = centroidMax - centroidMin;
+
+	//cost of split relative to leaf, traversal step and triangle test are weighted equally
+	float bestCost = Infinity;
+	int bestAxis = -1;
+	int bestSplit = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (centroidExtent[axis] <= 0.0f)
+			continue;
+		struct Bin {
+			glm::vec3 BoundsMin{ Infinity };
+			glm::vec3 BoundsMax{ -Infinity };
+			unsigned int Count{ 0 };
+		};
+		std::array<Bin, SahBinCount> bins;
+		const float binScale = SahBinCount / centroidExtent[axis];
+		for (unsigned int i = node.First; i < node.First + node.Count; i++)
+		{
+			const auto& bounds = primitiveBounds[primitiveIndices[i]];
+			const int bin = std::min(static_cast<int>((bounds.Centroid[axis] - centroidMin[axis]) * binScale), SahBinCount - 1);
+			bins[bin].BoundsMin = glm::min(bins[bin].BoundsMin, bounds.Min);
+			bins[bin].BoundsMax = glm::max(bins[bin].BoundsMax, bounds.Max);
+			bins[bin].Count++;
+		}
+
+		//sweep from right stores cost of every right side, sweep from left completes each split
+		std::array<float, SahBinCount> rightCosts{};
+		Bin right;
+		for (int split = SahBinCount - 1; split > 0; split--)
+		{
+			right.BoundsMin = glm::min(right.BoundsMin, bins[split].BoundsMin);
+			right.BoundsMax = glm::max(right.BoundsMax, bins[split].BoundsMax);
+			right.Count += bins[split].Count;
+			rightCosts[split] = right.Count == 0 ? 0.0f : getBoundsArea(right.BoundsMin, right.BoundsMax) * right.Count;
+		}
+		Bin left;
+		for (int split = 1; split < SahBinCount; split++)
+		{
+			left.BoundsMin = glm::min(left.BoundsMin, bins[split - 1].BoundsMin);
+			left.BoundsMax = glm::max(left.BoundsMax, bins[split - 1].BoundsMax);
+			left.Count += bins[split - 1].Count;
+			if (left.Count == 0 || left.Count == node.Count)
+				continue;
+			const float cost = getBoundsArea(left.BoundsMin, left.BoundsMax) * left.Count + rightCosts[split];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	const float nodeArea = getBoundsArea(node.BoundsMin, node.BoundsMax);
+	unsigned int middle;
+	if (bestAxis >= 0 && nodeArea + bestCost < nodeArea * node.Count)
+	{
+		const float binScale = SahBinCount / centroidExtent[bestAxis];
+		const auto firstIter = primitiveIndices.begin() + node.First;
+		const auto middleIter = std::partition(firstIter, firstIter + node.Count, [&](unsigned int primitive)
+		{
+			const float centroid = primitiveBounds[primitive].Centroid[bestAxis];
+			return std::min(static_cast<int>((centroid - centroidMin[bestAxis]) * binScale), SahBinCount - 1) < bestSplit;
+		});
+		middle = static_cast<unsigned int>(middleIter - primitiveIndices.begin());
+	}
+	else if (node.Count > MaxLeafTriangles)
+	{
+		//centroids coincide or no split pays off, halving by index still keeps leaves small
+		middle = node.First + node.Count / 2;
+	}
+	else
+		return false;
+
+	const auto leftIndex = static_cast<unsigned int>(nodes.size());
+	BuildNode leftNode{ glm::vec3(0.0f), glm::vec3(0.0f), node.First, middle - node.First, node.Depth + 1 };
+	BuildNode rightNode{ glm::vec3(0.0f), glm::vec3(0.0f), middle, node.First + node.Count - middle, node.Depth + 1 };
+	computeBounds(leftNode.First, leftNode.Count, leftNode.BoundsMin, leftNode.BoundsMax);
+	computeBounds(rightNode.First, rightNode.Count, rightNode.BoundsMin, rightNode.BoundsMax);
+	nodes.push_back(leftNode);
+	nodes.push_back(rightNode);
+	nodes[nodeIndex].First = leftIndex;
+	nodes[nodeIndex].Count = 0;
+	return true;
+}
+
+
+void dengine::TriangleBvh::computeBounds(unsigned int first, unsigned int count, glm::vec3& boundsMin,
+	glm::vec3& boundsMax) const
+{
+	boundsMin = glm::vec3(Infinity);
+	boundsMax = glm::vec3(-Infinity);
+	for (unsigned int i = first; i < first + count; i++)
+	{
+		boundsMin = glm::min(boundsMin, primitiveBounds[primitiveIndices[i]].Min);
+		boundsMax = glm::max(boundsMax, primitiveBounds[primitiveIndices[i]].Max);
+	}
+}
+
+
+unsigned int dengine::TriangleBvh::collapseNode(const std::pmr::vector<BuildNode>& nodes, unsigned int nodeIndex)
+{
+	//interior child with largest area is opened until four children are gathered, leaf root is its only child
+	std::array<unsigned int, 4> children{};
+	size_t childCount = 0;
+	if (nodes[nodeIndex].Count != 0)
+		children[childCount++] = nodeIndex;
+	else
+	{
+		children[childCount++] = nodes[nodeIndex].First;
+		children[childCount++] = nodes[nodeIndex].First + 1;
+	}
+	while (childCount < children.size())
+	{
+		int opened = -1;
+		float openedArea = -1.0f;
+		for (size_t i = 0; i < childCount; i++)
+		{
+			const auto& child = nodes[children[i]];
+			const float area = getBoundsArea(child.BoundsMin, child.BoundsMax);
+			if (child.Count == 0 && area > openedArea)
+			{
+				opened = static_cast<int>(i);
+				openedArea = area;
+			}
+		}
+		if (opened < 0)
+			break;
+		const auto first = nodes[children[opened]].First;
+		children[opened] = first;
+		children[childCount++] = first + 1;
+	}
+
+	const auto wideIndex = static_cast<unsigned int>(wideNodes.size());
+	wideNodes.emplace_back();
+	for (size_t slot = 0; slot < children.size(); slot++)
+	{
+		//empty slots have inverted bounds, which no ray interval overlaps
+		glm::vec3 boundsMin(Infinity);
+		glm::vec3 boundsMax(-Infinity);
+		unsigned int child = EmptyChild;
+		unsigned int count = 0;
+		if (slot < childCount)
+		{
+			const auto& node = nodes[children[slot]];
+			boundsMin = node.BoundsMin;
+			boundsMax = node.BoundsMax;
+			child = node.Count != 0 ? node.First : collapseNode(nodes, children[slot]);
+			count = node.Count;
+		}
+		auto& wideNode = wideNodes[wideIndex];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			wideNode.BoundsMin[axis][slot] = boundsMin[axis];
+			wideNode.BoundsMax[axis][slot] = boundsMax[axis];
+		}
+		wideNode.Children[slot] = child;
+		wideNode.Counts[slot] = count;
+	}
+	return wideIndex;
+}
+
+
+template<bool AnyHit>
+bool dengine::TriangleBvh::traverse(const BvhRay& ray, BvhHit& hit) const
+{
+	if (wideNodes.empty())
+		return false;
+	//zero components would give nan for planes through origin, tiny ones give huge but ordered distances
+	glm::vec3 inverseDirection;
+	int nearSide[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float direction = std::abs(ray.Direction[axis]) < 1e-12f ? std::copysign(1e-12f, ray.Direction[axis])
+			: ray.Direction[axis];
+		inverseDirection[axis] = 1.0f / direction;
+		nearSide[axis] = inverseDirection[axis] < 0.0f ? 1 : 0;
+	}
+#ifdef DENGINE_BVH_SSE
+	const __m128 originX = _mm_set1_ps(ray.Origin.x);
+	const __m128 originY = _mm_set1_ps(ray.Origin.y);
+	const __m128 originZ = _mm_set1_ps(ray.Origin.z);
+	const __m128 inverseX = _mm_set1_ps(inverseDirection.x);
+	const __m128 inverseY = _mm_set1_ps(inverseDirection.y);
+	const __m128 inverseZ = _mm_set1_ps(inverseDirection.z);
+#endif
+
+	float closest = ray.MaxDistance;
+	unsigned int closestTriangle = EmptyChild;
+	float closestU = 0.0f;
+	float closestV = 0.0f;
+	std::array<unsigned int, TraversalStackSize> stack;
+	size_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const auto& node = wideNodes[stack[--stackSize]];
+		//near plane of each axis is max bound when ray goes in negative direction
+		const float* nearX = nearSide[0] == 0 ? node.BoundsMin[0] : node.BoundsMax[0];
+		const float* farX = nearSide[0] == 0 ? node.BoundsMax[0] : node.BoundsMin[0];
+		const float* nearY = nearSide[1] == 0 ? node.BoundsMin[1] : node.BoundsMax[1];
+		const float* farY = nearSide[1] == 0 ? node.BoundsMax[1] : node.BoundsMin[1];
+		const float* nearZ = nearSide[2] == 0 ? node.BoundsMin[2] : node.BoundsMax[2];
+		const float* farZ = nearSide[2] == 0 ? node.BoundsMax[2] : node.BoundsMin[2];
+		float entryDistances[4];
+		int hitMask = 0;
+#ifdef DENGINE_BVH_SSE
+		const __m128 entry = _mm_max_ps(
+			_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(nearX), originX), inverseX),
+				_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(nearY), originY), inverseY)),
+			_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(nearZ), originZ), inverseZ), _mm_setzero_ps()));
+		const __m128 exit = _mm_min_ps(
+			_mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(farX), originX), inverseX),
+				_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(farY), originY), inverseY)),
+			_mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(farZ), originZ), inverseZ), _mm_set1_ps(closest)));
+		hitMask = _mm_movemask_ps(_mm_cmple_ps(entry, exit));
+		_mm_storeu_ps(entryDistances, entry);
+#else
+		for (int slot = 0; slot < 4; slot++)
+		{
+			const float entry = std::max({ (nearX[slot] - ray.Origin.x) * inverseDirection.x,
+				(nearY[slot] - ray.Origin.y) * inverseDirection.y, (nearZ[slot] - ray.Origin.z) * inverseDirection.z, 0.0f });
+			const float exit = std::min({ (farX[slot] - ray.Origin.x) * inverseDirection.x,
+				(farY[slot] - ray.Origin.y) * inverseDirection.y, (farZ[slot] - ray.Origin.z) * inverseDirection.z, closest });
+			entryDistances[slot] = entry;
+			if (entry <= exit)
+				hitMask |= 1 << slot;
+		}
+#endif
+
+		//leaves are tested right away, interior children are pushed farthest first so nearest is popped next
+		unsigned int interiorChildren[4];
+		float interiorDistances[4];
+		int interiorCount = 0;
+		for (int slot = 0; slot < 4; slot++)
+		{
+			if ((hitMask & (1 << slot)) == 0)
+				continue;
+			if (node.Counts[slot] == 0)
+			{
+				int insert = interiorCount++;
+				for (; insert > 0 && interiorDistances[insert - 1] < entryDistances[slot]; insert--)
+				{
+					interiorChildren[insert] = interiorChildren[insert - 1];
+					interiorDistances[insert] = interiorDistances[insert - 1];
+				}
+				interiorChildren[insert] = node.Children[slot];
+				interiorDistances[insert] = entryDistances[slot];
+				continue;
+			}
+			for (unsigned int i = node.Children[slot]; i < node.Children[slot] + node.Counts[slot]; i++)
+			{
+				//moller-trumbore, hits behind origin or beyond closest hit are rejected
+				const auto& triangle = triangles[i];
+				const glm::vec3 p = glm::cross(ray.Direction, triangle.Edge2);
+				const float determinant = glm::dot(triangle.Edge1, p);
+				if (std::abs(determinant) < 1e-12f)
+					continue;
+				const float inverseDeterminant = 1.0f / determinant;
+				const glm::vec3 s = ray.Origin - triangle.Vertex0;
+				const float u = glm::dot(s, p) * inverseDeterminant;
+				if (u < 0.0f || u > 1.0f)
+					continue;
+				const glm::vec3 q = glm::cross(s, triangle.Edge1);
+				const float v = glm::dot(ray.Direction, q) * inverseDeterminant;
+				if (v < 0.0f || u + v > 1.0f)
+					continue;
+				const float distance = glm::dot(triangle.Edge2, q) * inverseDeterminant;
+				if (distance <= 0.0f || distance >= closest)
+					continue;
+				if constexpr (AnyHit)
+					return true;
+				closest = distance;
+				closestTriangle = i;
+				closestU = u;
+				closestV = v;
+			}
+		}
+		for (int i = 0; i < interiorCount; i++)
+			stack[stackSize++] = interiorChildren[i];
+	}
+
+	if (closestTriangle == EmptyChild)
+		return false;
+	const auto& triangle = triangles[closestTriangle];
+	hit.Distance = closest;
+	hit.U = closestU;
+	hit.V = closestV;
+	hit.DrawItem = sources[closestTriangle].DrawItem;
+	hit.Triangle = sources[closestTriangle].Triangle;
+	hit.GeometricNormal = glm::normalize(glm::cross(triangle.Edge1, triangle.Edge2));
+	return true;
+}
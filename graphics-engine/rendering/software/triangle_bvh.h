@@ -0,0 +1,100 @@
+#ifndef TRIANGLE_BVH_INCLUDED
+#define TRIANGLE_BVH_INCLUDED
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <BS_thread_pool.hpp>
+#include <rendering/software/software_scene.h>
+
+namespace dengine
+{
+	struct BvhRay {
+		glm::vec3 Origin;
+		//normalized
+		glm::vec3 Direction;
+		float MaxDistance;
+	};
+
+	struct BvhHit {
+		float Distance;
+		//barycentric weights of second and third vertex
+		float U;
+		float V;
+		//index into draw items of scene and triangle within mesh of draw item
+		unsigned int DrawItem;
+		unsigned int Triangle;
+		//normalized, winding order of mesh
+		glm::vec3 GeometricNormal;
+	};
+
+
+	//world space triangles of software scene in four wide bounding volume hierarchy; binary tree is built with
+	//binned surface area heuristic, subtrees in parallel, then collapsed so traversal tests four boxes at once
+	class TriangleBvh {
+	public:
+		explicit TriangleBvh(BS::thread_pool& threadPool);
+		TriangleBvh(const TriangleBvh&) = delete;
+		TriangleBvh& operator=(const TriangleBvh&) = delete;
+
+		void Build(const SoftwareScene& scene);
+		//closest hit closer than max distance of ray
+		bool Intersect(const BvhRay& ray, BvhHit& hit) const;
+		//any hit, for shadow rays
+		bool IsOccluded(const BvhRay& ray) const;
+		size_t GetTriangleCount() const;
+		size_t GetNodeCount() const;
+	private:
+		struct Triangle {
+			glm::vec3 Vertex0;
+			glm::vec3 Edge1;
+			glm::vec3 Edge2;
+		};
+
+		struct TriangleSource {
+			unsigned int DrawItem;
+			unsigned int Triangle;
+		};
+
+		struct PrimitiveBounds {
+			glm::vec3 Min;
+			glm::vec3 Max;
+			glm::vec3 Centroid;
+		};
+
+		//interior nodes have no primitives and First is left child, right child follows it
+		struct BuildNode {
+			glm::vec3 BoundsMin;
+			glm::vec3 BoundsMax;
+			unsigned int First;
+			unsigned int Count;
+			unsigned int Depth;
+		};
+
+		//children bounds stored per axis, so one sse register holds same plane of all four boxes
+		struct WideNode {
+			float BoundsMin[3][4];
+			float BoundsMax[3][4];
+			//wide node index of interior child, first triangle of leaf child
+			unsigned int Children[4];
+			//triangles of leaf child, 0 for interior and empty children
+			unsigned int Counts[4];
+		};
+
+		bool splitNode(std::pmr::vector<BuildNode>& nodes, unsigned int nodeIndex);
+		void computeBounds(unsigned int first, unsigned int count, glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+		unsigned int collapseNode(const std::pmr::vector<BuildNode>& nodes, unsigned int nodeIndex);
+		template<bool AnyHit>
+		bool traverse(const BvhRay& ray, BvhHit& hit) const;
+
+		BS::thread_pool& threadPool;
+		std::pmr::vector<Triangle> triangles;
+		std::pmr::vector<TriangleSource> sources;
+		std::pmr::vector<WideNode> wideNodes;
+		//build state, primitive indices are partitioned in place by splits
+		std::pmr::vector<PrimitiveBounds> primitiveBounds;
+		std::pmr::vector<unsigned int> primitiveIndices;
+	};
+}
+
+#endif
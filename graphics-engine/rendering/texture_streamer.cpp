@@ -0,0 +1,680 @@
+#include <rendering/texture_streamer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <glm/gtc/type_ptr.hpp>
+#include <rendering/render_target_pool.h>
+#include <rendering/schemas/pbr_rendering_scheme.h>
+#include <profiling/profiler.h>
+#include <profiling/gpu_profiler.h>
+#include <profiling/memory_tracker.h>
+
+constexpr int StreamedTexelSize = 4;
+//cleared value of feedback slots, texture was not sampled by any pixel
+constexpr unsigned int FeedbackNotSampled = std::numeric_limits<unsigned int>::max();
+//persistently mapped ring bands are built into, bytes in flight never exceed it
+constexpr size_t StagingSize = 64ull << 20;
+//single band stays well below ring size, so several textures stream at once
+constexpr size_t MaxBandSize = StagingSize / 8;
+//tail texels average this many samples per axis of their footprint, registration never reads every imported texel
+constexpr int TailSamples = 4;
+constexpr GLuint64 FenceWaitTimeout = 5'000'000'000ull;
+//UNIFORM LOCATIONS
+constexpr int UniformSlotsLocation = 0;
+constexpr int UniformSizesLocation = 1;
+constexpr int UniformLevelBiasLocation = 4;
+//SHADER STORAGE BUFFER BINDINGS
+constexpr unsigned int SsboFeedbackBinding = 0;
+
+
+void dengine::downsampleTextureLevel(const unsigned char* source, int sourceWidth, int sourceHeight,
+	unsigned char* destination)
+{
+	const int width = std::max(sourceWidth / 2, 1);
+	const int height = std::max(sourceHeight / 2, 1);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+		{
+			const int x0 = std::min(x * 2, sourceWidth - 1), x1 = std::min(x * 2 + 1, sourceWidth - 1);
+			const int y0 = std::min(y * 2, sourceHeight - 1), y1 = std::min(y * 2 + 1, sourceHeight - 1);
+			for (int channel = 0; channel < StreamedTexelSize; channel++)
+			{
+				const int sum = source[(y0 * sourceWidth + x0) * StreamedTexelSize + channel] +
+					source[(y0 * sourceWidth + x1) * StreamedTexelSize + channel] +
+					source[(y1 * sourceWidth + x0) * StreamedTexelSize + channel] +
+					source[(y1 * sourceWidth + x1) * StreamedTexelSize + channel];
+				destination[(y * width + x) * StreamedTexelSize + channel] = static_cast<unsigned char>((sum + 2) / 4);
+			}
+		}
+}
+
+
+//rows of given level straight from level 0, every texel averages its footprint sampled with at most
+//maxSamples taps per axis
+void filterLevelRows(const unsigned char* source, int sourceWidth, int sourceHeight, int level, int firstRow,
+	int rowCount, int maxSamples, unsigned char* destination)
+{
+	const int width = std::max(sourceWidth >> level, 1);
+	const int footprint = 1 << level;
+	const int stride = std::max(footprint / maxSamples, 1);
+	for (int y = firstRow; y < firstRow + rowCount; y++)
+	{
+		const int y0 = std::min(y * footprint, sourceHeight - 1);
+		const int y1 = std::min(y0 + footprint, sourceHeight);
+		for (int x = 0; x < width; x++)
+		{
+			const int x0 = std::min(x * footprint, sourceWidth - 1);
+			const int x1 = std::min(x0 + footprint, sourceWidth);
+			unsigned long long sums[StreamedTexelSize] = {};
+			unsigned long long count = 0;
+			for (int sampleY = y0; sampleY < y1; sampleY += stride)
+				for (int sampleX = x0; sampleX < x1; sampleX += stride)
+				{
+					const unsigned char* texel = source + (static_cast<size_t>(sampleY) * sourceWidth + sampleX) * StreamedTexelSize;
+					for (int channel = 0; channel < StreamedTexelSize; channel++)
+						sums[channel] += texel[channel];
+					count++;
+				}
+			unsigned char* filtered = destination + (static_cast<size_t>(y - firstRow) * width + x) * StreamedTexelSize;
+			for (int channel = 0; channel < StreamedTexelSize; channel++)
+				filtered[channel] = static_cast<unsigned char>((sums[channel] + count / 2) / count);
+		}
+	}
+}
+
+
+long long getStreamedLevelSize(int width, int height)
+{
+	return static_cast<long long>(width) * height * StreamedTexelSize;
+}
+
+
+dengine::TextureStreamer::TextureStreamer(BS::thread_pool& threadPool) : threadPool(threadPool),
+	feedbackProgram("shaders/texture_feedback.vert", "shaders/texture_feedback.frag")
+{
+	for (auto& pendingFeedback : pendingFeedbacks)
+		glCreateBuffers(1, &pendingFeedback.Buffer);
+	//coherent mapping, bands written by workers are visible to uploads issued after they finish
+	const GLbitfield stagingFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &stagingBuffer);
+	glNamedBufferStorage(stagingBuffer, StagingSize, nullptr, stagingFlags);
+	stagingMemory = static_cast<unsigned char*>(glMapNamedBufferRange(stagingBuffer, 0, StagingSize, stagingFlags));
+	MemoryTracker::Get().TrackGpuObject(MemoryCategory::ReadbackBuffers, stagingBuffer, StagingSize, "texture streamer");
+}
+
+
+dengine::TextureStreamer::~TextureStreamer()
+{
+	//workers write into mapped staging memory, they have to finish before it goes away
+	for (auto& band : bands)
+	{
+		band.Built.wait();
+		if (band.Fence != nullptr)
+			glDeleteSync(band.Fence);
+	}
+	auto& memoryTracker = MemoryTracker::Get();
+	glUnmapNamedBuffer(stagingBuffer);
+	glDeleteBuffers(1, &stagingBuffer);
+	memoryTracker.ReleaseGpuObject(MemoryCategory::ReadbackBuffers, stagingBuffer);
+	for (auto& streamedTexture : textures)
+	{
+		glDeleteTextures(1, &streamedTexture.Texture);
+		memoryTracker.ReleaseGpuObject(MemoryCategory::Textures, streamedTexture.Texture);
+	}
+	for (auto& pendingFeedback : pendingFeedbacks)
+	{
+		if (pendingFeedback.Fence != nullptr)
+			glDeleteSync(pendingFeedback.Fence);
+		glDeleteBuffers(1, &pendingFeedback.Buffer);
+		memoryTracker.ReleaseGpuObject(MemoryCategory::ReadbackBuffers, pendingFeedback.Buffer);
+	}
+	deleteFeedbackTarget();
+}
+
+
+std::pmr::vector<unsigned int> dengine::TextureStreamer::Register(std::pmr::vector<Texture>& modelTextures,
+	std::span<const int> textureIndices, std::string_view owner)
+{
+	DENGINE_PROFILE_SCOPE("register textures");
+	std::pmr::vector<unsigned int> textureNames;
+	const size_t firstTexture = textures.size();
+	for (int textureIndex : textureIndices)
+	{
+		auto& texture = modelTextures[textureIndex];
+		//missing texture is name 0, shaders pick variant without that map
+		if (texture.Width <= 0 || texture.Height <= 0 || texture.Data.empty())
+		{
+			textureNames.push_back(0);
+			continue;
+		}
+
+		auto& streamedTexture = textures.emplace_back(std::move(texture.Data));
+		streamedTexture.Owner = owner;
+		for (int width = texture.Width, height = texture.Height;; width = std::max(width / 2, 1), height = std::max(height / 2, 1))
+		{
+			streamedTexture.Levels.push_back(Level{ width, height });
+			if (width == 1 && height == 1)
+				break;
+		}
+		const auto& levels = streamedTexture.Levels;
+		while (static_cast<size_t>(streamedTexture.TailLevel) + 1 < levels.size() &&
+			std::max(levels[streamedTexture.TailLevel].Width, levels[streamedTexture.TailLevel].Height) > settings.ResidentTailSize)
+			streamedTexture.TailLevel++;
+		streamedTexture.RequestedLevel = streamedTexture.TailLevel;
+
+		glCreateTextures(GL_TEXTURE_2D, 1, &streamedTexture.Texture);
+		glTextureParameteri(streamedTexture.Texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTextureParameteri(streamedTexture.Texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(streamedTexture.Texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(streamedTexture.Texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTextureParameteri(streamedTexture.Texture, GL_TEXTURE_MAX_LEVEL, static_cast<int>(levels.size()) - 1);
+		textureSlots.emplace(streamedTexture.Texture, static_cast<unsigned int>(textures.size() - 1));
+		textureNames.push_back(streamedTexture.Texture);
+	}
+	if (textures.size() == firstTexture)
+		return textureNames;
+
+	//only tail is built at load, its finest level samples level 0 sparsely and coarser ones are filtered from it
+	std::pmr::vector<std::pmr::vector<unsigned char>> tails(textures.size() - firstTexture);
+	threadPool.parallelize_loop(firstTexture, textures.size(), [&](size_t first, size_t last)
+	{
+		for (size_t i = first; i < last; i++)
+		{
+			const auto& streamedTexture = textures[i];
+			const auto& levels = streamedTexture.Levels;
+			auto& tail = tails[i - firstTexture];
+			size_t tailSize = 0;
+			for (size_t level = streamedTexture.TailLevel; level < levels.size(); level++)
+				tailSize += static_cast<size_t>(getStreamedLevelSize(levels[level].Width, levels[level].Height));
+			tail.resize(tailSize);
+			filterLevelRows(streamedTexture.Texels.data(), levels[0].Width, levels[0].Height, streamedTexture.TailLevel, 0,
+				levels[streamedTexture.TailLevel].Height, TailSamples, tail.data());
+			size_t offset = 0;
+			for (size_t level = streamedTexture.TailLevel + 1; level < levels.size(); level++)
+			{
+				const auto& source = levels[level - 1];
+				const size_t nextOffset = offset + static_cast<size_t>(getStreamedLevelSize(source.Width, source.Height));
+				downsampleTextureLevel(tail.data() + offset, source.Width, source.Height, tail.data() + nextOffset);
+				offset = nextOffset;
+			}
+		}
+	}).wait();
+
+	//tail is uploaded coarsest first from client memory, it is small and texture is complete after every level
+	for (size_t i = firstTexture; i < textures.size(); i++)
+	{
+		auto& streamedTexture = textures[i];
+		const auto& levels = streamedTexture.Levels;
+		const auto& tail = tails[i - firstTexture];
+		size_t offset = tail.size();
+		glBindTexture(GL_TEXTURE_2D, streamedTexture.Texture);
+		for (int level = static_cast<int>(levels.size()) - 1; level >= streamedTexture.TailLevel; level--)
+		{
+			offset -= static_cast<size_t>(getStreamedLevelSize(levels[level].Width, levels[level].Height));
+			glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, levels[level].Width, levels[level].Height, 0, GL_RGBA,
+				GL_UNSIGNED_BYTE, tail.data() + offset);
+			setResidentLevel(streamedTexture, level);
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return textureNames;
+}
+
+
+void dengine::TextureStreamer::Unregister(std::span<const unsigned int> textureNames)
+{
+	while (!bands.empty())
+		finishBands(true);
+	for (auto& pendingFeedback : pendingFeedbacks)
+		if (pendingFeedback.Fence != nullptr)
+		{
+			glDeleteSync(pendingFeedback.Fence);
+			pendingFeedback.Fence = nullptr;
+		}
+
+	auto& memoryTracker = MemoryTracker::Get();
+	std::erase_if(textures, [&](const StreamedTexture& streamedTexture)
+	{
+		if (std::find(textureNames.begin(), textureNames.end(), streamedTexture.Texture) == textureNames.end())
+			return false;
+		glDeleteTextures(1, &streamedTexture.Texture);
+		memoryTracker.ReleaseGpuObject(MemoryCategory::Textures, streamedTexture.Texture);
+		return true;
+	});
+	textureSlots.clear();
+	for (size_t i = 0; i < textures.size(); i++)
+		textureSlots.emplace(textures[i].Texture, static_cast<unsigned int>(i));
+	Invalidate();
+}
+
+
+void dengine::TextureStreamer::Stream()
+{
+	DENGINE_PROFILE_SCOPE("stream textures");
+	frame++;
+	readFeedbacks(settings.Synchronous);
+
+	statistics.UploadedBytes = 0;
+	statistics.UploadedLevels = 0;
+	statistics.EvictedLevels = 0;
+	for (auto& streamedTexture : textures)
+	{
+		if (settings.Enabled)
+			evictLevels(streamedTexture);
+		else
+			streamedTexture.RequestedLevel = 0;
+	}
+
+	if (settings.Enabled)
+	{
+		finishBands(false);
+		long long budget = settings.UploadBudget;
+		submitBands(budget);
+		//bands of this frame land in this frame, independent of worker timing
+		if (settings.Synchronous)
+			finishBands(true);
+	}
+	else
+	{
+		//every level at once: bands are waited for until whole chains are resident
+		const auto isMissingLevels = [](const StreamedTexture& streamedTexture)
+		{
+			return streamedTexture.RequestedLevel < streamedTexture.ResidentLevel;
+		};
+		while (!bands.empty() || std::any_of(textures.begin(), textures.end(), isMissingLevels))
+		{
+			long long budget = std::numeric_limits<long long>::max();
+			submitBands(budget);
+			finishBands(true);
+		}
+	}
+
+	statistics.Textures = textures.size();
+	statistics.ResidentBytes = 0;
+	statistics.FullBytes = 0;
+	statistics.PendingLevels = 0;
+	statistics.BandsInFlight = bands.size();
+	for (auto& streamedTexture : textures)
+	{
+		const auto& levels = streamedTexture.Levels;
+		const auto& residentLevel = levels[streamedTexture.ResidentLevel];
+		statistics.ResidentBytes += getTextureStorageSize(residentLevel.Width, residentLevel.Height,
+			static_cast<int>(levels.size()) - streamedTexture.ResidentLevel, StreamedTexelSize);
+		statistics.FullBytes += getTextureStorageSize(levels[0].Width, levels[0].Height, static_cast<int>(levels.size()),
+			StreamedTexelSize);
+		statistics.PendingLevels += std::max(streamedTexture.ResidentLevel - streamedTexture.RequestedLevel, 0);
+	}
+}
+
+
+void dengine::TextureStreamer::RenderFeedback(const PbrRenderingSubmitter& renderingSubmitter, glm::ivec2 renderSize)
+{
+	//invalidated view is measured right away, camera may stop before interval passes
+	if (!settings.Enabled || textures.empty() || (!feedbackRequested && feedbackFrame != 0 &&
+		frame < feedbackFrame + std::max(settings.FeedbackInterval, 1)))
+		return;
+	const auto program = feedbackProgram.Get();
+	//gpu is frames behind, skip feedback instead of waiting for it
+	auto& pendingFeedback = pendingFeedbacks[nextFeedback];
+	if (program == 0 || pendingFeedback.Fence != nullptr)
+		return;
+	DENGINE_PROFILE_SCOPE("texture feedback");
+	DENGINE_PROFILE_GPU_SCOPE("texture feedback");
+	nextFeedback = (nextFeedback + 1) % pendingFeedbacks.size();
+	feedbackFrame = frame;
+	feedbackRequested = false;
+
+	if (textures.size() > pendingFeedback.Capacity)
+	{
+		pendingFeedback.Capacity = textures.size();
+		glNamedBufferData(pendingFeedback.Buffer, pendingFeedback.Capacity * sizeof(unsigned int), nullptr, GL_STREAM_READ);
+		MemoryTracker::Get().TrackGpuObject(MemoryCategory::ReadbackBuffers, pendingFeedback.Buffer,
+			static_cast<long long>(pendingFeedback.Capacity * sizeof(unsigned int)), "texture streamer");
+	}
+	glClearNamedBufferData(pendingFeedback.Buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &FeedbackNotSampled);
+
+	const int divisor = std::max(settings.FeedbackDivisor, 1);
+	const glm::ivec2 feedbackSize = glm::max((renderSize + divisor - 1) / divisor, glm::ivec2(1));
+	const auto sizeClass = RenderTargetPool::GetSizeClass(feedbackSize.x, feedbackSize.y);
+	if (fbo == 0 || sizeClass != feedbackTargetSize)
+	{
+		deleteFeedbackTarget();
+		createFeedbackTarget(sizeClass);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, feedbackSize.x, feedbackSize.y);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	glUseProgram(program);
+	glProgramUniform1f(program, UniformLevelBiasLocation, std::log2(static_cast<float>(divisor)));
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SsboFeedbackBinding, pendingFeedback.Buffer);
+	renderingSubmitter.RedrawLastDispatch([&](const PbrDrawCommand& drawCommand)
+	{
+		const int textureNames[3] = { drawCommand.Key.DiffuseTexture, drawCommand.Key.NormalTexture,
+			drawCommand.Key.MetalnessTexture };
+		glm::ivec3 slots(-1);
+		glm::vec2 sizes[3] = { glm::vec2(0.0f), glm::vec2(0.0f), glm::vec2(0.0f) };
+		for (int i = 0; i < 3; i++)
+		{
+			auto slotIter = textureSlots.find(static_cast<unsigned int>(textureNames[i]));
+			if (textureNames[i] <= 0 || slotIter == textureSlots.end())
+				continue;
+			slots[i] = static_cast<int>(slotIter->second);
+			const auto& level = textures[slotIter->second].Levels[0];
+			sizes[i] = glm::vec2(static_cast<float>(level.Width), static_cast<float>(level.Height));
+		}
+		if (slots == glm::ivec3(-1))
+			return false;
+		glProgramUniform3i(program, UniformSlotsLocation, slots.x, slots.y, slots.z);
+		glProgramUniform2fv(program, UniformSizesLocation, 3, glm::value_ptr(sizes[0]));
+		return true;
+	});
+	//atomics have to land before buffer is read back
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	pendingFeedback.Frame = frame;
+	pendingFeedback.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+
+void dengine::TextureStreamer::Invalidate()
+{
+	feedbackRequested = true;
+	invalidatedFrame = frame;
+}
+
+
+bool dengine::TextureStreamer::IsStreaming() const
+{
+	if (!settings.Enabled || textures.empty())
+		return false;
+	const bool feedbackInFlight = std::any_of(pendingFeedbacks.begin(), pendingFeedbacks.end(), [](const auto& pendingFeedback)
+	{
+		return pendingFeedback.Fence != nullptr;
+	});
+	//feedback drawn before last change does not tell what current view needs
+	const bool feedbackOutdated = feedbackRequested || readFeedbackFrame <= invalidatedFrame;
+	return feedbackOutdated || feedbackInFlight || !bands.empty() || statistics.PendingLevels > 0;
+}
+
+
+void dengine::TextureStreamer::Reload()
+{
+	feedbackProgram.Compile();
+}
+
+
+void dengine::TextureStreamer::Update()
+{
+	feedbackProgram.Update(false);
+}
+
+
+bool dengine::TextureStreamer::IsCompiling() const
+{
+	return feedbackProgram.IsCompiling();
+}
+
+
+dengine::TextureStreamingSettings& dengine::TextureStreamer::GetSettings()
+{
+	return settings;
+}
+
+
+const dengine::TextureStreamingStatistics& dengine::TextureStreamer::GetStatistics() const
+{
+	return statistics;
+}
+
+
+void dengine::TextureStreamer::readFeedbacks(bool wait)
+{
+	//oldest feedback first, newer ones cannot be finished before it
+	for (size_t i = 0; i < pendingFeedbacks.size(); i++)
+	{
+		auto& pendingFeedback = pendingFeedbacks[(nextFeedback + i) % pendingFeedbacks.size()];
+		if (pendingFeedback.Fence == nullptr)
+			continue;
+		const auto status = glClientWaitSync(pendingFeedback.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? FenceWaitTimeout : 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+			break;
+		glDeleteSync(pendingFeedback.Fence);
+		pendingFeedback.Fence = nullptr;
+		if (status != GL_WAIT_FAILED)
+			readFeedback(pendingFeedback);
+	}
+}
+
+
+void dengine::TextureStreamer::readFeedback(PendingFeedback& pendingFeedback)
+{
+	readFeedbackFrame = std::max(readFeedbackFrame, pendingFeedback.Frame);
+	//textures registered after feedback was drawn have no slot in it yet
+	feedbackLevels.resize(std::min(pendingFeedback.Capacity, textures.size()));
+	glGetNamedBufferSubData(pendingFeedback.Buffer, 0, feedbackLevels.size() * sizeof(unsigned int), feedbackLevels.data());
+	for (size_t i = 0; i < feedbackLevels.size(); i++)
+	{
+		auto& streamedTexture = textures[i];
+		if (feedbackLevels[i] == FeedbackNotSampled)
+		{
+			streamedTexture.RequestedLevel = streamedTexture.TailLevel;
+			continue;
+		}
+		//trilinear filtering reads requested level and every coarser one
+		streamedTexture.RequestedLevel = std::min(static_cast<int>(feedbackLevels[i]), streamedTexture.TailLevel);
+		for (size_t level = streamedTexture.RequestedLevel; level < streamedTexture.Levels.size(); level++)
+			streamedTexture.Levels[level].RequestFrame = pendingFeedback.Frame;
+	}
+}
+
+
+void dengine::TextureStreamer::evictLevels(StreamedTexture& streamedTexture)
+{
+	//level being built sits right above resident one, it has to land before base level may move
+	if (streamedTexture.BuildingLevel != -1)
+		return;
+	int residentLevel = streamedTexture.ResidentLevel;
+	while (residentLevel < streamedTexture.TailLevel && residentLevel < streamedTexture.RequestedLevel &&
+		frame - streamedTexture.Levels[residentLevel].RequestFrame > static_cast<size_t>(settings.EvictionDelay))
+		residentLevel++;
+	if (residentLevel == streamedTexture.ResidentLevel)
+		return;
+
+	//base level moves first, freed levels are never sampled; zero sized image releases storage of level
+	const int evictedLevel = streamedTexture.ResidentLevel;
+	setResidentLevel(streamedTexture, residentLevel);
+	glBindTexture(GL_TEXTURE_2D, streamedTexture.Texture);
+	for (int level = evictedLevel; level < residentLevel; level++)
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	statistics.EvictedLevels += static_cast<unsigned int>(residentLevel - evictedLevel);
+}
+
+
+bool dengine::TextureStreamer::submitBands(long long& budget)
+{
+	//blurriest textures first, every round gives each of them one band
+	uploadOrder.clear();
+	for (size_t i = 0; i < textures.size(); i++)
+		if (textures[i].BuildingLevel != -1 || textures[i].RequestedLevel < textures[i].ResidentLevel)
+			uploadOrder.push_back(static_cast<unsigned int>(i));
+	std::stable_sort(uploadOrder.begin(), uploadOrder.end(), [this](unsigned int left, unsigned int right)
+	{
+		return textures[left].ResidentLevel - textures[left].RequestedLevel >
+			textures[right].ResidentLevel - textures[right].RequestedLevel;
+	});
+
+	bool firstBand = true;
+	for (bool submitted = true; submitted && budget > 0;)
+	{
+		submitted = false;
+		for (auto index : uploadOrder)
+		{
+			auto& streamedTexture = textures[index];
+			if (streamedTexture.BuildingLevel == -1)
+			{
+				if (streamedTexture.RequestedLevel >= streamedTexture.ResidentLevel)
+					continue;
+				//mutable storage, immutable one would allocate every level up front; rows arrive in bands later
+				const int level = streamedTexture.ResidentLevel - 1;
+				glBindTexture(GL_TEXTURE_2D, streamedTexture.Texture);
+				glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, streamedTexture.Levels[level].Width,
+					streamedTexture.Levels[level].Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				streamedTexture.BuildingLevel = level;
+				streamedTexture.SubmittedRows = 0;
+				streamedTexture.UploadedRows = 0;
+			}
+			const int level = streamedTexture.BuildingLevel;
+			const auto& builtLevel = streamedTexture.Levels[level];
+			if (streamedTexture.SubmittedRows == builtLevel.Height)
+				continue;
+
+			//level larger than whole budget is split into bands, first band of frame goes even over budget
+			const long long rowSize = getStreamedLevelSize(builtLevel.Width, 1);
+			const long long bandSize = std::min(budget, static_cast<long long>(MaxBandSize));
+			const int rowCount = static_cast<int>(std::clamp(bandSize / rowSize, 1ll,
+				static_cast<long long>(builtLevel.Height - streamedTexture.SubmittedRows)));
+			const long long size = rowSize * rowCount;
+			if (size > budget && !firstBand)
+			{
+				budget = 0;
+				break;
+			}
+			size_t offset = 0;
+			if (!allocateStaging(static_cast<size_t>(size), offset))
+			{
+				glBindTexture(GL_TEXTURE_2D, 0);
+				return false;
+			}
+			stagingHead = offset + static_cast<size_t>(size);
+
+			auto& band = bands.emplace_back(Band{ index, level, streamedTexture.SubmittedRows, rowCount, offset,
+				static_cast<size_t>(size) });
+			//level 0 stays in place for whole lifetime of texture, workers read it without copies
+			band.Built = threadPool.submit([texels = streamedTexture.Texels.data(), width = streamedTexture.Levels[0].Width,
+				height = streamedTexture.Levels[0].Height, level, firstRow = band.FirstRow, rowCount,
+				destination = stagingMemory + offset]()
+			{
+				filterLevelRows(texels, width, height, level, firstRow, rowCount, 1 << level, destination);
+			});
+			streamedTexture.SubmittedRows += rowCount;
+			budget -= size;
+			firstBand = false;
+			submitted = true;
+			if (budget <= 0)
+				break;
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+
+void dengine::TextureStreamer::finishBands(bool wait)
+{
+	//bands upload in submission order, so staging memory is freed from front of ring
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+	for (auto& band : bands)
+	{
+		if (band.Fence != nullptr)
+			continue;
+		if (!wait && band.Built.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			break;
+		band.Built.get();
+		auto& streamedTexture = textures[band.TextureIndex];
+		const auto& builtLevel = streamedTexture.Levels[band.Level];
+		glTextureSubImage2D(streamedTexture.Texture, band.Level, 0, band.FirstRow, builtLevel.Width, band.RowCount,
+			GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(band.StagingOffset));
+		band.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		statistics.UploadedBytes += static_cast<long long>(band.StagingSize);
+		streamedTexture.UploadedRows += band.RowCount;
+		//base level moves only once every row is there, partial levels are never sampled
+		if (streamedTexture.UploadedRows == builtLevel.Height)
+		{
+			setResidentLevel(streamedTexture, band.Level);
+			streamedTexture.BuildingLevel = -1;
+			statistics.UploadedLevels++;
+		}
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	size_t released = 0;
+	for (; released < bands.size() && bands[released].Fence != nullptr; released++)
+	{
+		const auto status = glClientWaitSync(bands[released].Fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? FenceWaitTimeout : 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+			break;
+		glDeleteSync(bands[released].Fence);
+	}
+	bands.erase(bands.begin(), bands.begin() + static_cast<std::ptrdiff_t>(released));
+	if (bands.empty())
+		stagingHead = 0;
+}
+
+
+bool dengine::TextureStreamer::allocateStaging(size_t size, size_t& offset) const
+{
+	if (bands.empty())
+	{
+		offset = 0;
+		return size <= StagingSize;
+	}
+	//used range runs from oldest band to head, possibly wrapped; head never catches up with tail
+	const size_t tail = bands.front().StagingOffset;
+	if (stagingHead > tail)
+	{
+		if (StagingSize - stagingHead >= size)
+		{
+			offset = stagingHead;
+			return true;
+		}
+		offset = 0;
+		return tail > size;
+	}
+	offset = stagingHead;
+	return tail - stagingHead > size;
+}
+
+
+void dengine::TextureStreamer::setResidentLevel(StreamedTexture& streamedTexture, int level)
+{
+	glTextureParameteri(streamedTexture.Texture, GL_TEXTURE_BASE_LEVEL, level);
+	streamedTexture.ResidentLevel = level;
+	const auto& residentLevel = streamedTexture.Levels[level];
+	MemoryTracker::Get().TrackGpuObject(MemoryCategory::Textures, streamedTexture.Texture,
+		getTextureStorageSize(residentLevel.Width, residentLevel.Height,
+			static_cast<int>(streamedTexture.Levels.size()) - level, StreamedTexelSize), streamedTexture.Owner);
+}
+
+
+void dengine::TextureStreamer::createFeedbackTarget(glm::ivec2 size)
+{
+	//depth only, feedback is written through storage buffer
+	glCreateFramebuffers(1, &fbo);
+	glCreateTextures(GL_TEXTURE_2D, 1, &depthTexture);
+	glTextureStorage2D(depthTexture, 1, GL_DEPTH_COMPONENT32F, size.x, size.y);
+	MemoryTracker::Get().TrackGpuObject(MemoryCategory::RenderTargets, depthTexture,
+		getTextureStorageSize(size.x, size.y, 1, 4), "texture streamer");
+	glNamedFramebufferTexture(fbo, GL_DEPTH_ATTACHMENT, depthTexture, 0);
+	glNamedFramebufferDrawBuffer(fbo, GL_NONE);
+	glNamedFramebufferReadBuffer(fbo, GL_NONE);
+	feedbackTargetSize = size;
+}
+
+
+void dengine::TextureStreamer::deleteFeedbackTarget()
+{
+	if (fbo == 0)
+		return;
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &depthTexture);
+	MemoryTracker::Get().ReleaseGpuObject(MemoryCategory::RenderTargets, depthTexture);
+	fbo = 0;
+	depthTexture = 0;
+}
@@ -0,0 +1,184 @@
+#ifndef TEXTURE_STREAMER_INCLUDED
+#define TEXTURE_STREAMER_INCLUDED
+
+#include <array>
+#include <future>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <BS_thread_pool.hpp>
+#include <importers/model_importer.h>
+#include <utils/reloadable_program.h>
+
+namespace dengine
+{
+	struct TextureStreamingSettings {
+		//disabled streaming skips feedback and uploads every missing level at once, regardless of budget
+		bool Enabled{ true };
+		//bytes submitted for upload per frame, levels are split into row bands so one band never exceeds it
+		long long UploadBudget{ 32ll << 20 };
+		//levels no larger than this stay resident from registration on and are never evicted
+		int ResidentTailSize{ 64 };
+		//feedback pass renders at render size divided by this
+		int FeedbackDivisor{ 8 };
+		//frames between feedback passes
+		int FeedbackInterval{ 4 };
+		//frames level has to stay unrequested before its memory is freed
+		int EvictionDelay{ 120 };
+		//feedback and level bands are waited for in frame they are issued, frames no longer depend on gpu
+		//and worker timing; for reproducible headless runs
+		bool Synchronous{ false };
+	};
+
+
+	struct TextureStreamingStatistics {
+		size_t Textures{ 0 };
+		long long ResidentBytes{ 0 };
+		//bytes with every level of every texture resident
+		long long FullBytes{ 0 };
+		//levels finer than resident ones that feedback asks for
+		size_t PendingLevels{ 0 };
+		//row bands built or uploading
+		size_t BandsInFlight{ 0 };
+		//last frame
+		long long UploadedBytes{ 0 };
+		unsigned int UploadedLevels{ 0 };
+		unsigned int EvictedLevels{ 0 };
+	};
+
+
+	class PbrRenderingSubmitter;
+
+	//box filters rgba8 level into next one, odd sizes repeat their last row or column
+	void downsampleTextureLevel(const unsigned char* source, int sourceWidth, int sourceHeight, unsigned char* destination);
+
+
+	//mip level streaming of scene textures: every texture starts with its coarse tail resident, low resolution
+	//feedback pass records finest level any pixel samples and finer levels are built from imported pixels on
+	//worker threads in row bands, which go to gpu through persistently mapped staging buffer within per frame
+	//budget; levels nobody asked for a while are freed again. textures keep their gl name throughout,
+	//so batch keys and materials never change
+	class TextureStreamer {
+	public:
+		explicit TextureStreamer(BS::thread_pool& threadPool);
+		~TextureStreamer();
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		//moves pixels of textures at given indices into cpu cache and uploads their tail, finer levels are built
+		//only once feedback asks for them; returns gl name per index
+		std::pmr::vector<unsigned int> Register(std::pmr::vector<Texture>& modelTextures,
+			std::span<const int> textureIndices, std::string_view owner);
+		//deletes textures of given gl names and frees their cpu cache, waits for bands in flight and drops
+		//feedback not read yet, as both address textures by index; name 0 is ignored
+		void Unregister(std::span<const unsigned int> textureNames);
+		//reads back finished feedback, evicts and uploads levels, called once per frame before drawing
+		void Stream();
+		//redraws last dispatch of submitter into feedback buffer, every FeedbackInterval frames
+		void RenderFeedback(const PbrRenderingSubmitter& renderingSubmitter, glm::ivec2 renderSize);
+		//view or scene changed, next RenderFeedback runs regardless of interval
+		void Invalidate();
+		//feedback since last Invalidate was not read back yet, is in flight or requested levels still wait for upload
+		bool IsStreaming() const;
+		void Reload();
+		void Update();
+		bool IsCompiling() const;
+
+		TextureStreamingSettings& GetSettings();
+		const TextureStreamingStatistics& GetStatistics() const;
+	private:
+		struct Level {
+			int Width;
+			int Height;
+			//frame this level was last requested in
+			size_t RequestFrame{ 0 };
+		};
+
+		struct StreamedTexture {
+			//keeps memory of imported pixels
+			explicit StreamedTexture(std::pmr::vector<unsigned char>&& texels) : Texels(std::move(texels)) {}
+
+			unsigned int Texture{ 0 };
+			std::pmr::string Owner;
+			std::pmr::vector<Level> Levels;
+			//level 0 only, 4 bytes per texel; every finer than tail level is rebuilt from it when requested
+			std::pmr::vector<unsigned char> Texels;
+			//finest level of resident tail
+			int TailLevel{ 0 };
+			//finest resident level, base level of texture
+			int ResidentLevel{ 0 };
+			//finest level of last feedback, tail level when texture was not visible
+			int RequestedLevel{ 0 };
+			//level whose row bands are being built or uploaded, -1 when none
+			int BuildingLevel{ -1 };
+			int SubmittedRows{ 0 };
+			int UploadedRows{ 0 };
+		};
+
+		//rows of one level built by worker into staging memory, freed once fence of its upload passes
+		struct Band {
+			unsigned int TextureIndex;
+			int Level;
+			int FirstRow;
+			int RowCount;
+			size_t StagingOffset;
+			size_t StagingSize;
+			std::future<void> Built;
+			GLsync Fence{ nullptr };
+		};
+
+		struct PendingFeedback {
+			unsigned int Buffer{ 0 };
+			size_t Capacity{ 0 };
+			GLsync Fence{ nullptr };
+			size_t Frame{ 0 };
+		};
+
+		void readFeedbacks(bool wait);
+		void readFeedback(PendingFeedback& pendingFeedback);
+		void evictLevels(StreamedTexture& streamedTexture);
+		//queues row bands of requested levels on workers, returns false when staging memory ran out
+		bool submitBands(long long& budget);
+		//uploads built bands in submission order and frees staging memory of finished uploads
+		void finishBands(bool wait);
+		//finds contiguous staging range, returns false when bands in flight occupy it
+		bool allocateStaging(size_t size, size_t& offset) const;
+		void setResidentLevel(StreamedTexture& streamedTexture, int level);
+		void createFeedbackTarget(glm::ivec2 size);
+		void deleteFeedbackTarget();
+
+		BS::thread_pool& threadPool;
+		TextureStreamingSettings settings;
+		TextureStreamingStatistics statistics;
+		std::pmr::vector<StreamedTexture> textures;
+		//gl name to index of streamed texture, index is its slot in feedback buffer
+		std::unordered_map<unsigned int, unsigned int> textureSlots;
+		ReloadableProgram feedbackProgram;
+		//ring of feedback buffers in flight, oldest one is at nextFeedback
+		std::array<PendingFeedback, 3> pendingFeedbacks;
+		size_t nextFeedback{ 0 };
+		std::pmr::vector<unsigned int> feedbackLevels;
+		std::pmr::vector<unsigned int> uploadOrder;
+		//in submission order, staging ranges of consecutive bands follow each other around ring
+		std::pmr::vector<Band> bands;
+		unsigned int stagingBuffer{ 0 };
+		unsigned char* stagingMemory{ nullptr };
+		size_t stagingHead{ 0 };
+		unsigned int fbo{ 0 };
+		unsigned int depthTexture{ 0 };
+		glm::ivec2 feedbackTargetSize{ 0 };
+		size_t frame{ 0 };
+		size_t feedbackFrame{ 0 };
+		bool feedbackRequested{ true };
+		//frame of last Invalidate and frame of newest feedback read back
+		size_t invalidatedFrame{ 0 };
+		size_t readFeedbackFrame{ 0 };
+	};
+}
+
+#endif
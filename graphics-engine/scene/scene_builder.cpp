@@ -0,0 +1,118 @@
+#include <scene/scene_builder.h>
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/transform.hpp>
+#include <scene/scene_components.h>
+#include <profiling/profiler.h>
+
+
+dengine::SceneBuilder::SceneBuilder(entt::registry& registry, TransformSystem& transformSystem,
+	IModelImporter& modelImporter, TextureStreamer& textureStreamer, OpenglSettings openglSettings) :
+	registry(registry), transformSystem(transformSystem), modelImporter(modelImporter), textureStreamer(textureStreamer),
+	openglSettings(openglSettings)
+{
+}
+
+
+bool dengine::SceneBuilder::Build(const SceneDescription& sceneDescription)
+{
+	DENGINE_PROFILE_SCOPE("build scene");
+	const size_t firstModel = loadedModels.size();
+	loadedModels.resize(firstModel + sceneDescription.Models.size());
+	for (int i = 0; i < sceneDescription.Models.size(); i++)
+		if (!loadModel(sceneDescription.Models[i], loadedModels[firstModel + i]))
+		{
+			//models of failed scene are already on gpu, failed one itself has nothing loaded
+			loadedModels.resize(firstModel + i);
+			UnloadModels(firstModel);
+			return false;
+		}
+
+	std::pmr::vector<entt::entity> nodeEntities;
+	for (auto& instance : sceneDescription.Instances)
+		instantiate(loadedModels[firstModel + instance.ModelIndex], instance, nodeEntities);
+
+	for (auto& light : sceneDescription.Lights)
+		registry.emplace<LightComponent>(registry.create(), LightComponent{ light.Position, light.Color });
+	if (sceneDescription.Sun)
+		registry.emplace<DirectionalLightComponent>(registry.create(),
+			DirectionalLightComponent{ sceneDescription.Sun->Direction, sceneDescription.Sun->Color });
+	return true;
+}
+
+
+bool dengine::SceneBuilder::loadModel(const SceneModel& sceneModel, LoadedSceneModel& loadedModel)
+{
+	auto model = modelImporter.Import(sceneModel.Path);
+	if (model.Meshes.empty())
+		return false;
+
+	loadedModel.Path = sceneModel.Path;
+	loadedModel.GpuModel = loadModelToGpu(model, textureStreamer);
+	loadedModel.Nodes = std::move(model.Nodes);
+	for (auto& bufferedMesh : loadedModel.GpuModel.Meshes)
+		loadedModel.RenderingUnits.push_back(PbrRenderingScheme::CreateRenderingUnit(bufferedMesh, openglSettings));
+	return true;
+}
+
+
+void dengine::SceneBuilder::unloadModel(LoadedSceneModel& loadedModel)
+{
+	for (auto& renderingUnit : loadedModel.RenderingUnits)
+		PbrRenderingScheme::DeleteRenderingUnit(renderingUnit);
+	loadedModel.RenderingUnits.clear();
+	unloadModelFromGpu(loadedModel.GpuModel, textureStreamer);
+}
+
+
+const std::pmr::vector<dengine::LoadedSceneModel>& dengine::SceneBuilder::GetLoadedModels() const
+{
+	return loadedModels;
+}
+
+
+void dengine::SceneBuilder::UnloadModels(size_t firstModel)
+{
+	for (size_t model = firstModel; model < loadedModels.size(); model++)
+		unloadModel(loadedModels[model]);
+	loadedModels.resize(std::min(firstModel, loadedModels.size()));
+}
+
+
+void dengine::SceneBuilder::instantiate(const LoadedSceneModel& loadedModel, const SceneInstance& instance,
+	std::pmr::vector<entt::entity>& nodeEntities)
+{
+	const glm::mat4 instanceMatrix = glm::translate(instance.Position) * glm::mat4_cast(instance.Rotation) *
+		glm::scale(instance.Scale);
+	const auto& materials = loadedModel.GpuModel.Materils;
+
+	//mirror model node tree in registry, every mesh reference becomes a child entity
+	auto instanceEntity = registry.create();
+	transformSystem.Attach(instanceEntity, entt::null, instanceMatrix);
+	nodeEntities.resize(loadedModel.Nodes.size());
+	for (int i = 0; i < loadedModel.Nodes.size(); i++)
+	{
+		const auto& node = loadedModel.Nodes[i];
+		nodeEntities[i] = registry.create();
+		const auto parentEntity = node.Parent >= 0 ? nodeEntities[node.Parent] : instanceEntity;
+		transformSystem.Attach(nodeEntities[i], parentEntity, node.LocalTransform);
+		for (auto meshIndex : node.MeshIndices)
+		{
+			const bool overrideMaterial = instance.MaterialOverride >= 0 && instance.MaterialOverride < materials.size();
+			const auto& loadedMaterial = materials[overrideMaterial
+				? instance.MaterialOverride
+				: loadedModel.GpuModel.Meshes[meshIndex].MaterialIndex];
+			auto entity = registry.create();
+			transformSystem.Attach(entity, nodeEntities[i], glm::mat4{ 1.0f });
+			registry.emplace<PbrRenderingUnit>(entity, loadedModel.RenderingUnits[meshIndex]);
+			registry.emplace<Material>(entity, Material{
+				loadedMaterial.DiffuseTextureId,
+				loadedMaterial.NormalTextureId,
+				loadedMaterial.MetalnessTextureId,
+			});
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#ifndef SCENE_BUILDER_INCLUDED
+#define SCENE_BUILDER_INCLUDED
+
+#include <vector>
+
+#include <entt/entt.hpp>
+#include <importers/model_importer.h>
+#include <rendering/rendering_tmp.h>
+#include <rendering/schemas/pbr_rendering_scheme.h>
+#include <rendering/texture_streamer.h>
+#include <scene/scene_description.h>
+#include <scene/transform_system.h>
+
+namespace dengine
+{
+	struct LoadedSceneModel {
+		std::pmr::string Path;
+		std::pmr::vector<Node> Nodes;
+		OpenglModel GpuModel;
+		std::pmr::vector<PbrRenderingUnit> RenderingUnits;
+	};
+
+
+	//imports and uploads scene models once and instantiates their node trees into registry
+	class SceneBuilder {
+	public:
+		SceneBuilder(entt::registry& registry, TransformSystem& transformSystem, IModelImporter& modelImporter,
+			TextureStreamer& textureStreamer, OpenglSettings openglSettings);
+		bool Build(const SceneDescription& sceneDescription);
+		//models of every built scene, in load order
+		const std::pmr::vector<LoadedSceneModel>& GetLoadedModels() const;
+		//frees models loaded at or after given index, rolls back models of build whose result was rejected
+		void UnloadModels(size_t firstModel);
+	private:
+		bool loadModel(const SceneModel& sceneModel, LoadedSceneModel& loadedModel);
+		void unloadModel(LoadedSceneModel& loadedModel);
+		void instantiate(const LoadedSceneModel& loadedModel, const SceneInstance& instance,
+			std::pmr::vector<entt::entity>& nodeEntities);
+
+		entt::registry& registry;
+		TransformSystem& transformSystem;
+		IModelImporter& modelImporter;
+		TextureStreamer& textureStreamer;
+		OpenglSettings openglSettings;
+		std::pmr::vector<LoadedSceneModel> loadedModels;
+	};
+}
+
+#endif
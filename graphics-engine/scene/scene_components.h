@@ -0,0 +1,22 @@
+#ifndef SCENE_COMPONENTS_INCLUDED
+#define SCENE_COMPONENTS_INCLUDED
+
+#include <glm/glm.hpp>
+
+namespace dengine
+{
+	struct LightComponent {
+		glm::vec4 Position;
+		//alpha is intensity
+		glm::vec4 Color;
+	};
+
+	struct DirectionalLightComponent {
+		//direction light travels in
+		glm::vec4 Direction;
+		//alpha is intensity
+		glm::vec4 Color;
+	};
+}
+
+#endif
@@ -0,0 +1,260 @@
+#include <scene/scene_description.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+namespace fs = std::filesystem;
+
+#include <spdlog/spdlog.h>
+#include <utils/mapped_file.h>
+
+
+constexpr const char* SceneFileExtension = ".dscene";
+constexpr int SceneFormatVersion = 1;
+
+
+//cursor over a single line of mapped scene file
+class LineReader {
+public:
+	LineReader(const char* begin, const char* end) : current(begin), end(end) {}
+
+	std::string_view NextToken()
+	{
+		skipSpaces();
+		const char* tokenBegin = current;
+		while (current < end && *current != ' ' && *current != '\t' && *current != '\r')
+			current++;
+		return std::string_view(tokenBegin, current - tokenBegin);
+	}
+
+	bool Read(float& value)
+	{
+		skipSpaces();
+		auto [ptr, error] = std::from_chars(current, end, value);
+		current = ptr;
+		return error == std::errc();
+	}
+
+	template<typename TInteger>
+	bool Read(TInteger& value)
+	{
+		skipSpaces();
+		auto [ptr, error] = std::from_chars(current, end, value);
+		current = ptr;
+		return error == std::errc();
+	}
+
+	bool AtEnd()
+	{
+		skipSpaces();
+		return current >= end || *current == '\r';
+	}
+
+	std::string_view Rest()
+	{
+		skipSpaces();
+		const char* restEnd = end;
+		while (restEnd > current && (restEnd[-1] == '\r' || restEnd[-1] == ' ' || restEnd[-1] == '\t'))
+			restEnd--;
+		return std::string_view(current, restEnd - current);
+	}
+private:
+	void skipSpaces()
+	{
+		while (current < end && (*current == ' ' || *current == '\t'))
+			current++;
+	}
+
+	const char* current;
+	const char* end;
+};
+
+
+bool dengine::isSceneDescriptionFile(const std::pmr::string& path)
+{
+	return fs::path(path.c_str()).extension() == SceneFileExtension;
+}
+
+
+bool dengine::loadSceneDescription(const std::pmr::string& path, SceneDescription& sceneDescription)
+{
+	auto log = spdlog::get("app_logger");
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		log->error("Failed to open scene file {}", path.c_str());
+		return false;
+	}
+
+	const char* data = file.Data();
+	const char* dataEnd = data + file.Size();
+	//instances dominate large scenes, reserve by line count so parsing never reallocates
+	sceneDescription.Instances.reserve(std::count(data, dataEnd, '\n') + 1);
+	const fs::path sceneDirectory = fs::path(path.c_str()).parent_path();
+
+	unsigned int lineNumber = 0;
+	bool headerFound = false;
+	while (data < dataEnd)
+	{
+		const char* lineEnd = static_cast<const char*>(std::memchr(data, '\n', dataEnd - data));
+		if (lineEnd == nullptr)
+			lineEnd = dataEnd;
+		lineNumber++;
+		LineReader reader(data, lineEnd);
+		data = lineEnd + 1;
+
+		const auto recordType = reader.NextToken();
+		if (recordType.empty() || recordType[0] == '#')
+			continue;
+
+		bool parsed = true;
+		if (recordType == "dscene")
+		{
+			int version = 0;
+			parsed = reader.Read(version) && version == SceneFormatVersion;
+			headerFound = parsed;
+		}
+		else if (recordType == "model")
+		{
+			const auto relativePath = reader.Rest();
+			parsed = !relativePath.empty();
+			const auto modelPath = (sceneDirectory / fs::path(relativePath)).lexically_normal();
+			sceneDescription.Models.push_back(SceneModel{ std::pmr::string(modelPath.string()) });
+		}
+		else if (recordType == "instance")
+		{
+			SceneInstance instance;
+			parsed = reader.Read(instance.ModelIndex) &&
+				reader.Read(instance.Position.x) && reader.Read(instance.Position.y) && reader.Read(instance.Position.z) &&
+				reader.Read(instance.Rotation.w) && reader.Read(instance.Rotation.x) &&
+				reader.Read(instance.Rotation.y) && reader.Read(instance.Rotation.z) &&
+				reader.Read(instance.Scale.x) && reader.Read(instance.Scale.y) && reader.Read(instance.Scale.z);
+			if (parsed && !reader.AtEnd())
+				parsed = reader.Read(instance.MaterialOverride);
+			parsed = parsed && instance.ModelIndex < sceneDescription.Models.size();
+			sceneDescription.Instances.push_back(instance);
+		}
+		else if (recordType == "light")
+		{
+			SceneLight light{ glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(1.0f) };
+			parsed = reader.Read(light.Position.x) && reader.Read(light.Position.y) && reader.Read(light.Position.z) &&
+				reader.Read(light.Color.r) && reader.Read(light.Color.g) && reader.Read(light.Color.b) &&
+				reader.Read(light.Color.a);
+			sceneDescription.Lights.push_back(light);
+		}
+		else if (recordType == "sun")
+		{
+			SceneDirectionalLight sun{ glm::vec4(0.0f), glm::vec4(1.0f) };
+			parsed = !sceneDescription.Sun &&
+				reader.Read(sun.Direction.x) && reader.Read(sun.Direction.y) && reader.Read(sun.Direction.z) &&
+				reader.Read(sun.Color.r) && reader.Read(sun.Color.g) && reader.Read(sun.Color.b) &&
+				reader.Read(sun.Color.a) && glm::dot(sun.Direction, sun.Direction) > 0.0f;
+			sceneDescription.Sun = sun;
+		}
+		else if (recordType == "environment")
+		{
+			const auto relativePath = reader.Rest();
+			parsed = !relativePath.empty();
+			const auto environmentPath = (sceneDirectory / fs::path(relativePath)).lexically_normal();
+			sceneDescription.EnvironmentMap = environmentPath.string();
+		}
+		else
+			parsed = false;
+
+		//paths take rest of line, every other record ends with its last value
+		const bool pathRecord = recordType == "model" || recordType == "environment";
+		if (parsed && headerFound && !pathRecord && !reader.AtEnd())
+		{
+			log->error("Unexpected token {} in scene file {} at line {}", reader.NextToken(), path.c_str(), lineNumber);
+			return false;
+		}
+		if (!parsed || !headerFound)
+		{
+			log->error("Failed to parse scene file {} at line {}", path.c_str(), lineNumber);
+			return false;
+		}
+	}
+	sceneDescription.Instances.shrink_to_fit();
+	log->info("Loaded scene {}: {} models, {} instances, {} lights", path.c_str(), sceneDescription.Models.size(),
+		sceneDescription.Instances.size(), sceneDescription.Lights.size());
+	return true;
+}
+
+
+template<typename TValue>
+char* writeValue(char* buffer, char* bufferEnd, TValue value)
+{
+	*buffer++ = ' ';
+	return std::to_chars(buffer, bufferEnd, value).ptr;
+}
+
+
+bool dengine::writeSceneDescription(const std::pmr::string& path, const SceneDescription& sceneDescription)
+{
+	std::ofstream stream(path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!stream.is_open())
+		return false;
+
+	const fs::path sceneDirectory = fs::absolute(fs::path(path.c_str())).parent_path();
+	stream << "dscene " << SceneFormatVersion << '\n';
+	for (auto& model : sceneDescription.Models)
+	{
+		auto modelPath = fs::absolute(fs::path(model.Path.c_str())).lexically_relative(sceneDirectory);
+		stream << "model " << modelPath.generic_string() << '\n';
+	}
+	if (!sceneDescription.EnvironmentMap.empty())
+	{
+		auto environmentPath = fs::absolute(fs::path(sceneDescription.EnvironmentMap.c_str())).lexically_relative(sceneDirectory);
+		stream << "environment " << environmentPath.generic_string() << '\n';
+	}
+
+	char line[512];
+	const auto lineEnd = line + sizeof(line);
+	for (auto& instance : sceneDescription.Instances)
+	{
+		char* cursor = line;
+		std::memcpy(cursor, "instance", 8);
+		cursor += 8;
+		cursor = writeValue(cursor, lineEnd, instance.ModelIndex);
+		for (int i = 0; i < 3; i++)
+			cursor = writeValue(cursor, lineEnd, instance.Position[i]);
+		cursor = writeValue(cursor, lineEnd, instance.Rotation.w);
+		for (int i = 0; i < 3; i++)
+			cursor = writeValue(cursor, lineEnd, instance.Rotation[i]);
+		for (int i = 0; i < 3; i++)
+			cursor = writeValue(cursor, lineEnd, instance.Scale[i]);
+		if (instance.MaterialOverride >= 0)
+			cursor = writeValue(cursor, lineEnd, instance.MaterialOverride);
+		*cursor++ = '\n';
+		stream.write(line, cursor - line);
+	}
+
+	for (auto& light : sceneDescription.Lights)
+	{
+		char* cursor = line;
+		std::memcpy(cursor, "light", 5);
+		cursor += 5;
+		for (int i = 0; i < 3; i++)
+			cursor = writeValue(cursor, lineEnd, light.Position[i]);
+		for (int i = 0; i < 4; i++)
+			cursor = writeValue(cursor, lineEnd, light.Color[i]);
+		*cursor++ = '\n';
+		stream.write(line, cursor - line);
+	}
+
+	if (sceneDescription.Sun)
+	{
+		char* cursor = line;
+		std::memcpy(cursor, "sun", 3);
+		cursor += 3;
+		for (int i = 0; i < 3; i++)
+			cursor = writeValue(cursor, lineEnd, sceneDescription.Sun->Direction[i]);
+		for (int i = 0; i < 4; i++)
+			cursor = writeValue(cursor, lineEnd, sceneDescription.Sun->Color[i]);
+		*cursor++ = '\n';
+		stream.write(line, cursor - line);
+	}
+	return stream.good();
+}
@@ -0,0 +1,63 @@
+#ifndef SCENE_DESCRIPTION_INCLUDED
+#define SCENE_DESCRIPTION_INCLUDED
+
+#include <vector>
+#include <string>
+#include <optional>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace dengine
+{
+	/*
+	 * Text scene format, one record per line, '#' starts a comment:
+	 *   dscene 1
+	 *   model <path>                                      - models are indexed in order of appearance
+	 *   instance <model> <px py pz> <qw qx qy qz> <sx sy sz> [material]
+	 *   light <px py pz> <r g b> <intensity>
+	 *   sun <dx dy dz> <r g b> <intensity>                - directional light casting shadows, at most one
+	 *   environment <path>                                - equirectangular hdr used for image based lighting
+	 * Model and environment paths are relative to the scene file. Material overrides index into the model materials.
+	 */
+	struct SceneModel {
+		std::pmr::string Path;
+	};
+
+	struct SceneInstance {
+		unsigned int ModelIndex{ 0 };
+		glm::vec3 Position{ 0.0f };
+		glm::quat Rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+		glm::vec3 Scale{ 1.0f };
+		int MaterialOverride{ -1 };
+	};
+
+	struct SceneLight {
+		glm::vec4 Position;
+		//alpha is intensity
+		glm::vec4 Color;
+	};
+
+	struct SceneDirectionalLight {
+		//direction light travels in
+		glm::vec4 Direction;
+		//alpha is intensity
+		glm::vec4 Color;
+	};
+
+	struct SceneDescription {
+		std::pmr::vector<SceneModel> Models;
+		std::pmr::vector<SceneInstance> Instances;
+		std::pmr::vector<SceneLight> Lights;
+		//renderers light scenes without sun by default one
+		std::optional<SceneDirectionalLight> Sun;
+		//empty when scene has no environment
+		std::pmr::string EnvironmentMap;
+	};
+
+	bool isSceneDescriptionFile(const std::pmr::string& path);
+	bool loadSceneDescription(const std::pmr::string& path, SceneDescription& sceneDescription);
+	bool writeSceneDescription(const std::pmr::string& path, const SceneDescription& sceneDescription);
+}
+
+#endif
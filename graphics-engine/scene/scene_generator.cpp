@@ -0,0 +1,68 @@
+#include <scene/scene_generator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <glm/gtc/constants.hpp>
+
+
+dengine::SceneDescription dengine::generateGridScene(const std::pmr::vector<std::pmr::string>& modelPaths,
+	const GridSceneSettings& settings)
+{
+	SceneDescription sceneDescription;
+	for (auto& modelPath : modelPaths)
+		sceneDescription.Models.push_back(SceneModel{ modelPath });
+	if (modelPaths.empty())
+		return sceneDescription;
+
+	std::mt19937 generator(settings.Seed);
+	std::uniform_real_distribution<float> angleDistribution(0.0f, glm::two_pi<float>());
+	std::uniform_real_distribution<float> scaleDistribution(1.0f - settings.ScaleJitter, 1.0f + settings.ScaleJitter);
+
+	const auto gridSize = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(settings.InstanceCount))));
+	const float gridOrigin = -0.5f * settings.Spacing * static_cast<float>(gridSize - 1);
+	sceneDescription.Instances.reserve(settings.InstanceCount);
+	for (unsigned int i = 0; i < settings.InstanceCount; i++)
+	{
+		SceneInstance instance;
+		instance.ModelIndex = i % modelPaths.size();
+		instance.Position = glm::vec3(gridOrigin + settings.Spacing * static_cast<float>(i % gridSize), 0.0f,
+			gridOrigin + settings.Spacing * static_cast<float>(i / gridSize));
+		if (settings.RandomRotation)
+			instance.Rotation = glm::angleAxis(angleDistribution(generator), glm::vec3(0.0f, 1.0f, 0.0f));
+		instance.Scale = glm::vec3(settings.ScaleJitter > 0.0f ? scaleDistribution(generator) : 1.0f);
+		sceneDescription.Instances.push_back(instance);
+	}
+	return sceneDescription;
+}
+
+
+void dengine::generateRandomLights(SceneDescription& sceneDescription, const RandomLightsSettings& settings)
+{
+	glm::vec3 boundsMin(-1.0f);
+	glm::vec3 boundsMax(1.0f);
+	if (!sceneDescription.Instances.empty())
+	{
+		boundsMin = boundsMax = sceneDescription.Instances[0].Position;
+		for (auto& instance : sceneDescription.Instances)
+		{
+			boundsMin = glm::min(boundsMin, instance.Position);
+			boundsMax = glm::max(boundsMax, instance.Position);
+		}
+	}
+
+	std::mt19937 generator(settings.Seed);
+	std::uniform_real_distribution<float> xDistribution(boundsMin.x, boundsMax.x);
+	std::uniform_real_distribution<float> zDistribution(boundsMin.z, boundsMax.z);
+	std::uniform_real_distribution<float> colorDistribution(0.3f, 1.0f);
+	std::uniform_real_distribution<float> intensityDistribution(settings.MinIntensity, settings.MaxIntensity);
+	for (unsigned int i = 0; i < settings.LightCount; i++)
+	{
+		sceneDescription.Lights.push_back(SceneLight{
+			glm::vec4(xDistribution(generator), boundsMax.y + settings.Height, zDistribution(generator), 1.0f),
+			glm::vec4(colorDistribution(generator), colorDistribution(generator), colorDistribution(generator),
+				intensityDistribution(generator))
+		});
+	}
+}
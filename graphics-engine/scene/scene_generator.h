@@ -0,0 +1,31 @@
+#ifndef SCENE_GENERATOR_INCLUDED
+#define SCENE_GENERATOR_INCLUDED
+
+#include <scene/scene_description.h>
+
+namespace dengine
+{
+	struct GridSceneSettings {
+		unsigned int InstanceCount{ 1000 };
+		float Spacing{ 2.0f };
+		//random yaw and uniform scale jitter, keeps batches from being trivially identical
+		bool RandomRotation{ true };
+		float ScaleJitter{ 0.0f };
+		unsigned int Seed{ 1 };
+	};
+
+	struct RandomLightsSettings {
+		unsigned int LightCount{ 16 };
+		float Height{ 3.0f };
+		float MinIntensity{ 5.0f };
+		float MaxIntensity{ 25.0f };
+		unsigned int Seed{ 1 };
+	};
+
+	//places instances of given models round robin on a square grid centered at origin
+	SceneDescription generateGridScene(const std::pmr::vector<std::pmr::string>& modelPaths, const GridSceneSettings& settings);
+	//scatters lights over the bounds of scene instances
+	void generateRandomLights(SceneDescription& sceneDescription, const RandomLightsSettings& settings);
+}
+
+#endif
@@ -0,0 +1,303 @@
+#include <scene/transform_system.h>
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include <profiling/profiler.h>
+
+
+//levels smaller than this are not worth dispatching to the thread pool
+constexpr unsigned int ParallelLevelThreshold = 2048;
+//with fewer than one dirty slot in this many, subtrees of dirty slots are walked instead of scanning every level
+constexpr size_t SparseUpdateRatio = 16;
+
+
+dengine::TransformSystem::TransformSystem(entt::registry& registry, BS::thread_pool& threadPool) :
+	registry(registry), threadPool(threadPool)
+{
+	registry.on_destroy<HierarchyComponent>().connect<&TransformSystem::onDestroy>(*this);
+}
+
+
+dengine::TransformSystem::~TransformSystem()
+{
+	registry.on_destroy<HierarchyComponent>().disconnect<&TransformSystem::onDestroy>(*this);
+}
+
+
+void dengine::TransformSystem::Attach(entt::entity entity, entt::entity parent, const glm::mat4& localMatrix)
+{
+	int parentSlot = -1;
+	unsigned int depth = 0;
+	if (parent != entt::null)
+	{
+		parentSlot = static_cast<int>(registry.get<HierarchyComponent>(parent).Slot);
+		depth = depths[parentSlot] + 1;
+	}
+
+	//already attached entity keeps its slot, so its children still point at it
+	auto* hierarchy = registry.try_get<HierarchyComponent>(entity);
+	if (hierarchy != nullptr && hierarchy->Slot < entities.size() && entities[hierarchy->Slot] == entity)
+	{
+		const auto slot = hierarchy->Slot;
+		for (int ancestor = parentSlot; ancestor >= 0; ancestor = parents[ancestor])
+			if (ancestor == static_cast<int>(slot))
+			{
+				spdlog::get("app_logger")->error("entity can not be attached to its own descendant");
+				return;
+			}
+		parents[slot] = parentSlot;
+		localMatrices[slot] = localMatrix;
+		if (!dirtyFlags[slot])
+			dirtySlots.push_back(slot);
+		dirtyFlags[slot] = 1;
+		hierarchy->Parent = parent;
+		//parent may now follow child, rebuildOrder resolves depths without relying on slot order
+		orderDirty = true;
+		transformsDirty = true;
+		return;
+	}
+
+	const auto slot = static_cast<unsigned int>(entities.size());
+	entities.push_back(entity);
+	parents.push_back(parentSlot);
+	depths.push_back(depth);
+	localMatrices.push_back(localMatrix);
+	worldMatrices.push_back(localMatrix);
+	dirtyFlags.push_back(1);
+	dirtySlots.push_back(slot);
+	registry.emplace_or_replace<HierarchyComponent>(entity, parent, slot);
+	registry.emplace_or_replace<TransformComponent>(entity, localMatrix);
+
+	//appending keeps parents before children but breaks depth order
+	orderDirty = true;
+	transformsDirty = true;
+}
+
+
+void dengine::TransformSystem::SetLocalMatrix(entt::entity entity, const glm::mat4& localMatrix)
+{
+	const auto slot = registry.get<HierarchyComponent>(entity).Slot;
+	localMatrices[slot] = localMatrix;
+	if (!dirtyFlags[slot])
+		dirtySlots.push_back(slot);
+	dirtyFlags[slot] = 1;
+	transformsDirty = true;
+}
+
+
+const glm::mat4& dengine::TransformSystem::GetLocalMatrix(entt::entity entity) const
+{
+	return localMatrices[registry.get<HierarchyComponent>(entity).Slot];
+}
+
+
+void dengine::TransformSystem::Update()
+{
+	DENGINE_PROFILE_SCOPE("update transforms");
+	if (orderDirty)
+		rebuildOrder();
+	if (!transformsDirty)
+		return;
+
+	if (dirtySlots.size() * SparseUpdateRatio < entities.size())
+	{
+		propagateSparse();
+		//publish on calling thread, so on_update listeners never run concurrently
+		for (auto slot : updatedSlots)
+		{
+			registry.patch<TransformComponent>(entities[slot], [&](auto& transform)
+			{
+				transform.ModelMatrix = worldMatrices[slot];
+			});
+			dirtyFlags[slot] = 0;
+		}
+		dirtySlots.clear();
+		transformsDirty = false;
+		return;
+	}
+
+	for (unsigned int level = 0; level + 1 < levelOffsets.size(); level++)
+	{
+		const unsigned int begin = levelOffsets[level];
+		const unsigned int end = levelOffsets[level + 1];
+		//every parent lives in a previous level, so slots of one level are independent
+		if (end - begin < ParallelLevelThreshold)
+			propagate(begin, end);
+		else
+			threadPool.parallelize_loop(begin, end, [this](unsigned int first, unsigned int last)
+			{
+				DENGINE_PROFILE_SCOPE("propagate transforms");
+				propagate(first, last);
+			}).wait();
+	}
+
+	for (unsigned int slot = 0; slot < entities.size(); slot++)
+		if (dirtyFlags[slot])
+			registry.patch<TransformComponent>(entities[slot], [&](auto& transform)
+			{
+				transform.ModelMatrix = worldMatrices[slot];
+			});
+	std::fill(dirtyFlags.begin(), dirtyFlags.end(), 0);
+	dirtySlots.clear();
+	transformsDirty = false;
+}
+
+
+bool dengine::TransformSystem::IsDirty() const
+{
+	return transformsDirty || orderDirty;
+}
+
+
+void dengine::TransformSystem::propagate(unsigned int begin, unsigned int end)
+{
+	for (unsigned int slot = begin; slot < end; slot++)
+	{
+		const int parentSlot = parents[slot];
+		if (parentSlot >= 0 && dirtyFlags[parentSlot])
+			dirtyFlags[slot] = 1;
+		if (!dirtyFlags[slot])
+			continue;
+
+		worldMatrices[slot] = parentSlot >= 0 ? worldMatrices[parentSlot] * localMatrices[slot] : localMatrices[slot];
+	}
+}
+
+
+void dengine::TransformSystem::propagateSparse()
+{
+	//slots are depth ordered, so ancestors are walked before their dirty descendants and cover them
+	std::sort(dirtySlots.begin(), dirtySlots.end());
+	updatedSlots.clear();
+	for (auto dirtySlot : dirtySlots)
+	{
+		if (dirtyFlags[dirtySlot] == 2)
+			continue;
+		const size_t subtreeBegin = updatedSlots.size();
+		updatedSlots.push_back(dirtySlot);
+		for (size_t i = subtreeBegin; i < updatedSlots.size(); i++)
+		{
+			const auto slot = updatedSlots[i];
+			const int parentSlot = parents[slot];
+			worldMatrices[slot] = parentSlot >= 0 ? worldMatrices[parentSlot] * localMatrices[slot] : localMatrices[slot];
+			dirtyFlags[slot] = 2;
+			updatedSlots.insert(updatedSlots.end(), childSlots.begin() + childOffsets[slot],
+				childSlots.begin() + childOffsets[slot + 1]);
+		}
+	}
+}
+
+
+void dengine::TransformSystem::onDestroy(entt::registry&, entt::entity entity)
+{
+	const auto slot = registry.get<HierarchyComponent>(entity).Slot;
+	entities[slot] = entt::null;
+	//children known since last rebuild lose parent right away, ones attached later are cleared by rebuildOrder
+	if (!orderDirty && slot + 1 < childOffsets.size())
+		for (auto child = childOffsets[slot]; child < childOffsets[slot + 1]; child++)
+			if (entities[childSlots[child]] != entt::null)
+				registry.get<HierarchyComponent>(entities[childSlots[child]]).Parent = entt::null;
+	orderDirty = true;
+}
+
+
+void dengine::TransformSystem::rebuildOrder()
+{
+	const auto count = static_cast<unsigned int>(entities.size());
+	std::pmr::vector<unsigned int> newSlots(count, 0);
+	for (unsigned int slot = 0; slot < count; slot++)
+	{
+		if (entities[slot] == entt::null)
+			continue;
+		const int parentSlot = parents[slot];
+		const bool hasParent = parentSlot >= 0 && entities[parentSlot] != entt::null;
+		if (!hasParent && parentSlot >= 0)
+		{
+			//orphaned by destroyed parent, becomes root
+			dirtyFlags[slot] = 1;
+			registry.get<HierarchyComponent>(entities[slot]).Parent = entt::null;
+		}
+		parents[slot] = hasParent ? parentSlot : -1;
+	}
+
+	//reattached entities may precede their parent, so depth is resolved by walking up to first known ancestor
+	unsigned int maxDepth = 0;
+	std::pmr::vector<unsigned char> resolved(count, 0);
+	std::pmr::vector<unsigned int> chain;
+	for (unsigned int slot = 0; slot < count; slot++)
+	{
+		if (entities[slot] == entt::null || resolved[slot])
+			continue;
+		chain.clear();
+		int ancestor = static_cast<int>(slot);
+		for (; ancestor >= 0 && !resolved[ancestor]; ancestor = parents[ancestor])
+			chain.push_back(ancestor);
+		unsigned int depth = ancestor >= 0 ? depths[ancestor] + 1 : 0;
+		for (auto chainSlot = chain.rbegin(); chainSlot != chain.rend(); chainSlot++, depth++)
+		{
+			depths[*chainSlot] = depth;
+			resolved[*chainSlot] = 1;
+		}
+		maxDepth = std::max(maxDepth, depth - 1);
+	}
+
+	//counting sort by depth, stable so siblings keep their relative order
+	std::pmr::vector<unsigned int> offsets(maxDepth + 2, 0);
+	for (unsigned int slot = 0; slot < count; slot++)
+		if (entities[slot] != entt::null)
+			offsets[depths[slot] + 1]++;
+	for (unsigned int level = 1; level < offsets.size(); level++)
+		offsets[level] += offsets[level - 1];
+	levelOffsets = offsets;
+	for (unsigned int slot = 0; slot < count; slot++)
+		if (entities[slot] != entt::null)
+			newSlots[slot] = offsets[depths[slot]]++;
+
+	const unsigned int newCount = levelOffsets.back();
+	std::pmr::vector<entt::entity> sortedEntities(newCount);
+	std::pmr::vector<int> sortedParents(newCount);
+	std::pmr::vector<unsigned int> sortedDepths(newCount);
+	std::pmr::vector<glm::mat4> sortedLocalMatrices(newCount);
+	std::pmr::vector<glm::mat4> sortedWorldMatrices(newCount);
+	std::pmr::vector<unsigned char> sortedDirtyFlags(newCount);
+	auto hierarchies = registry.view<HierarchyComponent>();
+	for (unsigned int slot = 0; slot < count; slot++)
+	{
+		if (entities[slot] == entt::null)
+			continue;
+		const auto newSlot = newSlots[slot];
+		sortedEntities[newSlot] = entities[slot];
+		sortedParents[newSlot] = parents[slot] >= 0 ? static_cast<int>(newSlots[parents[slot]]) : -1;
+		sortedDepths[newSlot] = depths[slot];
+		sortedLocalMatrices[newSlot] = localMatrices[slot];
+		sortedWorldMatrices[newSlot] = worldMatrices[slot];
+		sortedDirtyFlags[newSlot] = dirtyFlags[slot];
+		hierarchies.get<HierarchyComponent>(entities[slot]).Slot = newSlot;
+		transformsDirty = transformsDirty || dirtyFlags[slot];
+	}
+
+	entities = std::move(sortedEntities);
+	parents = std::move(sortedParents);
+	depths = std::move(sortedDepths);
+	localMatrices = std::move(sortedLocalMatrices);
+	worldMatrices = std::move(sortedWorldMatrices);
+	dirtyFlags = std::move(sortedDirtyFlags);
+
+	dirtySlots.clear();
+	childOffsets.assign(newCount + 2, 0);
+	for (unsigned int slot = 0; slot < newCount; slot++)
+	{
+		if (dirtyFlags[slot])
+			dirtySlots.push_back(slot);
+		if (parents[slot] >= 0)
+			childOffsets[parents[slot] + 2]++;
+	}
+	for (unsigned int slot = 2; slot < childOffsets.size(); slot++)
+		childOffsets[slot] += childOffsets[slot - 1];
+	childSlots.resize(childOffsets.back());
+	for (unsigned int slot = 0; slot < newCount; slot++)
+		if (parents[slot] >= 0)
+			childSlots[childOffsets[parents[slot] + 1]++] = slot;
+	childOffsets.pop_back();
+	orderDirty = false;
+}
@@ -0,0 +1,70 @@
+#ifndef TRANSFORM_SYSTEM_INCLUDED
+#define TRANSFORM_SYSTEM_INCLUDED
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <entt/entt.hpp>
+#include <BS_thread_pool.hpp>
+
+namespace dengine
+{
+	//world matrix of entity, written by TransformSystem
+	struct TransformComponent {
+		glm::mat4 ModelMatrix;
+	};
+
+
+	struct HierarchyComponent {
+		entt::entity Parent{ entt::null };
+		//index into TransformSystem arrays, changes when hierarchy is reordered
+		unsigned int Slot{ 0 };
+	};
+
+
+	class TransformSystem {
+	public:
+		TransformSystem(entt::registry& registry, BS::thread_pool& threadPool);
+		~TransformSystem();
+		TransformSystem(const TransformSystem&) = delete;
+		TransformSystem& operator=(const TransformSystem&) = delete;
+
+		//parent must be attached before its children, entt::null makes entity a root; attaching attached entity
+		//again moves it with its subtree under new parent, parent inside that subtree is rejected
+		void Attach(entt::entity entity, entt::entity parent, const glm::mat4& localMatrix);
+		void SetLocalMatrix(entt::entity entity, const glm::mat4& localMatrix);
+		const glm::mat4& GetLocalMatrix(entt::entity entity) const;
+		void Update();
+		//local matrices or hierarchy changed since last Update
+		bool IsDirty() const;
+	private:
+		void onDestroy(entt::registry&, entt::entity entity);
+		void rebuildOrder();
+		void propagate(unsigned int begin, unsigned int end);
+		//walks subtrees of dirty slots only, returns updated slots in updatedSlots
+		void propagateSparse();
+
+		entt::registry& registry;
+		BS::thread_pool& threadPool;
+
+		//stored SoA and sorted by depth, so parents are always updated before children
+		std::pmr::vector<entt::entity> entities;
+		std::pmr::vector<int> parents;
+		std::pmr::vector<unsigned int> depths;
+		std::pmr::vector<glm::mat4> localMatrices;
+		std::pmr::vector<glm::mat4> worldMatrices;
+		std::pmr::vector<unsigned char> dirtyFlags;
+		//slots whose local matrix changed since last Update, each listed once
+		std::pmr::vector<unsigned int> dirtySlots;
+		//children of slot are childSlots[childOffsets[slot]..childOffsets[slot + 1]), rebuilt with order
+		std::pmr::vector<unsigned int> childOffsets;
+		std::pmr::vector<unsigned int> childSlots;
+		std::pmr::vector<unsigned int> updatedSlots;
+		//first slot of every depth level, last element is total count
+		std::pmr::vector<unsigned int> levelOffsets;
+		bool orderDirty{ false };
+		bool transformsDirty{ false };
+	};
+}
+
+#endif
@@ -0,0 +1,42 @@
+#include <utils/directory_watcher.h>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+
+dengine::DirectoryWatcher::DirectoryWatcher(const std::pmr::string& directory, std::chrono::milliseconds interval) :
+	directory(directory), interval(interval), lastScan(std::chrono::steady_clock::now())
+{
+	scan();
+}
+
+
+bool dengine::DirectoryWatcher::Poll()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (now - lastScan < interval)
+		return false;
+	lastScan = now;
+	return scan();
+}
+
+
+bool dengine::DirectoryWatcher::scan()
+{
+	//editors often replace files on save, so file set is compared as well as times
+	std::pmr::unordered_map<std::pmr::string, long long> currentTimes;
+	std::error_code error;
+	for (fs::directory_iterator entryIter(directory.c_str(), error), end; !error && entryIter != end;
+		entryIter.increment(error))
+	{
+		std::error_code entryError;
+		if (!entryIter->is_regular_file(entryError))
+			continue;
+		const auto writeTime = entryIter->last_write_time(entryError);
+		if (!entryError)
+			currentTimes.emplace(entryIter->path().string(), writeTime.time_since_epoch().count());
+	}
+	const bool changed = currentTimes != modificationTimes;
+	modificationTimes = std::move(currentTimes);
+	return changed;
+}
@@ -0,0 +1,29 @@
+#ifndef DIRECTORY_WATCHER_INCLUDED
+#define DIRECTORY_WATCHER_INCLUDED
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+namespace dengine
+{
+	//detects added, removed and modified files by polling modification times,
+	//directory is rescanned at most once per interval so it is cheap to poll every frame
+	class DirectoryWatcher {
+	public:
+		explicit DirectoryWatcher(const std::pmr::string& directory,
+			std::chrono::milliseconds interval = std::chrono::milliseconds(250));
+
+		//true when directory changed since previous call
+		bool Poll();
+	private:
+		bool scan();
+
+		std::pmr::string directory;
+		std::chrono::milliseconds interval;
+		std::chrono::steady_clock::time_point lastScan;
+		std::pmr::unordered_map<std::pmr::string, long long> modificationTimes;
+	};
+}
+
+#endif
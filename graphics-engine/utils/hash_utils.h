@@ -0,0 +1,21 @@
+#ifndef HASH_UTILS_INCLUDED
+#define HASH_UTILS_INCLUDED
+
+#include <cstddef>
+
+namespace dengine
+{
+	//fnv-1a, stable across runs and platforms unlike std::hash, used for on-disk cache keys
+	inline unsigned long long hashBytes(const void* data, size_t size, unsigned long long hash = 0xcbf29ce484222325ull)
+	{
+		const auto bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+}
+
+#endif
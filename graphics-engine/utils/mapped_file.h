@@ -0,0 +1,32 @@
+#ifndef MAPPED_FILE_INCLUDED
+#define MAPPED_FILE_INCLUDED
+
+#include <string>
+
+namespace dengine
+{
+	//read only memory mapping of whole file
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::pmr::string& path);
+		void Close();
+		const char* Data() const { return data; }
+		size_t Size() const { return size; }
+	private:
+		const char* data{ nullptr };
+		size_t size{ 0 };
+#ifdef _WIN32
+		void* fileHandle{ nullptr };
+		void* mappingHandle{ nullptr };
+#else
+		int fileDescriptor{ -1 };
+#endif
+	};
+}
+
+#endif
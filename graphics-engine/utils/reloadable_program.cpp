@@ -0,0 +1,66 @@
+#include <utils/reloadable_program.h>
+
+#include <array>
+#include <glad/glad.h>
+
+
+dengine::ReloadableProgram::ReloadableProgram(std::span<const ShaderStage> stages,
+	std::span<const char* const> defines, void (*onLinked)(unsigned int program)) :
+	stages(stages.begin(), stages.end()), defines(defines.begin(), defines.end()), onLinked(onLinked)
+{
+	Compile();
+}
+
+
+dengine::ReloadableProgram::ReloadableProgram(const char* vertexPath, const char* fragmentPath,
+	std::span<const char* const> defines, void (*onLinked)(unsigned int program)) :
+	ReloadableProgram(std::array<ShaderStage, 2>{ ShaderStage{ GL_VERTEX_SHADER, vertexPath },
+		ShaderStage{ GL_FRAGMENT_SHADER, fragmentPath } }, defines, onLinked)
+{
+}
+
+
+dengine::ReloadableProgram::~ReloadableProgram()
+{
+	if (compiling)
+		cancelProgramCompilation(pending);
+	glDeleteProgram(program);
+}
+
+
+void dengine::ReloadableProgram::Compile()
+{
+	if (compiling)
+		cancelProgramCompilation(pending);
+	pending = beginProgramCompilation(stages, defines);
+	compiling = true;
+}
+
+
+void dengine::ReloadableProgram::Update(bool wait)
+{
+	if (!compiling || !pollProgramCompilation(pending, wait))
+		return;
+	compiling = false;
+	if (pending.Program == 0)
+		return;
+	if (onLinked != nullptr)
+		onLinked(pending.Program);
+	glDeleteProgram(program);
+	program = pending.Program;
+	pending = PendingProgram{};
+}
+
+
+unsigned int dengine::ReloadableProgram::Get()
+{
+	if (program == 0)
+		Update(false);
+	return program;
+}
+
+
+bool dengine::ReloadableProgram::IsCompiling() const
+{
+	return compiling;
+}
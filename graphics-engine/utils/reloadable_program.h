@@ -0,0 +1,42 @@
+#ifndef RELOADABLE_PROGRAM_INCLUDED
+#define RELOADABLE_PROGRAM_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <utils/shader_load_utils.h>
+
+namespace dengine
+{
+	//linked program that can be recompiled from its files at runtime,
+	//last linked program stays in use until replacement links, failed replacement is dropped
+	class ReloadableProgram {
+	public:
+		//onLinked sets up program state not stored in shader sources, called for every new program
+		ReloadableProgram(std::span<const ShaderStage> stages, std::span<const char* const> defines = {},
+			void (*onLinked)(unsigned int program) = nullptr);
+		ReloadableProgram(const char* vertexPath, const char* fragmentPath, std::span<const char* const> defines = {},
+			void (*onLinked)(unsigned int program) = nullptr);
+		~ReloadableProgram();
+		ReloadableProgram(const ReloadableProgram&) = delete;
+		ReloadableProgram& operator=(const ReloadableProgram&) = delete;
+
+		//starts compilation, compilation in progress is abandoned
+		void Compile();
+		//swaps in finished program, wait blocks until pending compilation finishes
+		void Update(bool wait);
+		//never blocks, returns 0 until first compilation links or when it failed
+		unsigned int Get();
+		bool IsCompiling() const;
+	private:
+		std::pmr::vector<ShaderStage> stages;
+		//defines are string literals
+		std::pmr::vector<const char*> defines;
+		void (*onLinked)(unsigned int program);
+		unsigned int program{ 0 };
+		PendingProgram pending;
+		bool compiling{ false };
+	};
+}
+
+#endif
@@ -1,43 +1,294 @@
 #include <utils/shader_load_utils.h>
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <spdlog/spdlog.h>
+#include <utils/hash_utils.h>
+#include <utils/mapped_file.h>
+namespace fs = std::filesystem;
 
 
-std::pmr::string dengine::loadShaderFromFile(const std::pmr::string& filePath)
+//binaries are only valid for driver that produced them, cache is relative to working directory like logs
+constexpr const char* ProgramBinaryCacheDirectory = "shader-cache";
+constexpr unsigned int ProgramBinaryMagic = 0x4e494244; //DBIN
+constexpr unsigned int ProgramBinaryVersion = 1;
+
+
+struct ProgramBinaryHeader {
+	unsigned int Magic;
+	unsigned int Version;
+	unsigned long long SourceHash;
+	unsigned long long DriverHash;
+	unsigned int BinaryFormat;
+	unsigned int BinarySize;
+};
+
+
+unsigned long long getDriverHash()
+{
+	static const unsigned long long driverHash = [] {
+		unsigned long long hash = dengine::hashBytes(nullptr, 0);
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+		{
+			const auto value = reinterpret_cast<const char*>(glGetString(name));
+			if (value != nullptr)
+				hash = dengine::hashBytes(value, std::strlen(value), hash);
+			hash = dengine::hashBytes("\n", 1, hash);
+		}
+		return hash;
+	}();
+	return driverHash;
+}
+
+
+fs::path getProgramBinaryPath(unsigned long long sourceHash, unsigned long long driverHash)
+{
+	char fileName[48];
+	std::snprintf(fileName, sizeof(fileName), "%016llx.bin", dengine::hashBytes(&driverHash,
+		sizeof(driverHash), sourceHash));
+	return fs::path(ProgramBinaryCacheDirectory) / fileName;
+}
+
+
+bool loadProgramBinary(unsigned int program, unsigned long long sourceHash, unsigned long long driverHash)
+{
+	dengine::MappedFile file;
+	if (!file.Open(std::pmr::string(getProgramBinaryPath(sourceHash, driverHash).string())))
+		return false;
+
+	ProgramBinaryHeader header;
+	if (file.Size() < sizeof(header))
+		return false;
+	std::memcpy(&header, file.Data(), sizeof(header));
+	if (header.Magic != ProgramBinaryMagic || header.Version != ProgramBinaryVersion ||
+		header.SourceHash != sourceHash || header.DriverHash != driverHash ||
+		header.BinarySize != file.Size() - sizeof(header))
+		return false;
+
+	//driver may still reject binary after update of same version string, caller falls back to compilation
+	glProgramBinary(program, header.BinaryFormat, file.Data() + sizeof(header), header.BinarySize);
+	int linkStatus = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+	return linkStatus == GL_TRUE;
+}
+
+
+void storeProgramBinary(unsigned int program, unsigned long long sourceHash, unsigned long long driverHash)
+{
+	int binarySize = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+	if (binarySize <= 0)
+		return;
+
+	std::pmr::vector<char> binary(binarySize);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(program, binarySize, &binarySize, &binaryFormat, binary.data());
+	const ProgramBinaryHeader header{ ProgramBinaryMagic, ProgramBinaryVersion, sourceHash, driverHash, binaryFormat,
+		static_cast<unsigned int>(binarySize) };
+
+	std::error_code error;
+	fs::create_directories(ProgramBinaryCacheDirectory, error);
+	std::ofstream stream(getProgramBinaryPath(sourceHash, driverHash), std::ios::binary | std::ios::trunc);
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	stream.write(binary.data(), binarySize);
+	if (!stream.good())
+		spdlog::get("app_logger")->warn("Failed to write program binary to {}", ProgramBinaryCacheDirectory);
+}
+
+
+std::pmr::string dengine::loadShaderFromFile(const std::pmr::string& filePath, std::span<const char* const> defines)
 {
-	std::fstream fstream;
-	fstream.open(filePath.c_str(), std::fstream::binary | std::fstream::in);
-	std::stringstream ss;
-	ss << fstream.rdbuf();
-	fstream.close();
-	return std::pmr::string(ss.str());
+	MappedFile file;
+	if (!file.Open(filePath))
+	{
+		spdlog::get("app_logger")->error("Failed to open shader {}", filePath.c_str());
+		return std::pmr::string();
+	}
+	std::pmr::string source(file.Data(), file.Size());
+	if (defines.empty())
+		return source;
+
+	//#version has to stay first directive
+	size_t insertPosition = 0;
+	int versionLine = 0;
+	const auto versionPosition = source.find("#version");
+	if (versionPosition != std::pmr::string::npos)
+	{
+		versionLine = static_cast<int>(std::count(source.begin(), source.begin() + versionPosition, '\n')) + 1;
+		insertPosition = source.find('\n', versionPosition);
+		insertPosition = insertPosition == std::pmr::string::npos ? source.size() : insertPosition + 1;
+	}
+	std::pmr::string injected;
+	if (insertPosition == source.size() && insertPosition > 0 && source.back() != '\n')
+		injected += '\n';
+	for (auto define : defines)
+	{
+		injected += "#define ";
+		injected += define;
+		injected += '\n';
+	}
+	injected += "#line " + std::to_string(versionLine + 1) + '\n';
+	source.insert(insertPosition, injected);
+	return source;
 }
 
 
-unsigned int dengine::uploadAndCompileShaders(const char* vertexPath, const char* fragmentPath)
+void logProgramErrors(const dengine::PendingProgram& pending)
 {
-	auto vertexShaderSource = loadShaderFromFile(vertexPath);
-	auto fragmentShaderSource = loadShaderFromFile(fragmentPath);
+	auto log = spdlog::get("app_logger");
+	std::pmr::string paths;
+	for (auto& stage : pending.Stages)
+	{
+		paths += paths.empty() ? "" : ", ";
+		paths += stage.Path;
+		int compileStatus = GL_FALSE;
+		glGetShaderiv(stage.Shader, GL_COMPILE_STATUS, &compileStatus);
+		if (compileStatus == GL_TRUE)
+			continue;
+		int logLength = 0;
+		glGetShaderiv(stage.Shader, GL_INFO_LOG_LENGTH, &logLength);
+		std::pmr::string infoLog(std::max(logLength, 1), '\0');
+		glGetShaderInfoLog(stage.Shader, logLength, nullptr, infoLog.data());
+		log->error("Failed to compile shader {}:\n{}", stage.Path.c_str(), infoLog.c_str());
+	}
 
-	unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	unsigned int program = glCreateProgram();
-	const char* vertexShaderSourcePtr = vertexShaderSource.c_str();
-	const char* fragmentShaderSourcePtr = fragmentShaderSource.c_str();
-	glShaderSource(vertexShader, 1, &vertexShaderSourcePtr, nullptr);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSourcePtr, nullptr);
-	glCompileShader(vertexShader);
-	glCompileShader(fragmentShader);
+	int logLength = 0;
+	glGetProgramiv(pending.Program, GL_INFO_LOG_LENGTH, &logLength);
+	std::pmr::string infoLog(std::max(logLength, 1), '\0');
+	glGetProgramInfoLog(pending.Program, logLength, nullptr, infoLog.data());
+	log->error("Failed to link {}:\n{}", paths.c_str(), infoLog.c_str());
+}
 
-	glAttachShader(program, vertexShader);
-	glAttachShader(program, fragmentShader);
-	glLinkProgram(program);
-	glDetachShader(program, vertexShader);
-	glDetachShader(program, fragmentShader);
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
 
-	return program;
+void releaseShaders(dengine::PendingProgram& pending)
+{
+	for (auto& stage : pending.Stages)
+	{
+		if (stage.Shader == 0)
+			continue;
+		glDetachShader(pending.Program, stage.Shader);
+		glDeleteShader(stage.Shader);
+		stage.Shader = 0;
+	}
+}
+
+
+bool hasParallelShaderCompilation()
+{
+	//driver picks thread count, without extension status queries block until link finishes anyway
+	static const bool supported = [] {
+		if (GLAD_GL_KHR_parallel_shader_compile)
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		return GLAD_GL_KHR_parallel_shader_compile != 0;
+	}();
+	return supported;
+}
+
+
+dengine::PendingProgram dengine::beginProgramCompilation(std::span<const ShaderStage> stages,
+	std::span<const char* const> defines)
+{
+	PendingProgram pending;
+	std::pmr::vector<std::pmr::string> sources;
+	for (auto& stage : stages)
+	{
+		pending.Stages.push_back(ShaderStage{ stage.Type, stage.Path });
+		sources.push_back(loadShaderFromFile(stage.Path, defines));
+		if (sources.back().empty())
+			return pending;
+	}
+
+	//warm runs restore linked program from cache and skip compilation entirely
+	int binaryFormatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormatCount);
+	//stage type and terminator of every source separate stages in hash
+	pending.SourceHash = dengine::hashBytes(nullptr, 0);
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		pending.SourceHash = dengine::hashBytes(&pending.Stages[i].Type,
+			sizeof(pending.Stages[i].Type), pending.SourceHash);
+		pending.SourceHash = dengine::hashBytes(sources[i].data(), sources[i].size() + 1, pending.SourceHash);
+	}
+	pending.StoreBinary = binaryFormatCount > 0;
+	pending.Program = glCreateProgram();
+	if (binaryFormatCount > 0 && loadProgramBinary(pending.Program, pending.SourceHash, getDriverHash()))
+	{
+		pending.StoreBinary = false;
+		return pending;
+	}
+
+	//status is not queried here, so driver is free to compile and link on its own threads
+	hasParallelShaderCompilation();
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		auto& stage = pending.Stages[i];
+		const char* sourcePtr = sources[i].c_str();
+		stage.Shader = glCreateShader(stage.Type);
+		glShaderSource(stage.Shader, 1, &sourcePtr, nullptr);
+		glCompileShader(stage.Shader);
+	}
+
+	glProgramParameteri(pending.Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	for (auto& stage : pending.Stages)
+		glAttachShader(pending.Program, stage.Shader);
+	glLinkProgram(pending.Program);
+	return pending;
+}
+
+
+dengine::PendingProgram dengine::beginProgramCompilation(const char* vertexPath, const char* fragmentPath,
+	std::span<const char* const> defines)
+{
+	const ShaderStage stages[] = { { GL_VERTEX_SHADER, vertexPath }, { GL_FRAGMENT_SHADER, fragmentPath } };
+	return beginProgramCompilation(stages, defines);
+}
+
+
+bool dengine::pollProgramCompilation(PendingProgram& pending, bool wait)
+{
+	if (pending.Program == 0 || pending.Stages.empty() || pending.Stages.front().Shader == 0)
+		return true;
+	if (!wait && hasParallelShaderCompilation())
+	{
+		int completionStatus = GL_FALSE;
+		glGetProgramiv(pending.Program, GL_COMPLETION_STATUS_KHR, &completionStatus);
+		if (completionStatus != GL_TRUE)
+			return false;
+	}
+
+	int linkStatus = GL_FALSE;
+	glGetProgramiv(pending.Program, GL_LINK_STATUS, &linkStatus);
+	if (linkStatus != GL_TRUE)
+	{
+		logProgramErrors(pending);
+		releaseShaders(pending);
+		glDeleteProgram(pending.Program);
+		pending.Program = 0;
+		return true;
+	}
+	releaseShaders(pending);
+	if (pending.StoreBinary)
+		storeProgramBinary(pending.Program, pending.SourceHash, getDriverHash());
+	return true;
+}
+
+
+void dengine::cancelProgramCompilation(PendingProgram& pending)
+{
+	releaseShaders(pending);
+	glDeleteProgram(pending.Program);
+	pending.Program = 0;
+}
+
+
+unsigned int dengine::uploadAndCompileShaders(const char* vertexPath, const char* fragmentPath,
+	std::span<const char* const> defines)
+{
+	auto pending = beginProgramCompilation(vertexPath, fragmentPath, defines);
+	pollProgramCompilation(pending, true);
+	return pending.Program;
 }
@@ -2,10 +2,38 @@
 #define SHADER_LOAD_UTIL_INCLUDED
 
 #include <string>
+#include <span>
+#include <vector>
 
 namespace dengine
 {
-	std::pmr::string loadShaderFromFile(const std::pmr::string& filePath);
-	unsigned int uploadAndCompileShaders(const char* vertexPath, const char* fragmentPath);
+	//defines are inserted after #version line, line numbers of driver errors still match file
+	std::pmr::string loadShaderFromFile(const std::pmr::string& filePath, std::span<const char* const> defines = {});
+	//Type is gl shader type, Shader is set while stage of pending program compiles
+	struct ShaderStage {
+		unsigned int Type{ 0 };
+		std::pmr::string Path;
+		unsigned int Shader{ 0 };
+	};
+
+	//program whose link was started and not yet checked
+	struct PendingProgram {
+		unsigned int Program{ 0 };
+		std::pmr::vector<ShaderStage> Stages;
+		unsigned long long SourceHash{ 0 };
+		bool StoreBinary{ false };
+	};
+
+	//restores cached binary or starts compilation, drivers with GL_KHR_parallel_shader_compile link in background
+	PendingProgram beginProgramCompilation(std::span<const ShaderStage> stages, std::span<const char* const> defines = {});
+	PendingProgram beginProgramCompilation(const char* vertexPath, const char* fragmentPath,
+		std::span<const char* const> defines = {});
+	//true once link finished, Program is 0 then when compilation failed; wait blocks until link finishes
+	bool pollProgramCompilation(PendingProgram& pending, bool wait);
+	void cancelProgramCompilation(PendingProgram& pending);
+	//returns 0 and logs driver output when compilation or linking fails,
+	//linked programs are cached as program binaries and restored on next run with same sources and driver
+	unsigned int uploadAndCompileShaders(const char* vertexPath, const char* fragmentPath,
+		std::span<const char* const> defines = {});
 }
 #endif